@@ -0,0 +1,96 @@
+// Generated from codec_fixture.neuro
+#ifndef NEUROX_GEN_CODECFIXTURE_H
+#define NEUROX_GEN_CODECFIXTURE_H
+
+#include "runtime/net/mqtt.h"
+#include "runtime/net/codec.h"
+#include "runtime/net/json.h"
+
+// Message Pose (cbor)
+typedef struct {
+    float x;
+    float y;
+    uint64_t stamp;
+    bool moving;
+} Pose;
+
+#define Pose_BINARY_SIZE 17
+
+static inline size_t Pose_encode_cbor(const void *message, uint8_t *buf, size_t cap) {
+    const Pose *m = message;
+    nrx_codec_writer_t w = nrx_codec_writer(buf, cap);
+    nrx_codec_raw(&w, "\xa4\x61x", 3);
+    nrx_cbor_f32(&w, m->x);
+    nrx_codec_raw(&w, "\x61y", 2);
+    nrx_cbor_f32(&w, m->y);
+    nrx_codec_raw(&w, "\x65stamp", 6);
+    nrx_cbor_uint(&w, m->stamp);
+    nrx_codec_raw(&w, "\x66moving", 7);
+    nrx_cbor_bool(&w, m->moving);
+    return nrx_codec_end(&w);
+}
+
+static inline size_t Pose_encode_binary(const void *message, uint8_t *buf, size_t cap) {
+    const Pose *m = message;
+    nrx_codec_writer_t w = nrx_codec_writer(buf, cap);
+    nrx_bin_f32(&w, m->x);
+    nrx_bin_f32(&w, m->y);
+    nrx_bin_uint(&w, (uint64_t)m->stamp, 8);
+    nrx_bin_uint(&w, (uint64_t)m->moving, 1);
+    return nrx_codec_end(&w);
+}
+
+static inline bool Pose_decode_binary(Pose *m, const uint8_t *buf, size_t len) {
+    if (len != Pose_BINARY_SIZE) return false;
+    m->x = nrx_bin_read_f32(buf + 0);
+    m->y = nrx_bin_read_f32(buf + 4);
+    m->stamp = (uint64_t)nrx_bin_read_uint(buf + 8, 8);
+    m->moving = buf[16] != 0;
+    return true;
+}
+
+static inline size_t Pose_encode_json(const void *message, uint8_t *buf, size_t cap) {
+    const Pose *m = message;
+    nrx_codec_writer_t w = nrx_codec_writer(buf, cap);
+    nrx_codec_raw(&w, "{\"x\":", 5);
+    nrx_json_f32(&w, m->x);
+    nrx_codec_raw(&w, ",\"y\":", 5);
+    nrx_json_f32(&w, m->y);
+    nrx_codec_raw(&w, ",\"stamp\":", 9);
+    nrx_json_uint(&w, m->stamp);
+    nrx_codec_raw(&w, ",\"moving\":", 10);
+    nrx_json_bool(&w, m->moving);
+    nrx_codec_raw(&w, "}", 1);
+    return nrx_codec_end(&w);
+}
+
+static inline bool Pose_read_json(Pose *m, const nrx_json_tape_t *t, uint32_t object) {
+    static const nrx_json_step_t keys[4] = {
+        NRX_JSON_KEY("x"),
+        NRX_JSON_KEY("y"),
+        NRX_JSON_KEY("stamp"),
+        NRX_JSON_KEY("moving"),
+    };
+    uint32_t at[4];
+    uint64_t u;
+    if (!nrx_json_lookup(t, object, keys, 4, at)) return false;
+    if (!nrx_json_get_f32(t, at[0], &m->x)) return false;
+    if (!nrx_json_get_f32(t, at[1], &m->y)) return false;
+    if (!nrx_json_get_u64(t, at[2], &u)) return false;
+    m->stamp = (uint64_t)u;
+    if (!nrx_json_get_bool(t, at[3], &m->moving)) return false;
+    return true;
+}
+
+static inline bool Pose_decode_json(Pose *m, const uint8_t *buf, size_t len) {
+    nrx_json_node_t nodes[NRX_JSON_MESSAGE_NODES(4)];
+    nrx_json_tape_t t;
+    return nrx_json_parse(&t, nodes, NRX_JSON_MESSAGE_NODES(4), (const char *)buf, len) == 0 &&
+           Pose_read_json(m, &t, 0);
+}
+
+static inline int Pose_publish(nrx_mqtt_topic_t *topic, const Pose *m) {
+    return nrx_mqtt_topic_publish_encoded(topic, Pose_encode_cbor, m);
+}
+
+#endif
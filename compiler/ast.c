@@ -126,6 +126,16 @@ void ast_decl_free(ast_decl_t *decl) {
             ast_expr_free(decl->as.schedule.frequency);
             ast_stmt_free(decl->as.schedule.body);
             break;
+        case DECL_MESSAGE:
+            NEUROX_FREE(decl->as.message.name);
+            for (size_t i = 0; i < decl->as.message.field_count; i++) {
+                NEUROX_FREE(decl->as.message.fields[i]->name);
+                NEUROX_FREE(decl->as.message.fields[i]->type->name);
+                NEUROX_FREE(decl->as.message.fields[i]->type);
+                NEUROX_FREE(decl->as.message.fields[i]);
+            }
+            NEUROX_FREE(decl->as.message.fields);
+            break;
         default:
             // TODO: Free other declaration types
             break;
@@ -223,6 +233,16 @@ void ast_decl_print(ast_decl_t *decl, int indent) {
             printf("Schedule: %s\n", decl->as.schedule.name);
             ast_stmt_print(decl->as.schedule.body, indent + 1);
             break;
+        case DECL_MESSAGE: {
+            static const char *formats[] = { "json", "cbor", "binary" };
+            printf("Message: %s as %s\n", decl->as.message.name, formats[decl->as.message.format]);
+            for (size_t i = 0; i < decl->as.message.field_count; i++) {
+                print_indent(indent + 1);
+                printf("Field: %s: %s\n", decl->as.message.fields[i]->name,
+                       decl->as.message.fields[i]->type->name);
+            }
+            break;
+        }
         default:
             printf("Declaration (type %d)\n", decl->type);
             break;
@@ -44,6 +44,7 @@ typedef enum {
     DECL_TASK,
     DECL_SCHEDULE,
     DECL_EVENT,
+    DECL_MESSAGE,
 } ast_decl_type_t;
 
 // Literal value
@@ -271,6 +272,20 @@ typedef struct {
     ast_stmt_t *handler;
 } ast_event_decl_t;
 
+// Message declaration: a payload schema and its wire format
+typedef enum {
+    MESSAGE_JSON,
+    MESSAGE_CBOR,
+    MESSAGE_BINARY,
+} ast_message_format_t;
+
+typedef struct {
+    char *name;
+    ast_message_format_t format;
+    ast_param_t **fields;
+    size_t field_count;
+} ast_message_decl_t;
+
 // Declaration node
 struct ast_decl_t {
     ast_decl_type_t type;
@@ -286,6 +301,7 @@ struct ast_decl_t {
         ast_task_decl_t task;
         ast_schedule_decl_t schedule;
         ast_event_decl_t event;
+        ast_message_decl_t message;
     } as;
     int line;
     int column;
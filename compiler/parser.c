@@ -52,6 +52,20 @@ static void consume(parser_t *parser, token_type_t type, const char *message) {
     error_at_current(parser, message);
 }
 
+static bool previous_is(parser_t *parser, const char *text) {
+    size_t len = strlen(text);
+    return parser->previous.length == len && memcmp(parser->previous.start, text, len) == 0;
+}
+
+// A type is a name or one of the built-in unit types (Percent, ms, ...)
+static bool match_type_name(parser_t *parser) {
+    if (parser->current.type >= TOKEN_TYPE_PERCENT && parser->current.type <= TOKEN_TYPE_SPEED) {
+        advance(parser);
+        return true;
+    }
+    return match(parser, TOKEN_IDENTIFIER);
+}
+
 static void skip_newlines(parser_t *parser) {
     while (match(parser, TOKEN_NEWLINE)) {
         // Skip
@@ -64,6 +78,19 @@ static ast_stmt_t *parse_statement(parser_t *parser);
 static ast_decl_t *parse_declaration(parser_t *parser);
 
 // Expression parsing
+// Unit suffix on a number literal (100ms, 10Hz), or false
+static bool match_unit(parser_t *parser, ast_unit_type_t *unit) {
+    switch (parser->current.type) {
+        case TOKEN_TYPE_MS: *unit = UNIT_MS; break;
+        case TOKEN_TYPE_CM: *unit = UNIT_CM; break;
+        case TOKEN_TYPE_DEG: *unit = UNIT_DEG; break;
+        case TOKEN_TYPE_HZ: *unit = UNIT_HZ; break;
+        default: return false;
+    }
+    advance(parser);
+    return true;
+}
+
 static ast_expr_t *parse_primary(parser_t *parser) {
     if (match(parser, TOKEN_NUMBER)) {
         ast_expr_t *expr = ast_expr_create(EXPR_LITERAL);
@@ -71,6 +98,16 @@ static ast_expr_t *parse_primary(parser_t *parser) {
         expr->as.literal.value.number = strtod(parser->previous.start, NULL);
         expr->line = parser->previous.line;
         expr->column = parser->previous.column;
+        
+        ast_unit_type_t unit;
+        if (match_unit(parser, &unit)) {
+            ast_expr_t *quantity = ast_expr_create(EXPR_UNIT);
+            quantity->as.unit.value = expr;
+            quantity->as.unit.unit = unit;
+            quantity->line = expr->line;
+            quantity->column = expr->column;
+            return quantity;
+        }
         return expr;
     }
     
@@ -87,7 +124,10 @@ static ast_expr_t *parse_primary(parser_t *parser) {
         return expr;
     }
     
-    if (match(parser, TOKEN_IDENTIFIER)) {
+    // Built-in actions and their argument words are keywords, but are
+    // called and passed like any other name
+    if (match(parser, TOKEN_IDENTIFIER) || match(parser, TOKEN_STOP) || match(parser, TOKEN_TURN) ||
+        match(parser, TOKEN_ESTOP) || match(parser, TOKEN_CLOCKWISE) || match(parser, TOKEN_COUNTERCLOCKWISE)) {
         ast_expr_t *expr = ast_expr_create(EXPR_IDENTIFIER);
         expr->as.identifier = token_to_string(&parser->previous);
         expr->line = parser->previous.line;
@@ -255,7 +295,8 @@ static ast_stmt_t *parse_block(parser_t *parser) {
     
     skip_newlines(parser);
     
-    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
+    // After an error nothing is consumed, so stop instead of spinning
+    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF) && !parser->had_error) {
         if (block->as.block.count >= capacity) {
             capacity *= 2;
             block->as.block.statements = NEUROX_REALLOC(block->as.block.statements,
@@ -407,7 +448,7 @@ static ast_decl_t *parse_task_decl(parser_t *parser) {
             
             if (match(parser, TOKEN_COLON)) {
                 // Parse type
-                consume(parser, TOKEN_IDENTIFIER, "Expected type name");
+                if (!match_type_name(parser)) error_at_current(parser, "Expected type name");
                 param->type = NEUROX_MALLOC(sizeof(ast_type_t));
                 param->type->name = token_to_string(&parser->previous);
                 param->type->unit = UNIT_PERCENT; // Default
@@ -468,6 +509,62 @@ static ast_decl_t *parse_schedule_decl(parser_t *parser) {
     return decl;
 }
 
+// message Pose as cbor { x: f32, y: f32, stamp: u64 }
+static ast_decl_t *parse_message_decl(parser_t *parser) {
+    consume(parser, TOKEN_IDENTIFIER, "Expected message name");
+    char *name = token_to_string(&parser->previous);
+    
+    ast_message_format_t format = MESSAGE_JSON;
+    if (match(parser, TOKEN_AS)) {
+        if (match(parser, TOKEN_JSON)) {
+            format = MESSAGE_JSON;
+        } else if (match(parser, TOKEN_IDENTIFIER) &&
+                   (previous_is(parser, "cbor") || previous_is(parser, "binary"))) {
+            format = previous_is(parser, "cbor") ? MESSAGE_CBOR : MESSAGE_BINARY;
+        } else {
+            error(parser, "Expected message format (json, cbor, binary)");
+        }
+    }
+    
+    consume(parser, TOKEN_LEFT_BRACE, "Expected '{' after message name");
+    skip_newlines(parser);
+    
+    // Fields, separated by commas or newlines
+    size_t capacity = 4;
+    size_t field_count = 0;
+    ast_param_t **fields = NEUROX_MALLOC(capacity * sizeof(ast_param_t *));
+    
+    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF) && !parser->had_error) {
+        if (field_count >= capacity) {
+            capacity *= 2;
+            fields = NEUROX_REALLOC(fields, capacity * sizeof(ast_param_t *));
+        }
+        
+        consume(parser, TOKEN_IDENTIFIER, "Expected field name");
+        ast_param_t *field = NEUROX_MALLOC(sizeof(ast_param_t));
+        field->name = token_to_string(&parser->previous);
+        consume(parser, TOKEN_COLON, "Expected ':' after field name");
+        consume(parser, TOKEN_IDENTIFIER, "Expected field type");
+        field->type = NEUROX_MALLOC(sizeof(ast_type_t));
+        field->type->name = token_to_string(&parser->previous);
+        field->type->unit = UNIT_PERCENT; // Default
+        fields[field_count++] = field;
+        
+        match(parser, TOKEN_COMMA);
+        skip_newlines(parser);
+    }
+    
+    consume(parser, TOKEN_RIGHT_BRACE, "Expected '}' after message fields");
+    
+    ast_decl_t *decl = ast_decl_create(DECL_MESSAGE);
+    decl->as.message.name = name;
+    decl->as.message.format = format;
+    decl->as.message.fields = fields;
+    decl->as.message.field_count = field_count;
+    
+    return decl;
+}
+
 static ast_decl_t *parse_declaration(parser_t *parser) {
     skip_newlines(parser);
     
@@ -487,6 +584,10 @@ static ast_decl_t *parse_declaration(parser_t *parser) {
         return parse_schedule_decl(parser);
     }
     
+    if (match(parser, TOKEN_MESSAGE)) {
+        return parse_message_decl(parser);
+    }
+    
     error(parser, "Expected declaration");
     return NULL;
 }
@@ -516,7 +617,7 @@ ast_robot_t *parser_parse(parser_t *parser) {
     size_t capacity = 16;
     robot->declarations = NEUROX_MALLOC(capacity * sizeof(ast_decl_t *));
     
-    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
+    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF) && !parser->had_error) {
         if (robot->decl_count >= capacity) {
             capacity *= 2;
             robot->declarations = NEUROX_REALLOC(robot->declarations,
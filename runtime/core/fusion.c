@@ -0,0 +1,663 @@
+#include "fusion.h"
+#include <math.h>
+#include <string.h>
+
+#define NRX_PI 3.14159265358979f
+#define NRX_TWO_PI 6.28318530717959f
+
+// Four-lane vector helpers
+// The batched kernels are written once against these and compile to SSE2,
+// AArch64 NEON or a plain loop the compiler may vectorise itself.
+#if defined(__SSE2__) && !defined(NRX_FUSION_NO_SIMD)
+#include <emmintrin.h>
+
+typedef __m128 v4f;
+typedef __m128 v4m;
+
+static inline v4f v4_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void v4_store(float *p, v4f a) { _mm_storeu_ps(p, a); }
+static inline v4f v4_set1(float x) { return _mm_set1_ps(x); }
+static inline v4f v4_add(v4f a, v4f b) { return _mm_add_ps(a, b); }
+static inline v4f v4_sub(v4f a, v4f b) { return _mm_sub_ps(a, b); }
+static inline v4f v4_mul(v4f a, v4f b) { return _mm_mul_ps(a, b); }
+static inline v4f v4_div(v4f a, v4f b) { return _mm_div_ps(a, b); }
+static inline v4f v4_sqrt(v4f a) { return _mm_sqrt_ps(a); }
+static inline v4f v4_min(v4f a, v4f b) { return _mm_min_ps(a, b); }
+static inline v4f v4_max(v4f a, v4f b) { return _mm_max_ps(a, b); }
+static inline v4f v4_abs(v4f a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline v4f v4_round(v4f a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+static inline v4m v4_lt(v4f a, v4f b) { return _mm_cmplt_ps(a, b); }
+static inline v4f v4_select(v4m m, v4f t, v4f f) {
+    return _mm_or_ps(_mm_and_ps(m, t), _mm_andnot_ps(m, f));
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(NRX_FUSION_NO_SIMD)
+#include <arm_neon.h>
+
+typedef float32x4_t v4f;
+typedef uint32x4_t v4m;
+
+static inline v4f v4_load(const float *p) { return vld1q_f32(p); }
+static inline void v4_store(float *p, v4f a) { vst1q_f32(p, a); }
+static inline v4f v4_set1(float x) { return vdupq_n_f32(x); }
+static inline v4f v4_add(v4f a, v4f b) { return vaddq_f32(a, b); }
+static inline v4f v4_sub(v4f a, v4f b) { return vsubq_f32(a, b); }
+static inline v4f v4_mul(v4f a, v4f b) { return vmulq_f32(a, b); }
+static inline v4f v4_div(v4f a, v4f b) { return vdivq_f32(a, b); }
+static inline v4f v4_sqrt(v4f a) { return vsqrtq_f32(a); }
+static inline v4f v4_min(v4f a, v4f b) { return vminq_f32(a, b); }
+static inline v4f v4_max(v4f a, v4f b) { return vmaxq_f32(a, b); }
+static inline v4f v4_abs(v4f a) { return vabsq_f32(a); }
+static inline v4f v4_round(v4f a) { return vrndnq_f32(a); }
+static inline v4m v4_lt(v4f a, v4f b) { return vcltq_f32(a, b); }
+static inline v4f v4_select(v4m m, v4f t, v4f f) { return vbslq_f32(m, t, f); }
+
+#else
+
+typedef struct { float v[NRX_FUSION_LANES]; } v4f;
+typedef struct { bool v[NRX_FUSION_LANES]; } v4m;
+
+#define V4_MAP(expr) \
+    v4f r; \
+    for (int i = 0; i < NRX_FUSION_LANES; i++) r.v[i] = (expr); \
+    return r
+
+static inline v4f v4_load(const float *p) { V4_MAP(p[i]); }
+static inline void v4_store(float *p, v4f a) { memcpy(p, a.v, sizeof(a.v)); }
+static inline v4f v4_set1(float x) { V4_MAP(x); }
+static inline v4f v4_add(v4f a, v4f b) { V4_MAP(a.v[i] + b.v[i]); }
+static inline v4f v4_sub(v4f a, v4f b) { V4_MAP(a.v[i] - b.v[i]); }
+static inline v4f v4_mul(v4f a, v4f b) { V4_MAP(a.v[i] * b.v[i]); }
+static inline v4f v4_div(v4f a, v4f b) { V4_MAP(a.v[i] / b.v[i]); }
+static inline v4f v4_sqrt(v4f a) { V4_MAP(sqrtf(a.v[i])); }
+static inline v4f v4_min(v4f a, v4f b) { V4_MAP(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+static inline v4f v4_max(v4f a, v4f b) { V4_MAP(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+static inline v4f v4_abs(v4f a) { V4_MAP(fabsf(a.v[i])); }
+static inline v4f v4_round(v4f a) { V4_MAP(nearbyintf(a.v[i])); }
+static inline v4f v4_select(v4m m, v4f t, v4f f) { V4_MAP(m.v[i] ? t.v[i] : f.v[i]); }
+static inline v4m v4_lt(v4f a, v4f b) {
+    v4m r;
+    for (int i = 0; i < NRX_FUSION_LANES; i++) r.v[i] = a.v[i] < b.v[i];
+    return r;
+}
+
+#endif
+
+// atan2 from a rational-free polynomial on [0, 1] (max error ~0.0015 rad),
+// shared by the vector and fixed-point paths
+static inline v4f v4_atan2(v4f y, v4f x) {
+    v4f zero = v4_set1(0.0f);
+    v4f ax = v4_abs(x), ay = v4_abs(y);
+    v4f z = v4_div(v4_min(ax, ay), v4_max(v4_max(ax, ay), v4_set1(1e-30f)));
+    
+    // pi/4 z - z (z - 1)(0.2447 + 0.0663 z)
+    v4f a = v4_sub(v4_mul(v4_set1(NRX_PI / 4.0f), z),
+                   v4_mul(v4_mul(z, v4_sub(z, v4_set1(1.0f))),
+                          v4_add(v4_set1(0.2447f), v4_mul(v4_set1(0.0663f), z))));
+    
+    a = v4_select(v4_lt(ax, ay), v4_sub(v4_set1(NRX_PI / 2.0f), a), a);
+    a = v4_select(v4_lt(x, zero), v4_sub(v4_set1(NRX_PI), a), a);
+    return v4_select(v4_lt(y, zero), v4_sub(zero, a), a);
+}
+
+static inline v4f v4_wrap_angle(v4f a) {
+    v4f turns = v4_round(v4_mul(a, v4_set1(1.0f / NRX_TWO_PI)));
+    return v4_sub(a, v4_mul(turns, v4_set1(NRX_TWO_PI)));
+}
+
+// sin on [-pi, pi]: fold into [-pi/2, pi/2], then a 7th-order odd polynomial
+static inline v4f v4_sin(v4f a) {
+    v4f half_pi = v4_set1(NRX_PI / 2.0f);
+    v4f pi = v4_set1(NRX_PI);
+    a = v4_select(v4_lt(half_pi, a), v4_sub(pi, a), a);
+    a = v4_select(v4_lt(a, v4_sub(v4_set1(0.0f), half_pi)), v4_sub(v4_sub(v4_set1(0.0f), pi), a), a);
+    
+    v4f a2 = v4_mul(a, a);
+    v4f p = v4_set1(-1.0f / 5040.0f);
+    p = v4_add(v4_mul(p, a2), v4_set1(1.0f / 120.0f));
+    p = v4_add(v4_mul(p, a2), v4_set1(-1.0f / 6.0f));
+    p = v4_add(v4_mul(p, a2), v4_set1(1.0f));
+    return v4_mul(p, a);
+}
+
+static inline float wrap_angle(float a) {
+    return a - NRX_TWO_PI * nearbyintf(a / NRX_TWO_PI);
+}
+
+// Q16.16 arithmetic
+#define Q16_PI 205887
+#define Q16_HALF_PI 102944
+#define Q16_TWO_PI 411775
+
+// Products round to nearest; truncation biases long integrations
+nrx_q16_t nrx_q16_mul(nrx_q16_t a, nrx_q16_t b) {
+    return (nrx_q16_t)(((int64_t)a * b + 0x8000) >> 16);
+}
+
+nrx_q16_t nrx_q16_div(nrx_q16_t a, nrx_q16_t b) {
+    if (b == 0) return a >= 0 ? INT32_MAX : INT32_MIN;
+    return (nrx_q16_t)((int64_t)a * NRX_Q16_ONE / b);
+}
+
+static uint64_t isqrt64(uint64_t n) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > n) bit >>= 2;
+    while (bit) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// The integer square root of a << 16 is the Q16 root of a
+nrx_q16_t nrx_q16_sqrt(nrx_q16_t a) {
+    if (a <= 0) return 0;
+    return (nrx_q16_t)isqrt64((uint64_t)a << 16);
+}
+
+static nrx_q16_t q16_wrap_angle(nrx_q16_t a) {
+    a %= Q16_TWO_PI;
+    if (a > Q16_PI) a -= Q16_TWO_PI;
+    if (a < -Q16_PI) a += Q16_TWO_PI;
+    return a;
+}
+
+nrx_q16_t nrx_q16_sin(nrx_q16_t a) {
+    a = q16_wrap_angle(a);
+    if (a > Q16_HALF_PI) a = Q16_PI - a;
+    if (a < -Q16_HALF_PI) a = -Q16_PI - a;
+    
+    nrx_q16_t a2 = nrx_q16_mul(a, a);
+    nrx_q16_t p = NRX_Q16(-1.0f / 5040.0f);
+    p = nrx_q16_mul(p, a2) + NRX_Q16(1.0f / 120.0f);
+    p = nrx_q16_mul(p, a2) + NRX_Q16(-1.0f / 6.0f);
+    p = nrx_q16_mul(p, a2) + NRX_Q16_ONE;
+    return nrx_q16_mul(p, a);
+}
+
+nrx_q16_t nrx_q16_cos(nrx_q16_t a) {
+    return nrx_q16_sin(q16_wrap_angle(a) + Q16_HALF_PI);
+}
+
+nrx_q16_t nrx_q16_atan2(nrx_q16_t y, nrx_q16_t x) {
+    if (x == 0 && y == 0) return 0;
+    
+    int64_t ax = x < 0 ? -(int64_t)x : x;
+    int64_t ay = y < 0 ? -(int64_t)y : y;
+    nrx_q16_t z = (nrx_q16_t)((ax < ay ? ax : ay) * NRX_Q16_ONE / (ax < ay ? ay : ax));
+    
+    nrx_q16_t a = nrx_q16_mul(Q16_PI / 4, z) -
+                  nrx_q16_mul(nrx_q16_mul(z, z - NRX_Q16_ONE), NRX_Q16(0.2447f) + nrx_q16_mul(NRX_Q16(0.0663f), z));
+    
+    if (ax < ay) a = Q16_HALF_PI - a;
+    if (x < 0) a = Q16_PI - a;
+    return y < 0 ? -a : a;
+}
+
+// Complementary filter
+void nrx_complementary_init(nrx_complementary_t *filter, float alpha) {
+    memset(filter, 0, sizeof(*filter));
+    filter->alpha = alpha;
+}
+
+void nrx_complementary_update(nrx_complementary_t *filter, const float gyro[3], const float accel[3], float dt) {
+    float roll_acc = atan2f(accel[1], accel[2]);
+    float pitch_acc = atan2f(-accel[0], sqrtf(accel[1] * accel[1] + accel[2] * accel[2]));
+    
+    if (!filter->primed) {
+        filter->roll = roll_acc;
+        filter->pitch = pitch_acc;
+        filter->primed = true;
+        return;
+    }
+    
+    float a = filter->alpha;
+    filter->roll = a * (filter->roll + gyro[0] * dt) + (1.0f - a) * roll_acc;
+    filter->pitch = a * (filter->pitch + gyro[1] * dt) + (1.0f - a) * pitch_acc;
+    filter->yaw = wrap_angle(filter->yaw + gyro[2] * dt);
+}
+
+void nrx_complementary4_init(nrx_complementary4_t *filter, float alpha) {
+    memset(filter, 0, sizeof(*filter));
+    filter->alpha = alpha;
+}
+
+void nrx_complementary4_update(nrx_complementary4_t *filter, const nrx_imu4_t *imu, float dt) {
+    v4f ax = v4_load(imu->ax), ay = v4_load(imu->ay), az = v4_load(imu->az);
+    v4f roll_acc = v4_atan2(ay, az);
+    v4f pitch_acc = v4_atan2(v4_sub(v4_set1(0.0f), ax), v4_sqrt(v4_add(v4_mul(ay, ay), v4_mul(az, az))));
+    
+    if (!filter->primed) {
+        v4_store(filter->roll, roll_acc);
+        v4_store(filter->pitch, pitch_acc);
+        filter->primed = true;
+        return;
+    }
+    
+    v4f vdt = v4_set1(dt);
+    v4f a = v4_set1(filter->alpha);
+    v4f b = v4_set1(1.0f - filter->alpha);
+    
+    v4f roll = v4_add(v4_load(filter->roll), v4_mul(v4_load(imu->gx), vdt));
+    v4f pitch = v4_add(v4_load(filter->pitch), v4_mul(v4_load(imu->gy), vdt));
+    v4f yaw = v4_add(v4_load(filter->yaw), v4_mul(v4_load(imu->gz), vdt));
+    
+    v4_store(filter->roll, v4_add(v4_mul(a, roll), v4_mul(b, roll_acc)));
+    v4_store(filter->pitch, v4_add(v4_mul(a, pitch), v4_mul(b, pitch_acc)));
+    v4_store(filter->yaw, v4_wrap_angle(yaw));
+}
+
+void nrx_complementary_q16_init(nrx_complementary_q16_t *filter, nrx_q16_t alpha) {
+    memset(filter, 0, sizeof(*filter));
+    filter->alpha = alpha;
+}
+
+void nrx_complementary_q16_update(nrx_complementary_q16_t *filter, const nrx_q16_t gyro[3],
+                                  const nrx_q16_t accel[3], nrx_q16_t dt) {
+    nrx_q16_t roll_acc = nrx_q16_atan2(accel[1], accel[2]);
+    nrx_q16_t pitch_acc = nrx_q16_atan2(-accel[0], nrx_q16_sqrt(nrx_q16_mul(accel[1], accel[1]) +
+                                                                nrx_q16_mul(accel[2], accel[2])));
+    
+    if (!filter->primed) {
+        filter->roll = roll_acc;
+        filter->pitch = pitch_acc;
+        filter->primed = true;
+        return;
+    }
+    
+    nrx_q16_t a = filter->alpha;
+    nrx_q16_t b = NRX_Q16_ONE - a;
+    filter->roll = nrx_q16_mul(a, filter->roll + nrx_q16_mul(gyro[0], dt)) + nrx_q16_mul(b, roll_acc);
+    filter->pitch = nrx_q16_mul(a, filter->pitch + nrx_q16_mul(gyro[1], dt)) + nrx_q16_mul(b, pitch_acc);
+    filter->yaw = q16_wrap_angle(filter->yaw + nrx_q16_mul(gyro[2], dt));
+}
+
+// Madgwick filter, IMU (6 DoF) form of the reference algorithm
+void nrx_madgwick_init(nrx_madgwick_t *filter, float beta) {
+    filter->beta = beta;
+    filter->q = (nrx_quat_t){ 1.0f, 0.0f, 0.0f, 0.0f };
+}
+
+void nrx_madgwick_update(nrx_madgwick_t *filter, const float gyro[3], const float accel[3], float dt) {
+    float q0 = filter->q.w, q1 = filter->q.x, q2 = filter->q.y, q3 = filter->q.z;
+    float gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    
+    // Rate of change of quaternion from the gyro
+    float qd0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qd1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qd2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qd3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+    
+    float norm = accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2];
+    if (norm > 0.0f) {
+        float recip = 1.0f / sqrtf(norm);
+        float ax = accel[0] * recip, ay = accel[1] * recip, az = accel[2] * recip;
+        
+        // Gradient of the gravity-direction error
+        float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+        float s0 = 4.0f * q0 * q2q2 + 2.0f * q2 * ax + 4.0f * q0 * q1q1 - 2.0f * q1 * ay;
+        float s1 = 4.0f * q1 * q3q3 - 2.0f * q3 * ax + 4.0f * q0q0 * q1 - 2.0f * q0 * ay - 4.0f * q1 +
+                   8.0f * q1 * q1q1 + 8.0f * q1 * q2q2 + 4.0f * q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + 2.0f * q0 * ax + 4.0f * q2 * q3q3 - 2.0f * q3 * ay - 4.0f * q2 +
+                   8.0f * q2 * q1q1 + 8.0f * q2 * q2q2 + 4.0f * q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - 2.0f * q1 * ax + 4.0f * q2q2 * q3 - 2.0f * q2 * ay;
+        
+        float snorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (snorm > 0.0f) {
+            float k = filter->beta / sqrtf(snorm);
+            qd0 -= k * s0;
+            qd1 -= k * s1;
+            qd2 -= k * s2;
+            qd3 -= k * s3;
+        }
+    }
+    
+    q0 += qd0 * dt;
+    q1 += qd1 * dt;
+    q2 += qd2 * dt;
+    q3 += qd3 * dt;
+    
+    float recip = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    filter->q = (nrx_quat_t){ q0 * recip, q1 * recip, q2 * recip, q3 * recip };
+}
+
+void nrx_madgwick4_init(nrx_madgwick4_t *filter, float beta) {
+    memset(filter, 0, sizeof(*filter));
+    filter->beta = beta;
+    for (int i = 0; i < NRX_FUSION_LANES; i++) {
+        filter->qw[i] = 1.0f;
+    }
+}
+
+void nrx_madgwick4_update(nrx_madgwick4_t *filter, const nrx_imu4_t *imu, float dt) {
+    v4f q0 = v4_load(filter->qw), q1 = v4_load(filter->qx), q2 = v4_load(filter->qy), q3 = v4_load(filter->qz);
+    v4f gx = v4_load(imu->gx), gy = v4_load(imu->gy), gz = v4_load(imu->gz);
+    v4f zero = v4_set1(0.0f), half = v4_set1(0.5f), two = v4_set1(2.0f);
+    v4f four = v4_set1(4.0f), eight = v4_set1(8.0f);
+    
+    v4f qd0 = v4_mul(half, v4_sub(v4_sub(v4_sub(zero, v4_mul(q1, gx)), v4_mul(q2, gy)), v4_mul(q3, gz)));
+    v4f qd1 = v4_mul(half, v4_sub(v4_add(v4_mul(q0, gx), v4_mul(q2, gz)), v4_mul(q3, gy)));
+    v4f qd2 = v4_mul(half, v4_add(v4_sub(v4_mul(q0, gy), v4_mul(q1, gz)), v4_mul(q3, gx)));
+    v4f qd3 = v4_mul(half, v4_sub(v4_add(v4_mul(q0, gz), v4_mul(q1, gy)), v4_mul(q2, gx)));
+    
+    v4f ax = v4_load(imu->ax), ay = v4_load(imu->ay), az = v4_load(imu->az);
+    v4f norm = v4_add(v4_add(v4_mul(ax, ax), v4_mul(ay, ay)), v4_mul(az, az));
+    v4m has_accel = v4_lt(zero, norm);
+    v4f recip = v4_div(v4_set1(1.0f), v4_sqrt(v4_max(norm, v4_set1(1e-30f))));
+    ax = v4_mul(ax, recip);
+    ay = v4_mul(ay, recip);
+    az = v4_mul(az, recip);
+    
+    v4f q0q0 = v4_mul(q0, q0), q1q1 = v4_mul(q1, q1), q2q2 = v4_mul(q2, q2), q3q3 = v4_mul(q3, q3);
+    v4f s0 = v4_sub(v4_add(v4_add(v4_mul(v4_mul(four, q0), q2q2), v4_mul(v4_mul(two, q2), ax)),
+                           v4_mul(v4_mul(four, q0), q1q1)),
+                    v4_mul(v4_mul(two, q1), ay));
+    v4f s1 = v4_add(v4_sub(v4_sub(v4_add(v4_sub(v4_mul(v4_mul(four, q1), q3q3), v4_mul(v4_mul(two, q3), ax)),
+                                         v4_mul(v4_mul(four, q0q0), q1)),
+                                  v4_mul(v4_mul(two, q0), ay)),
+                           v4_mul(four, q1)),
+                    v4_add(v4_add(v4_mul(v4_mul(eight, q1), q1q1), v4_mul(v4_mul(eight, q1), q2q2)),
+                           v4_mul(v4_mul(four, q1), az)));
+    v4f s2 = v4_add(v4_sub(v4_sub(v4_add(v4_add(v4_mul(v4_mul(four, q0q0), q2), v4_mul(v4_mul(two, q0), ax)),
+                                         v4_mul(v4_mul(four, q2), q3q3)),
+                                  v4_mul(v4_mul(two, q3), ay)),
+                           v4_mul(four, q2)),
+                    v4_add(v4_add(v4_mul(v4_mul(eight, q2), q1q1), v4_mul(v4_mul(eight, q2), q2q2)),
+                           v4_mul(v4_mul(four, q2), az)));
+    v4f s3 = v4_sub(v4_add(v4_sub(v4_mul(v4_mul(four, q1q1), q3), v4_mul(v4_mul(two, q1), ax)),
+                           v4_mul(v4_mul(four, q2q2), q3)),
+                    v4_mul(v4_mul(two, q2), ay));
+    
+    v4f snorm = v4_add(v4_add(v4_mul(s0, s0), v4_mul(s1, s1)), v4_add(v4_mul(s2, s2), v4_mul(s3, s3)));
+    v4f k = v4_div(v4_set1(filter->beta), v4_sqrt(v4_max(snorm, v4_set1(1e-30f))));
+    k = v4_select(has_accel, v4_select(v4_lt(zero, snorm), k, zero), zero);
+    
+    v4f vdt = v4_set1(dt);
+    q0 = v4_add(q0, v4_mul(v4_sub(qd0, v4_mul(k, s0)), vdt));
+    q1 = v4_add(q1, v4_mul(v4_sub(qd1, v4_mul(k, s1)), vdt));
+    q2 = v4_add(q2, v4_mul(v4_sub(qd2, v4_mul(k, s2)), vdt));
+    q3 = v4_add(q3, v4_mul(v4_sub(qd3, v4_mul(k, s3)), vdt));
+    
+    v4f qn = v4_add(v4_add(v4_mul(q0, q0), v4_mul(q1, q1)), v4_add(v4_mul(q2, q2), v4_mul(q3, q3)));
+    recip = v4_div(v4_set1(1.0f), v4_sqrt(qn));
+    v4_store(filter->qw, v4_mul(q0, recip));
+    v4_store(filter->qx, v4_mul(q1, recip));
+    v4_store(filter->qy, v4_mul(q2, recip));
+    v4_store(filter->qz, v4_mul(q3, recip));
+}
+
+void nrx_madgwick_q16_init(nrx_madgwick_q16_t *filter, nrx_q16_t beta) {
+    filter->beta = beta;
+    filter->qw = NRX_Q16_ONE;
+    filter->qx = filter->qy = filter->qz = 0;
+}
+
+void nrx_madgwick_q16_update(nrx_madgwick_q16_t *filter, const nrx_q16_t gyro[3],
+                             const nrx_q16_t accel[3], nrx_q16_t dt) {
+    nrx_q16_t q0 = filter->qw, q1 = filter->qx, q2 = filter->qy, q3 = filter->qz;
+    nrx_q16_t gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    
+    nrx_q16_t qd0 = (-nrx_q16_mul(q1, gx) - nrx_q16_mul(q2, gy) - nrx_q16_mul(q3, gz)) / 2;
+    nrx_q16_t qd1 = (nrx_q16_mul(q0, gx) + nrx_q16_mul(q2, gz) - nrx_q16_mul(q3, gy)) / 2;
+    nrx_q16_t qd2 = (nrx_q16_mul(q0, gy) - nrx_q16_mul(q1, gz) + nrx_q16_mul(q3, gx)) / 2;
+    nrx_q16_t qd3 = (nrx_q16_mul(q0, gz) + nrx_q16_mul(q1, gy) - nrx_q16_mul(q2, gx)) / 2;
+    
+    // Normalise the accelerometer in 64-bit so raw sensor counts fit; the
+    // sum of squares is Q32, so its integer root is Q16
+    int64_t norm2 = (int64_t)accel[0] * accel[0] + (int64_t)accel[1] * accel[1] + (int64_t)accel[2] * accel[2];
+    if (norm2 > 0) {
+        nrx_q16_t norm = (nrx_q16_t)isqrt64((uint64_t)norm2);
+        nrx_q16_t ax = nrx_q16_div(accel[0], norm);
+        nrx_q16_t ay = nrx_q16_div(accel[1], norm);
+        nrx_q16_t az = nrx_q16_div(accel[2], norm);
+        
+        nrx_q16_t q0q0 = nrx_q16_mul(q0, q0), q1q1 = nrx_q16_mul(q1, q1);
+        nrx_q16_t q2q2 = nrx_q16_mul(q2, q2), q3q3 = nrx_q16_mul(q3, q3);
+        nrx_q16_t s0 = 4 * nrx_q16_mul(q0, q2q2) + 2 * nrx_q16_mul(q2, ax) + 4 * nrx_q16_mul(q0, q1q1) -
+                       2 * nrx_q16_mul(q1, ay);
+        nrx_q16_t s1 = 4 * nrx_q16_mul(q1, q3q3) - 2 * nrx_q16_mul(q3, ax) + 4 * nrx_q16_mul(q0q0, q1) -
+                       2 * nrx_q16_mul(q0, ay) - 4 * q1 + 8 * nrx_q16_mul(q1, q1q1) + 8 * nrx_q16_mul(q1, q2q2) +
+                       4 * nrx_q16_mul(q1, az);
+        nrx_q16_t s2 = 4 * nrx_q16_mul(q0q0, q2) + 2 * nrx_q16_mul(q0, ax) + 4 * nrx_q16_mul(q2, q3q3) -
+                       2 * nrx_q16_mul(q3, ay) - 4 * q2 + 8 * nrx_q16_mul(q2, q1q1) + 8 * nrx_q16_mul(q2, q2q2) +
+                       4 * nrx_q16_mul(q2, az);
+        nrx_q16_t s3 = 4 * nrx_q16_mul(q1q1, q3) - 2 * nrx_q16_mul(q1, ax) + 4 * nrx_q16_mul(q2q2, q3) -
+                       2 * nrx_q16_mul(q2, ay);
+        
+        nrx_q16_t snorm = nrx_q16_sqrt(nrx_q16_mul(s0, s0) + nrx_q16_mul(s1, s1) +
+                                       nrx_q16_mul(s2, s2) + nrx_q16_mul(s3, s3));
+        if (snorm > 0) {
+            nrx_q16_t k = nrx_q16_div(filter->beta, snorm);
+            qd0 -= nrx_q16_mul(k, s0);
+            qd1 -= nrx_q16_mul(k, s1);
+            qd2 -= nrx_q16_mul(k, s2);
+            qd3 -= nrx_q16_mul(k, s3);
+        }
+    }
+    
+    q0 += nrx_q16_mul(qd0, dt);
+    q1 += nrx_q16_mul(qd1, dt);
+    q2 += nrx_q16_mul(qd2, dt);
+    q3 += nrx_q16_mul(qd3, dt);
+    
+    nrx_q16_t qn = nrx_q16_sqrt(nrx_q16_mul(q0, q0) + nrx_q16_mul(q1, q1) + nrx_q16_mul(q2, q2) + nrx_q16_mul(q3, q3));
+    if (qn > 0) {
+        filter->qw = nrx_q16_div(q0, qn);
+        filter->qx = nrx_q16_div(q1, qn);
+        filter->qy = nrx_q16_div(q2, qn);
+        filter->qz = nrx_q16_div(q3, qn);
+    }
+}
+
+void nrx_quat_to_euler(const nrx_quat_t *q, float *roll, float *pitch, float *yaw) {
+    float sinp = 2.0f * (q->w * q->y - q->z * q->x);
+    if (roll) *roll = atan2f(2.0f * (q->w * q->x + q->y * q->z), 1.0f - 2.0f * (q->x * q->x + q->y * q->y));
+    if (pitch) *pitch = fabsf(sinp) >= 1.0f ? copysignf(NRX_PI / 2.0f, sinp) : asinf(sinp);
+    if (yaw) *yaw = atan2f(2.0f * (q->w * q->z + q->x * q->y), 1.0f - 2.0f * (q->y * q->y + q->z * q->z));
+}
+
+// Planar pose EKF
+// With F = I + a e0 e2' + b e1 e2' (a = -v sin(theta) dt, b = v cos(theta) dt)
+// the covariance prediction F P F' + Q reduces to the closed form below, and
+// a heading measurement (H = e2) to a scalar gain per state.
+void nrx_ekf_init(nrx_ekf_t *ekf, float q_pos, float q_theta, float r_heading) {
+    memset(ekf, 0, sizeof(*ekf));
+    ekf->q_pos = q_pos;
+    ekf->q_theta = q_theta;
+    ekf->r_heading = r_heading;
+}
+
+void nrx_ekf_predict(nrx_ekf_t *ekf, float v, float omega, float dt) {
+    float s = sinf(ekf->theta), c = cosf(ekf->theta);
+    float a = -v * s * dt, b = v * c * dt;
+    
+    ekf->x += v * c * dt;
+    ekf->y += v * s * dt;
+    ekf->theta = wrap_angle(ekf->theta + omega * dt);
+    
+    float p02 = ekf->p02, p12 = ekf->p12, p22 = ekf->p22;
+    ekf->p00 += 2.0f * a * p02 + a * a * p22 + ekf->q_pos * dt;
+    ekf->p01 += a * p12 + b * p02 + a * b * p22;
+    ekf->p02 = p02 + a * p22;
+    ekf->p11 += 2.0f * b * p12 + b * b * p22 + ekf->q_pos * dt;
+    ekf->p12 = p12 + b * p22;
+    ekf->p22 = p22 + ekf->q_theta * dt;
+}
+
+void nrx_ekf_update_heading(nrx_ekf_t *ekf, float heading) {
+    float innovation = wrap_angle(heading - ekf->theta);
+    float recip = 1.0f / (ekf->p22 + ekf->r_heading);
+    float k0 = ekf->p02 * recip, k1 = ekf->p12 * recip, k2 = ekf->p22 * recip;
+    
+    ekf->x += k0 * innovation;
+    ekf->y += k1 * innovation;
+    ekf->theta = wrap_angle(ekf->theta + k2 * innovation);
+    
+    float p02 = ekf->p02, p12 = ekf->p12, p22 = ekf->p22;
+    ekf->p00 -= k0 * p02;
+    ekf->p01 -= k0 * p12;
+    ekf->p02 -= k0 * p22;
+    ekf->p11 -= k1 * p12;
+    ekf->p12 -= k1 * p22;
+    ekf->p22 -= k2 * p22;
+}
+
+void nrx_ekf4_init(nrx_ekf4_t *ekf, float q_pos, float q_theta, float r_heading) {
+    memset(ekf, 0, sizeof(*ekf));
+    ekf->q_pos = q_pos;
+    ekf->q_theta = q_theta;
+    ekf->r_heading = r_heading;
+}
+
+void nrx_ekf4_predict(nrx_ekf4_t *ekf, const float v[NRX_FUSION_LANES], const float omega[NRX_FUSION_LANES], float dt) {
+    v4f vdt = v4_set1(dt);
+    v4f theta = v4_load(ekf->theta);
+    v4f s = v4_sin(theta);
+    v4f c = v4_sin(v4_wrap_angle(v4_add(theta, v4_set1(NRX_PI / 2.0f))));
+    v4f vel = v4_mul(v4_load(v), vdt);
+    v4f a = v4_sub(v4_set1(0.0f), v4_mul(vel, s)), b = v4_mul(vel, c);
+    
+    v4_store(ekf->x, v4_add(v4_load(ekf->x), b));
+    v4_store(ekf->y, v4_sub(v4_load(ekf->y), a));
+    v4_store(ekf->theta, v4_wrap_angle(v4_add(theta, v4_mul(v4_load(omega), vdt))));
+    
+    v4f p02 = v4_load(ekf->p02), p12 = v4_load(ekf->p12), p22 = v4_load(ekf->p22);
+    v4f qp = v4_set1(ekf->q_pos * dt);
+    v4f two = v4_set1(2.0f);
+    v4_store(ekf->p00, v4_add(v4_load(ekf->p00),
+                              v4_add(v4_mul(v4_mul(two, a), p02), v4_add(v4_mul(v4_mul(a, a), p22), qp))));
+    v4_store(ekf->p01, v4_add(v4_load(ekf->p01),
+                              v4_add(v4_add(v4_mul(a, p12), v4_mul(b, p02)), v4_mul(v4_mul(a, b), p22))));
+    v4_store(ekf->p02, v4_add(p02, v4_mul(a, p22)));
+    v4_store(ekf->p11, v4_add(v4_load(ekf->p11),
+                              v4_add(v4_mul(v4_mul(two, b), p12), v4_add(v4_mul(v4_mul(b, b), p22), qp))));
+    v4_store(ekf->p12, v4_add(p12, v4_mul(b, p22)));
+    v4_store(ekf->p22, v4_add(p22, v4_set1(ekf->q_theta * dt)));
+}
+
+void nrx_ekf4_update_heading(nrx_ekf4_t *ekf, const float heading[NRX_FUSION_LANES]) {
+    v4f theta = v4_load(ekf->theta);
+    v4f innovation = v4_wrap_angle(v4_sub(v4_load(heading), theta));
+    v4f p02 = v4_load(ekf->p02), p12 = v4_load(ekf->p12), p22 = v4_load(ekf->p22);
+    v4f recip = v4_div(v4_set1(1.0f), v4_add(p22, v4_set1(ekf->r_heading)));
+    v4f k0 = v4_mul(p02, recip), k1 = v4_mul(p12, recip), k2 = v4_mul(p22, recip);
+    
+    v4_store(ekf->x, v4_add(v4_load(ekf->x), v4_mul(k0, innovation)));
+    v4_store(ekf->y, v4_add(v4_load(ekf->y), v4_mul(k1, innovation)));
+    v4_store(ekf->theta, v4_wrap_angle(v4_add(theta, v4_mul(k2, innovation))));
+    
+    v4_store(ekf->p00, v4_sub(v4_load(ekf->p00), v4_mul(k0, p02)));
+    v4_store(ekf->p01, v4_sub(v4_load(ekf->p01), v4_mul(k0, p12)));
+    v4_store(ekf->p02, v4_sub(p02, v4_mul(k0, p22)));
+    v4_store(ekf->p11, v4_sub(v4_load(ekf->p11), v4_mul(k1, p12)));
+    v4_store(ekf->p12, v4_sub(p12, v4_mul(k1, p22)));
+    v4_store(ekf->p22, v4_sub(p22, v4_mul(k2, p22)));
+}
+
+void nrx_ekf_q16_init(nrx_ekf_q16_t *ekf, nrx_q16_t q_pos, nrx_q16_t q_theta, nrx_q16_t r_heading) {
+    memset(ekf, 0, sizeof(*ekf));
+    ekf->q_pos = q_pos;
+    ekf->q_theta = q_theta;
+    ekf->r_heading = r_heading;
+}
+
+void nrx_ekf_q16_predict(nrx_ekf_q16_t *ekf, nrx_q16_t v, nrx_q16_t omega, nrx_q16_t dt) {
+    nrx_q16_t vel = nrx_q16_mul(v, dt);
+    nrx_q16_t a = -nrx_q16_mul(vel, nrx_q16_sin(ekf->theta));
+    nrx_q16_t b = nrx_q16_mul(vel, nrx_q16_cos(ekf->theta));
+    
+    ekf->x += b;
+    ekf->y -= a;
+    ekf->theta = q16_wrap_angle(ekf->theta + nrx_q16_mul(omega, dt));
+    
+    nrx_q16_t p02 = ekf->p02, p12 = ekf->p12, p22 = ekf->p22;
+    nrx_q16_t qp = nrx_q16_mul(ekf->q_pos, dt);
+    ekf->p00 += 2 * nrx_q16_mul(a, p02) + nrx_q16_mul(nrx_q16_mul(a, a), p22) + qp;
+    ekf->p01 += nrx_q16_mul(a, p12) + nrx_q16_mul(b, p02) + nrx_q16_mul(nrx_q16_mul(a, b), p22);
+    ekf->p02 = p02 + nrx_q16_mul(a, p22);
+    ekf->p11 += 2 * nrx_q16_mul(b, p12) + nrx_q16_mul(nrx_q16_mul(b, b), p22) + qp;
+    ekf->p12 = p12 + nrx_q16_mul(b, p22);
+    ekf->p22 = p22 + nrx_q16_mul(ekf->q_theta, dt);
+}
+
+void nrx_ekf_q16_update_heading(nrx_ekf_q16_t *ekf, nrx_q16_t heading) {
+    nrx_q16_t innovation = q16_wrap_angle(heading - ekf->theta);
+    nrx_q16_t s = ekf->p22 + ekf->r_heading;
+    if (s <= 0) return;
+    
+    nrx_q16_t k0 = nrx_q16_div(ekf->p02, s), k1 = nrx_q16_div(ekf->p12, s), k2 = nrx_q16_div(ekf->p22, s);
+    
+    ekf->x += nrx_q16_mul(k0, innovation);
+    ekf->y += nrx_q16_mul(k1, innovation);
+    ekf->theta = q16_wrap_angle(ekf->theta + nrx_q16_mul(k2, innovation));
+    
+    nrx_q16_t p02 = ekf->p02, p12 = ekf->p12, p22 = ekf->p22;
+    ekf->p00 -= nrx_q16_mul(k0, p02);
+    ekf->p01 -= nrx_q16_mul(k0, p12);
+    ekf->p02 -= nrx_q16_mul(k0, p22);
+    ekf->p11 -= nrx_q16_mul(k1, p12);
+    ekf->p12 -= nrx_q16_mul(k1, p22);
+    ekf->p22 -= nrx_q16_mul(k2, p22);
+}
+
+// Built-in sensor types
+void nrx_fusion_init(nrx_fusion_t *fusion, nrx_fusion_kind_t kind) {
+    memset(fusion, 0, sizeof(*fusion));
+    fusion->kind = kind;
+    
+    switch (kind) {
+        case NRX_FUSION_COMPLEMENTARY:
+            nrx_complementary_init(&fusion->as.complementary, 0.98f);
+            break;
+        case NRX_FUSION_MADGWICK:
+            nrx_madgwick_init(&fusion->as.madgwick, 0.1f);
+            break;
+        case NRX_FUSION_EKF:
+            nrx_ekf_init(&fusion->as.ekf, 0.01f, 0.005f, 0.05f);
+            break;
+    }
+}
+
+void nrx_fusion_update_imu(nrx_fusion_t *fusion, const float gyro[3], const float accel[3], float dt) {
+    if (fusion->kind == NRX_FUSION_COMPLEMENTARY) {
+        nrx_complementary_update(&fusion->as.complementary, gyro, accel, dt);
+    } else if (fusion->kind == NRX_FUSION_MADGWICK) {
+        nrx_madgwick_update(&fusion->as.madgwick, gyro, accel, dt);
+    }
+}
+
+void nrx_fusion_update_odometry(nrx_fusion_t *fusion, float v, float omega, float dt) {
+    if (fusion->kind == NRX_FUSION_EKF) {
+        nrx_ekf_predict(&fusion->as.ekf, v, omega, dt);
+    }
+}
+
+void nrx_fusion_update_heading(nrx_fusion_t *fusion, float heading) {
+    if (fusion->kind == NRX_FUSION_EKF) {
+        nrx_ekf_update_heading(&fusion->as.ekf, heading);
+    }
+}
+
+void nrx_fusion_get_attitude(const nrx_fusion_t *fusion, float *roll, float *pitch, float *yaw) {
+    switch (fusion->kind) {
+        case NRX_FUSION_COMPLEMENTARY:
+            if (roll) *roll = fusion->as.complementary.roll;
+            if (pitch) *pitch = fusion->as.complementary.pitch;
+            if (yaw) *yaw = fusion->as.complementary.yaw;
+            break;
+        case NRX_FUSION_MADGWICK:
+            nrx_quat_to_euler(&fusion->as.madgwick.q, roll, pitch, yaw);
+            break;
+        case NRX_FUSION_EKF:
+            if (roll) *roll = 0.0f;
+            if (pitch) *pitch = 0.0f;
+            if (yaw) *yaw = fusion->as.ekf.theta;
+            break;
+    }
+}
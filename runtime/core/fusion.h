@@ -0,0 +1,161 @@
+#ifndef NEUROX_FUSION_H
+#define NEUROX_FUSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Sensor fusion kernels
+// Three filters, each in three forms:
+//   - float, one instance (the reference)
+//   - float, four instances in SoA lanes, using SSE or NEON when the
+//     compiler targets them and plain C otherwise (define
+//     NRX_FUSION_NO_SIMD to force the plain C path)
+//   - Q16.16 fixed point, one instance, for FPU-less targets
+//
+// Units: angles in radians, rates in rad/s, accelerations in any unit
+// (only the direction is used), time steps in seconds.
+
+// Q16.16 fixed point
+typedef int32_t nrx_q16_t;
+
+#define NRX_Q16_ONE 65536
+#define NRX_Q16(x) ((nrx_q16_t)((x) * 65536.0f + ((x) >= 0 ? 0.5f : -0.5f)))
+#define NRX_Q16_TO_FLOAT(q) ((float)(q) / 65536.0f)
+
+nrx_q16_t nrx_q16_mul(nrx_q16_t a, nrx_q16_t b);
+nrx_q16_t nrx_q16_div(nrx_q16_t a, nrx_q16_t b);
+nrx_q16_t nrx_q16_sqrt(nrx_q16_t a);
+nrx_q16_t nrx_q16_sin(nrx_q16_t a);
+nrx_q16_t nrx_q16_cos(nrx_q16_t a);
+nrx_q16_t nrx_q16_atan2(nrx_q16_t y, nrx_q16_t x);
+
+#define NRX_FUSION_LANES 4
+
+// SoA IMU samples for the batched kernels, one lane per instance
+typedef struct {
+    float gx[NRX_FUSION_LANES], gy[NRX_FUSION_LANES], gz[NRX_FUSION_LANES];
+    float ax[NRX_FUSION_LANES], ay[NRX_FUSION_LANES], az[NRX_FUSION_LANES];
+} nrx_imu4_t;
+
+// Complementary filter
+// Integrates the gyro and pulls roll/pitch toward the accelerometer's
+// gravity direction; alpha near 1 trusts the gyro more. Yaw is gyro only.
+typedef struct {
+    float alpha;
+    float roll, pitch, yaw;
+    bool primed;
+} nrx_complementary_t;
+
+typedef struct {
+    float alpha;
+    float roll[NRX_FUSION_LANES], pitch[NRX_FUSION_LANES], yaw[NRX_FUSION_LANES];
+    bool primed;
+} nrx_complementary4_t;
+
+typedef struct {
+    nrx_q16_t alpha;
+    nrx_q16_t roll, pitch, yaw;
+    bool primed;
+} nrx_complementary_q16_t;
+
+void nrx_complementary_init(nrx_complementary_t *filter, float alpha);
+void nrx_complementary_update(nrx_complementary_t *filter, const float gyro[3], const float accel[3], float dt);
+void nrx_complementary4_init(nrx_complementary4_t *filter, float alpha);
+void nrx_complementary4_update(nrx_complementary4_t *filter, const nrx_imu4_t *imu, float dt);
+void nrx_complementary_q16_init(nrx_complementary_q16_t *filter, nrx_q16_t alpha);
+void nrx_complementary_q16_update(nrx_complementary_q16_t *filter, const nrx_q16_t gyro[3],
+                                  const nrx_q16_t accel[3], nrx_q16_t dt);
+
+// Madgwick orientation filter (gyro + accelerometer)
+// Gradient-descent correction of the gyro-integrated quaternion; beta is
+// the correction gain (about 0.04 to 0.1 for MEMS gyros).
+typedef struct {
+    float w, x, y, z;
+} nrx_quat_t;
+
+typedef struct {
+    float beta;
+    nrx_quat_t q;
+} nrx_madgwick_t;
+
+typedef struct {
+    float beta;
+    float qw[NRX_FUSION_LANES], qx[NRX_FUSION_LANES], qy[NRX_FUSION_LANES], qz[NRX_FUSION_LANES];
+} nrx_madgwick4_t;
+
+typedef struct {
+    nrx_q16_t beta;
+    nrx_q16_t qw, qx, qy, qz;
+} nrx_madgwick_q16_t;
+
+void nrx_madgwick_init(nrx_madgwick_t *filter, float beta);
+void nrx_madgwick_update(nrx_madgwick_t *filter, const float gyro[3], const float accel[3], float dt);
+void nrx_madgwick4_init(nrx_madgwick4_t *filter, float beta);
+void nrx_madgwick4_update(nrx_madgwick4_t *filter, const nrx_imu4_t *imu, float dt);
+void nrx_madgwick_q16_init(nrx_madgwick_q16_t *filter, nrx_q16_t beta);
+void nrx_madgwick_q16_update(nrx_madgwick_q16_t *filter, const nrx_q16_t gyro[3],
+                             const nrx_q16_t accel[3], nrx_q16_t dt);
+void nrx_quat_to_euler(const nrx_quat_t *q, float *roll, float *pitch, float *yaw);
+
+// Planar pose EKF
+// State (x, y, theta). Predicts from wheel odometry (v, omega) and corrects
+// theta from an absolute heading (compass or fused IMU yaw). The covariance
+// is symmetric, so only its six unique terms are stored.
+typedef struct {
+    float x, y, theta;
+    float p00, p01, p02, p11, p12, p22;
+    float q_pos, q_theta;           // Process noise per second
+    float r_heading;                // Heading measurement variance
+} nrx_ekf_t;
+
+typedef struct {
+    float x[NRX_FUSION_LANES], y[NRX_FUSION_LANES], theta[NRX_FUSION_LANES];
+    float p00[NRX_FUSION_LANES], p01[NRX_FUSION_LANES], p02[NRX_FUSION_LANES];
+    float p11[NRX_FUSION_LANES], p12[NRX_FUSION_LANES], p22[NRX_FUSION_LANES];
+    float q_pos, q_theta, r_heading;
+} nrx_ekf4_t;
+
+typedef struct {
+    nrx_q16_t x, y, theta;
+    nrx_q16_t p00, p01, p02, p11, p12, p22;
+    nrx_q16_t q_pos, q_theta, r_heading;
+} nrx_ekf_q16_t;
+
+void nrx_ekf_init(nrx_ekf_t *ekf, float q_pos, float q_theta, float r_heading);
+void nrx_ekf_predict(nrx_ekf_t *ekf, float v, float omega, float dt);
+void nrx_ekf_update_heading(nrx_ekf_t *ekf, float heading);
+void nrx_ekf4_init(nrx_ekf4_t *ekf, float q_pos, float q_theta, float r_heading);
+void nrx_ekf4_predict(nrx_ekf4_t *ekf, const float v[NRX_FUSION_LANES], const float omega[NRX_FUSION_LANES], float dt);
+void nrx_ekf4_update_heading(nrx_ekf4_t *ekf, const float heading[NRX_FUSION_LANES]);
+void nrx_ekf_q16_init(nrx_ekf_q16_t *ekf, nrx_q16_t q_pos, nrx_q16_t q_theta, nrx_q16_t r_heading);
+void nrx_ekf_q16_predict(nrx_ekf_q16_t *ekf, nrx_q16_t v, nrx_q16_t omega, nrx_q16_t dt);
+void nrx_ekf_q16_update_heading(nrx_ekf_q16_t *ekf, nrx_q16_t heading);
+
+// Built-in .neuro sensor types
+// `sensor imu on I2C0 type IMU` declares a fused sensor. neuroxc emits a
+// static nrx_fusion_t named after it and initializes it with default
+// tuning in main(). Nothing generated reads the device, so the program
+// feeds it samples with the nrx_fusion_update_* calls.
+typedef enum {
+    NRX_FUSION_COMPLEMENTARY,       // type TiltIMU
+    NRX_FUSION_MADGWICK,            // type IMU
+    NRX_FUSION_EKF,                 // type Odometry
+} nrx_fusion_kind_t;
+
+typedef struct {
+    nrx_fusion_kind_t kind;
+    union {
+        nrx_complementary_t complementary;
+        nrx_madgwick_t madgwick;
+        nrx_ekf_t ekf;
+    } as;
+} nrx_fusion_t;
+
+void nrx_fusion_init(nrx_fusion_t *fusion, nrx_fusion_kind_t kind);
+void nrx_fusion_update_imu(nrx_fusion_t *fusion, const float gyro[3], const float accel[3], float dt);
+void nrx_fusion_update_odometry(nrx_fusion_t *fusion, float v, float omega, float dt);
+void nrx_fusion_update_heading(nrx_fusion_t *fusion, float heading);
+void nrx_fusion_get_attitude(const nrx_fusion_t *fusion, float *roll, float *pitch, float *yaw);
+
+#endif // NEUROX_FUSION_H
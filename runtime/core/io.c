@@ -0,0 +1,158 @@
+#define _DEFAULT_SOURCE
+
+#include "io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// Registrations live in a fixed table; epoll carries the slot index so the
+// I/O thread never chases freed memory after nrx_io_remove().
+typedef struct {
+    atomic_int fd;
+    nrx_io_cb_t callback;
+    void *context;
+} nrx_io_slot_t;
+
+static struct {
+    int epoll_fd;
+    int wake_fd;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_int dispatching;     // Slot whose callback is running, -1 if none
+    nrx_io_slot_t slots[NRX_IO_MAX_FDS];
+    pthread_mutex_t lock;       // Serializes add/remove, never taken by the I/O thread
+} g_io = { .epoll_fd = -1, .wake_fd = -1, .dispatching = -1, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+#define NRX_IO_WAKE_SLOT UINT32_MAX
+
+static void *io_thread(void *arg) {
+    (void)arg;
+    struct epoll_event events[32];
+    
+    while (atomic_load(&g_io.running)) {
+        int n = epoll_wait(g_io.epoll_fd, events, 32, -1);
+        
+        for (int i = 0; i < n; i++) {
+            uint32_t slot = events[i].data.u32;
+            if (slot == NRX_IO_WAKE_SLOT) {
+                uint64_t value;
+                ssize_t r = read(g_io.wake_fd, &value, sizeof(value));
+                (void)r;
+                continue;
+            }
+            
+            nrx_io_slot_t *entry = &g_io.slots[slot];
+            atomic_store(&g_io.dispatching, (int)slot);
+            int fd = atomic_load(&entry->fd);
+            if (fd >= 0 && entry->callback) {
+                entry->callback(fd, events[i].events, entry->context);
+            }
+            atomic_store(&g_io.dispatching, -1);
+        }
+    }
+    
+    return NULL;
+}
+
+int nrx_io_start(void) {
+    if (atomic_load(&g_io.running)) return 0;
+    
+    // The epoll instance and slot table outlive stop/start cycles
+    if (g_io.epoll_fd < 0) {
+        for (int i = 0; i < NRX_IO_MAX_FDS; i++) {
+            atomic_store(&g_io.slots[i].fd, -1);
+        }
+        g_io.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        g_io.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (g_io.epoll_fd < 0 || g_io.wake_fd < 0) return -1;
+        
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = NRX_IO_WAKE_SLOT };
+        epoll_ctl(g_io.epoll_fd, EPOLL_CTL_ADD, g_io.wake_fd, &ev);
+    }
+    
+    atomic_store(&g_io.running, true);
+    if (pthread_create(&g_io.thread, NULL, io_thread, NULL) != 0) {
+        atomic_store(&g_io.running, false);
+        return -1;
+    }
+    
+    return 0;
+}
+
+void nrx_io_stop(void) {
+    if (!atomic_exchange(&g_io.running, false)) return;
+    
+    uint64_t one = 1;
+    ssize_t w = write(g_io.wake_fd, &one, sizeof(one));
+    (void)w;
+    pthread_join(g_io.thread, NULL);
+}
+
+bool nrx_io_running(void) {
+    return atomic_load(&g_io.running);
+}
+
+int nrx_io_add(int fd, uint32_t events, nrx_io_cb_t callback, void *context) {
+    if (fd < 0 || !callback) return -1;
+    if (nrx_io_start() != 0) return -1;
+    
+    pthread_mutex_lock(&g_io.lock);
+    
+    int slot = -1;
+    for (int i = 0; i < NRX_IO_MAX_FDS; i++) {
+        if (atomic_load(&g_io.slots[i].fd) < 0) {
+            slot = i;
+            break;
+        }
+    }
+    
+    if (slot >= 0) {
+        g_io.slots[slot].callback = callback;
+        g_io.slots[slot].context = context;
+        atomic_store(&g_io.slots[slot].fd, fd);
+        
+        struct epoll_event ev = { .events = events, .data.u32 = (uint32_t)slot };
+        if (epoll_ctl(g_io.epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            atomic_store(&g_io.slots[slot].fd, -1);
+            slot = -1;
+        }
+    }
+    
+    pthread_mutex_unlock(&g_io.lock);
+    return slot >= 0 ? 0 : -1;
+}
+
+int nrx_io_remove(int fd) {
+    if (fd < 0 || g_io.epoll_fd < 0) return -1;
+    
+    pthread_mutex_lock(&g_io.lock);
+    
+    int result = -1;
+    for (int i = 0; i < NRX_IO_MAX_FDS; i++) {
+        if (atomic_load(&g_io.slots[i].fd) == fd) {
+            epoll_ctl(g_io.epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            atomic_store(&g_io.slots[i].fd, -1);
+            
+            // Once this returns the callback's context may be freed, so
+            // wait out a dispatch already in progress
+            while (atomic_load(&g_io.dispatching) == i) {
+                sched_yield();
+            }
+            result = 0;
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock(&g_io.lock);
+    return result;
+}
+
+int nrx_io_disable(int fd) {
+    if (fd < 0 || g_io.epoll_fd < 0) return -1;
+    return epoll_ctl(g_io.epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
@@ -0,0 +1,31 @@
+#ifndef NEUROX_IO_H
+#define NEUROX_IO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Runtime I/O thread
+// One thread multiplexes every driver fd (GPIO line events, UART, ...)
+// with epoll. Callbacks run on the I/O thread and must not block; work that
+// belongs in task context is handed over with nrx_scheduler_defer().
+#define NRX_IO_MAX_FDS 64
+
+typedef void (*nrx_io_cb_t)(int fd, uint32_t events, void *context);
+
+int nrx_io_start(void);
+void nrx_io_stop(void);
+bool nrx_io_running(void);
+
+// events are EPOLLIN/EPOLLOUT/... flags. nrx_io_remove() returns only once
+// no callback for the fd is running, so its context can then be freed.
+// Neither may be called from a callback.
+int nrx_io_add(int fd, uint32_t events, nrx_io_cb_t callback, void *context);
+int nrx_io_remove(int fd);
+
+// Stops events for the fd without taking the registration lock, so a
+// callback can silence a dead device; the slot stays taken until the
+// owner calls nrx_io_remove().
+int nrx_io_disable(int fd);
+
+#endif // NEUROX_IO_H
@@ -0,0 +1,263 @@
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Per-thread single-producer/single-consumer ring. head and tail are
+// free-running counters; the ring is full when they are NRX_LOG_RING_SIZE
+// apart. Rings are linked into a global list on a thread's first event and
+// are never freed, so the drain can walk the list without locks.
+typedef struct nrx_log_ring_t {
+    nrx_log_event_t events[NRX_LOG_RING_SIZE];
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_uint_fast64_t dropped;
+    struct nrx_log_ring_t *next;
+} nrx_log_ring_t;
+
+static _Thread_local nrx_log_ring_t *tl_ring;
+
+static struct {
+    _Atomic(nrx_log_ring_t *) rings;
+    atomic_uint ring_count;
+    atomic_uint_fast64_t drained;
+    FILE *output;
+} g_log;
+
+static nrx_log_ring_t *log_ring_get(void) {
+    if (tl_ring) return tl_ring;
+    
+    nrx_log_ring_t *ring = calloc(1, sizeof(nrx_log_ring_t));
+    if (!ring) return NULL;
+    
+    ring->next = atomic_load(&g_log.rings);
+    while (!atomic_compare_exchange_weak(&g_log.rings, &ring->next, ring)) {
+    }
+    atomic_fetch_add(&g_log.ring_count, 1);
+    
+    tl_ring = ring;
+    return ring;
+}
+
+void nrx_log_event(nrx_log_code_t code, int32_t arg0, int32_t arg1, int32_t arg2,
+                   float val0, float val1, const char *text) {
+    nrx_log_ring_t *ring = log_ring_get();
+    if (!ring) return;
+    
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    
+    // Never block the producer; count what the drain could not keep up with
+    if (head - tail >= NRX_LOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    
+    nrx_log_event_t *event = &ring->events[head & (NRX_LOG_RING_SIZE - 1)];
+    event->timestamp_us = nrx_time_now_us();
+    event->code = (uint16_t)code;
+    event->reserved = 0;
+    event->arg[0] = arg0;
+    event->arg[1] = arg1;
+    event->arg[2] = arg2;
+    event->val[0] = val0;
+    event->val[1] = val1;
+    event->text = text;
+    
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void nrx_log_set_output(FILE *out) {
+    g_log.output = out;
+}
+
+void nrx_log_format(const nrx_log_event_t *event, FILE *out) {
+    const int32_t *a = event->arg;
+    const float *v = event->val;
+    
+    fprintf(out, "[%llu.%06llu] ",
+            (unsigned long long)(event->timestamp_us / 1000000ULL),
+            (unsigned long long)(event->timestamp_us % 1000000ULL));
+    
+    switch ((nrx_log_code_t)event->code) {
+        case NRX_LOG_SAFETY_FAULT:
+            fprintf(out, "[SAFETY FAULT] Code %d: %s\n", a[0], event->text ? event->text : "Unknown");
+            break;
+        case NRX_LOG_LIMIT_EXCEEDED:
+            fprintf(out, "[SAFETY FAULT] Limit exceeded: type=%d, value=%f, bound=%f\n", a[0], v[0], v[1]);
+            break;
+        case NRX_LOG_MONITOR_TRIP:
+            fprintf(out, "[SAFETY FAULT] Monitor trip: channel=%d, mask=0x%08X\n", a[0], (unsigned)a[1]);
+            break;
+        case NRX_LOG_WATCHDOG_STALL:
+            fprintf(out, "[SAFETY FAULT] Watchdog timeout: task '%s' (channel %d)\n",
+                    event->text ? event->text : "unnamed", a[0]);
+            break;
+        case NRX_LOG_ESTOP:
+            fprintf(out, "[EMERGENCY STOP] System halted: %d actuators off in %d us\n", a[0], a[1]);
+            break;
+        case NRX_LOG_ESTOP_RESET:
+            fprintf(out, "[SAFETY] E-stop reset\n");
+            break;
+        case NRX_LOG_GPIO_INIT:
+            fprintf(out, "[HAL] GPIO init: pin=%d, mode=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_GPIO_WRITE:
+            fprintf(out, "[HAL] GPIO write: pin=%d, state=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_GPIO_TOGGLE:
+            fprintf(out, "[HAL] GPIO toggle: pin=%d, new_state=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_PWM_INIT:
+            fprintf(out, "[HAL] PWM init: pin=%d, freq=%d Hz\n", a[0], a[1]);
+            break;
+        case NRX_LOG_PWM_DUTY:
+            fprintf(out, "[HAL] PWM set duty: pin=%d, duty=%.1f%%\n", a[0], v[0]);
+            break;
+        case NRX_LOG_PWM_STOP:
+            fprintf(out, "[HAL] PWM stop: pin=%d\n", a[0]);
+            break;
+        case NRX_LOG_ADC_INIT:
+            fprintf(out, "[HAL] ADC init: pin=%d\n", a[0]);
+            break;
+        case NRX_LOG_UART_INIT:
+            fprintf(out, "[HAL] UART init: port=%d, baud=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_UART_DEINIT:
+            fprintf(out, "[HAL] UART deinit: port=%d\n", a[0]);
+            break;
+        case NRX_LOG_UART_WRITE:
+            fprintf(out, "[HAL] UART write: port=%d, len=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_UART_OVERRUN:
+            fprintf(out, "[HAL] UART overrun: port=%d, dropped=%d bytes\n", a[0], a[1]);
+            break;
+        case NRX_LOG_UART_CLOSED:
+            fprintf(out, "[HAL] UART closed by device: port=%d, errno=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_I2C_INIT:
+            fprintf(out, "[HAL] I2C init: port=%d, freq=%d Hz\n", a[0], a[1]);
+            break;
+        case NRX_LOG_I2C_DEINIT:
+            fprintf(out, "[HAL] I2C deinit: port=%d\n", a[0]);
+            break;
+        case NRX_LOG_I2C_WRITE:
+            fprintf(out, "[HAL] I2C write: port=%d, addr=0x%02X, len=%d\n", a[0], (unsigned)a[1], a[2]);
+            break;
+        case NRX_LOG_I2C_READ:
+            fprintf(out, "[HAL] I2C read: port=%d, addr=0x%02X, len=%d\n", a[0], (unsigned)a[1], a[2]);
+            break;
+        case NRX_LOG_SPI_INIT:
+            fprintf(out, "[HAL] SPI init: port=%d, freq=%d Hz\n", a[0], a[1]);
+            break;
+        case NRX_LOG_SPI_DEINIT:
+            fprintf(out, "[HAL] SPI deinit: port=%d\n", a[0]);
+            break;
+        case NRX_LOG_SPI_TRANSFER:
+            fprintf(out, "[HAL] SPI transfer: port=%d, len=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_BUS_ERROR:
+            fprintf(out, "[HAL] %s error: port=%d, addr=0x%02X, errno=%d\n",
+                    event->text ? event->text : "Bus", a[0], (unsigned)a[1], a[2]);
+            break;
+        case NRX_LOG_MOTOR_INIT:
+            fprintf(out, "[HAL] Motor init: pwm=%d, dir1=%d, dir2=%d\n", a[0], a[1], a[2]);
+            break;
+        case NRX_LOG_MOTOR_POWER:
+            fprintf(out, "[HAL] Motor set power: pwm=%d, %.1f%%\n", a[0], v[0]);
+            break;
+        case NRX_LOG_MOTOR_STOP:
+            fprintf(out, "[HAL] Motor stop: pwm=%d\n", a[0]);
+            break;
+        case NRX_LOG_MOTOR_BRAKE:
+            fprintf(out, "[HAL] Motor brake: pwm=%d\n", a[0]);
+            break;
+        case NRX_LOG_SERVO_INIT:
+            fprintf(out, "[HAL] Servo init: pin=%d\n", a[0]);
+            break;
+        case NRX_LOG_SERVO_ANGLE:
+            fprintf(out, "[HAL] Servo set angle: pin=%d, %.1f deg (pulse: %.1f us)\n", a[0], v[0], v[1]);
+            break;
+        case NRX_LOG_ACTUATOR_REGISTRY_FULL:
+            fprintf(out, "[HAL] Actuator registry full, pin %d not covered by E-stop\n", a[0]);
+            break;
+        case NRX_LOG_ACTUATOR_COMMIT:
+            fprintf(out, "[HAL] Actuator commit: gpio=%d, pwm=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_SIM_COLLISION:
+            fprintf(out, "[SIM] Collision #%d at (%.3f, %.3f)\n", a[0], v[0], v[1]);
+            break;
+        case NRX_LOG_TRACE_STOP:
+            fprintf(out, "[TRACE] %s stopped: %d records, %d underruns\n", event->text, a[0], a[1]);
+            break;
+        case NRX_LOG_TRACE_DIVERGED:
+            fprintf(out, "[TRACE] Replay diverged from the trace: kind=%d, channel=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_MQTT_CONNECTED:
+            fprintf(out, "[MQTT] Connected: session present=%d, protocol=%d\n", a[0], a[1]);
+            break;
+        case NRX_LOG_MQTT_LOST:
+            fprintf(out, "[MQTT] Connection lost (%s, %d), retrying in %d ms\n", event->text, a[0], a[1]);
+            break;
+        case NRX_LOG_MQTT_REJECTED:
+            fprintf(out, "[MQTT] Broker refused packet type %d: reason 0x%02x\n", a[0], a[1]);
+            break;
+        case NRX_LOG_MQTT_JOURNAL:
+            fprintf(out, "[MQTT] Journal reopened: %d messages to forward, %d bytes cut off\n", a[0], a[1]);
+            break;
+        default:
+            fprintf(out, "[LOG] code=%u args=%d,%d,%d\n", event->code, a[0], a[1], a[2]);
+            break;
+    }
+}
+
+// Single consumer: only one thread may drain at a time
+size_t nrx_log_drain(void) {
+    FILE *out = g_log.output ? g_log.output : stdout;
+    size_t total = 0;
+    
+    for (nrx_log_ring_t *ring = atomic_load(&g_log.rings); ring; ring = ring->next) {
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        
+        while (tail != head) {
+            nrx_log_format(&ring->events[tail & (NRX_LOG_RING_SIZE - 1)], out);
+            tail++;
+            total++;
+        }
+        
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    
+    if (total > 0) {
+        fflush(out);
+        atomic_fetch_add(&g_log.drained, total);
+    }
+    
+    return total;
+}
+
+static void log_drain_task(void *context) {
+    (void)context;
+    nrx_log_drain();
+}
+
+nrx_task_t *nrx_log_start_drain(uint32_t frequency_hz) {
+    nrx_task_t *task = nrx_task_create("log_drain", log_drain_task, NULL, NRX_PRIORITY_LOW);
+    if (!task) return NULL;
+    
+    nrx_task_schedule_periodic(task, frequency_hz);
+    return task;
+}
+
+void nrx_log_get_stats(nrx_log_stats_t *stats) {
+    if (!stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    for (nrx_log_ring_t *ring = atomic_load(&g_log.rings); ring; ring = ring->next) {
+        stats->events_written += atomic_load(&ring->head) + atomic_load(&ring->dropped);
+        stats->events_dropped += atomic_load(&ring->dropped);
+    }
+    stats->events_drained = atomic_load(&g_log.drained);
+    stats->rings = atomic_load(&g_log.ring_count);
+}
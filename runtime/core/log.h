@@ -0,0 +1,105 @@
+#ifndef NEUROX_LOG_H
+#define NEUROX_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "scheduler.h"
+
+// Binary event log
+// Hot paths record fixed-size events (timestamp, numeric code, arguments)
+// into a per-thread single-producer ring without locks or syscalls. A
+// low-priority drain task formats them later, off the control path.
+
+// Event codes
+typedef enum {
+    // Safety
+    NRX_LOG_SAFETY_FAULT,       // arg0=fault, text=fault name
+    NRX_LOG_LIMIT_EXCEEDED,     // arg0=limit type, val0=value, val1=bound
+    NRX_LOG_MONITOR_TRIP,       // arg0=channel, arg1=violation mask
+    NRX_LOG_WATCHDOG_STALL,     // arg0=channel, text=task name
+    NRX_LOG_ESTOP,              // arg0=actuators stopped, arg1=latency us
+    NRX_LOG_ESTOP_RESET,
+    
+    // HAL
+    NRX_LOG_GPIO_INIT,          // arg0=pin, arg1=mode
+    NRX_LOG_GPIO_WRITE,         // arg0=pin, arg1=state
+    NRX_LOG_GPIO_TOGGLE,        // arg0=pin, arg1=new state
+    NRX_LOG_PWM_INIT,           // arg0=pin, arg1=frequency
+    NRX_LOG_PWM_DUTY,           // arg0=pin, val0=duty
+    NRX_LOG_PWM_STOP,           // arg0=pin
+    NRX_LOG_ADC_INIT,           // arg0=pin
+    NRX_LOG_UART_INIT,          // arg0=port, arg1=baud
+    NRX_LOG_UART_DEINIT,        // arg0=port
+    NRX_LOG_UART_WRITE,         // arg0=port, arg1=len
+    NRX_LOG_UART_OVERRUN,       // arg0=port, arg1=bytes dropped
+    NRX_LOG_UART_CLOSED,        // arg0=port, arg1=errno
+    NRX_LOG_I2C_INIT,           // arg0=port, arg1=frequency
+    NRX_LOG_I2C_DEINIT,         // arg0=port
+    NRX_LOG_I2C_WRITE,          // arg0=port, arg1=addr, arg2=len
+    NRX_LOG_I2C_READ,           // arg0=port, arg1=addr, arg2=len
+    NRX_LOG_SPI_INIT,           // arg0=port, arg1=frequency
+    NRX_LOG_SPI_DEINIT,         // arg0=port
+    NRX_LOG_SPI_TRANSFER,       // arg0=port, arg1=len
+    NRX_LOG_BUS_ERROR,          // arg0=port, arg1=addr, arg2=errno, text=bus
+    NRX_LOG_MOTOR_INIT,         // arg0=pwm, arg1=dir1, arg2=dir2
+    NRX_LOG_MOTOR_POWER,        // arg0=pwm pin, val0=power
+    NRX_LOG_MOTOR_STOP,         // arg0=pwm pin
+    NRX_LOG_MOTOR_BRAKE,        // arg0=pwm pin
+    NRX_LOG_SERVO_INIT,         // arg0=pin
+    NRX_LOG_SERVO_ANGLE,        // arg0=pin, val0=angle, val1=pulse us
+    NRX_LOG_ACTUATOR_REGISTRY_FULL, // arg0=pin
+    NRX_LOG_ACTUATOR_COMMIT,    // arg0=gpio writes, arg1=pwm writes
+    
+    // Simulation
+    NRX_LOG_SIM_COLLISION,      // arg0=collisions so far, val0=x, val1=y
+    NRX_LOG_TRACE_STOP,         // arg0=records, arg1=underruns, text=mode
+    NRX_LOG_TRACE_DIVERGED,     // arg0=kind, arg1=pin or port
+    
+    // Network
+    NRX_LOG_MQTT_CONNECTED,     // arg0=session present, arg1=protocol version
+    NRX_LOG_MQTT_LOST,          // arg0=errno or reason code, arg1=retry in ms, text=cause
+    NRX_LOG_MQTT_REJECTED,      // arg0=packet type, arg1=reason code
+    NRX_LOG_MQTT_JOURNAL,       // arg0=messages recovered, arg1=bytes cut off
+    
+    NRX_LOG_CODE_COUNT,
+} nrx_log_code_t;
+
+// Event record (40 bytes)
+typedef struct {
+    uint64_t timestamp_us;
+    uint16_t code;
+    uint16_t reserved;
+    int32_t arg[3];
+    float val[2];
+    const char *text;           // Must outlive the drain (string literals)
+} nrx_log_event_t;
+
+#define NRX_LOG_RING_SIZE 1024  // Events per thread, power of two
+
+// Recording (lock-free, no allocation after a thread's first event)
+void nrx_log_event(nrx_log_code_t code, int32_t arg0, int32_t arg1, int32_t arg2,
+                   float val0, float val1, const char *text);
+
+static inline void nrx_log(nrx_log_code_t code, int32_t arg0, int32_t arg1) {
+    nrx_log_event(code, arg0, arg1, 0, 0.0f, 0.0f, NULL);
+}
+
+// Draining
+void nrx_log_set_output(FILE *out);
+size_t nrx_log_drain(void);
+nrx_task_t *nrx_log_start_drain(uint32_t frequency_hz);
+void nrx_log_format(const nrx_log_event_t *event, FILE *out);
+
+// Statistics
+typedef struct {
+    uint64_t events_written;
+    uint64_t events_drained;
+    uint64_t events_dropped;    // Ring full, event discarded
+    uint32_t rings;             // Threads that have logged
+} nrx_log_stats_t;
+
+void nrx_log_get_stats(nrx_log_stats_t *stats);
+
+#endif // NEUROX_LOG_H
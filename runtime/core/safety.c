@@ -1,18 +1,161 @@
 #include "safety.h"
 #include "scheduler.h"
+#include "hal.h"
+#include "log.h"
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
+#include <math.h>
+#include <stdatomic.h>
 
 // Global safety state
 static struct {
     nrx_safety_config_t config;
-    nrx_safety_state_t state;
-    nrx_fault_code_t current_fault;
-    uint64_t last_watchdog_feed_us;
+    _Atomic nrx_safety_state_t state;
+    _Atomic nrx_fault_code_t current_fault;
     bool initialized;
+    
+    // E-stop measurements, written from the (async-signal-safe) E-stop path
+    // and reported later from nrx_safety_update()
+    atomic_uint estop_count;
+    atomic_uint estop_actuators;
+    atomic_uint estop_last_latency_us;
+    atomic_uint estop_worst_latency_us;
+    atomic_bool estop_report_pending;
+    
+    // Effective bounds per limit type (disabled limits are +/-INFINITY)
+    float type_min[NRX_LIMIT_TYPE_COUNT];
+    float type_max[NRX_LIMIT_TYPE_COUNT];
+    float type_rate[NRX_LIMIT_TYPE_COUNT];
 } g_safety;
 
+// Safety monitor channels, stored as structure-of-arrays so a pass is a
+// straight-line loop over NRX_SAFETY_MAX_CHANNELS floats. Unused channels
+// carry infinite bounds and NAN values, which never compare as violations.
+static struct {
+    float value[NRX_SAFETY_MAX_CHANNELS];
+    float prev[NRX_SAFETY_MAX_CHANNELS];
+    float min[NRX_SAFETY_MAX_CHANNELS];
+    float max[NRX_SAFETY_MAX_CHANNELS];
+    float rate[NRX_SAFETY_MAX_CHANNELS];
+    uint8_t flags[NRX_SAFETY_MAX_CHANNELS];
+    nrx_limit_type_t type[NRX_SAFETY_MAX_CHANNELS];
+    size_t count;
+    uint64_t last_pass_us;
+    nrx_safety_monitor_stats_t stats;
+} g_monitor;
+
+// Heartbeat channels. Per-channel data is kept in flat arrays indexed by
+// channel; heap[] orders channel ids by deadline and pos[] maps a channel
+// back to its heap slot so a feed only re-sifts that one slot.
+static struct {
+    uint64_t deadline_us[NRX_WATCHDOG_MAX_CHANNELS];
+    uint64_t timeout_us[NRX_WATCHDOG_MAX_CHANNELS];
+    const char *name[NRX_WATCHDOG_MAX_CHANNELS];
+    uint8_t heap[NRX_WATCHDOG_MAX_CHANNELS];
+    uint8_t pos[NRX_WATCHDOG_MAX_CHANNELS];
+    size_t count;
+    int stalled;
+} g_watchdog;
+
+static void watchdog_swap(size_t a, size_t b) {
+    uint8_t ca = g_watchdog.heap[a];
+    uint8_t cb = g_watchdog.heap[b];
+    g_watchdog.heap[a] = cb;
+    g_watchdog.heap[b] = ca;
+    g_watchdog.pos[cb] = (uint8_t)a;
+    g_watchdog.pos[ca] = (uint8_t)b;
+}
+
+static void watchdog_sift_up(size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (g_watchdog.deadline_us[g_watchdog.heap[parent]] <=
+            g_watchdog.deadline_us[g_watchdog.heap[i]]) {
+            break;
+        }
+        watchdog_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void watchdog_sift_down(size_t i) {
+    for (;;) {
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        size_t smallest = i;
+        
+        if (left < g_watchdog.count &&
+            g_watchdog.deadline_us[g_watchdog.heap[left]] <
+            g_watchdog.deadline_us[g_watchdog.heap[smallest]]) {
+            smallest = left;
+        }
+        if (right < g_watchdog.count &&
+            g_watchdog.deadline_us[g_watchdog.heap[right]] <
+            g_watchdog.deadline_us[g_watchdog.heap[smallest]]) {
+            smallest = right;
+        }
+        if (smallest == i) break;
+        
+        watchdog_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+static void safety_monitor_reset(void) {
+    memset(&g_monitor, 0, sizeof(g_monitor));
+    for (size_t i = 0; i < NRX_SAFETY_MAX_CHANNELS; i++) {
+        g_monitor.value[i] = NAN;
+        g_monitor.prev[i] = NAN;
+        g_monitor.min[i] = -INFINITY;
+        g_monitor.max[i] = INFINITY;
+        g_monitor.rate[i] = INFINITY;
+    }
+    g_monitor.stats.last_trip_channel = -1;
+}
+
+// Rebuild the per-type bounds from the limit table and push them to the
+// monitor channels. Called on configuration changes only.
+static void safety_sync_limits(void) {
+    for (int t = 0; t < NRX_LIMIT_TYPE_COUNT; t++) {
+        g_safety.type_min[t] = -INFINITY;
+        g_safety.type_max[t] = INFINITY;
+    }
+    
+    for (size_t i = 0; i < g_safety.config.limit_count; i++) {
+        nrx_limit_t *limit = &g_safety.config.limits[i];
+        if (limit->enabled && limit->type < NRX_LIMIT_TYPE_COUNT) {
+            g_safety.type_min[limit->type] = limit->min_value;
+            g_safety.type_max[limit->type] = limit->max_value;
+        }
+    }
+    
+    for (size_t i = 0; i < g_monitor.count; i++) {
+        nrx_limit_type_t type = g_monitor.type[i];
+        g_monitor.min[i] = g_safety.type_min[type];
+        g_monitor.max[i] = g_safety.type_max[type];
+        g_monitor.rate[i] = g_safety.type_rate[type];
+    }
+}
+
+// Enter the fault state without any formatting or I/O
+static void safety_raise(nrx_fault_code_t fault) {
+    g_safety.current_fault = fault;
+    nrx_safety_state_t expected = NRX_SAFETY_NORMAL;
+    if (!atomic_compare_exchange_strong(&g_safety.state, &expected, NRX_SAFETY_FAULT) &&
+        expected == NRX_SAFETY_WARNING) {
+        atomic_compare_exchange_strong(&g_safety.state, &expected, NRX_SAFETY_FAULT);
+    }
+    
+    // Critical faults trigger estop, before any handler can add latency
+    if (fault == NRX_FAULT_ESTOP || fault == NRX_FAULT_WATCHDOG) {
+        nrx_safety_estop();
+    }
+    
+    if (g_safety.config.fault_handler) {
+        g_safety.config.fault_handler(fault);
+    }
+}
+
 void nrx_safety_init(nrx_safety_config_t *config) {
     memset(&g_safety, 0, sizeof(g_safety));
     
@@ -23,29 +166,39 @@ void nrx_safety_init(nrx_safety_config_t *config) {
         g_safety.config.limits = NULL;
         g_safety.config.limit_count = 0;
         g_safety.config.enable_estop = true;
-        g_safety.config.enable_watchdog = false;
-        g_safety.config.watchdog_timeout_ms = 1000;
         g_safety.config.fault_handler = NULL;
         g_safety.config.estop_handler = NULL;
     }
     
     g_safety.state = NRX_SAFETY_NORMAL;
     g_safety.current_fault = NRX_FAULT_NONE;
-    g_safety.last_watchdog_feed_us = nrx_time_now_us();
+    
+    for (int t = 0; t < NRX_LIMIT_TYPE_COUNT; t++) {
+        g_safety.type_rate[t] = INFINITY;
+    }
+    safety_monitor_reset();
+    safety_sync_limits();
+    
+    memset(&g_watchdog, 0, sizeof(g_watchdog));
+    g_watchdog.stalled = -1;
+    
     g_safety.initialized = true;
 }
 
 void nrx_safety_update(void) {
     if (!g_safety.initialized) return;
     
-    // Check watchdog
-    if (g_safety.config.enable_watchdog) {
-        uint64_t now = nrx_time_now_us();
-        uint64_t elapsed_ms = (now - g_safety.last_watchdog_feed_us) / 1000;
-        
-        if (elapsed_ms > g_safety.config.watchdog_timeout_ms) {
-            nrx_safety_fault(NRX_FAULT_WATCHDOG, "Watchdog timeout");
-        }
+    // Report the last E-stop outside the stopping path
+    if (atomic_exchange(&g_safety.estop_report_pending, false)) {
+        nrx_log(NRX_LOG_ESTOP, (int32_t)atomic_load(&g_safety.estop_actuators),
+                (int32_t)atomic_load(&g_safety.estop_last_latency_us));
+    }
+    
+    // Check per-task heartbeats
+    int stalled = nrx_safety_watchdog_check(nrx_time_now_us());
+    if (stalled >= 0) {
+        nrx_log_event(NRX_LOG_WATCHDOG_STALL, stalled, 0, 0, 0.0f, 0.0f, g_watchdog.name[stalled]);
+        safety_raise(NRX_FAULT_WATCHDOG);
     }
 }
 
@@ -57,20 +210,24 @@ void nrx_safety_set_state(nrx_safety_state_t state) {
     g_safety.state = state;
 }
 
-void nrx_safety_fault(nrx_fault_code_t fault, const char *message) {
-    g_safety.current_fault = fault;
-    g_safety.state = NRX_SAFETY_FAULT;
-    
-    fprintf(stderr, "[SAFETY FAULT] Code %d: %s\n", fault, message ? message : "Unknown");
-    
-    if (g_safety.config.fault_handler) {
-        g_safety.config.fault_handler(fault);
-    }
+// The log drain formats records later, so they carry the fault's static
+// name rather than any caller text
+static const char *const fault_names[] = {
+    [NRX_FAULT_NONE] = "none",
+    [NRX_FAULT_LIMIT_EXCEEDED] = "limit exceeded",
+    [NRX_FAULT_WATCHDOG] = "watchdog",
+    [NRX_FAULT_ESTOP] = "emergency stop",
+    [NRX_FAULT_SENSOR] = "sensor",
+    [NRX_FAULT_MOTOR] = "motor",
+    [NRX_FAULT_COMMUNICATION] = "communication",
+    [NRX_FAULT_POWER] = "power",
+};
+
+void nrx_safety_fault(nrx_fault_code_t fault) {
+    const char *name = (size_t)fault < sizeof(fault_names) / sizeof(fault_names[0]) ? fault_names[fault] : NULL;
+    nrx_log_event(NRX_LOG_SAFETY_FAULT, fault, 0, 0, 0.0f, 0.0f, name);
     
-    // Critical faults trigger estop
-    if (fault == NRX_FAULT_ESTOP || fault == NRX_FAULT_WATCHDOG) {
-        nrx_safety_estop();
-    }
+    safety_raise(fault);
 }
 
 void nrx_safety_clear_fault(void) {
@@ -84,24 +241,38 @@ nrx_fault_code_t nrx_safety_get_fault(void) {
     return g_safety.current_fault;
 }
 
+// Async-signal-safe: no locks, no allocation, no stdio. Actuators are
+// driven off before anything else runs, including the user handler.
 void nrx_safety_estop(void) {
-    g_safety.state = NRX_SAFETY_ESTOP;
-    g_safety.current_fault = NRX_FAULT_ESTOP;
+    uint64_t trigger_us = nrx_time_now_us();
+    
+    atomic_store(&g_safety.state, NRX_SAFETY_ESTOP);
+    atomic_store(&g_safety.current_fault, NRX_FAULT_ESTOP);
+    
+    size_t stopped = nrx_hal_estop_all();
+    uint32_t latency = (uint32_t)(nrx_time_now_us() - trigger_us);
+    
+    atomic_fetch_add(&g_safety.estop_count, 1);
+    atomic_store(&g_safety.estop_actuators, (unsigned)stopped);
+    atomic_store(&g_safety.estop_last_latency_us, latency);
     
-    fprintf(stderr, "[EMERGENCY STOP] System halted\n");
+    unsigned worst = atomic_load(&g_safety.estop_worst_latency_us);
+    while (latency > worst &&
+           !atomic_compare_exchange_weak(&g_safety.estop_worst_latency_us, &worst, latency)) {
+    }
+    atomic_store(&g_safety.estop_report_pending, true);
     
     if (g_safety.config.estop_handler) {
         g_safety.config.estop_handler();
     }
-    
-    // TODO: Stop all motors, disable actuators
 }
 
 void nrx_safety_estop_reset(void) {
     if (g_safety.state == NRX_SAFETY_ESTOP) {
         g_safety.state = NRX_SAFETY_NORMAL;
         g_safety.current_fault = NRX_FAULT_NONE;
-        fprintf(stderr, "[SAFETY] E-stop reset\n");
+        nrx_hal_estop_release();
+        nrx_log(NRX_LOG_ESTOP_RESET, 0, 0);
     }
 }
 
@@ -109,19 +280,26 @@ bool nrx_safety_is_estopped(void) {
     return g_safety.state == NRX_SAFETY_ESTOP;
 }
 
+void nrx_safety_estop_get_stats(nrx_estop_stats_t *stats) {
+    if (!stats) return;
+    
+    stats->count = atomic_load(&g_safety.estop_count);
+    stats->actuators_stopped = atomic_load(&g_safety.estop_actuators);
+    stats->last_latency_us = atomic_load(&g_safety.estop_last_latency_us);
+    stats->worst_latency_us = atomic_load(&g_safety.estop_worst_latency_us);
+}
+
 bool nrx_safety_check_limit(nrx_limit_type_t type, float value) {
-    for (size_t i = 0; i < g_safety.config.limit_count; i++) {
-        nrx_limit_t *limit = &g_safety.config.limits[i];
-        
-        if (limit->type == type && limit->enabled) {
-            if (value < limit->min_value || value > limit->max_value) {
-                char msg[128];
-                snprintf(msg, sizeof(msg), "Limit exceeded: type=%d, value=%f, range=[%f, %f]",
-                        type, value, limit->min_value, limit->max_value);
-                nrx_safety_fault(NRX_FAULT_LIMIT_EXCEEDED, msg);
-                return false;
-            }
-        }
+    if (type >= NRX_LIMIT_TYPE_COUNT) return true;
+    
+    float min_val = g_safety.type_min[type];
+    float max_val = g_safety.type_max[type];
+    
+    if (value < min_val || value > max_val) {
+        nrx_log_event(NRX_LOG_LIMIT_EXCEEDED, type, 0, 0, value,
+                      value < min_val ? min_val : max_val, NULL);
+        safety_raise(NRX_FAULT_LIMIT_EXCEEDED);
+        return false;
     }
     
     return true;
@@ -134,6 +312,7 @@ void nrx_safety_set_limit(nrx_limit_type_t type, float min_val, float max_val) {
             g_safety.config.limits[i].min_value = min_val;
             g_safety.config.limits[i].max_value = max_val;
             g_safety.config.limits[i].enabled = true;
+            safety_sync_limits();
             return;
         }
     }
@@ -149,15 +328,153 @@ void nrx_safety_set_limit(nrx_limit_type_t type, float min_val, float max_val) {
     g_safety.config.limits[g_safety.config.limit_count].enabled = true;
     
     g_safety.config.limit_count = new_count;
+    safety_sync_limits();
+}
+
+void nrx_safety_set_rate_limit(nrx_limit_type_t type, float max_rate_per_s) {
+    if (type >= NRX_LIMIT_TYPE_COUNT) return;
+    
+    g_safety.type_rate[type] = max_rate_per_s > 0 ? max_rate_per_s : INFINITY;
+    safety_sync_limits();
+}
+
+int nrx_safety_watchdog_add(const char *name, uint32_t timeout_ms) {
+    if (g_watchdog.count >= NRX_WATCHDOG_MAX_CHANNELS || timeout_ms == 0) {
+        return -1;
+    }
+    
+    size_t channel = g_watchdog.count++;
+    g_watchdog.name[channel] = name;
+    g_watchdog.timeout_us[channel] = (uint64_t)timeout_ms * 1000;
+    g_watchdog.deadline_us[channel] = nrx_time_now_us() + g_watchdog.timeout_us[channel];
+    g_watchdog.heap[channel] = (uint8_t)channel;
+    g_watchdog.pos[channel] = (uint8_t)channel;
+    watchdog_sift_up(channel);
+    
+    return (int)channel;
+}
+
+int nrx_safety_watchdog_attach(nrx_task_t *task, uint32_t timeout_ms) {
+    if (!task) return -1;
+    
+    task->watchdog_channel = nrx_safety_watchdog_add(task->name, timeout_ms);
+    return task->watchdog_channel;
+}
+
+void nrx_safety_heartbeat(int channel) {
+    if (channel < 0 || (size_t)channel >= g_watchdog.count) return;
+    
+    // A feed usually moves the deadline later, but a stalled channel is
+    // parked at UINT64_MAX and comes back earlier
+    g_watchdog.deadline_us[channel] = nrx_time_now_us() + g_watchdog.timeout_us[channel];
+    watchdog_sift_up(g_watchdog.pos[channel]);
+    watchdog_sift_down(g_watchdog.pos[channel]);
+}
+
+int nrx_safety_watchdog_check(uint64_t now_us) {
+    if (g_watchdog.count == 0) return -1;
+    
+    uint8_t channel = g_watchdog.heap[0];
+    if (now_us <= g_watchdog.deadline_us[channel]) return -1;
+    
+    // Park the stalled channel until its next heartbeat so it reports once
+    g_watchdog.deadline_us[channel] = UINT64_MAX;
+    watchdog_sift_down(0);
+    g_watchdog.stalled = channel;
+    
+    return channel;
+}
+
+const char *nrx_safety_watchdog_stalled(void) {
+    if (g_watchdog.stalled < 0) return NULL;
+    return g_watchdog.name[g_watchdog.stalled];
+}
+
+// Real-time safety monitor
+int nrx_safety_channel_add(nrx_limit_type_t type) {
+    if (type >= NRX_LIMIT_TYPE_COUNT || g_monitor.count >= NRX_SAFETY_MAX_CHANNELS) {
+        return -1;
+    }
+    
+    size_t channel = g_monitor.count++;
+    g_monitor.type[channel] = type;
+    g_monitor.min[channel] = g_safety.type_min[type];
+    g_monitor.max[channel] = g_safety.type_max[type];
+    g_monitor.rate[channel] = g_safety.type_rate[type];
+    
+    return (int)channel;
+}
+
+void nrx_safety_command(int channel, float value) {
+    if (channel < 0 || channel >= NRX_SAFETY_MAX_CHANNELS) return;
+    g_monitor.value[channel] = value;
+}
+
+uint32_t nrx_safety_monitor_run(uint64_t now_us) {
+    uint64_t start = nrx_time_now_us();
+    
+    // A pass with no time since the last one cannot measure a rate; it
+    // checks bounds only and leaves the rate baseline where it was
+    bool timed = !g_monitor.stats.passes || now_us > g_monitor.last_pass_us;
+    float dt = g_monitor.stats.passes && timed ? (float)(now_us - g_monitor.last_pass_us) * 1e-6f
+                                               : INFINITY;
+    
+    // Branch-free bound and rate-of-change checks over every channel
+    for (size_t i = 0; i < NRX_SAFETY_MAX_CHANNELS; i++) {
+        float v = g_monitor.value[i];
+        float delta = fabsf(v - g_monitor.prev[i]);
+        g_monitor.flags[i] = (uint8_t)((v < g_monitor.min[i]) |
+                                       (v > g_monitor.max[i]) |
+                                       (delta > g_monitor.rate[i] * dt));
+    }
+    if (timed) {
+        memcpy(g_monitor.prev, g_monitor.value, sizeof(g_monitor.prev));
+        g_monitor.last_pass_us = now_us;
+    }
+    
+    uint32_t mask = 0;
+    for (size_t i = 0; i < NRX_SAFETY_MAX_CHANNELS; i++) {
+        mask |= (uint32_t)g_monitor.flags[i] << i;
+    }
+    
+    // Trip on newly violating channels only, so a sustained violation
+    // raises one fault rather than one per pass
+    uint32_t tripped = mask & ~g_monitor.stats.violation_mask;
+    g_monitor.stats.violation_mask = mask;
+    g_monitor.stats.passes++;
+    
+    if (tripped) {
+        g_monitor.stats.trips++;
+        g_monitor.stats.last_trip_channel = __builtin_ctz(tripped);
+        nrx_log(NRX_LOG_MONITOR_TRIP, g_monitor.stats.last_trip_channel, (int32_t)mask);
+        safety_raise(NRX_FAULT_LIMIT_EXCEEDED);
+    }
+    
+    uint32_t elapsed = (uint32_t)(nrx_time_now_us() - start);
+    g_monitor.stats.last_pass_us = elapsed;
+    if (elapsed > g_monitor.stats.worst_pass_us) {
+        g_monitor.stats.worst_pass_us = elapsed;
+    }
+    
+    return mask;
 }
 
-void nrx_safety_watchdog_feed(void) {
-    g_safety.last_watchdog_feed_us = nrx_time_now_us();
+static void safety_monitor_task(void *context) {
+    (void)context;
+    nrx_safety_monitor_run(nrx_time_now_us());
+}
+
+nrx_task_t *nrx_safety_monitor_start(uint32_t frequency_hz) {
+    nrx_task_t *task = nrx_task_create("safety_monitor", safety_monitor_task,
+                                       NULL, NRX_PRIORITY_HIGH);
+    if (!task) return NULL;
+    
+    nrx_task_schedule_critical(task, frequency_hz);
+    return task;
 }
 
-void nrx_safety_watchdog_enable(bool enable) {
-    g_safety.config.enable_watchdog = enable;
-    if (enable) {
-        nrx_safety_watchdog_feed();
+void nrx_safety_monitor_get_stats(nrx_safety_monitor_stats_t *stats) {
+    if (stats) {
+        *stats = g_monitor.stats;
     }
 }
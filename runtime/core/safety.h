@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "scheduler.h"
 
 // Safety state
 typedef enum {
@@ -30,7 +31,9 @@ typedef enum {
     NRX_LIMIT_SPEED,
     NRX_LIMIT_TURN_RATE,
     NRX_LIMIT_ACCELERATION,
-    NRX_LIMIT_POWER,
+    NRX_LIMIT_POWER,            // Motor power, signed percent
+    NRX_LIMIT_ANGLE,            // Servo angle, degrees
+    NRX_LIMIT_TYPE_COUNT,
 } nrx_limit_type_t;
 
 // Limit definition
@@ -47,8 +50,6 @@ typedef struct {
     size_t limit_count;
     
     bool enable_estop;
-    bool enable_watchdog;
-    uint32_t watchdog_timeout_ms;
     
     void (*fault_handler)(nrx_fault_code_t fault);
     void (*estop_handler)(void);
@@ -63,7 +64,7 @@ nrx_safety_state_t nrx_safety_get_state(void);
 void nrx_safety_set_state(nrx_safety_state_t state);
 
 // Fault handling
-void nrx_safety_fault(nrx_fault_code_t fault, const char *message);
+void nrx_safety_fault(nrx_fault_code_t fault);
 void nrx_safety_clear_fault(void);
 nrx_fault_code_t nrx_safety_get_fault(void);
 
@@ -72,12 +73,53 @@ void nrx_safety_estop(void);
 void nrx_safety_estop_reset(void);
 bool nrx_safety_is_estopped(void);
 
+// E-stop latency, measured from trigger to the last actuator driven off
+typedef struct {
+    uint32_t count;              // E-stops triggered since init
+    uint32_t actuators_stopped;  // Actuators stopped by the last E-stop
+    uint32_t last_latency_us;
+    uint32_t worst_latency_us;
+} nrx_estop_stats_t;
+
+void nrx_safety_estop_get_stats(nrx_estop_stats_t *stats);
+
 // Limit checking
 bool nrx_safety_check_limit(nrx_limit_type_t type, float value);
 void nrx_safety_set_limit(nrx_limit_type_t type, float min_val, float max_val);
 
-// Watchdog
-void nrx_safety_watchdog_feed(void);
-void nrx_safety_watchdog_enable(bool enable);
+void nrx_safety_set_rate_limit(nrx_limit_type_t type, float max_rate_per_s);
+
+// Per-task heartbeat channels, each with its own timeout. Deadlines are kept
+// in a min-heap so the check only looks at the earliest one.
+#define NRX_WATCHDOG_MAX_CHANNELS 32
+
+int nrx_safety_watchdog_add(const char *name, uint32_t timeout_ms);
+int nrx_safety_watchdog_attach(nrx_task_t *task, uint32_t timeout_ms);
+void nrx_safety_heartbeat(int channel);
+int nrx_safety_watchdog_check(uint64_t now_us);  // Returns stalled channel or -1
+const char *nrx_safety_watchdog_stalled(void);
+
+// Real-time safety monitor
+// Actuator commands are recorded per channel and checked in one pass over
+// fixed-size SoA arrays, so a pass costs the same no matter how many
+// channels are in use. The pass never allocates or touches stdio.
+// Every motor and servo gets a channel when it is initialized (power and
+// angle limits respectively) and feeds it on each command, direct or staged.
+#define NRX_SAFETY_MAX_CHANNELS 32
+
+typedef struct {
+    uint32_t passes;           // Monitor passes executed
+    uint32_t trips;            // Passes that raised a new violation
+    uint32_t violation_mask;   // Channels violating on the last pass
+    int32_t last_trip_channel; // Lowest channel of the last trip (-1 = none)
+    uint32_t last_pass_us;     // Duration of the last pass
+    uint32_t worst_pass_us;    // Worst pass duration observed
+} nrx_safety_monitor_stats_t;
+
+int nrx_safety_channel_add(nrx_limit_type_t type);
+void nrx_safety_command(int channel, float value);
+uint32_t nrx_safety_monitor_run(uint64_t now_us);
+nrx_task_t *nrx_safety_monitor_start(uint32_t frequency_hz);
+void nrx_safety_monitor_get_stats(nrx_safety_monitor_stats_t *stats);
 
 #endif // NEUROX_SAFETY_H
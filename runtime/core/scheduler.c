@@ -1,43 +1,77 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "scheduler.h"
+#include "safety.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <stdatomic.h>
 
 // Platform-specific timing (Linux implementation)
 #ifdef __linux__
 #include <sys/time.h>
 #include <unistd.h>
 
-uint64_t nrx_time_now_us(void) {
+static uint64_t platform_now_us(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
 }
 
-void nrx_delay_us(uint32_t us) {
-    usleep(us);
-}
-
-void nrx_delay_ms(uint32_t ms) {
-    usleep(ms * 1000);
+static void platform_delay_us(uint32_t us) {
+    struct timespec ts = { us / 1000000u, (long)(us % 1000000u) * 1000L };
+    nanosleep(&ts, NULL);
 }
 #else
 // Embedded platform stubs
-uint64_t nrx_time_now_us(void) {
+static uint64_t platform_now_us(void) {
     // TODO: Implement for embedded platform
     return 0;
 }
 
-void nrx_delay_us(uint32_t us) {
+static void platform_delay_us(uint32_t us) {
     // TODO: Implement for embedded platform
+    (void)us;
+}
+#endif
+
+// Virtual time: delays advance the counter instead of sleeping
+static struct {
+    atomic_bool enabled;
+    atomic_uint_fast64_t now_us;
+} g_virtual_time;
+
+void nrx_time_set_virtual(bool enabled, uint64_t start_us) {
+    atomic_store(&g_virtual_time.now_us, start_us);
+    atomic_store(&g_virtual_time.enabled, enabled);
+}
+
+bool nrx_time_is_virtual(void) {
+    return atomic_load_explicit(&g_virtual_time.enabled, memory_order_relaxed);
+}
+
+void nrx_time_advance_us(uint64_t us) {
+    atomic_fetch_add(&g_virtual_time.now_us, us);
+}
+
+uint64_t nrx_time_now_us(void) {
+    if (atomic_load_explicit(&g_virtual_time.enabled, memory_order_relaxed)) {
+        return atomic_load_explicit(&g_virtual_time.now_us, memory_order_relaxed);
+    }
+    return platform_now_us();
+}
+
+void nrx_delay_us(uint32_t us) {
+    if (atomic_load_explicit(&g_virtual_time.enabled, memory_order_relaxed)) {
+        atomic_fetch_add(&g_virtual_time.now_us, us);
+        return;
+    }
+    platform_delay_us(us);
 }
 
 void nrx_delay_ms(uint32_t ms) {
-    // TODO: Implement for embedded platform
+    nrx_delay_us(ms * 1000);
 }
-#endif
 
 // Global scheduler state
 static struct {
@@ -48,6 +82,80 @@ static struct {
     nrx_scheduler_stats_t stats;
 } g_scheduler;
 
+// Deferred call queue: bounded multi-producer/single-consumer ring where
+// each cell's sequence number says whether it is free or filled. Sequences
+// are stored relative to the cell index so the zeroed static state is
+// already a valid empty queue and deferring works before scheduler init.
+typedef struct {
+    atomic_size_t sequence;
+    nrx_deferred_fn_t fn;
+    void *context;
+    uint64_t arg;
+    uint64_t timestamp_ns;
+} nrx_deferred_cell_t;
+
+static struct {
+    nrx_deferred_cell_t cells[NRX_DEFER_QUEUE_SIZE];
+    atomic_size_t enqueue_pos;
+    size_t dequeue_pos;
+    atomic_uint dropped;
+} g_deferred;
+
+int nrx_scheduler_defer(nrx_deferred_fn_t fn, void *context, uint64_t arg, uint64_t timestamp_ns) {
+    if (!fn) return -1;
+    
+    size_t pos = atomic_load_explicit(&g_deferred.enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        size_t index = pos & (NRX_DEFER_QUEUE_SIZE - 1);
+        nrx_deferred_cell_t *cell = &g_deferred.cells[index];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire) + index;
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_deferred.enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                cell->fn = fn;
+                cell->context = context;
+                cell->arg = arg;
+                cell->timestamp_ns = timestamp_ns;
+                atomic_store_explicit(&cell->sequence, pos + 1 - index, memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add(&g_deferred.dropped, 1);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&g_deferred.enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+size_t nrx_scheduler_run_deferred(void) {
+    size_t count = 0;
+    
+    for (;;) {
+        size_t pos = g_deferred.dequeue_pos;
+        size_t index = pos & (NRX_DEFER_QUEUE_SIZE - 1);
+        nrx_deferred_cell_t *cell = &g_deferred.cells[index];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire) + index;
+        if (seq != pos + 1) break;
+        
+        nrx_deferred_fn_t fn = cell->fn;
+        void *context = cell->context;
+        uint64_t arg = cell->arg;
+        uint64_t timestamp_ns = cell->timestamp_ns;
+        
+        atomic_store_explicit(&cell->sequence, pos + NRX_DEFER_QUEUE_SIZE - index, memory_order_release);
+        g_deferred.dequeue_pos = pos + 1;
+        
+        fn(context, arg, timestamp_ns);
+        count++;
+    }
+    
+    g_scheduler.stats.deferred_run += (uint32_t)count;
+    return count;
+}
+
 void nrx_scheduler_init(nrx_scheduler_config_t *config) {
     memset(&g_scheduler, 0, sizeof(g_scheduler));
     
@@ -80,14 +188,32 @@ nrx_task_t *nrx_task_create(const char *name, nrx_task_fn_t function,
     task->context = context;
     task->priority = priority;
     task->state = NRX_TASK_IDLE;
+    task->watchdog_channel = -1;
     task->next = NULL;
     
     return task;
 }
 
+// Take a task off whichever list holds it, so rescheduling never links it
+// in twice
+static void task_unlink(nrx_task_t *task) {
+    for (int prio = 0; prio < NRX_PRIORITY_COUNT; prio++) {
+        nrx_task_t **current = &g_scheduler.task_lists[prio];
+        while (*current) {
+            if (*current == task) {
+                *current = task->next;
+                task->next = NULL;
+                return;
+            }
+            current = &(*current)->next;
+        }
+    }
+}
+
 void nrx_task_schedule_periodic(nrx_task_t *task, uint32_t frequency_hz) {
     if (!task || frequency_hz == 0) return;
     
+    task_unlink(task);
     task->period_us = 1000000 / frequency_hz;
     task->next_run_us = nrx_time_now_us() + task->period_us;
     task->state = NRX_TASK_READY;
@@ -106,6 +232,20 @@ void nrx_task_schedule_periodic(nrx_task_t *task, uint32_t frequency_hz) {
     }
 }
 
+// Schedule ahead of every other task, e.g. the safety monitor
+void nrx_task_schedule_critical(nrx_task_t *task, uint32_t frequency_hz) {
+    if (!task || frequency_hz == 0) return;
+    
+    task_unlink(task);
+    task->priority = NRX_PRIORITY_HIGH;
+    task->period_us = 1000000 / frequency_hz;
+    task->next_run_us = nrx_time_now_us() + task->period_us;
+    task->state = NRX_TASK_READY;
+    
+    task->next = g_scheduler.task_lists[NRX_PRIORITY_HIGH];
+    g_scheduler.task_lists[NRX_PRIORITY_HIGH] = task;
+}
+
 void nrx_task_suspend(nrx_task_t *task) {
     if (task) {
         task->state = NRX_TASK_SUSPENDED;
@@ -121,22 +261,14 @@ void nrx_task_resume(nrx_task_t *task) {
 void nrx_task_delete(nrx_task_t *task) {
     if (!task) return;
     
-    // Remove from task list
-    for (int prio = 0; prio < NRX_PRIORITY_COUNT; prio++) {
-        nrx_task_t **current = &g_scheduler.task_lists[prio];
-        while (*current) {
-            if (*current == task) {
-                *current = task->next;
-                break;
-            }
-            current = &(*current)->next;
-        }
-    }
-    
+    task_unlink(task);
     free(task);
 }
 
 static void nrx_scheduler_tick(void) {
+    // Events handed over since the last tick run before any task
+    nrx_scheduler_run_deferred();
+    
     uint64_t now = nrx_time_now_us();
     
     // Iterate through priority levels
@@ -175,6 +307,10 @@ static void nrx_scheduler_tick(void) {
                 task->next_run_us += task->period_us;
                 task->state = NRX_TASK_READY;
                 
+                if (task->watchdog_channel >= 0) {
+                    nrx_safety_heartbeat(task->watchdog_channel);
+                }
+                
                 g_scheduler.stats.tasks_executed++;
                 
                 // Check for missed deadline
@@ -216,6 +352,7 @@ void nrx_scheduler_stop(void) {
 void nrx_scheduler_get_stats(nrx_scheduler_stats_t *stats) {
     if (stats) {
         *stats = g_scheduler.stats;
+        stats->deferred_dropped = atomic_load(&g_deferred.dropped);
     }
 }
 
@@ -45,6 +45,9 @@ typedef struct nrx_task_t {
     uint32_t worst_exec_us;    // Worst execution time
     uint32_t avg_exec_us;      // Average execution time
     
+    // Safety watchdog channel fed after each run (-1 = none)
+    int32_t watchdog_channel;
+    
     // Linked list
     struct nrx_task_t *next;
 } nrx_task_t;
@@ -66,15 +69,35 @@ void nrx_scheduler_stop(void);
 nrx_task_t *nrx_task_create(const char *name, nrx_task_fn_t function, 
                             void *context, nrx_priority_t priority);
 void nrx_task_schedule_periodic(nrx_task_t *task, uint32_t frequency_hz);
+void nrx_task_schedule_critical(nrx_task_t *task, uint32_t frequency_hz);
 void nrx_task_suspend(nrx_task_t *task);
 void nrx_task_resume(nrx_task_t *task);
 void nrx_task_delete(nrx_task_t *task);
 
+// Deferred calls
+// Other threads (the I/O thread, drivers) hand work to task context through
+// a bounded lock-free queue that the scheduler drains at the start of every
+// tick. Safe to call from any thread; returns -1 when the queue is full.
+#define NRX_DEFER_QUEUE_SIZE 4096
+
+typedef void (*nrx_deferred_fn_t)(void *context, uint64_t arg, uint64_t timestamp_ns);
+
+int nrx_scheduler_defer(nrx_deferred_fn_t fn, void *context, uint64_t arg, uint64_t timestamp_ns);
+size_t nrx_scheduler_run_deferred(void);
+
 // Timing utilities
 uint64_t nrx_time_now_us(void);
 void nrx_delay_us(uint32_t us);
 void nrx_delay_ms(uint32_t ms);
 
+// Virtual time
+// While enabled, nrx_time_now_us() reads a counter that only moves when a
+// delay or nrx_time_advance_us() moves it, so a program runs as fast as the
+// CPU allows on a reproducible timeline. The simulator turns this on.
+void nrx_time_set_virtual(bool enabled, uint64_t start_us);
+bool nrx_time_is_virtual(void);
+void nrx_time_advance_us(uint64_t us);
+
 // Statistics
 typedef struct {
     uint32_t tasks_scheduled;
@@ -82,6 +105,8 @@ typedef struct {
     uint32_t missed_deadlines;
     uint32_t max_jitter_us;
     uint32_t cpu_usage_percent;
+    uint32_t deferred_run;
+    uint32_t deferred_dropped;
 } nrx_scheduler_stats_t;
 
 void nrx_scheduler_get_stats(nrx_scheduler_stats_t *stats);
@@ -30,13 +30,33 @@ typedef enum {
 } nrx_gpio_state_t;
 
 void nrx_gpio_init(uint8_t pin, nrx_gpio_mode_t mode);
-void nrx_gpio_write(uint8_t pin, nrx_gpio_state_t state);
+// Output writes return 0, or -1 while an E-stop is latched
+int nrx_gpio_write(uint8_t pin, nrx_gpio_state_t state);
 nrx_gpio_state_t nrx_gpio_read(uint8_t pin);
-void nrx_gpio_toggle(uint8_t pin);
+int nrx_gpio_toggle(uint8_t pin);
+
+// GPIO edge events
+// Input lines report edges from the kernel instead of being polled. Edges
+// are counted on the runtime I/O thread; callbacks run later in scheduler
+// context with the kernel's CLOCK_MONOTONIC timestamp of the edge. A NULL
+// callback only counts edges, which is all an encoder needs.
+typedef enum {
+    NRX_GPIO_EDGE_NONE = 0,
+    NRX_GPIO_EDGE_RISING = 1,
+    NRX_GPIO_EDGE_FALLING = 2,
+    NRX_GPIO_EDGE_BOTH = 3,
+} nrx_gpio_edge_t;
+
+typedef void (*nrx_gpio_edge_cb_t)(uint8_t pin, nrx_gpio_edge_t edge,
+                                   uint64_t timestamp_ns, void *user_data);
+
+int nrx_gpio_on_edge(uint8_t pin, nrx_gpio_edge_t edges, nrx_gpio_edge_cb_t callback, void *user_data);
+uint32_t nrx_gpio_edge_count(uint8_t pin);
 
 // PWM (for motors, servos)
 void nrx_pwm_init(uint8_t pin, uint32_t frequency_hz);
-void nrx_pwm_set_duty(uint8_t pin, float duty_percent);
+int nrx_pwm_set_duty(uint8_t pin, float duty_percent);    // -1 while E-stopped
+float nrx_pwm_get_duty(uint8_t pin);
 void nrx_pwm_stop(uint8_t pin);
 
 // ADC (for analog sensors)
@@ -49,10 +69,18 @@ typedef struct nrx_uart_t nrx_uart_t;
 
 nrx_uart_t *nrx_uart_init(uint8_t port, uint32_t baud_rate);
 void nrx_uart_deinit(nrx_uart_t *uart);
-int nrx_uart_write(nrx_uart_t *uart, const uint8_t *data, size_t len);
+int nrx_uart_write(nrx_uart_t *uart, const uint8_t *data, size_t len);  // -1 once the device is gone
 int nrx_uart_read(nrx_uart_t *uart, uint8_t *buffer, size_t len);
 int nrx_uart_available(nrx_uart_t *uart);
 
+// Zero-copy receive
+// Received bytes land in a per-port ring filled by the runtime I/O thread.
+// peek returns a pointer into the ring and how many bytes are contiguous
+// there (on Linux the ring is mapped twice, so that is every byte
+// received); the bytes stay valid until consumed. One consumer per port.
+size_t nrx_uart_peek(nrx_uart_t *uart, const uint8_t **data);
+void nrx_uart_consume(nrx_uart_t *uart, size_t len);
+
 // I2C
 typedef struct nrx_i2c_t nrx_i2c_t;
 
@@ -68,6 +96,51 @@ nrx_spi_t *nrx_spi_init(uint8_t port, uint32_t frequency_hz);
 void nrx_spi_deinit(nrx_spi_t *spi);
 int nrx_spi_transfer(nrx_spi_t *spi, const uint8_t *tx_data, uint8_t *rx_data, size_t len);
 
+// Asynchronous bus transactions
+// Each bus has a queue drained by its own worker thread, which batches
+// queued transactions into one I2C_RDWR or SPI_IOC_MESSAGE(N) ioctl. The
+// caller owns the transaction and its buffers until it completes; nothing
+// is allocated per transfer. Completion sets the status, which can be
+// polled or waited on like a future, and then defers the callback (if any)
+// into scheduler context. A transfer with a callback must stay valid until
+// the callback has run.
+//
+// I2C: write tx, then read rx after a repeated start (either may be empty).
+// SPI: full duplex, clocking max(tx_len, rx_len) bytes. tx is padded with
+// zeros, and input past rx_len is dropped; either may be NULL.
+//
+// A batch that fails gives every transfer in it the same error. Nothing is
+// retried, since some of it may already have reached the device.
+typedef enum {
+    NRX_BUS_IDLE,
+    NRX_BUS_QUEUED,
+    NRX_BUS_DONE,
+    NRX_BUS_ERROR,
+} nrx_bus_status_t;
+
+typedef struct nrx_bus_xfer_t nrx_bus_xfer_t;
+typedef void (*nrx_bus_done_cb_t)(nrx_bus_xfer_t *xfer, void *user_data);
+
+struct nrx_bus_xfer_t {
+    uint8_t addr;               // I2C 7-bit address, ignored for SPI
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    nrx_bus_done_cb_t callback;
+    void *user_data;
+    
+    // Owned by the bus while queued
+    _Atomic nrx_bus_status_t status;
+    int result;                 // Bytes transferred, or -errno
+    nrx_bus_xfer_t *next;
+};
+
+int nrx_i2c_submit(nrx_i2c_t *i2c, nrx_bus_xfer_t *xfer);
+int nrx_spi_submit(nrx_spi_t *spi, nrx_bus_xfer_t *xfer);
+bool nrx_bus_xfer_done(const nrx_bus_xfer_t *xfer);
+int nrx_bus_xfer_wait(nrx_bus_xfer_t *xfer);   // Blocks, returns result
+
 // Motor control
 typedef struct {
     uint8_t pin_pwm;
@@ -78,9 +151,10 @@ typedef struct {
 } nrx_motor_t;
 
 void nrx_motor_init(nrx_motor_t *motor, uint8_t pin_pwm, uint8_t pin_dir1, uint8_t pin_dir2);
-void nrx_motor_set_power(nrx_motor_t *motor, float power_percent);
-void nrx_motor_stop(nrx_motor_t *motor);
-void nrx_motor_brake(nrx_motor_t *motor);
+// -1 while an E-stop is latched, which has already stopped the motor
+int nrx_motor_set_power(nrx_motor_t *motor, float power_percent);
+int nrx_motor_stop(nrx_motor_t *motor);
+int nrx_motor_brake(nrx_motor_t *motor);
 
 // Servo control
 typedef struct {
@@ -91,8 +165,30 @@ typedef struct {
 } nrx_servo_t;
 
 void nrx_servo_init(nrx_servo_t *servo, uint8_t pin);
-void nrx_servo_set_angle(nrx_servo_t *servo, float angle_deg);
-void nrx_servo_set_pulse(nrx_servo_t *servo, float pulse_us);
+int nrx_servo_set_angle(nrx_servo_t *servo, float angle_deg);  // -1 while E-stopped
+int nrx_servo_set_pulse(nrx_servo_t *servo, float pulse_us);
+
+// Actuator registry
+// Every motor and servo registers its pins on init so the E-stop path can
+// drive all of them to a safe state without knowing the robot layout. Each
+// also gets a safety monitor channel that sees every command it is given.
+#define NRX_HAL_MAX_ACTUATORS 32
+
+size_t nrx_actuator_count(void);
+size_t nrx_hal_estop_all(void);  // Async-signal-safe, returns actuators stopped
+void nrx_hal_estop_release(void);
+
+// Batched actuator updates
+// Changes are staged into a shadow register set and written together by
+// nrx_actuator_commit(), so all motors change in the same PWM period.
+// Outputs whose staged value matches the last written value are skipped.
+// Commits are refused while an E-stop is latched, like every direct
+// output write; nrx_pwm_stop() alone still goes through.
+void nrx_gpio_stage(uint8_t pin, nrx_gpio_state_t state);
+void nrx_pwm_stage_duty(uint8_t pin, float duty_percent);
+void nrx_motor_stage_power(nrx_motor_t *motor, float power_percent);
+void nrx_servo_stage_angle(nrx_servo_t *servo, float angle_deg);
+int nrx_actuator_commit(void);  // Returns outputs written, -1 if E-stopped
 
 // Sensor abstractions
 typedef struct {
@@ -103,4 +199,44 @@ typedef struct {
 void nrx_sensor_init(nrx_sensor_t *sensor, void *context, float (*read_fn)(void *));
 float nrx_sensor_read(nrx_sensor_t *sensor);
 
+// Backends
+// The portable part of the HAL (shadow registers, staging, the actuator
+// registry, E-stop, bus queues, UART rings, logging) sits on top of a small
+// set of hardware leaves. The platform driver provides them by default; a
+// backend installed with nrx_hal_set_backend() takes them over, e.g. the
+// simulator. A backend that only wants to observe or alter some leaves
+// forwards the rest to the one it replaced.
+//
+// Handles are the platform's descriptors (-1 when there is no device) and
+// are passed back unchanged. Writes to outputs may come from the E-stop
+// path, so gpio_write and pwm_write must not block. Both take a batch, so
+// the E-stop drives every actuator in one call of each.
+typedef struct {
+    const char *name;
+    void *context;
+    
+    void (*gpio_init)(void *context, uint8_t pin, nrx_gpio_mode_t mode);
+    void (*gpio_write)(void *context, const uint8_t *pins, const uint8_t *states, size_t count);
+    nrx_gpio_state_t (*gpio_read)(void *context, uint8_t pin);
+    void (*pwm_init)(void *context, uint8_t pin, uint32_t frequency_hz);
+    void (*pwm_write)(void *context, const uint8_t *pins, const float *duty_percent, size_t count);
+    uint16_t (*adc_read)(void *context, uint8_t pin);
+    
+    // UART ports with a handle receive on the I/O thread; ports without
+    // one are polled through uart_receive when the consumer looks
+    int (*uart_open)(void *context, uint8_t port, uint32_t baud_rate);
+    int (*uart_write)(void *context, int handle, uint8_t port, const uint8_t *data, size_t len);
+    size_t (*uart_receive)(void *context, uint8_t port, uint8_t *buffer, size_t len);
+    
+    // Runs on the bus worker; fills rx buffers, returns 0 or -errno for
+    // the whole batch
+    int (*bus_open)(void *context, uint8_t port, bool is_spi, uint32_t frequency_hz);
+    int (*bus_transfer)(void *context, int handle, uint8_t port, bool is_spi,
+                        nrx_bus_xfer_t *const *batch, size_t count);
+} nrx_hal_backend_t;
+
+void nrx_hal_set_backend(const nrx_hal_backend_t *backend);   // NULL restores the platform
+const nrx_hal_backend_t *nrx_hal_get_backend(void);
+const nrx_hal_backend_t *nrx_hal_platform_backend(void);
+
 #endif // NEUROX_HAL_H
@@ -1,150 +1,1414 @@
+#define _GNU_SOURCE
+
 #include "hal.h"
+#include "hal_linux.h"
+#include "log.h"
+#include "io.h"
+#include "safety.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <linux/gpio.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+#include <linux/serial.h>
 
-// Linux mock implementation for testing
+// Linux backend: GPIO v2 character device, sysfs PWM and an optional
+// /dev/gpiomem fast path. gpio_states[] and pwm_duty[] always hold the last
+// value written, which doubles as the simulated chip when no hardware is
+// present and as the shadow for batched commits.
 
 nrx_platform_t nrx_hal_get_platform(void) {
     return NRX_PLATFORM_LINUX;
 }
 
-// GPIO mock
+// BCM283x GPIO register word offsets (gpiomem path)
+#define BCM_GPFSEL0 0
+#define BCM_GPSET0  7
+#define BCM_GPCLR0  10
+#define BCM_GPLEV0  13
+#define BCM_GPIO_MAX 54
+
+static struct {
+    bool initialized;
+    bool gpio_simulated;
+    bool pwm_simulated;
+    char consumer[GPIO_MAX_NAME_SIZE];
+    char pwm_chip_path[192];
+    char dev_root[128];
+    char uart_prefix[128];
+    
+    // One GPIO v2 line request per initialized pin
+    int chip_fd;
+    uint8_t line_index[256];     // Index + 1 into the line table, 0 = not requested
+    uint8_t line_pin[GPIO_V2_LINES_MAX];
+    int line_fd[GPIO_V2_LINES_MAX];
+    bool line_polled[GPIO_V2_LINES_MAX];
+    nrx_gpio_mode_t line_mode[GPIO_V2_LINES_MAX];
+    nrx_gpio_edge_t line_edges[GPIO_V2_LINES_MAX];
+    uint32_t line_count;
+    
+    volatile uint32_t *gpiomem;
+    
+    // sysfs PWM channels, duty_cycle kept open
+    int pwm_fd[256];
+    uint32_t pwm_period_ns[256];
+} g_linux = { .chip_fd = -1 };
+
+// Hardware leaves; the platform's own are defined with the bus code below
+static const nrx_hal_backend_t linux_backend;
+static const nrx_hal_backend_t *g_backend = &linux_backend;
+
+static void linux_hal_ensure_init(void) {
+    if (!g_linux.initialized) {
+        nrx_hal_linux_init(NULL);
+    }
+}
+
+// Integer formatting without stdio, usable from the E-stop path. buf
+// takes 12 bytes: the digits, a newline and a terminating NUL, which the
+// returned length leaves out.
+static size_t format_u32(char *buf, uint32_t value) {
+    char tmp[10];
+    size_t len = 0;
+    do {
+        tmp[len++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = tmp[len - 1 - i];
+    }
+    buf[len] = '\n';
+    buf[len + 1] = '\0';
+    return len + 1;
+}
+
+static int sysfs_write(const char *path, const char *value) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    
+    ssize_t written = write(fd, value, strlen(value));
+    close(fd);
+    return written < 0 ? -1 : 0;
+}
+
+int nrx_hal_linux_init(const nrx_hal_linux_config_t *config) {
+    nrx_hal_linux_config_t defaults = {
+        .gpiochip_path = "/dev/gpiochip0",
+        .pwm_root = "/sys/class/pwm",
+        .pwm_chip = 0,
+        .consumer = "neurox",
+        .dev_root = "/dev",
+        .uart_prefix = "/dev/ttyS",
+        .use_gpiomem = false,
+    };
+    if (!config) config = &defaults;
+    
+    nrx_hal_linux_deinit();
+    g_linux.initialized = true;
+    
+    for (int i = 0; i < 256; i++) {
+        g_linux.pwm_fd[i] = -1;
+    }
+    
+    strncpy(g_linux.consumer, config->consumer ? config->consumer : defaults.consumer,
+            sizeof(g_linux.consumer) - 1);
+    strncpy(g_linux.dev_root, config->dev_root ? config->dev_root : defaults.dev_root,
+            sizeof(g_linux.dev_root) - 1);
+    strncpy(g_linux.uart_prefix, config->uart_prefix ? config->uart_prefix : defaults.uart_prefix,
+            sizeof(g_linux.uart_prefix) - 1);
+    
+    if (config->use_gpiomem) {
+        int fd = open("/dev/gpiomem", O_RDWR | O_SYNC | O_CLOEXEC);
+        if (fd >= 0) {
+            void *map = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (map != MAP_FAILED) {
+                g_linux.gpiomem = map;
+            }
+        }
+    }
+    
+    if (!g_linux.gpiomem) {
+        const char *path = config->gpiochip_path ? config->gpiochip_path : defaults.gpiochip_path;
+        g_linux.chip_fd = open(path, O_RDWR | O_CLOEXEC);
+    }
+    g_linux.gpio_simulated = !g_linux.gpiomem && g_linux.chip_fd < 0;
+    
+    int n = snprintf(g_linux.pwm_chip_path, sizeof(g_linux.pwm_chip_path), "%s/pwmchip%d",
+                     config->pwm_root ? config->pwm_root : defaults.pwm_root, config->pwm_chip);
+    g_linux.pwm_simulated = n < 0 || (size_t)n >= sizeof(g_linux.pwm_chip_path) ||
+                            access(g_linux.pwm_chip_path, W_OK) != 0;
+    
+    return (g_linux.gpio_simulated || g_linux.pwm_simulated) ? 1 : 0;
+}
+
+void nrx_hal_linux_deinit(void) {
+    for (uint32_t i = 0; i < g_linux.line_count; i++) {
+        if (g_linux.line_polled[i]) nrx_io_remove(g_linux.line_fd[i]);
+        close(g_linux.line_fd[i]);
+    }
+    if (g_linux.chip_fd >= 0) close(g_linux.chip_fd);
+    if (g_linux.gpiomem) munmap((void *)g_linux.gpiomem, 4096);
+    
+    if (g_linux.initialized) {
+        for (int i = 0; i < 256; i++) {
+            if (g_linux.pwm_fd[i] >= 0) close(g_linux.pwm_fd[i]);
+        }
+    }
+    
+    memset(&g_linux, 0, sizeof(g_linux));
+    g_linux.chip_fd = -1;
+}
+
+bool nrx_hal_linux_gpio_simulated(void) {
+    linux_hal_ensure_init();
+    return g_linux.gpio_simulated;
+}
+
+bool nrx_hal_linux_pwm_simulated(void) {
+    linux_hal_ensure_init();
+    return g_linux.pwm_simulated;
+}
+
+// Set by the E-stop until it is released; every output write checks it
+static atomic_bool outputs_latched;
+
+// Checked again after a write. An E-stop that began between the first
+// check and the hardware write may have zeroed the outputs before the
+// write landed, so they are stopped once more.
+static bool estop_began(void) {
+    if (!atomic_load(&outputs_latched)) return false;
+    nrx_hal_estop_all();
+    return true;
+}
+
+// GPIO
 static uint8_t gpio_states[256] = {0};
 
+// Edge events
+// Counts are bumped on the I/O thread; callbacks are deferred to the
+// scheduler so user code never runs on the I/O thread
+#define NRX_GPIO_EVENT_BUFFER 1024   // Kernel-side queue, the uAPI maximum
+#define NRX_GPIO_EVENT_BATCH 64      // Events per read()
+
+typedef struct {
+    _Atomic nrx_gpio_edge_t edges;
+    nrx_gpio_edge_cb_t callback;
+    void *user_data;
+    atomic_uint count;
+} nrx_gpio_edge_slot_t;
+
+static nrx_gpio_edge_slot_t gpio_edges[256];
+
+static void gpio_edge_deferred(void *context, uint64_t arg, uint64_t timestamp_ns) {
+    (void)context;
+    uint8_t pin = (uint8_t)arg;
+    nrx_gpio_edge_slot_t *slot = &gpio_edges[pin];
+    
+    if (slot->callback) {
+        slot->callback(pin, (nrx_gpio_edge_t)(arg >> 8), timestamp_ns, slot->user_data);
+    }
+}
+
+static void gpio_edge_dispatch(uint8_t pin, nrx_gpio_edge_t edge, uint64_t timestamp_ns) {
+    nrx_gpio_edge_slot_t *slot = &gpio_edges[pin];
+    if (!(atomic_load_explicit(&slot->edges, memory_order_acquire) & edge)) return;
+    
+    gpio_states[pin] = (edge == NRX_GPIO_EDGE_RISING) ? NRX_GPIO_HIGH : NRX_GPIO_LOW;
+    atomic_fetch_add_explicit(&slot->count, 1, memory_order_relaxed);
+    
+    if (slot->callback) {
+        nrx_scheduler_defer(gpio_edge_deferred, NULL, (uint64_t)pin | ((uint64_t)edge << 8), timestamp_ns);
+    }
+}
+
+static void gpio_line_events(int fd, uint32_t events, void *context) {
+    (void)events;
+    (void)context;
+    struct gpio_v2_line_event batch[NRX_GPIO_EVENT_BATCH];
+    
+    ssize_t n = read(fd, batch, sizeof(batch));
+    if (n <= 0) return;
+    
+    size_t count = (size_t)n / sizeof(batch[0]);
+    for (size_t i = 0; i < count; i++) {
+        nrx_gpio_edge_t edge = batch[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE
+                                   ? NRX_GPIO_EDGE_RISING : NRX_GPIO_EDGE_FALLING;
+        gpio_edge_dispatch((uint8_t)batch[i].offset, edge, batch[i].timestamp_ns);
+    }
+}
+
+static uint64_t gpio_line_flags(uint32_t i) {
+    uint64_t flags;
+    switch (g_linux.line_mode[i]) {
+        case NRX_GPIO_MODE_OUTPUT:
+            return GPIO_V2_LINE_FLAG_OUTPUT;
+        case NRX_GPIO_MODE_INPUT_PULLUP:
+            flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+            break;
+        case NRX_GPIO_MODE_INPUT_PULLDOWN:
+            flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+            break;
+        default:
+            flags = GPIO_V2_LINE_FLAG_INPUT;
+            break;
+    }
+    if (g_linux.line_edges[i] & NRX_GPIO_EDGE_RISING) flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+    if (g_linux.line_edges[i] & NRX_GPIO_EDGE_FALLING) flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    return flags;
+}
+
+// A request holds a single line, so its flags fit in config.flags and the
+// only attribute ever needed is an output's value carried over from
+// gpio_states[]
+static void gpio_line_config(uint32_t i, struct gpio_v2_line_config *config) {
+    memset(config, 0, sizeof(*config));
+    config->flags = gpio_line_flags(i);
+    if (g_linux.line_mode[i] == NRX_GPIO_MODE_OUTPUT) {
+        config->attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        config->attrs[0].attr.values = gpio_states[g_linux.line_pin[i]] ? 1 : 0;
+        config->attrs[0].mask = 1;
+        config->num_attrs = 1;
+    }
+}
+
+static int gpio_line_watch(uint32_t i) {
+    if (!g_linux.line_edges[i] || g_linux.line_polled[i]) return 0;
+    if (nrx_io_add(g_linux.line_fd[i], EPOLLIN, gpio_line_events, NULL) != 0) return -1;
+    g_linux.line_polled[i] = true;
+    return 0;
+}
+
+// Request a new line on its own; lines already requested are never
+// released, so driven outputs hold their level and queued edges survive
+static int gpio_line_request(uint32_t i) {
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = g_linux.line_pin[i];
+    req.num_lines = 1;
+    memcpy(req.consumer, g_linux.consumer, sizeof(req.consumer));
+    gpio_line_config(i, &req.config);
+    
+    // The kernel sizes the event queue at request time, so inputs reserve
+    // the full queue in case edges are enabled later
+    if (g_linux.line_mode[i] != NRX_GPIO_MODE_OUTPUT) req.event_buffer_size = NRX_GPIO_EVENT_BUFFER;
+    
+    if (ioctl(g_linux.chip_fd, GPIO_V2_GET_LINE_IOCTL, &req) != 0) return -1;
+    g_linux.line_fd[i] = req.fd;
+    g_linux.line_polled[i] = false;
+    return 0;
+}
+
+// Change mode or edges of a requested line in place
+static int gpio_line_reconfigure(uint32_t i) {
+    struct gpio_v2_line_config config;
+    gpio_line_config(i, &config);
+    if (ioctl(g_linux.line_fd[i], GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) != 0) return -1;
+    return gpio_line_watch(i);
+}
+
+// GPIO leaves
+static void linux_gpio_write(void *context, const uint8_t *pins, const uint8_t *states, size_t count) {
+    (void)context;
+    
+    if (g_linux.gpiomem) {
+        uint32_t set[2] = {0}, clr[2] = {0};
+        for (size_t i = 0; i < count; i++) {
+            uint8_t pin = pins[i];
+            if (pin >= BCM_GPIO_MAX) continue;
+            if (states[i]) set[pin >> 5] |= 1u << (pin & 31);
+            else clr[pin >> 5] |= 1u << (pin & 31);
+        }
+        for (int bank = 0; bank < 2; bank++) {
+            if (set[bank]) g_linux.gpiomem[BCM_GPSET0 + bank] = set[bank];
+            if (clr[bank]) g_linux.gpiomem[BCM_GPCLR0 + bank] = clr[bank];
+        }
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        uint8_t index = g_linux.line_index[pins[i]];
+        if (!index || g_linux.line_mode[index - 1] != NRX_GPIO_MODE_OUTPUT) continue;
+        struct gpio_v2_line_values lv = { .bits = states[i] ? 1 : 0, .mask = 1 };
+        ioctl(g_linux.line_fd[index - 1], GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
+    }
+}
+
+static void linux_gpio_init(void *context, uint8_t pin, nrx_gpio_mode_t mode) {
+    (void)context;
+    
+    if (g_linux.gpiomem && pin < BCM_GPIO_MAX) {
+        volatile uint32_t *fsel = &g_linux.gpiomem[BCM_GPFSEL0 + pin / 10];
+        uint32_t shift = (pin % 10) * 3;
+        uint32_t function = (mode == NRX_GPIO_MODE_OUTPUT) ? 1u : 0u;
+        *fsel = (*fsel & ~(7u << shift)) | (function << shift);
+    } else if (g_linux.chip_fd >= 0) {
+        uint8_t index = g_linux.line_index[pin];
+        if (index) {
+            nrx_gpio_mode_t previous = g_linux.line_mode[index - 1];
+            g_linux.line_mode[index - 1] = mode;
+            if (gpio_line_reconfigure(index - 1) != 0) g_linux.line_mode[index - 1] = previous;
+        } else if (g_linux.line_count < GPIO_V2_LINES_MAX) {
+            // The line only joins the table once the kernel grants it
+            uint32_t i = g_linux.line_count;
+            g_linux.line_pin[i] = pin;
+            g_linux.line_mode[i] = mode;
+            g_linux.line_edges[i] = NRX_GPIO_EDGE_NONE;
+            if (gpio_line_request(i) == 0) {
+                g_linux.line_count++;
+                g_linux.line_index[pin] = (uint8_t)(i + 1);
+            }
+        }
+    }
+}
+
+static nrx_gpio_state_t linux_gpio_read(void *context, uint8_t pin) {
+    (void)context;
+    
+    if (g_linux.gpiomem && pin < BCM_GPIO_MAX) {
+        uint32_t level = g_linux.gpiomem[BCM_GPLEV0 + (pin >> 5)];
+        return (level >> (pin & 31)) & 1u ? NRX_GPIO_HIGH : NRX_GPIO_LOW;
+    }
+    
+    uint8_t index = g_linux.line_index[pin];
+    if (index && g_linux.line_mode[index - 1] != NRX_GPIO_MODE_OUTPUT) {
+        struct gpio_v2_line_values lv = { .bits = 0, .mask = 1 };
+        if (ioctl(g_linux.line_fd[index - 1], GPIO_V2_LINE_GET_VALUES_IOCTL, &lv) == 0) {
+            gpio_states[pin] = (lv.bits & 1) ? NRX_GPIO_HIGH : NRX_GPIO_LOW;
+        }
+    }
+    
+    return gpio_states[pin];
+}
+
+// Write the shadow values of the given pins in one backend call
+static void gpio_hw_write(const uint8_t *pins, size_t count) {
+    uint8_t states[256];
+    for (size_t i = 0; i < count; i++) {
+        states[i] = gpio_states[pins[i]];
+    }
+    g_backend->gpio_write(g_backend->context, pins, states, count);
+}
+
 void nrx_gpio_init(uint8_t pin, nrx_gpio_mode_t mode) {
-    printf("[HAL] GPIO init: pin=%d, mode=%d\n", pin, mode);
+    linux_hal_ensure_init();
+    g_backend->gpio_init(g_backend->context, pin, mode);
+    nrx_log(NRX_LOG_GPIO_INIT, pin, mode);
 }
 
-void nrx_gpio_write(uint8_t pin, nrx_gpio_state_t state) {
+int nrx_gpio_write(uint8_t pin, nrx_gpio_state_t state) {
+    if (atomic_load(&outputs_latched)) return -1;
+    
     gpio_states[pin] = state;
-    printf("[HAL] GPIO write: pin=%d, state=%d\n", pin, state);
+    gpio_hw_write(&pin, 1);
+    if (estop_began()) return -1;
+    
+    nrx_log(NRX_LOG_GPIO_WRITE, pin, state);
+    return 0;
 }
 
 nrx_gpio_state_t nrx_gpio_read(uint8_t pin) {
-    return gpio_states[pin];
+    return g_backend->gpio_read(g_backend->context, pin);
 }
 
-void nrx_gpio_toggle(uint8_t pin) {
+int nrx_gpio_toggle(uint8_t pin) {
+    if (atomic_load(&outputs_latched)) return -1;
+    
     gpio_states[pin] = !gpio_states[pin];
-    printf("[HAL] GPIO toggle: pin=%d, new_state=%d\n", pin, gpio_states[pin]);
+    gpio_hw_write(&pin, 1);
+    if (estop_began()) return -1;
+    
+    nrx_log(NRX_LOG_GPIO_TOGGLE, pin, gpio_states[pin]);
+    return 0;
+}
+
+int nrx_gpio_on_edge(uint8_t pin, nrx_gpio_edge_t edges, nrx_gpio_edge_cb_t callback, void *user_data) {
+    linux_hal_ensure_init();
+    
+    // The register fast path has no event interface
+    if (g_linux.gpiomem) return -1;
+    
+    nrx_gpio_edge_slot_t *slot = &gpio_edges[pin];
+    atomic_store(&slot->edges, NRX_GPIO_EDGE_NONE);
+    slot->callback = callback;
+    slot->user_data = user_data;
+    atomic_store_explicit(&slot->edges, edges, memory_order_release);
+    
+    if (g_linux.chip_fd >= 0) {
+        uint8_t index = g_linux.line_index[pin];
+        if (!index) {
+            nrx_gpio_init(pin, NRX_GPIO_MODE_INPUT);
+            index = g_linux.line_index[pin];
+        }
+        if (!index || g_linux.line_mode[index - 1] == NRX_GPIO_MODE_OUTPUT) return -1;
+        
+        nrx_gpio_edge_t previous = g_linux.line_edges[index - 1];
+        g_linux.line_edges[index - 1] = edges;
+        if (gpio_line_reconfigure(index - 1) != 0) {
+            g_linux.line_edges[index - 1] = previous;
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+uint32_t nrx_gpio_edge_count(uint8_t pin) {
+    return atomic_load_explicit(&gpio_edges[pin].count, memory_order_relaxed);
+}
+
+void nrx_hal_linux_sim_input(uint8_t pin, nrx_gpio_state_t state) {
+    if (gpio_states[pin] == state) return;
+    
+    nrx_gpio_edge_t edge = state ? NRX_GPIO_EDGE_RISING : NRX_GPIO_EDGE_FALLING;
+    gpio_states[pin] = state;
+    gpio_edge_dispatch(pin, edge, nrx_time_now_us() * 1000ULL);
+}
+
+// PWM
+static float pwm_duty[256] = {0};
+
+// sysfs has one file per channel, so a batch is one pwrite each
+static void linux_pwm_write(void *context, const uint8_t *pins, const float *duty_percent, size_t count) {
+    (void)context;
+    if (!g_linux.initialized) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        uint8_t pin = pins[i];
+        if (g_linux.pwm_fd[pin] < 0) continue;
+        
+        float duty = duty_percent[i];
+        float clamped = duty < 0.0f ? 0.0f : (duty > 100.0f ? 100.0f : duty);
+        uint32_t duty_ns = (uint32_t)((float)g_linux.pwm_period_ns[pin] * clamped / 100.0f);
+        
+        char buf[12];
+        size_t len = format_u32(buf, duty_ns);
+        ssize_t written = pwrite(g_linux.pwm_fd[pin], buf, len, 0);
+        (void)written;
+    }
+}
+
+// Write the shadow duties of the given pins in one backend call
+static void pwm_hw_write(const uint8_t *pins, size_t count) {
+    float duty[256];
+    for (size_t i = 0; i < count; i++) {
+        duty[i] = pwm_duty[pins[i]];
+    }
+    g_backend->pwm_write(g_backend->context, pins, duty, count);
+}
+
+static void linux_pwm_init(void *context, uint8_t pin, uint32_t frequency_hz) {
+    (void)context;
+    
+    if (!g_linux.pwm_simulated && frequency_hz > 0) {
+        char path[256];
+        char value[12];
+        
+        format_u32(value, pin);
+        snprintf(path, sizeof(path), "%s/export", g_linux.pwm_chip_path);
+        sysfs_write(path, value);  // EBUSY when already exported
+        
+        // Duty must never exceed the period, so clear it before resizing
+        snprintf(path, sizeof(path), "%s/pwm%d/duty_cycle", g_linux.pwm_chip_path, pin);
+        sysfs_write(path, "0\n");
+        
+        uint32_t period_ns = 1000000000u / frequency_hz;
+        format_u32(value, period_ns);
+        snprintf(path, sizeof(path), "%s/pwm%d/period", g_linux.pwm_chip_path, pin);
+        if (sysfs_write(path, value) == 0) {
+            g_linux.pwm_period_ns[pin] = period_ns;
+        }
+        
+        if (g_linux.pwm_fd[pin] < 0) {
+            snprintf(path, sizeof(path), "%s/pwm%d/duty_cycle", g_linux.pwm_chip_path, pin);
+            g_linux.pwm_fd[pin] = open(path, O_WRONLY | O_CLOEXEC);
+        }
+        
+        snprintf(path, sizeof(path), "%s/pwm%d/enable", g_linux.pwm_chip_path, pin);
+        sysfs_write(path, "1\n");
+    }
 }
 
-// PWM mock
 void nrx_pwm_init(uint8_t pin, uint32_t frequency_hz) {
-    printf("[HAL] PWM init: pin=%d, freq=%u Hz\n", pin, frequency_hz);
+    linux_hal_ensure_init();
+    g_backend->pwm_init(g_backend->context, pin, frequency_hz);
+    nrx_log(NRX_LOG_PWM_INIT, pin, (int32_t)frequency_hz);
 }
 
-void nrx_pwm_set_duty(uint8_t pin, float duty_percent) {
-    printf("[HAL] PWM set duty: pin=%d, duty=%.1f%%\n", pin, duty_percent);
+int nrx_pwm_set_duty(uint8_t pin, float duty_percent) {
+    if (atomic_load(&outputs_latched)) return -1;
+    
+    pwm_duty[pin] = duty_percent;
+    pwm_hw_write(&pin, 1);
+    if (estop_began()) return -1;
+    
+    nrx_log_event(NRX_LOG_PWM_DUTY, pin, 0, 0, duty_percent, 0.0f, NULL);
+    return 0;
+}
+
+float nrx_pwm_get_duty(uint8_t pin) {
+    return pwm_duty[pin];
 }
 
 void nrx_pwm_stop(uint8_t pin) {
-    printf("[HAL] PWM stop: pin=%d\n", pin);
+    pwm_duty[pin] = 0.0f;
+    pwm_hw_write(&pin, 1);
+    
+    if (g_linux.initialized && g_linux.pwm_fd[pin] >= 0) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/pwm%d/enable", g_linux.pwm_chip_path, pin);
+        sysfs_write(path, "0\n");
+    }
+    
+    nrx_log(NRX_LOG_PWM_STOP, pin, 0);
+}
+
+// ADC (mock on Linux: no ADC driver yet, reads mid-scale)
+static uint16_t linux_adc_read(void *context, uint8_t pin) {
+    (void)context;
+    (void)pin;
+    return 2048;
 }
 
-// ADC mock
 void nrx_adc_init(uint8_t pin) {
-    printf("[HAL] ADC init: pin=%d\n", pin);
+    nrx_log(NRX_LOG_ADC_INIT, pin, 0);
 }
 
 uint16_t nrx_adc_read(uint8_t pin) {
-    return 2048; // Mock 12-bit value
+    return g_backend->adc_read(g_backend->context, pin);
 }
 
 float nrx_adc_read_voltage(uint8_t pin) {
-    return 1.65f; // Mock voltage (3.3V / 2)
+    return (float)nrx_adc_read(pin) * 3.3f / 4095.0f;    // 12-bit, 3.3 V reference
 }
 
-// UART mock
+// UART
+// termios in raw mode with the driver's low-latency flag set. The I/O
+// thread reads straight into a receive ring that is mapped twice back to
+// back, so any span of buffered bytes is contiguous in memory and can be
+// parsed in place. Without a device node the port is simulated and never
+// receives anything.
+#define NRX_UART_RX_RING (64 * 1024)    // Power of two and a page multiple
+
 struct nrx_uart_t {
     uint8_t port;
     uint32_t baud_rate;
+    int fd;
+    
+    // Single producer (I/O thread), single consumer
+    uint8_t *rx;                // rx[i] and rx[i + NRX_UART_RX_RING] alias
+    bool mirrored;
+    atomic_size_t head;
+    atomic_size_t tail;
+    bool overrun;
+    atomic_bool closed;         // Device gone; set on the I/O thread
 };
 
+static speed_t uart_speed(uint32_t baud) {
+    static const struct { uint32_t baud; speed_t speed; } table[] = {
+        {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600},
+        {115200, B115200}, {230400, B230400}, {460800, B460800}, {500000, B500000},
+        {921600, B921600}, {1000000, B1000000}, {1500000, B1500000},
+        {2000000, B2000000}, {3000000, B3000000}, {4000000, B4000000},
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (table[i].baud == baud) return table[i].speed;
+    }
+    return B0;
+}
+
+static int uart_configure(int fd, uint32_t baud) {
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) return -1;
+    
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    
+    speed_t speed = uart_speed(baud);
+    if (speed != B0) {
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) return -1;
+    
+    // Push received bytes to the reader without the tty flip-buffer delay.
+    // Drivers without serial_struct support (USB CDC, ptys) ignore this.
+    struct serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+    
+    tcflush(fd, TCIOFLUSH);
+    return 0;
+}
+
+static bool uart_ring_alloc(nrx_uart_t *uart) {
+    int fd = memfd_create("nrx_uart_rx", MFD_CLOEXEC);
+    if (fd >= 0 && ftruncate(fd, NRX_UART_RX_RING) == 0) {
+        uint8_t *base = mmap(NULL, 2 * NRX_UART_RX_RING, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED) {
+            void *lo = mmap(base, NRX_UART_RX_RING, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            void *hi = mmap(base + NRX_UART_RX_RING, NRX_UART_RX_RING, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_FIXED, fd, 0);
+            if (lo != MAP_FAILED && hi != MAP_FAILED) {
+                close(fd);
+                uart->rx = base;
+                uart->mirrored = true;
+                return true;
+            }
+            munmap(base, 2 * NRX_UART_RX_RING);
+        }
+    }
+    if (fd >= 0) close(fd);
+    
+    // Plain ring: peek then only sees up to the wrap point
+    uart->rx = malloc(NRX_UART_RX_RING);
+    uart->mirrored = false;
+    return uart->rx != NULL;
+}
+
+static void uart_rx_ready(int fd, uint32_t events, void *context) {
+    (void)events;
+    nrx_uart_t *uart = context;
+    
+    size_t head = atomic_load_explicit(&uart->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&uart->tail, memory_order_acquire);
+    size_t space = NRX_UART_RX_RING - (head - tail);
+    size_t offset = head & (NRX_UART_RX_RING - 1);
+    ssize_t n;
+    
+    if (space == 0) {
+        // Consumer is behind; discard so the level-triggered fd settles
+        uint8_t scratch[512];
+        n = read(fd, scratch, sizeof(scratch));
+        if (n > 0) {
+            if (!uart->overrun) nrx_log(NRX_LOG_UART_OVERRUN, uart->port, (int32_t)n);
+            uart->overrun = true;
+            return;
+        }
+    } else if (uart->mirrored) {
+        n = read(fd, uart->rx + offset, space);
+    } else {
+        size_t first = NRX_UART_RX_RING - offset;
+        struct iovec iov[2] = {
+            { uart->rx + offset, first < space ? first : space },
+            { uart->rx, first < space ? space - first : 0 },
+        };
+        n = readv(fd, iov, 2);
+    }
+    
+    if (n > 0) {
+        uart->overrun = false;
+        atomic_store_explicit(&uart->head, head + (size_t)n, memory_order_release);
+    } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        // Device gone (USB unplug, pty closed): stop polling it. The
+        // registration is dropped by nrx_uart_deinit(), off this thread.
+        nrx_log(NRX_LOG_UART_CLOSED, uart->port, n == 0 ? 0 : errno);
+        atomic_store(&uart->closed, true);
+        nrx_io_disable(fd);
+    }
+}
+
+static int linux_uart_open(void *context, uint8_t port, uint32_t baud_rate) {
+    (void)context;
+    
+    char path[192];
+    snprintf(path, sizeof(path), "%s%d", g_linux.uart_prefix, port);
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0 && uart_configure(fd, baud_rate) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static int linux_uart_write(void *context, int handle, uint8_t port, const uint8_t *data, size_t len) {
+    (void)context;
+    (void)port;
+    if (handle < 0) return (int)len;
+    
+    // Non-blocking fd: wait for room in the driver's TX buffer, briefly
+    size_t written = 0;
+    while (written < len) {
+        ssize_t n = write(handle, data + written, len - written);
+        if (n > 0) {
+            written += (size_t)n;
+        } else if (n < 0 && errno == EAGAIN) {
+            struct pollfd pfd = { .fd = handle, .events = POLLOUT };
+            if (poll(&pfd, 1, 100) <= 0) break;
+        } else if (n < 0 && errno != EINTR) {
+            break;
+        }
+    }
+    
+    return (int)written;
+}
+
+// Device ports receive on the I/O thread, so there is nothing to poll
+static size_t linux_uart_receive(void *context, uint8_t port, uint8_t *buffer, size_t len) {
+    (void)context;
+    (void)port;
+    (void)buffer;
+    (void)len;
+    return 0;
+}
+
+// Ports without a device are filled by the backend from the consumer side;
+// the consumer is then also the ring's only producer
+static void uart_poll_backend(nrx_uart_t *uart) {
+    if (uart->fd >= 0) return;
+    
+    size_t head = atomic_load_explicit(&uart->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&uart->tail, memory_order_relaxed);
+    size_t space = NRX_UART_RX_RING - (head - tail);
+    size_t offset = head & (NRX_UART_RX_RING - 1);
+    if (space == 0) return;
+    
+    size_t first = uart->mirrored ? space : NRX_UART_RX_RING - offset;
+    if (first > space) first = space;
+    size_t n = g_backend->uart_receive(g_backend->context, uart->port, uart->rx + offset, first);
+    if (n == first && first < space) {
+        n += g_backend->uart_receive(g_backend->context, uart->port, uart->rx, space - first);
+    }
+    
+    if (n > 0) {
+        atomic_store_explicit(&uart->head, head + n, memory_order_release);
+    }
+}
+
 nrx_uart_t *nrx_uart_init(uint8_t port, uint32_t baud_rate) {
-    nrx_uart_t *uart = malloc(sizeof(nrx_uart_t));
+    linux_hal_ensure_init();
+    
+    nrx_uart_t *uart = calloc(1, sizeof(nrx_uart_t));
+    if (!uart) return NULL;
     uart->port = port;
     uart->baud_rate = baud_rate;
-    printf("[HAL] UART init: port=%d, baud=%u\n", port, baud_rate);
+    
+    if (!uart_ring_alloc(uart)) {
+        free(uart);
+        return NULL;
+    }
+    
+    uart->fd = g_backend->uart_open(g_backend->context, port, baud_rate);
+    if (uart->fd >= 0 && nrx_io_add(uart->fd, EPOLLIN, uart_rx_ready, uart) != 0) {
+        close(uart->fd);
+        uart->fd = -1;
+    }
+    
+    nrx_log(NRX_LOG_UART_INIT, port, (int32_t)baud_rate);
     return uart;
 }
 
 void nrx_uart_deinit(nrx_uart_t *uart) {
     if (uart) {
-        printf("[HAL] UART deinit: port=%d\n", uart->port);
+        if (uart->fd >= 0) {
+            nrx_io_remove(uart->fd);
+            close(uart->fd);
+        }
+        if (uart->mirrored) munmap(uart->rx, 2 * NRX_UART_RX_RING);
+        else free(uart->rx);
+        
+        nrx_log(NRX_LOG_UART_DEINIT, uart->port, 0);
         free(uart);
     }
 }
 
 int nrx_uart_write(nrx_uart_t *uart, const uint8_t *data, size_t len) {
-    printf("[HAL] UART write: port=%d, len=%zu\n", uart->port, len);
-    return (int)len;
+    if (atomic_load(&uart->closed)) return -1;
+    
+    nrx_log(NRX_LOG_UART_WRITE, uart->port, (int32_t)len);
+    return g_backend->uart_write(g_backend->context, uart->fd, uart->port, data, len);
+}
+
+size_t nrx_uart_peek(nrx_uart_t *uart, const uint8_t **data) {
+    uart_poll_backend(uart);
+    
+    size_t tail = atomic_load_explicit(&uart->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&uart->head, memory_order_acquire);
+    size_t offset = tail & (NRX_UART_RX_RING - 1);
+    size_t available = head - tail;
+    
+    if (!uart->mirrored && available > NRX_UART_RX_RING - offset) {
+        available = NRX_UART_RX_RING - offset;
+    }
+    
+    *data = uart->rx + offset;
+    return available;
+}
+
+void nrx_uart_consume(nrx_uart_t *uart, size_t len) {
+    size_t tail = atomic_load_explicit(&uart->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&uart->head, memory_order_acquire);
+    if (len > head - tail) len = head - tail;
+    
+    atomic_store_explicit(&uart->tail, tail + len, memory_order_release);
 }
 
 int nrx_uart_read(nrx_uart_t *uart, uint8_t *buffer, size_t len) {
-    return 0; // No data available
+    size_t total = 0;
+    
+    // At most two spans when the ring is not mirrored
+    while (total < len) {
+        const uint8_t *data;
+        size_t n = nrx_uart_peek(uart, &data);
+        if (n == 0) break;
+        if (n > len - total) n = len - total;
+        
+        memcpy(buffer + total, data, n);
+        nrx_uart_consume(uart, n);
+        total += n;
+    }
+    
+    return (int)total;
 }
 
 int nrx_uart_available(nrx_uart_t *uart) {
-    return 0;
+    uart_poll_backend(uart);
+    
+    size_t head = atomic_load_explicit(&uart->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&uart->tail, memory_order_relaxed);
+    return (int)(head - tail);
 }
 
-// I2C mock
-struct nrx_i2c_t {
+// I2C and SPI
+// One worker thread per bus blocks in the ioctl so callers never do. Each
+// wake-up takes everything queued (up to one batch) and issues it as a
+// single I2C_RDWR or SPI_IOC_MESSAGE(N). Without a device node the bus is
+// simulated: SPI loops tx back to rx and I2C reads return zeros.
+#define NRX_BUS_BATCH_MAX 16        // I2C_RDWR allows 42 messages, 2 per transfer
+
+typedef struct {
+    int fd;
     uint8_t port;
+    bool is_spi;
     uint32_t frequency_hz;
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    nrx_bus_xfer_t *head;
+    nrx_bus_xfer_t *tail;
+    bool stopping;
+} nrx_bus_t;
+
+struct nrx_i2c_t {
+    nrx_bus_t bus;
 };
 
+struct nrx_spi_t {
+    nrx_bus_t bus;
+};
+
+// Waiters for any transfer share one condition; completions are per batch
+static pthread_mutex_t bus_done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bus_done_cond = PTHREAD_COND_INITIALIZER;
+
+// Bytes clocked: the longer of the two buffers
+static size_t spi_xfer_len(const nrx_bus_xfer_t *xfer) {
+    size_t tx_len = xfer->tx ? xfer->tx_len : 0;
+    size_t rx_len = xfer->rx ? xfer->rx_len : 0;
+    return tx_len > rx_len ? tx_len : rx_len;
+}
+
+static void bus_xfer_deferred(void *context, uint64_t arg, uint64_t timestamp_ns) {
+    (void)arg;
+    (void)timestamp_ns;
+    nrx_bus_xfer_t *xfer = context;
+    xfer->callback(xfer, xfer->user_data);
+}
+
+static int i2c_run(int fd, nrx_bus_xfer_t *const *batch, size_t count) {
+    struct i2c_msg msgs[2 * NRX_BUS_BATCH_MAX];
+    uint32_t nmsgs = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        nrx_bus_xfer_t *xfer = batch[i];
+        if (xfer->tx_len) {
+            msgs[nmsgs++] = (struct i2c_msg){ xfer->addr, 0, (uint16_t)xfer->tx_len, (uint8_t *)xfer->tx };
+        }
+        if (xfer->rx_len) {
+            msgs[nmsgs++] = (struct i2c_msg){ xfer->addr, I2C_M_RD, (uint16_t)xfer->rx_len, xfer->rx };
+        }
+    }
+    
+    struct i2c_rdwr_ioctl_data data = { msgs, nmsgs };
+    return ioctl(fd, I2C_RDWR, &data) < 0 ? -errno : 0;
+}
+
+// Transfers run at the speed set when the bus was opened. Buffers of
+// different lengths become two segments under one chip select: both for
+// the shorter length, then the rest of the longer one alone. The kernel
+// clocks out zeros for a missing tx buffer and drops input without rx.
+static int spi_run(int fd, nrx_bus_xfer_t *const *batch, size_t count) {
+    struct spi_ioc_transfer tr[2 * NRX_BUS_BATCH_MAX];
+    memset(tr, 0, sizeof(tr));
+    size_t n = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        const nrx_bus_xfer_t *xfer = batch[i];
+        size_t tx_len = xfer->tx ? xfer->tx_len : 0;
+        size_t rx_len = xfer->rx ? xfer->rx_len : 0;
+        size_t both = tx_len < rx_len ? tx_len : rx_len;
+        size_t total = spi_xfer_len(xfer);
+        
+        if (both) {
+            tr[n].tx_buf = (uintptr_t)xfer->tx;
+            tr[n].rx_buf = (uintptr_t)xfer->rx;
+            tr[n].len = (uint32_t)both;
+            tr[n++].bits_per_word = 8;
+        }
+        if (total > both || total == 0) {
+            tr[n].tx_buf = tx_len > both ? (uintptr_t)(xfer->tx + both) : 0;
+            tr[n].rx_buf = rx_len > both ? (uintptr_t)(xfer->rx + both) : 0;
+            tr[n].len = (uint32_t)(total - both);
+            tr[n++].bits_per_word = 8;
+        }
+        tr[n - 1].cs_change = i + 1 < count;    // Deselect between transfers
+    }
+    
+    return ioctl(fd, SPI_IOC_MESSAGE(n), tr) < 0 ? -errno : 0;
+}
+
+static int linux_bus_open(void *context, uint8_t port, bool is_spi, uint32_t frequency_hz) {
+    (void)context;
+    
+    // The I2C clock is fixed by the adapter's device tree entry
+    char path[192];
+    if (is_spi) snprintf(path, sizeof(path), "%s/spidev%d.0", g_linux.dev_root, port);
+    else snprintf(path, sizeof(path), "%s/i2c-%d", g_linux.dev_root, port);
+    
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd >= 0 && is_spi && frequency_hz > 0) {
+        ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &frequency_hz);
+    }
+    return fd;
+}
+
+static int linux_bus_transfer(void *context, int handle, uint8_t port, bool is_spi,
+                              nrx_bus_xfer_t *const *batch, size_t count) {
+    (void)context;
+    (void)port;
+    
+    if (handle >= 0) {
+        return is_spi ? spi_run(handle, batch, count) : i2c_run(handle, batch, count);
+    }
+    
+    // Simulated SPI loops tx back, padded with zeros like the wire
+    for (size_t i = 0; i < count; i++) {
+        nrx_bus_xfer_t *xfer = batch[i];
+        if (!xfer->rx) continue;
+        size_t echoed = is_spi && xfer->tx ? (xfer->tx_len < xfer->rx_len ? xfer->tx_len : xfer->rx_len) : 0;
+        if (echoed) memcpy(xfer->rx, xfer->tx, echoed);
+        memset(xfer->rx + echoed, 0, xfer->rx_len - echoed);
+    }
+    return 0;
+}
+
+static void bus_run_batch(nrx_bus_t *bus, nrx_bus_xfer_t **batch, size_t count) {
+    // A failed batch fails every transfer in it. Part of it may already
+    // have reached the bus, so nothing is sent again: a register write or
+    // FIFO push must not happen twice.
+    int error = g_backend->bus_transfer(g_backend->context, bus->fd, bus->port, bus->is_spi, batch, count);
+    
+    // A waiter may release the transfer as soon as its status is set, so
+    // note which ones want a callback first
+    bool deferred[NRX_BUS_BATCH_MAX];
+    for (size_t i = 0; i < count; i++) {
+        deferred[i] = batch[i]->callback != NULL;
+    }
+    
+    pthread_mutex_lock(&bus_done_lock);
+    for (size_t i = 0; i < count; i++) {
+        nrx_bus_xfer_t *xfer = batch[i];
+        if (error) {
+            xfer->result = error;
+            nrx_log_event(NRX_LOG_BUS_ERROR, bus->port, xfer->addr, -error, 0.0f, 0.0f,
+                          bus->is_spi ? "SPI" : "I2C");
+        } else {
+            xfer->result = bus->is_spi ? (int)spi_xfer_len(xfer) : (int)(xfer->tx_len + xfer->rx_len);
+        }
+        atomic_store_explicit(&xfer->status, error ? NRX_BUS_ERROR : NRX_BUS_DONE, memory_order_release);
+    }
+    pthread_cond_broadcast(&bus_done_cond);
+    pthread_mutex_unlock(&bus_done_lock);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (deferred[i]) {
+            nrx_scheduler_defer(bus_xfer_deferred, batch[i], 0, 0);
+        }
+    }
+}
+
+static void *bus_worker(void *arg) {
+    nrx_bus_t *bus = arg;
+    nrx_bus_xfer_t *batch[NRX_BUS_BATCH_MAX];
+    
+    for (;;) {
+        pthread_mutex_lock(&bus->lock);
+        while (!bus->head && !bus->stopping) {
+            pthread_cond_wait(&bus->wake, &bus->lock);
+        }
+        if (!bus->head) {
+            pthread_mutex_unlock(&bus->lock);
+            break;
+        }
+        
+        size_t count = 0;
+        while (bus->head && count < NRX_BUS_BATCH_MAX) {
+            batch[count++] = bus->head;
+            bus->head = bus->head->next;
+        }
+        if (!bus->head) bus->tail = NULL;
+        pthread_mutex_unlock(&bus->lock);
+        
+        bus_run_batch(bus, batch, count);
+    }
+    
+    return NULL;
+}
+
+static bool bus_open(nrx_bus_t *bus, uint8_t port, uint32_t frequency_hz, bool is_spi) {
+    bus->port = port;
+    bus->frequency_hz = frequency_hz;
+    bus->is_spi = is_spi;
+    bus->fd = g_backend->bus_open(g_backend->context, port, is_spi, frequency_hz);
+    
+    pthread_mutex_init(&bus->lock, NULL);
+    pthread_cond_init(&bus->wake, NULL);
+    if (pthread_create(&bus->worker, NULL, bus_worker, bus) != 0) {
+        if (bus->fd >= 0) close(bus->fd);
+        return false;
+    }
+    
+    return true;
+}
+
+static void bus_close(nrx_bus_t *bus) {
+    // Transfers already queued still complete before the worker exits
+    pthread_mutex_lock(&bus->lock);
+    bus->stopping = true;
+    pthread_cond_signal(&bus->wake);
+    pthread_mutex_unlock(&bus->lock);
+    pthread_join(bus->worker, NULL);
+    
+    if (bus->fd >= 0) close(bus->fd);
+    pthread_mutex_destroy(&bus->lock);
+    pthread_cond_destroy(&bus->wake);
+}
+
+static int bus_submit(nrx_bus_t *bus, nrx_bus_xfer_t *xfer) {
+    if (!xfer || atomic_load(&xfer->status) == NRX_BUS_QUEUED) return -1;
+    if (!bus->is_spi && (xfer->tx_len > UINT16_MAX || xfer->rx_len > UINT16_MAX)) return -1;
+    
+    xfer->next = NULL;
+    xfer->result = 0;
+    atomic_store(&xfer->status, NRX_BUS_QUEUED);
+    
+    pthread_mutex_lock(&bus->lock);
+    if (bus->tail) bus->tail->next = xfer;
+    else bus->head = xfer;
+    bus->tail = xfer;
+    pthread_cond_signal(&bus->wake);
+    pthread_mutex_unlock(&bus->lock);
+    
+    return 0;
+}
+
+bool nrx_bus_xfer_done(const nrx_bus_xfer_t *xfer) {
+    nrx_bus_status_t status = atomic_load_explicit(&xfer->status, memory_order_acquire);
+    return status == NRX_BUS_DONE || status == NRX_BUS_ERROR;
+}
+
+int nrx_bus_xfer_wait(nrx_bus_xfer_t *xfer) {
+    pthread_mutex_lock(&bus_done_lock);
+    while (atomic_load(&xfer->status) == NRX_BUS_QUEUED) {
+        pthread_cond_wait(&bus_done_cond, &bus_done_lock);
+    }
+    pthread_mutex_unlock(&bus_done_lock);
+    
+    return xfer->result;
+}
+
 nrx_i2c_t *nrx_i2c_init(uint8_t port, uint32_t frequency_hz) {
-    nrx_i2c_t *i2c = malloc(sizeof(nrx_i2c_t));
-    i2c->port = port;
-    i2c->frequency_hz = frequency_hz;
-    printf("[HAL] I2C init: port=%d, freq=%u Hz\n", port, frequency_hz);
+    linux_hal_ensure_init();
+    
+    nrx_i2c_t *i2c = calloc(1, sizeof(nrx_i2c_t));
+    if (!i2c) return NULL;
+    
+    if (!bus_open(&i2c->bus, port, frequency_hz, false)) {
+        free(i2c);
+        return NULL;
+    }
+    
+    nrx_log(NRX_LOG_I2C_INIT, port, (int32_t)frequency_hz);
     return i2c;
 }
 
 void nrx_i2c_deinit(nrx_i2c_t *i2c) {
     if (i2c) {
-        printf("[HAL] I2C deinit: port=%d\n", i2c->port);
+        bus_close(&i2c->bus);
+        nrx_log(NRX_LOG_I2C_DEINIT, i2c->bus.port, 0);
         free(i2c);
     }
 }
 
+int nrx_i2c_submit(nrx_i2c_t *i2c, nrx_bus_xfer_t *xfer) {
+    return bus_submit(&i2c->bus, xfer);
+}
+
 int nrx_i2c_write(nrx_i2c_t *i2c, uint8_t addr, const uint8_t *data, size_t len) {
-    printf("[HAL] I2C write: port=%d, addr=0x%02X, len=%zu\n", i2c->port, addr, len);
-    return (int)len;
+    nrx_bus_xfer_t xfer = { .addr = addr, .tx = data, .tx_len = len };
+    if (bus_submit(&i2c->bus, &xfer) != 0) return -1;
+    
+    nrx_log_event(NRX_LOG_I2C_WRITE, i2c->bus.port, addr, (int32_t)len, 0.0f, 0.0f, NULL);
+    return nrx_bus_xfer_wait(&xfer);
 }
 
 int nrx_i2c_read(nrx_i2c_t *i2c, uint8_t addr, uint8_t *buffer, size_t len) {
-    printf("[HAL] I2C read: port=%d, addr=0x%02X, len=%zu\n", i2c->port, addr, len);
-    return 0;
+    nrx_bus_xfer_t xfer = { .addr = addr, .rx = buffer, .rx_len = len };
+    if (bus_submit(&i2c->bus, &xfer) != 0) return -1;
+    
+    nrx_log_event(NRX_LOG_I2C_READ, i2c->bus.port, addr, (int32_t)len, 0.0f, 0.0f, NULL);
+    return nrx_bus_xfer_wait(&xfer);
 }
 
-// SPI mock
-struct nrx_spi_t {
-    uint8_t port;
-    uint32_t frequency_hz;
-};
-
 nrx_spi_t *nrx_spi_init(uint8_t port, uint32_t frequency_hz) {
-    nrx_spi_t *spi = malloc(sizeof(nrx_spi_t));
-    spi->port = port;
-    spi->frequency_hz = frequency_hz;
-    printf("[HAL] SPI init: port=%d, freq=%u Hz\n", port, frequency_hz);
+    linux_hal_ensure_init();
+    
+    nrx_spi_t *spi = calloc(1, sizeof(nrx_spi_t));
+    if (!spi) return NULL;
+    
+    if (!bus_open(&spi->bus, port, frequency_hz, true)) {
+        free(spi);
+        return NULL;
+    }
+    
+    nrx_log(NRX_LOG_SPI_INIT, port, (int32_t)frequency_hz);
     return spi;
 }
 
 void nrx_spi_deinit(nrx_spi_t *spi) {
     if (spi) {
-        printf("[HAL] SPI deinit: port=%d\n", spi->port);
+        bus_close(&spi->bus);
+        nrx_log(NRX_LOG_SPI_DEINIT, spi->bus.port, 0);
         free(spi);
     }
 }
 
+int nrx_spi_submit(nrx_spi_t *spi, nrx_bus_xfer_t *xfer) {
+    return bus_submit(&spi->bus, xfer);
+}
+
 int nrx_spi_transfer(nrx_spi_t *spi, const uint8_t *tx_data, uint8_t *rx_data, size_t len) {
-    printf("[HAL] SPI transfer: port=%d, len=%zu\n", spi->port, len);
-    return (int)len;
+    nrx_bus_xfer_t xfer = { .tx = tx_data, .tx_len = len, .rx = rx_data, .rx_len = len };
+    if (bus_submit(&spi->bus, &xfer) != 0) return -1;
+    
+    nrx_log(NRX_LOG_SPI_TRANSFER, spi->bus.port, (int32_t)len);
+    return nrx_bus_xfer_wait(&xfer);
+}
+
+// Backends
+// Swap backends before any device is opened: handles already held by
+// ports and buses belong to the backend that opened them.
+static const nrx_hal_backend_t linux_backend = {
+    .name = "linux",
+    .gpio_init = linux_gpio_init,
+    .gpio_write = linux_gpio_write,
+    .gpio_read = linux_gpio_read,
+    .pwm_init = linux_pwm_init,
+    .pwm_write = linux_pwm_write,
+    .adc_read = linux_adc_read,
+    .uart_open = linux_uart_open,
+    .uart_write = linux_uart_write,
+    .uart_receive = linux_uart_receive,
+    .bus_open = linux_bus_open,
+    .bus_transfer = linux_bus_transfer,
+};
+
+void nrx_hal_set_backend(const nrx_hal_backend_t *backend) {
+    g_backend = backend ? backend : &linux_backend;
+}
+
+const nrx_hal_backend_t *nrx_hal_get_backend(void) {
+    return g_backend;
+}
+
+const nrx_hal_backend_t *nrx_hal_platform_backend(void) {
+    return &linux_backend;
+}
+
+// Actuator registry
+// Slots are reserved with an atomic increment and published in order, so
+// the E-stop path (possibly a signal handler) only ever sees complete entries.
+#define NRX_PIN_NONE 0xFF
+
+typedef struct {
+    uint8_t pin_pwm;
+    uint8_t pin_dir1;
+    uint8_t pin_dir2;
+} nrx_actuator_entry_t;
+
+static nrx_actuator_entry_t actuators[NRX_HAL_MAX_ACTUATORS];
+static atomic_size_t actuators_reserved;
+static atomic_size_t actuators_published;
+
+// Safety monitor channel + 1 of the actuator on each PWM pin, 0 for none
+static uint8_t monitor_slot[256];
+
+static void actuator_register(uint8_t pin_pwm, uint8_t pin_dir1, uint8_t pin_dir2, nrx_limit_type_t type) {
+    int channel = nrx_safety_channel_add(type);
+    monitor_slot[pin_pwm] = channel >= 0 ? (uint8_t)(channel + 1) : 0;
+    
+    size_t slot = atomic_fetch_add(&actuators_reserved, 1);
+    if (slot >= NRX_HAL_MAX_ACTUATORS) {
+        nrx_log(NRX_LOG_ACTUATOR_REGISTRY_FULL, pin_pwm, 0);
+        return;
+    }
+    
+    actuators[slot].pin_pwm = pin_pwm;
+    actuators[slot].pin_dir1 = pin_dir1;
+    actuators[slot].pin_dir2 = pin_dir2;
+    
+    size_t expected = slot;
+    while (!atomic_compare_exchange_weak(&actuators_published, &expected, slot + 1)) {
+        expected = slot;
+    }
+}
+
+// Every actuator command goes past the safety monitor, written or not
+static void actuator_command(uint8_t pin_pwm, float value) {
+    if (monitor_slot[pin_pwm]) {
+        nrx_safety_command(monitor_slot[pin_pwm] - 1, value);
+    }
+}
+
+size_t nrx_actuator_count(void) {
+    return atomic_load(&actuators_published);
+}
+
+// Shadow register set for batched updates. gpio_states[] and pwm_duty[]
+// hold the last values written; staged values wait for a commit.
+static uint8_t staged_gpio[256];
+static float staged_duty[256];
+static uint64_t gpio_dirty[4];
+static uint64_t pwm_dirty[4];
+
+size_t nrx_hal_estop_all(void) {
+    size_t count = atomic_load(&actuators_published);
+    
+    // Drop pending changes so nothing staged before the stop is applied
+    atomic_store(&outputs_latched, true);
+    memset(gpio_dirty, 0, sizeof(gpio_dirty));
+    memset(pwm_dirty, 0, sizeof(pwm_dirty));
+    
+    // PWM outputs first so every actuator loses drive in the same batch,
+    // then release the H-bridge direction pins with a single GPIO write
+    uint8_t pwm_pins[NRX_HAL_MAX_ACTUATORS];
+    for (size_t i = 0; i < count; i++) {
+        pwm_pins[i] = actuators[i].pin_pwm;
+        pwm_duty[pwm_pins[i]] = 0.0f;
+    }
+    pwm_hw_write(pwm_pins, count);
+    
+    uint8_t dir_pins[2 * NRX_HAL_MAX_ACTUATORS];
+    size_t dir_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (actuators[i].pin_dir1 != NRX_PIN_NONE) dir_pins[dir_count++] = actuators[i].pin_dir1;
+        if (actuators[i].pin_dir2 != NRX_PIN_NONE) dir_pins[dir_count++] = actuators[i].pin_dir2;
+    }
+    for (size_t i = 0; i < dir_count; i++) {
+        gpio_states[dir_pins[i]] = NRX_GPIO_LOW;
+    }
+    gpio_hw_write(dir_pins, dir_count);
+    
+    return count;
+}
+
+void nrx_hal_estop_release(void) {
+    atomic_store(&outputs_latched, false);
+}
+
+// Batched actuator updates
+void nrx_gpio_stage(uint8_t pin, nrx_gpio_state_t state) {
+    staged_gpio[pin] = state;
+    gpio_dirty[pin >> 6] |= 1ULL << (pin & 63);
+}
+
+void nrx_pwm_stage_duty(uint8_t pin, float duty_percent) {
+    staged_duty[pin] = duty_percent;
+    pwm_dirty[pin >> 6] |= 1ULL << (pin & 63);
+}
+
+int nrx_actuator_commit(void) {
+    if (atomic_load(&outputs_latched)) {
+        memset(gpio_dirty, 0, sizeof(gpio_dirty));
+        memset(pwm_dirty, 0, sizeof(pwm_dirty));
+        return -1;
+    }
+    
+    uint8_t gpio_pins[256];
+    uint8_t pwm_pins[256];
+    int gpio_writes = 0;
+    int pwm_writes = 0;
+    
+    // Direction pins first, then duty, matching nrx_motor_set_power().
+    // The latch is checked before each batch and after the last, so a
+    // commit that overlaps an E-stop writes nothing that outlives it.
+    for (int word = 0; word < 4; word++) {
+        uint64_t bits = gpio_dirty[word];
+        gpio_dirty[word] = 0;
+        
+        while (bits) {
+            int pin = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            
+            if (gpio_states[pin] != staged_gpio[pin]) {
+                gpio_states[pin] = staged_gpio[pin];
+                gpio_pins[gpio_writes++] = (uint8_t)pin;
+            }
+        }
+    }
+    if (estop_began()) return -1;
+    gpio_hw_write(gpio_pins, (size_t)gpio_writes);
+    
+    for (int word = 0; word < 4; word++) {
+        uint64_t bits = pwm_dirty[word];
+        pwm_dirty[word] = 0;
+        
+        while (bits) {
+            int pin = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            
+            if (pwm_duty[pin] != staged_duty[pin]) {
+                pwm_duty[pin] = staged_duty[pin];
+                pwm_pins[pwm_writes++] = (uint8_t)pin;
+            }
+        }
+    }
+    if (estop_began()) return -1;
+    pwm_hw_write(pwm_pins, (size_t)pwm_writes);
+    if (estop_began()) return -1;
+    
+    if (gpio_writes || pwm_writes) {
+        nrx_log(NRX_LOG_ACTUATOR_COMMIT, gpio_writes, pwm_writes);
+    }
+    
+    return gpio_writes + pwm_writes;
 }
 
 // Motor control
@@ -158,42 +1422,75 @@ void nrx_motor_init(nrx_motor_t *motor, uint8_t pin_pwm, uint8_t pin_dir1, uint8
     nrx_pwm_init(pin_pwm, 1000);
     nrx_gpio_init(pin_dir1, NRX_GPIO_MODE_OUTPUT);
     nrx_gpio_init(pin_dir2, NRX_GPIO_MODE_OUTPUT);
+    actuator_register(pin_pwm, pin_dir1, pin_dir2, NRX_LIMIT_POWER);
     
-    printf("[HAL] Motor init: pwm=%d, dir1=%d, dir2=%d\n", pin_pwm, pin_dir1, pin_dir2);
+    nrx_log_event(NRX_LOG_MOTOR_INIT, pin_pwm, pin_dir1, pin_dir2, 0.0f, 0.0f, NULL);
 }
 
-void nrx_motor_set_power(nrx_motor_t *motor, float power_percent) {
+void nrx_motor_stage_power(nrx_motor_t *motor, float power_percent) {
     motor->power = power_percent;
+    actuator_command(motor->pin_pwm, power_percent);
+    
+    if (power_percent > 0) {
+        nrx_gpio_stage(motor->pin_dir1, motor->reversed ? NRX_GPIO_LOW : NRX_GPIO_HIGH);
+        nrx_gpio_stage(motor->pin_dir2, motor->reversed ? NRX_GPIO_HIGH : NRX_GPIO_LOW);
+        nrx_pwm_stage_duty(motor->pin_pwm, power_percent);
+    } else if (power_percent < 0) {
+        nrx_gpio_stage(motor->pin_dir1, motor->reversed ? NRX_GPIO_HIGH : NRX_GPIO_LOW);
+        nrx_gpio_stage(motor->pin_dir2, motor->reversed ? NRX_GPIO_LOW : NRX_GPIO_HIGH);
+        nrx_pwm_stage_duty(motor->pin_pwm, -power_percent);
+    } else {
+        nrx_gpio_stage(motor->pin_dir1, NRX_GPIO_LOW);
+        nrx_gpio_stage(motor->pin_dir2, NRX_GPIO_LOW);
+        nrx_pwm_stage_duty(motor->pin_pwm, 0);
+    }
+}
+
+// Direction pins first, then duty; stops at the first refused write
+static int motor_drive(const nrx_motor_t *motor, nrx_gpio_state_t dir1, nrx_gpio_state_t dir2,
+                       float duty_percent) {
+    if (nrx_gpio_write(motor->pin_dir1, dir1) != 0) return -1;
+    if (nrx_gpio_write(motor->pin_dir2, dir2) != 0) return -1;
+    return nrx_pwm_set_duty(motor->pin_pwm, duty_percent);
+}
+
+int nrx_motor_set_power(nrx_motor_t *motor, float power_percent) {
+    actuator_command(motor->pin_pwm, power_percent);
     
+    int result;
     if (power_percent > 0) {
-        nrx_gpio_write(motor->pin_dir1, motor->reversed ? NRX_GPIO_LOW : NRX_GPIO_HIGH);
-        nrx_gpio_write(motor->pin_dir2, motor->reversed ? NRX_GPIO_HIGH : NRX_GPIO_LOW);
-        nrx_pwm_set_duty(motor->pin_pwm, power_percent);
+        result = motor_drive(motor, motor->reversed ? NRX_GPIO_LOW : NRX_GPIO_HIGH,
+                             motor->reversed ? NRX_GPIO_HIGH : NRX_GPIO_LOW, power_percent);
     } else if (power_percent < 0) {
-        nrx_gpio_write(motor->pin_dir1, motor->reversed ? NRX_GPIO_HIGH : NRX_GPIO_LOW);
-        nrx_gpio_write(motor->pin_dir2, motor->reversed ? NRX_GPIO_LOW : NRX_GPIO_HIGH);
-        nrx_pwm_set_duty(motor->pin_pwm, -power_percent);
+        result = motor_drive(motor, motor->reversed ? NRX_GPIO_HIGH : NRX_GPIO_LOW,
+                             motor->reversed ? NRX_GPIO_LOW : NRX_GPIO_HIGH, -power_percent);
     } else {
-        nrx_motor_stop(motor);
+        result = nrx_motor_stop(motor);
     }
+    if (result != 0) return -1;
     
-    printf("[HAL] Motor set power: %.1f%%\n", power_percent);
+    motor->power = power_percent;
+    nrx_log_event(NRX_LOG_MOTOR_POWER, motor->pin_pwm, 0, 0, power_percent, 0.0f, NULL);
+    return 0;
 }
 
-void nrx_motor_stop(nrx_motor_t *motor) {
-    nrx_gpio_write(motor->pin_dir1, NRX_GPIO_LOW);
-    nrx_gpio_write(motor->pin_dir2, NRX_GPIO_LOW);
-    nrx_pwm_set_duty(motor->pin_pwm, 0);
+int nrx_motor_stop(nrx_motor_t *motor) {
+    // The E-stop has already stopped it when this is refused
     motor->power = 0;
-    printf("[HAL] Motor stop\n");
+    actuator_command(motor->pin_pwm, 0.0f);
+    if (motor_drive(motor, NRX_GPIO_LOW, NRX_GPIO_LOW, 0) != 0) return -1;
+    
+    nrx_log(NRX_LOG_MOTOR_STOP, motor->pin_pwm, 0);
+    return 0;
 }
 
-void nrx_motor_brake(nrx_motor_t *motor) {
-    nrx_gpio_write(motor->pin_dir1, NRX_GPIO_HIGH);
-    nrx_gpio_write(motor->pin_dir2, NRX_GPIO_HIGH);
-    nrx_pwm_set_duty(motor->pin_pwm, 100);
+int nrx_motor_brake(nrx_motor_t *motor) {
+    actuator_command(motor->pin_pwm, 0.0f);
+    if (motor_drive(motor, NRX_GPIO_HIGH, NRX_GPIO_HIGH, 100) != 0) return -1;
+    
     motor->power = 0;
-    printf("[HAL] Motor brake\n");
+    nrx_log(NRX_LOG_MOTOR_BRAKE, motor->pin_pwm, 0);
+    return 0;
 }
 
 // Servo control
@@ -204,24 +1501,38 @@ void nrx_servo_init(nrx_servo_t *servo, uint8_t pin) {
     servo->max_pulse_us = 2000.0f;
     
     nrx_pwm_init(pin, 50); // 50 Hz for servos
-    printf("[HAL] Servo init: pin=%d\n", pin);
+    actuator_register(pin, NRX_PIN_NONE, NRX_PIN_NONE, NRX_LIMIT_ANGLE);
+    nrx_log(NRX_LOG_SERVO_INIT, pin, 0);
 }
 
-void nrx_servo_set_angle(nrx_servo_t *servo, float angle_deg) {
-    servo->angle = angle_deg;
-    
+int nrx_servo_set_angle(nrx_servo_t *servo, float angle_deg) {
     // Map angle to pulse width
     float pulse_us = servo->min_pulse_us + 
                      (angle_deg / 180.0f) * (servo->max_pulse_us - servo->min_pulse_us);
     
-    nrx_servo_set_pulse(servo, pulse_us);
-    printf("[HAL] Servo set angle: %.1f deg (pulse: %.1f us)\n", angle_deg, pulse_us);
+    if (nrx_servo_set_pulse(servo, pulse_us) != 0) return -1;
+    
+    servo->angle = angle_deg;
+    nrx_log_event(NRX_LOG_SERVO_ANGLE, servo->pin, 0, 0, angle_deg, pulse_us, NULL);
+    return 0;
 }
 
-void nrx_servo_set_pulse(nrx_servo_t *servo, float pulse_us) {
+void nrx_servo_stage_angle(nrx_servo_t *servo, float angle_deg) {
+    servo->angle = angle_deg;
+    actuator_command(servo->pin, angle_deg);
+    
+    float pulse_us = servo->min_pulse_us + 
+                     (angle_deg / 180.0f) * (servo->max_pulse_us - servo->min_pulse_us);
+    nrx_pwm_stage_duty(servo->pin, (pulse_us / 20000.0f) * 100.0f);
+}
+
+int nrx_servo_set_pulse(nrx_servo_t *servo, float pulse_us) {
+    actuator_command(servo->pin, (pulse_us - servo->min_pulse_us) * 180.0f /
+                                 (servo->max_pulse_us - servo->min_pulse_us));
+    
     // Convert pulse width to duty cycle (50 Hz = 20ms period)
     float duty = (pulse_us / 20000.0f) * 100.0f;
-    nrx_pwm_set_duty(servo->pin, duty);
+    return nrx_pwm_set_duty(servo->pin, duty);
 }
 
 // Sensor abstractions
@@ -0,0 +1,35 @@
+#ifndef NEUROX_HAL_LINUX_H
+#define NEUROX_HAL_LINUX_H
+
+#include "hal.h"
+
+// Linux backend configuration
+// GPIO pins are line offsets on one gpiochip character device, driven
+// through a single GPIO v2 line request so several lines can be set in one
+// ioctl. PWM pins are channel numbers on a sysfs pwmchip; each channel's
+// duty_cycle file stays open after init. I2C and SPI ports map to i2c-dev
+// and spidev nodes. When a device is not present the backend falls back to
+// an in-memory simulation of it.
+typedef struct {
+    const char *gpiochip_path;   // Default "/dev/gpiochip0"
+    const char *pwm_root;        // Default "/sys/class/pwm"
+    int pwm_chip;                // pwmchipN under pwm_root
+    const char *consumer;        // Line consumer label, default "neurox"
+    const char *dev_root;        // i2c-N and spidevN.0 live here, default "/dev"
+    const char *uart_prefix;     // UART port N is <prefix>N, default "/dev/ttyS"
+    
+    // Map /dev/gpiomem and toggle GPIOs through the BCM283x SET/CLR
+    // registers instead of ioctls (Raspberry Pi only, no pull support)
+    bool use_gpiomem;
+} nrx_hal_linux_config_t;
+
+int nrx_hal_linux_init(const nrx_hal_linux_config_t *config);
+void nrx_hal_linux_deinit(void);
+bool nrx_hal_linux_gpio_simulated(void);
+bool nrx_hal_linux_pwm_simulated(void);
+
+// Drive an input of the simulated chip; edges are dispatched exactly as if
+// they had come from a line-event fd
+void nrx_hal_linux_sim_input(uint8_t pin, nrx_gpio_state_t state);
+
+#endif // NEUROX_HAL_LINUX_H
@@ -0,0 +1,597 @@
+#include "hal_sim.h"
+#include "scheduler.h"
+#include "log.h"
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define SIM_PI 3.14159265358979f
+#define SIM_BEAM_RAYS 5
+#define SIM_BEAM_HALF_ANGLE 0.26f          // About 15 degrees, a typical sonar cone
+#define SIM_CONTACT_RELEASE_M 0.002f        // Backing off this far ends a contact
+
+typedef struct {
+    float x0, y0, x1, y1;
+} sim_wall_t;
+
+typedef struct {
+    float x, y, radius;
+} sim_obstacle_t;
+
+typedef struct {
+    float mount_angle;
+    float max_range;
+    float noise;
+    uint8_t adc_pin;
+} sim_ultrasonic_t;
+
+// Guards g_sim, which nrx_sim_init() clears wholesale, so it lives apart
+static pthread_mutex_t g_sim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+    bool active;
+    nrx_sim_config_t config;
+    uint64_t rng;
+    
+    // Robot, integrated up to time_us
+    uint64_t time_us;
+    float x, y, theta;
+    float v_left, v_right;
+    uint32_t collisions;
+    bool colliding;
+    
+    // Outputs as last written by the program, inputs as set by the test
+    uint8_t gpio[256];
+    float duty[256];
+    
+    sim_wall_t walls[NRX_SIM_MAX_WALLS];
+    size_t wall_count;
+    sim_obstacle_t obstacles[NRX_SIM_MAX_OBSTACLES];
+    size_t obstacle_count;
+    
+    sim_ultrasonic_t ultrasonic[NRX_SIM_MAX_ULTRASONIC];
+    size_t ultrasonic_count;
+    uint8_t adc_ultrasonic[256];        // Index + 1, 0 = not a sensor
+    
+    // Lidar frames are rendered as physics reaches their time and queued
+    // until the program reads its UART
+    bool lidar;
+    uint8_t lidar_port;
+    uint16_t lidar_rays;
+    float lidar_range;
+    uint64_t lidar_period_us;
+    uint64_t lidar_next_us;
+    uint8_t lidar_queue[NRX_SIM_LIDAR_QUEUE];
+    size_t lidar_head;
+    size_t lidar_tail;
+} g_sim;
+
+// Outputs written by the program. Writes may come from the E-stop path, so
+// they never lock: values go to these shadows with a dirty bit per pin,
+// and the next sim_advance() applies them from the time they were written.
+static _Atomic uint8_t out_gpio[256];
+static _Atomic float out_duty[256];
+static atomic_uint_fast64_t out_gpio_dirty[4];
+static atomic_uint_fast64_t out_pwm_dirty[4];
+static atomic_uint_fast64_t out_written_us;
+
+static float wrap_angle(float a) {
+    return a - 2.0f * SIM_PI * floorf((a + SIM_PI) / (2.0f * SIM_PI));
+}
+
+// Deterministic noise: xorshift64* and Box-Muller
+static float sim_gaussian(void) {
+    float u[2];
+    for (int i = 0; i < 2; i++) {
+        g_sim.rng ^= g_sim.rng >> 12;
+        g_sim.rng ^= g_sim.rng << 25;
+        g_sim.rng ^= g_sim.rng >> 27;
+        uint64_t r = g_sim.rng * 0x2545F4914F6CDD1DULL;
+        u[i] = ((float)(r >> 40) + 0.5f) / 16777216.0f;
+    }
+    return sqrtf(-2.0f * logf(u[0])) * cosf(2.0f * SIM_PI * u[1]);
+}
+
+// Geometry
+static float ray_cast(float px, float py, float angle, float max_range) {
+    float dx = cosf(angle), dy = sinf(angle);
+    float best = max_range;
+    
+    for (size_t i = 0; i < g_sim.wall_count; i++) {
+        const sim_wall_t *w = &g_sim.walls[i];
+        float ex = w->x1 - w->x0, ey = w->y1 - w->y0;
+        float denom = dx * ey - dy * ex;
+        if (fabsf(denom) < 1e-9f) continue;
+        
+        float ax = w->x0 - px, ay = w->y0 - py;
+        float t = (ax * ey - ay * ex) / denom;
+        float u = (ax * dy - ay * dx) / denom;
+        if (t >= 0.0f && u >= 0.0f && u <= 1.0f && t < best) best = t;
+    }
+    
+    for (size_t i = 0; i < g_sim.obstacle_count; i++) {
+        const sim_obstacle_t *o = &g_sim.obstacles[i];
+        float fx = px - o->x, fy = py - o->y;
+        float b = fx * dx + fy * dy;
+        float c = fx * fx + fy * fy - o->radius * o->radius;
+        float disc = b * b - c;
+        if (disc < 0.0f) continue;
+        
+        float root = sqrtf(disc);
+        float t = -b - root;
+        if (t < 0.0f) t = -b + root;        // Origin inside the obstacle
+        if (t >= 0.0f && t < best) best = t;
+    }
+    
+    return best;
+}
+
+static bool position_clear(float x, float y, float radius) {
+    for (size_t i = 0; i < g_sim.wall_count; i++) {
+        const sim_wall_t *w = &g_sim.walls[i];
+        float ex = w->x1 - w->x0, ey = w->y1 - w->y0;
+        float len2 = ex * ex + ey * ey;
+        float t = len2 > 0.0f ? ((x - w->x0) * ex + (y - w->y0) * ey) / len2 : 0.0f;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        float cx = w->x0 + t * ex - x, cy = w->y0 + t * ey - y;
+        if (cx * cx + cy * cy < radius * radius) return false;
+    }
+    
+    for (size_t i = 0; i < g_sim.obstacle_count; i++) {
+        const sim_obstacle_t *o = &g_sim.obstacles[i];
+        float cx = o->x - x, cy = o->y - y, r = o->radius + radius;
+        if (cx * cx + cy * cy < r * r) return false;
+    }
+    
+    return true;
+}
+
+// Physics
+static float wheel_command(uint8_t pwm, uint8_t dir1, uint8_t dir2) {
+    float duty = g_sim.duty[pwm];
+    duty = duty < 0.0f ? 0.0f : (duty > 100.0f ? 100.0f : duty);
+    
+    // H-bridge: one direction pin high drives, both equal brake or coast
+    int direction = (int)g_sim.gpio[dir1] - (int)g_sim.gpio[dir2];
+    return (float)direction * duty / 100.0f * g_sim.config.max_wheel_speed_mps;
+}
+
+static void lidar_render(void) {
+    size_t frame = 4 + 2 * (size_t)g_sim.lidar_rays;
+    if (NRX_SIM_LIDAR_QUEUE - (g_sim.lidar_head - g_sim.lidar_tail) < frame) return;   // Reader fell behind
+    
+    uint8_t header[4] = { 0xA5, 0x5A, (uint8_t)g_sim.lidar_rays, (uint8_t)(g_sim.lidar_rays >> 8) };
+    for (size_t i = 0; i < 4; i++) {
+        g_sim.lidar_queue[g_sim.lidar_head++ & (NRX_SIM_LIDAR_QUEUE - 1)] = header[i];
+    }
+    
+    float step = 2.0f * SIM_PI / (float)g_sim.lidar_rays;
+    for (uint16_t i = 0; i < g_sim.lidar_rays; i++) {
+        float range = ray_cast(g_sim.x, g_sim.y, g_sim.theta + step * (float)i, g_sim.lidar_range);
+        uint32_t mm = (uint32_t)(range * 1000.0f + 0.5f);
+        if (mm > UINT16_MAX) mm = UINT16_MAX;
+        g_sim.lidar_queue[g_sim.lidar_head++ & (NRX_SIM_LIDAR_QUEUE - 1)] = (uint8_t)mm;
+        g_sim.lidar_queue[g_sim.lidar_head++ & (NRX_SIM_LIDAR_QUEUE - 1)] = (uint8_t)(mm >> 8);
+    }
+}
+
+static void sim_step(float dt) {
+    const nrx_sim_config_t *c = &g_sim.config;
+    float cmd_left = wheel_command(c->left_pwm, c->left_dir1, c->left_dir2);
+    float cmd_right = wheel_command(c->right_pwm, c->right_dir1, c->right_dir2);
+    
+    float k = dt / (c->motor_time_constant_s + dt);
+    g_sim.v_left += (cmd_left - g_sim.v_left) * k;
+    g_sim.v_right += (cmd_right - g_sim.v_right) * k;
+    
+    // Midpoint heading integrates arcs closely at millisecond steps
+    float v = 0.5f * (g_sim.v_left + g_sim.v_right);
+    float omega = (g_sim.v_right - g_sim.v_left) / c->wheel_base_m;
+    float heading = g_sim.theta + 0.5f * omega * dt;
+    float x = g_sim.x + v * cosf(heading) * dt;
+    float y = g_sim.y + v * sinf(heading) * dt;
+    
+    // Blocked translation stalls the robot in place; the wheels slip. Creeping
+    // along at the contact point is still the same collision.
+    if (position_clear(x, y, c->robot_radius_m)) {
+        g_sim.x = x;
+        g_sim.y = y;
+        if (g_sim.colliding && position_clear(x, y, c->robot_radius_m + SIM_CONTACT_RELEASE_M)) {
+            g_sim.colliding = false;
+        }
+    } else if (!g_sim.colliding) {
+        g_sim.colliding = true;
+        g_sim.collisions++;
+        nrx_log_event(NRX_LOG_SIM_COLLISION, (int32_t)g_sim.collisions, 0, 0, g_sim.x, g_sim.y, NULL);
+    }
+    g_sim.theta = wrap_angle(g_sim.theta + omega * dt);
+}
+
+static void sim_advance_to(uint64_t now) {
+    uint32_t step_us = g_sim.config.step_us;
+    float dt = (float)step_us * 1e-6f;
+    
+    while (g_sim.time_us + step_us <= now) {
+        sim_step(dt);
+        g_sim.time_us += step_us;
+        
+        if (g_sim.lidar && g_sim.time_us >= g_sim.lidar_next_us) {
+            lidar_render();
+            g_sim.lidar_next_us += g_sim.lidar_period_us;
+        }
+    }
+}
+
+// Pending outputs take effect at the step where they were written; a
+// burst of writes between advances applies at the last one
+static void sim_advance(void) {
+    uint64_t now = nrx_time_now_us();
+    bool pending = false;
+    for (int word = 0; word < 4; word++) {
+        pending |= atomic_load_explicit(&out_gpio_dirty[word], memory_order_acquire) != 0;
+        pending |= atomic_load_explicit(&out_pwm_dirty[word], memory_order_acquire) != 0;
+    }
+    
+    if (pending) {
+        uint64_t written = atomic_load_explicit(&out_written_us, memory_order_relaxed);
+        sim_advance_to(written < now ? written : now);
+        
+        for (int word = 0; word < 4; word++) {
+            uint64_t bits = atomic_exchange_explicit(&out_gpio_dirty[word], 0, memory_order_acquire);
+            while (bits) {
+                int pin = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                g_sim.gpio[pin] = atomic_load_explicit(&out_gpio[pin], memory_order_relaxed);
+            }
+            bits = atomic_exchange_explicit(&out_pwm_dirty[word], 0, memory_order_acquire);
+            while (bits) {
+                int pin = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                g_sim.duty[pin] = atomic_load_explicit(&out_duty[pin], memory_order_relaxed);
+            }
+        }
+    }
+    
+    sim_advance_to(now);
+}
+
+static float ultrasonic_range(const sim_ultrasonic_t *sensor) {
+    float angle = g_sim.theta + sensor->mount_angle;
+    float ox = g_sim.x + g_sim.config.robot_radius_m * cosf(angle);
+    float oy = g_sim.y + g_sim.config.robot_radius_m * sinf(angle);
+    
+    // Nearest echo across the beam
+    float range = sensor->max_range;
+    for (int i = 0; i < SIM_BEAM_RAYS; i++) {
+        float offset = SIM_BEAM_HALF_ANGLE * (2.0f * (float)i / (SIM_BEAM_RAYS - 1) - 1.0f);
+        float r = ray_cast(ox, oy, angle + offset, sensor->max_range);
+        if (r < range) range = r;
+    }
+    
+    if (sensor->noise > 0.0f && range < sensor->max_range) {
+        range += sensor->noise * sim_gaussian();
+        range = range < 0.0f ? 0.0f : (range > sensor->max_range ? sensor->max_range : range);
+    }
+    return range;
+}
+
+// Hardware leaves
+static void sim_gpio_init(void *context, uint8_t pin, nrx_gpio_mode_t mode) {
+    (void)context;
+    (void)pin;
+    (void)mode;
+}
+
+static void sim_gpio_write(void *context, const uint8_t *pins, const uint8_t *states, size_t count) {
+    (void)context;
+    for (size_t i = 0; i < count; i++) {
+        atomic_store_explicit(&out_gpio[pins[i]], states[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&out_written_us, nrx_time_now_us(), memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        atomic_fetch_or_explicit(&out_gpio_dirty[pins[i] >> 6], 1ULL << (pins[i] & 63), memory_order_release);
+    }
+}
+
+static nrx_gpio_state_t sim_gpio_read(void *context, uint8_t pin) {
+    (void)context;
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    nrx_gpio_state_t state = g_sim.gpio[pin] ? NRX_GPIO_HIGH : NRX_GPIO_LOW;
+    pthread_mutex_unlock(&g_sim_lock);
+    return state;
+}
+
+static void sim_pwm_init(void *context, uint8_t pin, uint32_t frequency_hz) {
+    (void)context;
+    (void)pin;
+    (void)frequency_hz;
+}
+
+static void sim_pwm_write(void *context, const uint8_t *pins, const float *duty_percent, size_t count) {
+    (void)context;
+    for (size_t i = 0; i < count; i++) {
+        atomic_store_explicit(&out_duty[pins[i]], duty_percent[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&out_written_us, nrx_time_now_us(), memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        atomic_fetch_or_explicit(&out_pwm_dirty[pins[i] >> 6], 1ULL << (pins[i] & 63), memory_order_release);
+    }
+}
+
+static uint16_t sim_adc_read(void *context, uint8_t pin) {
+    (void)context;
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    
+    uint16_t counts = 0;
+    uint8_t index = g_sim.adc_ultrasonic[pin];
+    if (index) {
+        const sim_ultrasonic_t *sensor = &g_sim.ultrasonic[index - 1];
+        counts = (uint16_t)(ultrasonic_range(sensor) / sensor->max_range * 4095.0f + 0.5f);
+    }
+    
+    pthread_mutex_unlock(&g_sim_lock);
+    return counts;
+}
+
+static int sim_uart_open(void *context, uint8_t port, uint32_t baud_rate) {
+    (void)context;
+    (void)port;
+    (void)baud_rate;
+    return -1;
+}
+
+static int sim_uart_write(void *context, int handle, uint8_t port, const uint8_t *data, size_t len) {
+    (void)context;
+    (void)handle;
+    (void)port;
+    (void)data;
+    return (int)len;
+}
+
+static size_t sim_uart_receive(void *context, uint8_t port, uint8_t *buffer, size_t len) {
+    (void)context;
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    
+    size_t n = 0;
+    if (g_sim.lidar && port == g_sim.lidar_port) {
+        while (n < len && g_sim.lidar_tail != g_sim.lidar_head) {
+            buffer[n++] = g_sim.lidar_queue[g_sim.lidar_tail++ & (NRX_SIM_LIDAR_QUEUE - 1)];
+        }
+    }
+    
+    pthread_mutex_unlock(&g_sim_lock);
+    return n;
+}
+
+static int sim_bus_open(void *context, uint8_t port, bool is_spi, uint32_t frequency_hz) {
+    (void)context;
+    (void)port;
+    (void)is_spi;
+    (void)frequency_hz;
+    return -1;
+}
+
+// No simulated bus devices yet: the platform's deviceless behaviour
+static int sim_bus_transfer(void *context, int handle, uint8_t port, bool is_spi,
+                            nrx_bus_xfer_t *const *batch, size_t count) {
+    (void)context;
+    (void)handle;
+    const nrx_hal_backend_t *platform = nrx_hal_platform_backend();
+    return platform->bus_transfer(platform->context, -1, port, is_spi, batch, count);
+}
+
+static const nrx_hal_backend_t sim_backend = {
+    .name = "sim",
+    .gpio_init = sim_gpio_init,
+    .gpio_write = sim_gpio_write,
+    .gpio_read = sim_gpio_read,
+    .pwm_init = sim_pwm_init,
+    .pwm_write = sim_pwm_write,
+    .adc_read = sim_adc_read,
+    .uart_open = sim_uart_open,
+    .uart_write = sim_uart_write,
+    .uart_receive = sim_uart_receive,
+    .bus_open = sim_bus_open,
+    .bus_transfer = sim_bus_transfer,
+};
+
+// Setup
+int nrx_sim_init(const nrx_sim_config_t *config) {
+    nrx_sim_config_t defaults = {
+        .left_pwm = 12, .left_dir1 = 5, .left_dir2 = 6,
+        .right_pwm = 13, .right_dir1 = 19, .right_dir2 = 26,
+    };
+    if (!config) config = &defaults;
+    
+    pthread_mutex_lock(&g_sim_lock);
+    memset(&g_sim, 0, sizeof(g_sim));
+    for (int word = 0; word < 4; word++) {
+        atomic_store(&out_gpio_dirty[word], 0);
+        atomic_store(&out_pwm_dirty[word], 0);
+    }
+    
+    g_sim.config = *config;
+    nrx_sim_config_t *c = &g_sim.config;
+    if (c->wheel_base_m <= 0.0f) c->wheel_base_m = 0.15f;
+    if (c->max_wheel_speed_mps <= 0.0f) c->max_wheel_speed_mps = 0.5f;
+    if (c->motor_time_constant_s <= 0.0f) c->motor_time_constant_s = 0.05f;
+    if (c->robot_radius_m <= 0.0f) c->robot_radius_m = 0.1f;
+    if (c->step_us == 0) c->step_us = 1000;
+    g_sim.rng = c->seed ? c->seed : 0x9E3779B97F4A7C15ULL;
+    g_sim.active = true;
+    
+    nrx_time_set_virtual(true, 0);
+    nrx_hal_set_backend(&sim_backend);
+    pthread_mutex_unlock(&g_sim_lock);
+    return 0;
+}
+
+void nrx_sim_deinit(void) {
+    pthread_mutex_lock(&g_sim_lock);
+    if (g_sim.active) {
+        g_sim.active = false;
+        nrx_hal_set_backend(NULL);
+        nrx_time_set_virtual(false, 0);
+    }
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+void nrx_sim_run(uint64_t duration_us) {
+    nrx_time_advance_us(duration_us);
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+// Robot state
+void nrx_sim_set_pose(float x, float y, float theta) {
+    pthread_mutex_lock(&g_sim_lock);
+    g_sim.x = x;
+    g_sim.y = y;
+    g_sim.theta = wrap_angle(theta);
+    g_sim.colliding = false;
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+void nrx_sim_get_pose(float *x, float *y, float *theta) {
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    if (x) *x = g_sim.x;
+    if (y) *y = g_sim.y;
+    if (theta) *theta = g_sim.theta;
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+void nrx_sim_get_velocity(float *v, float *omega) {
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    if (v) *v = 0.5f * (g_sim.v_left + g_sim.v_right);
+    if (omega) *omega = (g_sim.v_right - g_sim.v_left) / g_sim.config.wheel_base_m;
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+uint32_t nrx_sim_collisions(void) {
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    uint32_t collisions = g_sim.collisions;
+    pthread_mutex_unlock(&g_sim_lock);
+    return collisions;
+}
+
+void nrx_sim_set_input(uint8_t pin, nrx_gpio_state_t state) {
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    g_sim.gpio[pin] = state;
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+// World
+void nrx_sim_clear_world(void) {
+    pthread_mutex_lock(&g_sim_lock);
+    g_sim.wall_count = 0;
+    g_sim.obstacle_count = 0;
+    pthread_mutex_unlock(&g_sim_lock);
+}
+
+int nrx_sim_add_wall(float x0, float y0, float x1, float y1) {
+    pthread_mutex_lock(&g_sim_lock);
+    int id = -1;
+    if (g_sim.wall_count < NRX_SIM_MAX_WALLS) {
+        id = (int)g_sim.wall_count;
+        g_sim.walls[g_sim.wall_count++] = (sim_wall_t){ x0, y0, x1, y1 };
+    }
+    pthread_mutex_unlock(&g_sim_lock);
+    return id;
+}
+
+int nrx_sim_add_obstacle(float x, float y, float radius) {
+    pthread_mutex_lock(&g_sim_lock);
+    int id = -1;
+    if (g_sim.obstacle_count < NRX_SIM_MAX_OBSTACLES && radius > 0.0f) {
+        id = (int)g_sim.obstacle_count;
+        g_sim.obstacles[g_sim.obstacle_count++] = (sim_obstacle_t){ x, y, radius };
+    }
+    pthread_mutex_unlock(&g_sim_lock);
+    return id;
+}
+
+int nrx_sim_add_box(float x0, float y0, float x1, float y1) {
+    if (nrx_sim_add_wall(x0, y0, x1, y0) < 0) return -1;
+    if (nrx_sim_add_wall(x1, y0, x1, y1) < 0) return -1;
+    if (nrx_sim_add_wall(x1, y1, x0, y1) < 0) return -1;
+    return nrx_sim_add_wall(x0, y1, x0, y0) < 0 ? -1 : 0;
+}
+
+float nrx_sim_ray_cast(float x, float y, float angle, float max_range) {
+    pthread_mutex_lock(&g_sim_lock);
+    float range = ray_cast(x, y, angle, max_range);
+    pthread_mutex_unlock(&g_sim_lock);
+    return range;
+}
+
+// Sensors
+int nrx_sim_add_ultrasonic(float mount_angle, float max_range_m, float noise_m, uint8_t adc_pin) {
+    if (max_range_m <= 0.0f) return -1;
+    
+    pthread_mutex_lock(&g_sim_lock);
+    int id = -1;
+    if (g_sim.ultrasonic_count < NRX_SIM_MAX_ULTRASONIC) {
+        id = (int)g_sim.ultrasonic_count++;
+        g_sim.ultrasonic[id] = (sim_ultrasonic_t){ mount_angle, max_range_m, noise_m, adc_pin };
+        if (adc_pin != NRX_SIM_NO_PIN) g_sim.adc_ultrasonic[adc_pin] = (uint8_t)(id + 1);
+    }
+    pthread_mutex_unlock(&g_sim_lock);
+    return id;
+}
+
+float nrx_sim_ultrasonic_read(int id) {
+    if (id < 0 || (size_t)id >= g_sim.ultrasonic_count) return 0.0f;
+    
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    float range = ultrasonic_range(&g_sim.ultrasonic[id]);
+    pthread_mutex_unlock(&g_sim_lock);
+    return range;
+}
+
+static float ultrasonic_sensor_read(void *context) {
+    return nrx_sim_ultrasonic_read((int)(intptr_t)context);
+}
+
+void nrx_sim_ultrasonic_sensor(nrx_sensor_t *sensor, int id) {
+    nrx_sensor_init(sensor, (void *)(intptr_t)id, ultrasonic_sensor_read);
+}
+
+int nrx_sim_add_lidar(uint8_t uart_port, uint16_t rays, float max_range_m, float rate_hz) {
+    size_t frame = 4 + 2 * (size_t)rays;
+    if (rays == 0 || max_range_m <= 0.0f || rate_hz <= 0.0f || frame > NRX_SIM_LIDAR_QUEUE) return -1;
+    
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    g_sim.lidar = true;
+    g_sim.lidar_port = uart_port;
+    g_sim.lidar_rays = rays;
+    g_sim.lidar_range = max_range_m;
+    g_sim.lidar_period_us = (uint64_t)(1e6f / rate_hz);
+    g_sim.lidar_next_us = g_sim.time_us + g_sim.lidar_period_us;
+    g_sim.lidar_head = g_sim.lidar_tail = 0;
+    pthread_mutex_unlock(&g_sim_lock);
+    return 0;
+}
+
+size_t nrx_sim_lidar_scan(float *ranges, size_t rays, float max_range_m) {
+    pthread_mutex_lock(&g_sim_lock);
+    sim_advance();
+    
+    float step = 2.0f * SIM_PI / (float)rays;
+    for (size_t i = 0; i < rays; i++) {
+        ranges[i] = ray_cast(g_sim.x, g_sim.y, g_sim.theta + step * (float)i, max_range_m);
+    }
+    
+    pthread_mutex_unlock(&g_sim_lock);
+    return rays;
+}
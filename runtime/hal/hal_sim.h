@@ -0,0 +1,71 @@
+#ifndef NEUROX_HAL_SIM_H
+#define NEUROX_HAL_SIM_H
+
+#include "hal.h"
+
+// Simulation backend
+// Replaces the hardware leaves with a differential-drive robot in a 2D
+// world of walls and round obstacles, and switches the runtime to virtual
+// time. Physics advances in fixed steps up to the virtual clock whenever
+// the program touches the HAL, so a run depends only on its inputs and
+// goes as fast as the CPU allows.
+//
+// The drive is the two motors named in the config: each wheel's speed
+// follows its duty and direction pins through a first-order lag. Range
+// sensors are ray casts against the world. Ultrasonic sensors read back
+// through an ADC pin or an nrx_sensor_t; a lidar streams scan frames on a
+// UART port:
+//
+//   0xA5 0x5A, ray count (u16 LE), one range in mm (u16 LE) per ray,
+//   counter-clockwise from the robot's heading
+//
+// Units are metres, radians and seconds; the world frame has x forward
+// and y left of the starting pose.
+
+#define NRX_SIM_NO_PIN 0xFF
+#define NRX_SIM_MAX_WALLS 256
+#define NRX_SIM_MAX_OBSTACLES 64
+#define NRX_SIM_MAX_ULTRASONIC 8
+#define NRX_SIM_LIDAR_QUEUE (16 * 1024)     // Bytes of unread frames, power of two
+
+typedef struct {
+    // Drive motors, as passed to nrx_motor_init()
+    uint8_t left_pwm, left_dir1, left_dir2;
+    uint8_t right_pwm, right_dir1, right_dir2;
+    
+    // Zero selects the default
+    float wheel_base_m;                 // 0.15
+    float max_wheel_speed_mps;          // At 100% duty, 0.5
+    float motor_time_constant_s;        // 0.05
+    float robot_radius_m;               // Collision radius, 0.1
+    uint32_t step_us;                   // Physics step, 1000
+    uint64_t seed;                      // Sensor noise
+} nrx_sim_config_t;
+
+// NULL config: motors on pins 12/5/6 (left) and 13/19/26 (right)
+int nrx_sim_init(const nrx_sim_config_t *config);
+void nrx_sim_deinit(void);
+void nrx_sim_run(uint64_t duration_us);
+
+// Robot state
+void nrx_sim_set_pose(float x, float y, float theta);
+void nrx_sim_get_pose(float *x, float *y, float *theta);
+void nrx_sim_get_velocity(float *v, float *omega);
+uint32_t nrx_sim_collisions(void);
+void nrx_sim_set_input(uint8_t pin, nrx_gpio_state_t state);
+
+// World
+void nrx_sim_clear_world(void);
+int nrx_sim_add_wall(float x0, float y0, float x1, float y1);
+int nrx_sim_add_obstacle(float x, float y, float radius);
+int nrx_sim_add_box(float x0, float y0, float x1, float y1);   // Four walls
+float nrx_sim_ray_cast(float x, float y, float angle, float max_range);
+
+// Sensors
+int nrx_sim_add_ultrasonic(float mount_angle, float max_range_m, float noise_m, uint8_t adc_pin);
+float nrx_sim_ultrasonic_read(int id);
+void nrx_sim_ultrasonic_sensor(nrx_sensor_t *sensor, int id);
+int nrx_sim_add_lidar(uint8_t uart_port, uint16_t rays, float max_range_m, float rate_hz);
+size_t nrx_sim_lidar_scan(float *ranges, size_t rays, float max_range_m);
+
+#endif // NEUROX_HAL_SIM_H
@@ -0,0 +1,621 @@
+#define _GNU_SOURCE
+
+#include "hal_trace.h"
+#include "scheduler.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRACE_BUFFER_SIZE (64 * 1024)
+#define TRACE_NONE UINT32_MAX
+
+static size_t trace_padded(size_t size) {
+    return (size + NRX_TRACE_ALIGN - 1) & ~(size_t)(NRX_TRACE_ALIGN - 1);
+}
+
+// Reading
+struct nrx_trace_t {
+    const uint8_t *base;
+    size_t size;
+    size_t end;                 // Past the last complete record
+    size_t count;
+};
+
+nrx_trace_t *nrx_trace_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(nrx_trace_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    
+    const nrx_trace_header_t *header = base;
+    if (memcmp(header->magic, NRX_TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != NRX_TRACE_VERSION ||
+        header->header_size < sizeof(*header) || header->header_size > (size_t)st.st_size) {
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    
+    nrx_trace_t *trace = calloc(1, sizeof(*trace));
+    if (!trace) {
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    trace->base = base;
+    trace->size = (size_t)st.st_size;
+    
+    // A recorder that died mid-write leaves a torn last record; stop there
+    size_t offset = trace_padded(header->header_size);
+    while (offset + sizeof(nrx_trace_record_t) <= trace->size) {
+        const nrx_trace_record_t *record = (const nrx_trace_record_t *)(trace->base + offset);
+        if (record->size < sizeof(*record) || offset + record->size > trace->size) break;
+        if (record->kind == 0 || record->kind >= NRX_TRACE_KIND_COUNT) break;
+        
+        offset += trace_padded(record->size);
+        trace->count++;
+    }
+    trace->end = offset < trace->size ? offset : trace->size;
+    
+    return trace;
+}
+
+void nrx_trace_close(nrx_trace_t *trace) {
+    if (!trace) return;
+    munmap((void *)trace->base, trace->size);
+    free(trace);
+}
+
+size_t nrx_trace_count(const nrx_trace_t *trace) {
+    return trace ? trace->count : 0;
+}
+
+// NULL starts at the first record; NULL at the end
+const nrx_trace_record_t *nrx_trace_next(const nrx_trace_t *trace, const nrx_trace_record_t *record) {
+    size_t offset;
+    if (record) {
+        offset = (size_t)((const uint8_t *)record - trace->base) + trace_padded(record->size);
+    } else {
+        offset = trace_padded(((const nrx_trace_header_t *)trace->base)->header_size);
+    }
+    if (offset + sizeof(nrx_trace_record_t) > trace->end) return NULL;
+    return (const nrx_trace_record_t *)(trace->base + offset);
+}
+
+// Shared state
+typedef enum {
+    TRACE_OFF,
+    TRACE_RECORDING,
+    TRACE_REPLAYING,
+} trace_mode_t;
+
+static struct {
+    pthread_mutex_t lock;
+    trace_mode_t mode;
+    const nrx_hal_backend_t *inner;     // The backend being wrapped
+    nrx_trace_stats_t stats;
+    
+    // Recording
+    int fd;
+    bool write_error;
+    int uart_fd[256];
+    size_t used;
+    uint8_t buffer[TRACE_BUFFER_SIZE];
+    
+    // Replay: each pin or port consumes its own records in order
+    nrx_trace_t *trace;
+    bool timing;
+    bool diverged;
+    const nrx_trace_record_t **records;
+    uint32_t *next;                     // Next record index of the same stream
+    uint32_t cursor[NRX_TRACE_KIND_COUNT][256];
+    size_t uart_offset[256];            // Bytes of the current UART record delivered
+} g_trace = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// Recording
+static void trace_flush(void) {
+    size_t done = 0;
+    while (done < g_trace.used) {
+        ssize_t n = write(g_trace.fd, g_trace.buffer + done, g_trace.used - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            g_trace.write_error = true;
+            break;
+        }
+        done += (size_t)n;
+    }
+    g_trace.used = 0;
+}
+
+static void trace_write(const void *data, size_t len) {
+    if (g_trace.used + len > TRACE_BUFFER_SIZE) trace_flush();
+    
+    // Payloads too big to buffer go straight out
+    if (len > TRACE_BUFFER_SIZE) {
+        const uint8_t *p = data;
+        while (len > 0) {
+            ssize_t n = write(g_trace.fd, p, len);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                g_trace.write_error = true;
+                return;
+            }
+            p += n;
+            len -= (size_t)n;
+        }
+        return;
+    }
+    
+    memcpy(g_trace.buffer + g_trace.used, data, len);
+    g_trace.used += len;
+}
+
+// Caller holds the lock
+static void trace_append(nrx_trace_kind_t kind, uint8_t channel, uint16_t value,
+                         const void *head, size_t head_len, const void *data, size_t data_len) {
+    nrx_trace_record_t record = {
+        .size = (uint32_t)(sizeof(record) + head_len + data_len),
+        .kind = (uint8_t)kind,
+        .channel = channel,
+        .value = value,
+        .timestamp_us = nrx_time_now_us(),
+    };
+    static const uint8_t zeros[NRX_TRACE_ALIGN];
+    
+    trace_write(&record, sizeof(record));
+    if (head_len) trace_write(head, head_len);
+    if (data_len) trace_write(data, data_len);
+    trace_write(zeros, trace_padded(record.size) - record.size);
+    
+    g_trace.stats.records++;
+    g_trace.stats.bytes += trace_padded(record.size);
+}
+
+// Outputs are never recorded and pass straight through, without the lock
+static void pass_gpio_init(void *context, uint8_t pin, nrx_gpio_mode_t mode) {
+    (void)context;
+    g_trace.inner->gpio_init(g_trace.inner->context, pin, mode);
+}
+
+static void pass_gpio_write(void *context, const uint8_t *pins, const uint8_t *states, size_t count) {
+    (void)context;
+    g_trace.inner->gpio_write(g_trace.inner->context, pins, states, count);
+}
+
+static void pass_pwm_init(void *context, uint8_t pin, uint32_t frequency_hz) {
+    (void)context;
+    g_trace.inner->pwm_init(g_trace.inner->context, pin, frequency_hz);
+}
+
+static void pass_pwm_write(void *context, const uint8_t *pins, const float *duty_percent, size_t count) {
+    (void)context;
+    g_trace.inner->pwm_write(g_trace.inner->context, pins, duty_percent, count);
+}
+
+static nrx_gpio_state_t record_gpio_read(void *context, uint8_t pin) {
+    (void)context;
+    nrx_gpio_state_t state = g_trace.inner->gpio_read(g_trace.inner->context, pin);
+    
+    pthread_mutex_lock(&g_trace.lock);
+    trace_append(NRX_TRACE_GPIO, pin, (uint16_t)state, NULL, 0, NULL, 0);
+    pthread_mutex_unlock(&g_trace.lock);
+    return state;
+}
+
+static uint16_t record_adc_read(void *context, uint8_t pin) {
+    (void)context;
+    uint16_t counts = g_trace.inner->adc_read(g_trace.inner->context, pin);
+    
+    pthread_mutex_lock(&g_trace.lock);
+    trace_append(NRX_TRACE_ADC, pin, counts, NULL, 0, NULL, 0);
+    pthread_mutex_unlock(&g_trace.lock);
+    return counts;
+}
+
+// The recorder keeps the port's descriptor and hands the HAL none, so the
+// HAL polls uart_receive and every byte passes through here
+static int record_uart_open(void *context, uint8_t port, uint32_t baud_rate) {
+    (void)context;
+    int fd = g_trace.inner->uart_open(g_trace.inner->context, port, baud_rate);
+    
+    pthread_mutex_lock(&g_trace.lock);
+    if (g_trace.uart_fd[port] >= 0) close(g_trace.uart_fd[port]);
+    g_trace.uart_fd[port] = fd;
+    pthread_mutex_unlock(&g_trace.lock);
+    return -1;
+}
+
+static int record_uart_write(void *context, int handle, uint8_t port, const uint8_t *data, size_t len) {
+    (void)context;
+    int fd = g_trace.uart_fd[port];
+    return g_trace.inner->uart_write(g_trace.inner->context, fd >= 0 ? fd : handle, port, data, len);
+}
+
+static size_t record_uart_receive(void *context, uint8_t port, uint8_t *buffer, size_t len) {
+    (void)context;
+    size_t received;
+    int fd = g_trace.uart_fd[port];
+    
+    if (fd >= 0) {
+        ssize_t n = read(fd, buffer, len);         // Non-blocking
+        received = n > 0 ? (size_t)n : 0;
+    } else {
+        received = g_trace.inner->uart_receive(g_trace.inner->context, port, buffer, len);
+    }
+    
+    if (received > 0) {
+        pthread_mutex_lock(&g_trace.lock);
+        trace_append(NRX_TRACE_UART, port, 0, NULL, 0, buffer, received);
+        pthread_mutex_unlock(&g_trace.lock);
+    }
+    return received;
+}
+
+static int record_bus_open(void *context, uint8_t port, bool is_spi, uint32_t frequency_hz) {
+    (void)context;
+    return g_trace.inner->bus_open(g_trace.inner->context, port, is_spi, frequency_hz);
+}
+
+// One record per transfer, since batching depends on timing. A failed batch
+// records its error against each of its transfers.
+static int record_bus_transfer(void *context, int handle, uint8_t port, bool is_spi,
+                               nrx_bus_xfer_t *const *batch, size_t count) {
+    (void)context;
+    int error = g_trace.inner->bus_transfer(g_trace.inner->context, handle, port, is_spi, batch, count);
+    
+    int32_t result = error;
+    pthread_mutex_lock(&g_trace.lock);
+    for (size_t i = 0; i < count; i++) {
+        const nrx_bus_xfer_t *xfer = batch[i];
+        size_t rx_len = !error && xfer->rx ? xfer->rx_len : 0;
+        trace_append(is_spi ? NRX_TRACE_SPI : NRX_TRACE_I2C, port, is_spi ? 0 : xfer->addr,
+                     &result, sizeof(result), xfer->rx, rx_len);
+    }
+    pthread_mutex_unlock(&g_trace.lock);
+    return error;
+}
+
+static const nrx_hal_backend_t record_backend = {
+    .name = "record",
+    .gpio_init = pass_gpio_init,
+    .gpio_write = pass_gpio_write,
+    .gpio_read = record_gpio_read,
+    .pwm_init = pass_pwm_init,
+    .pwm_write = pass_pwm_write,
+    .adc_read = record_adc_read,
+    .uart_open = record_uart_open,
+    .uart_write = record_uart_write,
+    .uart_receive = record_uart_receive,
+    .bus_open = record_bus_open,
+    .bus_transfer = record_bus_transfer,
+};
+
+int nrx_trace_record_start(const char *path) {
+    pthread_mutex_lock(&g_trace.lock);
+    if (g_trace.mode != TRACE_OFF) {
+        pthread_mutex_unlock(&g_trace.lock);
+        return -1;
+    }
+    
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        pthread_mutex_unlock(&g_trace.lock);
+        return -1;
+    }
+    
+    g_trace.fd = fd;
+    g_trace.write_error = false;
+    g_trace.used = 0;
+    memset(&g_trace.stats, 0, sizeof(g_trace.stats));
+    for (int i = 0; i < 256; i++) g_trace.uart_fd[i] = -1;
+    
+    nrx_trace_header_t header = { .version = NRX_TRACE_VERSION, .header_size = sizeof(header) };
+    memcpy(header.magic, NRX_TRACE_MAGIC, sizeof(header.magic));
+    trace_write(&header, sizeof(header));
+    
+    g_trace.inner = nrx_hal_get_backend();
+    g_trace.mode = TRACE_RECORDING;
+    nrx_hal_set_backend(&record_backend);
+    pthread_mutex_unlock(&g_trace.lock);
+    return 0;
+}
+
+int nrx_trace_record_stop(void) {
+    pthread_mutex_lock(&g_trace.lock);
+    if (g_trace.mode != TRACE_RECORDING) {
+        pthread_mutex_unlock(&g_trace.lock);
+        return -1;
+    }
+    
+    nrx_hal_set_backend(g_trace.inner);
+    g_trace.mode = TRACE_OFF;
+    
+    trace_flush();
+    if (close(g_trace.fd) != 0) g_trace.write_error = true;
+    for (int i = 0; i < 256; i++) {
+        if (g_trace.uart_fd[i] >= 0) close(g_trace.uart_fd[i]);
+        g_trace.uart_fd[i] = -1;
+    }
+    
+    nrx_log_event(NRX_LOG_TRACE_STOP, (int32_t)g_trace.stats.records, 0, 0, 0.0f, 0.0f, "Recording");
+    int result = g_trace.write_error ? -1 : 0;
+    pthread_mutex_unlock(&g_trace.lock);
+    return result;
+}
+
+// Replay
+static void replay_diverged(nrx_trace_kind_t kind, uint8_t channel) {
+    if (!g_trace.diverged) {
+        g_trace.diverged = true;
+        nrx_log(NRX_LOG_TRACE_DIVERGED, kind, channel);
+    }
+}
+
+static const nrx_trace_record_t *replay_peek(nrx_trace_kind_t kind, uint8_t channel) {
+    uint32_t index = g_trace.cursor[kind][channel];
+    return index == TRACE_NONE ? NULL : g_trace.records[index];
+}
+
+// Caller holds the lock
+static const nrx_trace_record_t *replay_take(nrx_trace_kind_t kind, uint8_t channel) {
+    uint32_t index = g_trace.cursor[kind][channel];
+    if (index == TRACE_NONE) {
+        g_trace.stats.underruns++;
+        replay_diverged(kind, channel);
+        return NULL;
+    }
+    
+    const nrx_trace_record_t *record = g_trace.records[index];
+    g_trace.cursor[kind][channel] = g_trace.next[index];
+    g_trace.stats.records++;
+    g_trace.stats.bytes += nrx_trace_payload_len(record);
+    
+    // The program saw this input no earlier than it was recorded
+    if (g_trace.timing) {
+        uint64_t now = nrx_time_now_us();
+        if (record->timestamp_us > now) nrx_time_advance_us(record->timestamp_us - now);
+    }
+    return record;
+}
+
+static nrx_gpio_state_t replay_gpio_read(void *context, uint8_t pin) {
+    (void)context;
+    pthread_mutex_lock(&g_trace.lock);
+    const nrx_trace_record_t *record = replay_take(NRX_TRACE_GPIO, pin);
+    pthread_mutex_unlock(&g_trace.lock);
+    
+    if (!record) return g_trace.inner->gpio_read(g_trace.inner->context, pin);
+    return record->value ? NRX_GPIO_HIGH : NRX_GPIO_LOW;
+}
+
+static uint16_t replay_adc_read(void *context, uint8_t pin) {
+    (void)context;
+    pthread_mutex_lock(&g_trace.lock);
+    const nrx_trace_record_t *record = replay_take(NRX_TRACE_ADC, pin);
+    pthread_mutex_unlock(&g_trace.lock);
+    
+    if (!record) return g_trace.inner->adc_read(g_trace.inner->context, pin);
+    return record->value;
+}
+
+static int replay_uart_open(void *context, uint8_t port, uint32_t baud_rate) {
+    (void)context;
+    (void)port;
+    (void)baud_rate;
+    return -1;
+}
+
+static int replay_uart_write(void *context, int handle, uint8_t port, const uint8_t *data, size_t len) {
+    (void)context;
+    (void)handle;
+    return g_trace.inner->uart_write(g_trace.inner->context, -1, port, data, len);
+}
+
+// Received bytes arrive as they were read; with timing, not before then.
+// Running out is not an underrun: a quiet port is normal.
+static size_t replay_uart_receive(void *context, uint8_t port, uint8_t *buffer, size_t len) {
+    (void)context;
+    size_t n = 0;
+    
+    pthread_mutex_lock(&g_trace.lock);
+    while (n < len) {
+        const nrx_trace_record_t *record = replay_peek(NRX_TRACE_UART, port);
+        if (!record) break;
+        if (g_trace.timing && record->timestamp_us > nrx_time_now_us()) break;
+        
+        size_t offset = g_trace.uart_offset[port];
+        size_t chunk = nrx_trace_payload_len(record) - offset;
+        if (chunk > len - n) chunk = len - n;
+        memcpy(buffer + n, nrx_trace_payload(record) + offset, chunk);
+        n += chunk;
+        
+        g_trace.uart_offset[port] = offset + chunk;
+        if (g_trace.uart_offset[port] == nrx_trace_payload_len(record)) {
+            g_trace.uart_offset[port] = 0;
+            replay_take(NRX_TRACE_UART, port);
+        }
+    }
+    pthread_mutex_unlock(&g_trace.lock);
+    return n;
+}
+
+static int replay_bus_open(void *context, uint8_t port, bool is_spi, uint32_t frequency_hz) {
+    (void)context;
+    (void)port;
+    (void)is_spi;
+    (void)frequency_hz;
+    return -1;
+}
+
+static int32_t replay_result(const nrx_trace_record_t *record) {
+    int32_t result = -EIO;
+    if (nrx_trace_payload_len(record) >= sizeof(result)) {
+        memcpy(&result, nrx_trace_payload(record), sizeof(result));
+    }
+    return result;
+}
+
+static int replay_bus_transfer(void *context, int handle, uint8_t port, bool is_spi,
+                               nrx_bus_xfer_t *const *batch, size_t count) {
+    (void)context;
+    (void)handle;
+    nrx_trace_kind_t kind = is_spi ? NRX_TRACE_SPI : NRX_TRACE_I2C;
+    
+    pthread_mutex_lock(&g_trace.lock);
+    
+    // Each transfer takes its own record; a recorded failure fails the
+    // whole batch, as it would on the bus
+    int error = 0;
+    for (size_t i = 0; i < count; i++) {
+        nrx_bus_xfer_t *xfer = batch[i];
+        const nrx_trace_record_t *record = replay_take(kind, port);
+        if (!record) {
+            error = -ENODATA;
+            break;
+        }
+        
+        int32_t result = replay_result(record);
+        if (result != 0) {
+            if (!error) error = result;
+            continue;
+        }
+        
+        size_t recorded = nrx_trace_payload_len(record) - sizeof(result);
+        size_t rx_len = xfer->rx ? xfer->rx_len : 0;
+        if (recorded != rx_len || (!is_spi && record->value != xfer->addr)) {
+            g_trace.stats.mismatches++;
+            replay_diverged(kind, port);
+        }
+        
+        if (rx_len) {
+            size_t copy = recorded < rx_len ? recorded : rx_len;
+            memcpy(xfer->rx, nrx_trace_payload(record) + sizeof(result), copy);
+            memset(xfer->rx + copy, 0, rx_len - copy);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_trace.lock);
+    return error;
+}
+
+static const nrx_hal_backend_t replay_backend = {
+    .name = "replay",
+    .gpio_init = pass_gpio_init,
+    .gpio_write = pass_gpio_write,
+    .gpio_read = replay_gpio_read,
+    .pwm_init = pass_pwm_init,
+    .pwm_write = pass_pwm_write,
+    .adc_read = replay_adc_read,
+    .uart_open = replay_uart_open,
+    .uart_write = replay_uart_write,
+    .uart_receive = replay_uart_receive,
+    .bus_open = replay_bus_open,
+    .bus_transfer = replay_bus_transfer,
+};
+
+int nrx_trace_replay_start(const char *path, bool timing) {
+    nrx_trace_t *trace = nrx_trace_open(path);
+    if (!trace) return -1;
+    
+    size_t count = trace->count;
+    const nrx_trace_record_t **records = malloc((count ? count : 1) * sizeof(*records));
+    uint32_t *next = malloc((count ? count : 1) * sizeof(*next));
+    if (!records || !next || count >= TRACE_NONE) {
+        free(records);
+        free(next);
+        nrx_trace_close(trace);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&g_trace.lock);
+    if (g_trace.mode != TRACE_OFF) {
+        pthread_mutex_unlock(&g_trace.lock);
+        free(records);
+        free(next);
+        nrx_trace_close(trace);
+        return -1;
+    }
+    
+    // Chain each stream's records in file order, walking backwards
+    const nrx_trace_record_t *record = NULL;
+    for (size_t i = 0; i < count; i++) {
+        record = nrx_trace_next(trace, record);
+        records[i] = record;
+    }
+    memset(g_trace.cursor, 0xFF, sizeof(g_trace.cursor));
+    for (size_t i = count; i-- > 0;) {
+        uint32_t *cursor = &g_trace.cursor[records[i]->kind][records[i]->channel];
+        next[i] = *cursor;
+        *cursor = (uint32_t)i;
+    }
+    
+    g_trace.trace = trace;
+    g_trace.records = records;
+    g_trace.next = next;
+    g_trace.timing = timing;
+    g_trace.diverged = false;
+    memset(g_trace.uart_offset, 0, sizeof(g_trace.uart_offset));
+    memset(&g_trace.stats, 0, sizeof(g_trace.stats));
+    
+    if (timing) nrx_time_set_virtual(true, count ? records[0]->timestamp_us : 0);
+    
+    g_trace.inner = nrx_hal_get_backend();
+    g_trace.mode = TRACE_REPLAYING;
+    nrx_hal_set_backend(&replay_backend);
+    pthread_mutex_unlock(&g_trace.lock);
+    return 0;
+}
+
+void nrx_trace_replay_stop(void) {
+    pthread_mutex_lock(&g_trace.lock);
+    if (g_trace.mode != TRACE_REPLAYING) {
+        pthread_mutex_unlock(&g_trace.lock);
+        return;
+    }
+    
+    nrx_hal_set_backend(g_trace.inner);
+    g_trace.mode = TRACE_OFF;
+    if (g_trace.timing) nrx_time_set_virtual(false, 0);
+    
+    nrx_log_event(NRX_LOG_TRACE_STOP, (int32_t)g_trace.stats.records,
+                  (int32_t)g_trace.stats.underruns, 0, 0.0f, 0.0f, "Replay");
+    
+    nrx_trace_close(g_trace.trace);
+    free(g_trace.records);
+    free(g_trace.next);
+    g_trace.trace = NULL;
+    g_trace.records = NULL;
+    g_trace.next = NULL;
+    pthread_mutex_unlock(&g_trace.lock);
+}
+
+bool nrx_trace_replay_done(void) {
+    pthread_mutex_lock(&g_trace.lock);
+    bool done = g_trace.mode == TRACE_REPLAYING;
+    for (int kind = 0; done && kind < NRX_TRACE_KIND_COUNT; kind++) {
+        for (int channel = 0; done && channel < 256; channel++) {
+            if (g_trace.cursor[kind][channel] != TRACE_NONE) done = false;
+        }
+    }
+    pthread_mutex_unlock(&g_trace.lock);
+    return done;
+}
+
+void nrx_trace_get_stats(nrx_trace_stats_t *stats) {
+    if (!stats) return;
+    pthread_mutex_lock(&g_trace.lock);
+    *stats = g_trace.stats;
+    pthread_mutex_unlock(&g_trace.lock);
+}
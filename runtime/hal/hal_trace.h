@@ -0,0 +1,90 @@
+#ifndef NEUROX_HAL_TRACE_H
+#define NEUROX_HAL_TRACE_H
+
+#include "hal.h"
+
+// HAL record and replay
+// Recording wraps the installed backend and appends every input the
+// program sees (GPIO and ADC reads, UART bytes received, I2C/SPI responses)
+// to a trace file with the time it was seen. Replaying wraps a backend the
+// other way: inputs come from the trace in the order they were recorded,
+// per pin or port, and outputs pass through. With timing on, replay also
+// puts the runtime on virtual time and moves the clock to each record's
+// timestamp as it is consumed, so scheduler and task timing can be studied
+// offline against a field trace.
+//
+// Start recording before opening UART ports and stop after closing them:
+// while recording, the recorder reads the port itself when the program
+// polls, instead of the I/O thread.
+//
+// File layout (host byte order), meant to be mapped and walked in place:
+//
+//   nrx_trace_header_t
+//   nrx_trace_record_t + payload, padded to 8 bytes, repeated
+//
+//   GPIO  value=state                    no payload
+//   ADC   value=counts                   no payload
+//   UART  value=0                        bytes received
+//   I2C   value=addr                     int32 result (0 or -errno), rx bytes
+//   SPI   value=0                        int32 result (0 or -errno), rx bytes
+#define NRX_TRACE_MAGIC "NRXTRACE"
+#define NRX_TRACE_VERSION 1
+#define NRX_TRACE_ALIGN 8
+
+typedef enum {
+    NRX_TRACE_GPIO = 1,
+    NRX_TRACE_ADC = 2,
+    NRX_TRACE_UART = 3,
+    NRX_TRACE_I2C = 4,
+    NRX_TRACE_SPI = 5,
+    NRX_TRACE_KIND_COUNT,
+} nrx_trace_kind_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;       // Offset of the first record
+} nrx_trace_header_t;
+
+typedef struct {
+    uint32_t size;              // Record plus payload, before padding
+    uint8_t kind;
+    uint8_t channel;            // Pin or port
+    uint16_t value;
+    uint64_t timestamp_us;
+} nrx_trace_record_t;
+
+static inline const uint8_t *nrx_trace_payload(const nrx_trace_record_t *record) {
+    return (const uint8_t *)(record + 1);
+}
+
+static inline size_t nrx_trace_payload_len(const nrx_trace_record_t *record) {
+    return record->size - sizeof(nrx_trace_record_t);
+}
+
+// Reading a trace (mapped read-only; records stay valid until close)
+typedef struct nrx_trace_t nrx_trace_t;
+
+nrx_trace_t *nrx_trace_open(const char *path);
+void nrx_trace_close(nrx_trace_t *trace);
+size_t nrx_trace_count(const nrx_trace_t *trace);
+const nrx_trace_record_t *nrx_trace_next(const nrx_trace_t *trace, const nrx_trace_record_t *record);
+
+// Recording and replay wrap the backend installed when they start and
+// restore it when they stop. One at a time.
+int nrx_trace_record_start(const char *path);
+int nrx_trace_record_stop(void);
+int nrx_trace_replay_start(const char *path, bool timing);
+void nrx_trace_replay_stop(void);
+bool nrx_trace_replay_done(void);   // Every record consumed
+
+typedef struct {
+    uint64_t records;           // Written or consumed
+    uint64_t bytes;
+    uint64_t underruns;         // Replay: input asked for with none left
+    uint64_t mismatches;        // Replay: transfer shape differs from the trace
+} nrx_trace_stats_t;
+
+void nrx_trace_get_stats(nrx_trace_stats_t *stats);
+
+#endif // NEUROX_HAL_TRACE_H
@@ -0,0 +1,262 @@
+#include "sensor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+typedef struct {
+    nrx_filter_type_t type;
+    uint32_t window;
+    float alpha;
+    
+    // Moving average and median history
+    float history[NRX_SENSOR_WINDOW_MAX];
+    uint32_t filled;
+    uint32_t next;
+    float sum;
+    
+    // IIR output
+    float state;
+    bool primed;
+} nrx_filter_stage_t;
+
+// A published sample under its own sequence counter: odd while the
+// writer fills it, then 2 * (n + 1) once it holds sample n. A reader can
+// tell a torn or overwritten slot from the sample it asked for.
+typedef struct {
+    atomic_uint_fast64_t seq;
+    atomic_uint_fast64_t timestamp_us;
+    atomic_uint_fast32_t value_bits;
+} sensor_slot_t;
+
+struct nrx_sensor_channel_t {
+    const char *name;
+    nrx_sensor_t *source;
+    uint32_t rate_hz;
+    nrx_task_t *task;
+    
+    nrx_filter_stage_t stages[NRX_SENSOR_MAX_STAGES];
+    uint32_t stage_count;
+    uint32_t decimation;
+    uint32_t decimation_phase;
+    
+    // Written only by the channel task; head counts samples published
+    sensor_slot_t ring[NRX_SENSOR_RING_SIZE];
+    atomic_uint_fast64_t head;
+};
+
+nrx_sensor_channel_t *nrx_sensor_channel_create(const char *name, nrx_sensor_t *source, uint32_t rate_hz) {
+    if (!source || rate_hz == 0) return NULL;
+    
+    nrx_sensor_channel_t *channel = calloc(1, sizeof(nrx_sensor_channel_t));
+    if (!channel) return NULL;
+    
+    channel->name = name;
+    channel->source = source;
+    channel->rate_hz = rate_hz;
+    channel->decimation = 1;
+    return channel;
+}
+
+void nrx_sensor_channel_destroy(nrx_sensor_channel_t *channel) {
+    if (!channel) return;
+    if (channel->task) nrx_task_delete(channel->task);
+    free(channel);
+}
+
+int nrx_sensor_channel_add_filter(nrx_sensor_channel_t *channel, nrx_filter_type_t type, float param) {
+    if (!channel || channel->task || channel->stage_count >= NRX_SENSOR_MAX_STAGES) return -1;
+    
+    nrx_filter_stage_t *stage = &channel->stages[channel->stage_count];
+    memset(stage, 0, sizeof(*stage));
+    stage->type = type;
+    
+    switch (type) {
+        case NRX_FILTER_MOVING_AVERAGE:
+        case NRX_FILTER_MEDIAN:
+            if (param < 1.0f || param > NRX_SENSOR_WINDOW_MAX) return -1;
+            stage->window = (uint32_t)param;
+            break;
+        case NRX_FILTER_IIR:
+            if (!(param > 0.0f && param <= 1.0f)) return -1;
+            stage->alpha = param;
+            break;
+        default:
+            return -1;
+    }
+    
+    channel->stage_count++;
+    return 0;
+}
+
+int nrx_sensor_channel_set_decimation(nrx_sensor_channel_t *channel, uint32_t factor) {
+    if (!channel || channel->task || factor == 0) return -1;
+    
+    channel->decimation = factor;
+    channel->decimation_phase = 0;
+    return 0;
+}
+
+static void sensor_channel_task(void *context) {
+    nrx_sensor_channel_sample(context);
+}
+
+nrx_task_t *nrx_sensor_channel_start(nrx_sensor_channel_t *channel, nrx_priority_t priority) {
+    if (!channel || channel->task) return NULL;
+    
+    channel->task = nrx_task_create(channel->name ? channel->name : "sensor",
+                                    sensor_channel_task, channel, priority);
+    if (!channel->task) return NULL;
+    
+    nrx_task_schedule_periodic(channel->task, channel->rate_hz);
+    return channel->task;
+}
+
+// Filters
+static float filter_median(const nrx_filter_stage_t *stage) {
+    float sorted[NRX_SENSOR_WINDOW_MAX];
+    uint32_t n = stage->filled;
+    
+    // Insertion sort; windows are tiny
+    for (uint32_t i = 0; i < n; i++) {
+        float v = stage->history[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    
+    return (n & 1) ? sorted[n / 2] : 0.5f * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+static float filter_apply(nrx_filter_stage_t *stage, float x) {
+    switch (stage->type) {
+        case NRX_FILTER_MOVING_AVERAGE:
+        case NRX_FILTER_MEDIAN: {
+            float evicted = stage->filled == stage->window ? stage->history[stage->next] : 0.0f;
+            stage->history[stage->next] = x;
+            stage->next = (stage->next + 1) % stage->window;
+            if (stage->filled < stage->window) stage->filled++;
+            
+            if (stage->type == NRX_FILTER_MEDIAN) return filter_median(stage);
+            
+            // Running sum, resynchronised once per window to stop drift
+            stage->sum += x - evicted;
+            if (stage->next == 0) {
+                stage->sum = 0.0f;
+                for (uint32_t i = 0; i < stage->filled; i++) {
+                    stage->sum += stage->history[i];
+                }
+            }
+            return stage->sum / (float)stage->filled;
+        }
+        case NRX_FILTER_IIR:
+            if (!stage->primed) {
+                stage->state = x;
+                stage->primed = true;
+            } else {
+                stage->state += stage->alpha * (x - stage->state);
+            }
+            return stage->state;
+        default:
+            return x;
+    }
+}
+
+void nrx_sensor_channel_sample(nrx_sensor_channel_t *channel) {
+    uint64_t before = nrx_time_now_us();
+    float value = nrx_sensor_read(channel->source);
+    uint64_t after = nrx_time_now_us();
+    
+    // Filters see every raw sample so decimation does not alias
+    for (uint32_t i = 0; i < channel->stage_count; i++) {
+        value = filter_apply(&channel->stages[i], value);
+    }
+    
+    if (++channel->decimation_phase < channel->decimation) return;
+    channel->decimation_phase = 0;
+    
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    
+    // Seqlock write: mark the slot odd before touching the payload
+    uint64_t head = atomic_load_explicit(&channel->head, memory_order_relaxed);
+    sensor_slot_t *slot = &channel->ring[head & (NRX_SENSOR_RING_SIZE - 1)];
+    atomic_store_explicit(&slot->seq, 2 * head + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->timestamp_us, before + (after - before) / 2, memory_order_relaxed);
+    atomic_store_explicit(&slot->value_bits, bits, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, 2 * head + 2, memory_order_release);
+    atomic_store_explicit(&channel->head, head + 1, memory_order_release);
+}
+
+// Copies sample number index, or returns false when its slot is being
+// rewritten or already holds a newer sample
+static bool sensor_read_slot(const nrx_sensor_channel_t *channel, uint64_t index, nrx_sample_t *sample) {
+    const sensor_slot_t *slot = &channel->ring[index & (NRX_SENSOR_RING_SIZE - 1)];
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq != 2 * index + 2) return false;
+    
+    sample->timestamp_us = atomic_load_explicit(&slot->timestamp_us, memory_order_relaxed);
+    uint32_t bits = (uint32_t)atomic_load_explicit(&slot->value_bits, memory_order_relaxed);
+    memcpy(&sample->value, &bits, sizeof(bits));
+    
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq;
+}
+
+bool nrx_sensor_latest(const nrx_sensor_channel_t *channel, nrx_sample_t *sample) {
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&channel->head, memory_order_acquire);
+        if (head == 0) return false;
+        
+        if (sensor_read_slot(channel, head - 1, sample)) return true;
+    }
+}
+
+size_t nrx_sensor_history(const nrx_sensor_channel_t *channel, nrx_sample_t *samples, size_t max) {
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&channel->head, memory_order_acquire);
+        
+        // Keep one slot of slack for a write in progress
+        size_t count = head < NRX_SENSOR_RING_SIZE - 1 ? (size_t)head : NRX_SENSOR_RING_SIZE - 1;
+        if (count > max) count = max;
+        
+        // Newest first; start again if the writer laps the oldest
+        size_t copied = 0;
+        while (copied < count && sensor_read_slot(channel, head - 1 - copied, &samples[copied])) {
+            copied++;
+        }
+        if (copied == count) return count;
+    }
+}
+
+bool nrx_sensor_value_at(const nrx_sensor_channel_t *channel, uint64_t timestamp_us, float *value) {
+    nrx_sample_t samples[NRX_SENSOR_RING_SIZE];
+    size_t count = nrx_sensor_history(channel, samples, NRX_SENSOR_RING_SIZE);
+    if (count == 0) return false;
+    
+    // No extrapolation: newer than the newest sample holds the newest value
+    if (timestamp_us >= samples[0].timestamp_us) {
+        *value = samples[0].value;
+        return true;
+    }
+    
+    for (size_t i = 1; i < count; i++) {
+        const nrx_sample_t *older = &samples[i];
+        const nrx_sample_t *newer = &samples[i - 1];
+        if (timestamp_us >= older->timestamp_us) {
+            uint64_t span = newer->timestamp_us - older->timestamp_us;
+            float t = span ? (float)(timestamp_us - older->timestamp_us) / (float)span : 0.0f;
+            *value = older->value + t * (newer->value - older->value);
+            return true;
+        }
+    }
+    
+    return false;   // Older than the history kept
+}
+
+uint64_t nrx_sensor_sample_count(const nrx_sensor_channel_t *channel) {
+    return atomic_load_explicit(&channel->head, memory_order_acquire);
+}
@@ -0,0 +1,52 @@
+#ifndef NEUROX_SENSOR_H
+#define NEUROX_SENSOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hal.h"
+#include "scheduler.h"
+
+// Sensor sampling pipeline
+// Each channel samples one nrx_sensor_t at its own rate from a scheduler
+// task, runs the value through optional filter stages, keeps every Nth
+// result (decimation) and publishes it with a timestamp into a ring. Any
+// number of consumers read the ring without touching the hardware.
+//
+// One task writes a channel; readers never block it. A reader that is
+// lapped by the writer retries, so reads are always consistent.
+
+#define NRX_SENSOR_RING_SIZE 64         // Published samples kept, power of two
+#define NRX_SENSOR_MAX_STAGES 4
+#define NRX_SENSOR_WINDOW_MAX 16        // Moving average and median windows
+
+typedef struct {
+    uint64_t timestamp_us;              // Midpoint of the hardware read
+    float value;
+} nrx_sample_t;
+
+typedef enum {
+    NRX_FILTER_MOVING_AVERAGE,          // param = window length
+    NRX_FILTER_MEDIAN,                  // param = window length
+    NRX_FILTER_IIR,                     // param = alpha in (0, 1], first order low-pass
+} nrx_filter_type_t;
+
+typedef struct nrx_sensor_channel_t nrx_sensor_channel_t;
+
+// Setup (before the channel starts)
+nrx_sensor_channel_t *nrx_sensor_channel_create(const char *name, nrx_sensor_t *source, uint32_t rate_hz);
+void nrx_sensor_channel_destroy(nrx_sensor_channel_t *channel);
+int nrx_sensor_channel_add_filter(nrx_sensor_channel_t *channel, nrx_filter_type_t type, float param);
+int nrx_sensor_channel_set_decimation(nrx_sensor_channel_t *channel, uint32_t factor);
+nrx_task_t *nrx_sensor_channel_start(nrx_sensor_channel_t *channel, nrx_priority_t priority);
+
+// Take one sample now; this is the channel task's body
+void nrx_sensor_channel_sample(nrx_sensor_channel_t *channel);
+
+// Consumers
+bool nrx_sensor_latest(const nrx_sensor_channel_t *channel, nrx_sample_t *sample);
+bool nrx_sensor_value_at(const nrx_sensor_channel_t *channel, uint64_t timestamp_us, float *value);
+size_t nrx_sensor_history(const nrx_sensor_channel_t *channel, nrx_sample_t *samples, size_t max);
+uint64_t nrx_sensor_sample_count(const nrx_sensor_channel_t *channel);
+
+#endif // NEUROX_SENSOR_H
@@ -0,0 +1,77 @@
+#include "codec.h"
+#include <math.h>
+#include <stdio.h>
+
+// Digits of v, most significant first, into buf; returns how many
+static size_t put_digits(char *buf, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (size_t i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+    return n;
+}
+
+void nrx_json_uint(nrx_codec_writer_t *w, uint64_t v) {
+    char buf[20];
+    nrx_codec_raw(w, buf, put_digits(buf, v));
+}
+
+void nrx_json_int(nrx_codec_writer_t *w, int64_t v) {
+    char buf[21];
+    size_t n = 0;
+    if (v < 0) buf[n++] = '-';
+    n += put_digits(buf + n, v < 0 ? (uint64_t)-(v + 1) + 1 : (uint64_t)v);
+    nrx_codec_raw(w, buf, n);
+}
+
+// Fixed point while v * 10^decimals fits an integer exactly enough,
+// exponent notation outside [min, max)
+static void put_float(nrx_codec_writer_t *w, double v, int decimals, double min, double max, int digits) {
+    if (!isfinite(v)) {
+        nrx_codec_raw(w, "null", 4);
+        return;
+    }
+    
+    double mag = fabs(v);
+    char buf[40];
+    size_t n = 0;
+    if (mag != 0.0 && (mag < min || mag >= max)) {
+        int len = snprintf(buf, sizeof(buf), "%.*g", digits, v);
+        nrx_codec_raw(w, buf, (size_t)len);
+        return;
+    }
+    
+    uint64_t scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+    uint64_t fixed = (uint64_t)llround(mag * (double)scale);
+    uint64_t whole = fixed / scale;
+    uint64_t frac = fixed % scale;
+    
+    if (v < 0 && fixed) buf[n++] = '-';
+    n += put_digits(buf + n, whole);
+    if (frac) {
+        // Leading zeros of the fraction kept, trailing ones trimmed
+        while (frac % 10 == 0) {
+            frac /= 10;
+            decimals--;
+        }
+        buf[n++] = '.';
+        char digits_buf[20];
+        size_t m = put_digits(digits_buf, frac);
+        for (size_t i = m; i < (size_t)decimals; i++) buf[n++] = '0';
+        memcpy(buf + n, digits_buf, m);
+        n += m;
+    }
+    nrx_codec_raw(w, buf, n);
+}
+
+void nrx_json_f32(nrx_codec_writer_t *w, float v) {
+    put_float(w, v, 6, 1e-3, 1e12, 9);
+}
+
+void nrx_json_f64(nrx_codec_writer_t *w, double v) {
+    put_float(w, v, 9, 1e-6, 1e9, 17);
+}
@@ -0,0 +1,146 @@
+#ifndef NEUROX_CODEC_H
+#define NEUROX_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// Payload codecs
+// Writers used by the encoders the compiler generates for `message`
+// declarations. There are three wire formats: CBOR (RFC 8949), a fixed
+// little-endian layout, and JSON. A generated encoder writes a message's
+// fields from its struct straight into the caller's buffer, usually the
+// MQTT client's send queue, with keys and map headers folded into
+// constant byte strings at compile time. Writers stop at the end of the
+// buffer and flag the overflow; nrx_codec_end() then returns 0.
+typedef struct {
+    uint8_t *p;
+    size_t len;
+    size_t cap;
+    bool overflow;
+} nrx_codec_writer_t;
+
+static inline nrx_codec_writer_t nrx_codec_writer(uint8_t *buf, size_t cap) {
+    return (nrx_codec_writer_t){ buf, 0, cap, false };
+}
+
+// Bytes written, or 0 if anything did not fit
+static inline size_t nrx_codec_end(const nrx_codec_writer_t *w) {
+    return w->overflow ? 0 : w->len;
+}
+
+// Room for n bytes, or NULL (and overflow) at the end of the buffer
+static inline uint8_t *nrx_codec_take(nrx_codec_writer_t *w, size_t n) {
+    if (w->overflow || w->cap - w->len < n) {
+        w->overflow = true;
+        return NULL;
+    }
+    uint8_t *p = w->p + w->len;
+    w->len += n;
+    return p;
+}
+
+static inline void nrx_codec_raw(nrx_codec_writer_t *w, const void *data, size_t len) {
+    uint8_t *p = nrx_codec_take(w, len);
+    if (p && len) memcpy(p, data, len);
+}
+
+// Fixed layout: fields in declaration order, little-endian, unpadded
+static inline void nrx_bin_uint(nrx_codec_writer_t *w, uint64_t v, size_t size) {
+    uint8_t *p = nrx_codec_take(w, size);
+    for (size_t i = 0; p && i < size; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline void nrx_bin_f32(nrx_codec_writer_t *w, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    nrx_bin_uint(w, bits, 4);
+}
+
+static inline void nrx_bin_f64(nrx_codec_writer_t *w, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, 8);
+    nrx_bin_uint(w, bits, 8);
+}
+
+static inline uint64_t nrx_bin_read_uint(const uint8_t *p, size_t size) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < size; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static inline float nrx_bin_read_f32(const uint8_t *p) {
+    uint32_t bits = (uint32_t)nrx_bin_read_uint(p, 4);
+    float v;
+    memcpy(&v, &bits, 4);
+    return v;
+}
+
+static inline double nrx_bin_read_f64(const uint8_t *p) {
+    uint64_t bits = nrx_bin_read_uint(p, 8);
+    double v;
+    memcpy(&v, &bits, 8);
+    return v;
+}
+
+// CBOR: integers in their shortest form, floats at their declared width
+static inline void nrx_cbor_head(nrx_codec_writer_t *w, uint8_t major, uint64_t v) {
+    size_t extra = v < 24 ? 0 : v <= UINT8_MAX ? 1 : v <= UINT16_MAX ? 2 : v <= UINT32_MAX ? 4 : 8;
+    uint8_t *p = nrx_codec_take(w, 1 + extra);
+    if (!p) return;
+    
+    p[0] = (uint8_t)(major << 5 | (extra == 0 ? v : extra == 1 ? 24 : extra == 2 ? 25 : extra == 4 ? 26 : 27));
+    for (size_t i = 0; i < extra; i++) p[1 + i] = (uint8_t)(v >> (8 * (extra - 1 - i)));
+}
+
+static inline void nrx_cbor_uint(nrx_codec_writer_t *w, uint64_t v) {
+    nrx_cbor_head(w, 0, v);
+}
+
+static inline void nrx_cbor_int(nrx_codec_writer_t *w, int64_t v) {
+    if (v < 0) nrx_cbor_head(w, 1, (uint64_t)(-(v + 1)));
+    else nrx_cbor_head(w, 0, (uint64_t)v);
+}
+
+static inline void nrx_cbor_bool(nrx_codec_writer_t *w, bool v) {
+    uint8_t *p = nrx_codec_take(w, 1);
+    if (p) *p = v ? 0xF5 : 0xF4;
+}
+
+static inline void nrx_cbor_f32(nrx_codec_writer_t *w, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    uint8_t *p = nrx_codec_take(w, 5);
+    if (!p) return;
+    
+    p[0] = 0xFA;
+    for (int i = 0; i < 4; i++) p[1 + i] = (uint8_t)(bits >> (24 - 8 * i));
+}
+
+static inline void nrx_cbor_f64(nrx_codec_writer_t *w, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, 8);
+    uint8_t *p = nrx_codec_take(w, 9);
+    if (!p) return;
+    
+    p[0] = 0xFB;
+    for (int i = 0; i < 8; i++) p[1 + i] = (uint8_t)(bits >> (56 - 8 * i));
+}
+
+// JSON: integers, and floats of everyday magnitude, are formatted without
+// printf. Those floats get a fixed number of decimals (6 for f32, 9 for
+// f64) with trailing zeros trimmed; very large or very small ones fall back
+// to exponent notation. NaN and infinities become null. Use CBOR or the
+// fixed layout where every bit matters.
+void nrx_json_uint(nrx_codec_writer_t *w, uint64_t v);
+void nrx_json_int(nrx_codec_writer_t *w, int64_t v);
+void nrx_json_f32(nrx_codec_writer_t *w, float v);
+void nrx_json_f64(nrx_codec_writer_t *w, double v);
+
+static inline void nrx_json_bool(nrx_codec_writer_t *w, bool v) {
+    if (v) nrx_codec_raw(w, "true", 4);
+    else nrx_codec_raw(w, "false", 5);
+}
+
+#endif // NEUROX_CODEC_H
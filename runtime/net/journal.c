@@ -0,0 +1,322 @@
+#define _GNU_SOURCE
+
+#include "journal.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define JOURNAL_MAGIC "NRXJRNL1"
+#define JOURNAL_VERSION 1
+#define JOURNAL_ALIGN 8
+#define JOURNAL_MIN_SIZE 4096
+
+// File layout: header, then the ring
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;          // Ring bytes
+    uint64_t head;              // Next append; everything before it is complete
+    uint64_t tail;              // Oldest record still held
+    uint64_t next_seq;
+    uint8_t reserved[16];
+} journal_header_t;
+
+typedef enum {
+    RECORD_PENDING = 1,
+    RECORD_DONE = 2,
+    RECORD_WRAP = 3,            // Filler up to the end of the ring
+    RECORD_TAKEN = 4,           // Pending, and already handed to a sender
+} record_state_t;
+
+typedef struct {
+    uint32_t len;               // Whole record, padded
+    uint8_t state;
+    uint8_t qos;
+    uint8_t retain;
+    uint8_t reserved;
+    uint32_t crc;               // Over the fields below, topic and payload
+    uint16_t topic_len;
+    uint16_t reserved2;
+    uint32_t payload_len;
+    uint32_t reserved3;
+    uint64_t seq;
+} record_t;
+
+struct nrx_journal_t {
+    int fd;
+    uint8_t *base;
+    size_t map_size;
+    journal_header_t *header;
+    uint8_t *ring;
+    uint64_t capacity;
+    size_t pending;
+    nrx_journal_stats_t stats;
+};
+
+static uint32_t crc_table[256];
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t record_crc(const record_t *record) {
+    uint32_t crc = crc_update(0xFFFFFFFFu, &record->topic_len, sizeof(*record) - offsetof(record_t, topic_len));
+    crc = crc_update(crc, &record->qos, 2);
+    crc = crc_update(crc, record + 1, (size_t)record->topic_len + record->payload_len);
+    return ~crc;
+}
+
+static size_t padded(size_t len) {
+    return (len + JOURNAL_ALIGN - 1) & ~(size_t)(JOURNAL_ALIGN - 1);
+}
+
+static record_t *record_at(const nrx_journal_t *journal, uint64_t offset) {
+    return (record_t *)(journal->ring + offset % journal->capacity);
+}
+
+// Cut the ring at the first record that does not check out
+static void recover(nrx_journal_t *journal) {
+    journal_header_t *h = journal->header;
+    uint64_t offset = h->tail;
+    while (offset < h->head) {
+        record_t *record = record_at(journal, offset);
+        uint64_t room = journal->capacity - offset % journal->capacity;
+        bool ok = record->len >= JOURNAL_ALIGN && record->len % JOURNAL_ALIGN == 0 &&
+                  record->len <= room && record->len <= h->head - offset;
+        if (ok && record->state != RECORD_WRAP) {
+            ok = record->len >= sizeof(record_t) &&
+                 sizeof(record_t) + (size_t)record->topic_len + record->payload_len <= record->len &&
+                 (record->state == RECORD_PENDING || record->state == RECORD_DONE ||
+                  record->state == RECORD_TAKEN) &&
+                 record_crc(record) == record->crc;
+        }
+        if (!ok) {
+            journal->stats.truncated = h->head - offset;
+            h->head = offset;
+            break;
+        }
+        
+        // Whoever took a record went down with the last run
+        if (record->state == RECORD_TAKEN) record->state = RECORD_PENDING;
+        if (record->state == RECORD_PENDING) journal->pending++;
+        offset += record->len;
+    }
+    journal->stats.recovered = journal->pending;
+}
+
+nrx_journal_t *nrx_journal_open(const char *path, size_t size) {
+    if (!path) return NULL;
+    if (!crc_table[1]) crc_init();
+    
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return NULL;
+    
+    // An existing journal keeps its size; anything unreadable starts over
+    struct stat st;
+    bool reuse = false;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= JOURNAL_MIN_SIZE) {
+        journal_header_t h;
+        reuse = pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) &&
+                memcmp(h.magic, JOURNAL_MAGIC, 8) == 0 && h.version == JOURNAL_VERSION &&
+                h.header_size == sizeof(journal_header_t) &&
+                h.capacity == (uint64_t)st.st_size - sizeof(journal_header_t) &&
+                h.tail <= h.head && h.head - h.tail <= h.capacity;
+        if (reuse) size = (size_t)st.st_size;
+    }
+    if (size < JOURNAL_MIN_SIZE) size = JOURNAL_MIN_SIZE;
+    size = padded(size);
+    if (!reuse && ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return NULL;
+    }
+    
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    nrx_journal_t *journal = base != MAP_FAILED ? calloc(1, sizeof(nrx_journal_t)) : NULL;
+    if (!journal) {
+        if (base != MAP_FAILED) munmap(base, size);
+        close(fd);
+        return NULL;
+    }
+    
+    journal->fd = fd;
+    journal->base = base;
+    journal->map_size = size;
+    journal->header = base;
+    journal->ring = journal->base + sizeof(journal_header_t);
+    journal->capacity = size - sizeof(journal_header_t);
+    
+    if (reuse) {
+        recover(journal);
+    } else {
+        memset(journal->header, 0, sizeof(journal_header_t));
+        journal->header->version = JOURNAL_VERSION;
+        journal->header->header_size = sizeof(journal_header_t);
+        journal->header->capacity = journal->capacity;
+        memcpy(journal->header->magic, JOURNAL_MAGIC, 8);
+    }
+    return journal;
+}
+
+void nrx_journal_close(nrx_journal_t *journal) {
+    if (!journal) return;
+    nrx_journal_sync(journal);
+    munmap(journal->base, journal->map_size);
+    close(journal->fd);
+    free(journal);
+}
+
+void nrx_journal_sync(nrx_journal_t *journal) {
+    if (journal) msync(journal->base, journal->map_size, MS_SYNC);
+}
+
+// Release the oldest record, delivered or not. A taken record still goes
+// out from the sender's copy, so it is not counted as dropped.
+static void drop_tail(nrx_journal_t *journal) {
+    journal_header_t *h = journal->header;
+    record_t *record = record_at(journal, h->tail);
+    if (record->state == RECORD_PENDING || record->state == RECORD_TAKEN) journal->pending--;
+    if (record->state == RECORD_PENDING) journal->stats.dropped++;
+    __atomic_store_n(&h->tail, h->tail + record->len, __ATOMIC_RELEASE);
+}
+
+int nrx_journal_append(nrx_journal_t *journal, uint8_t qos, bool retain,
+                       const char *topic, size_t topic_len,
+                       const struct iovec *iov, int iovcnt, bool drop_oldest) {
+    if (!journal || topic_len > UINT16_MAX) return -1;
+    
+    size_t payload_len = 0;
+    for (int i = 0; i < iovcnt; i++) payload_len += iov[i].iov_len;
+    size_t len = padded(sizeof(record_t) + topic_len + payload_len);
+    if (len > journal->capacity / 2) {
+        journal->stats.dropped++;
+        return -1;
+    }
+    
+    // A record never wraps: the rest of the ring is filled and it starts at 0
+    journal_header_t *h = journal->header;
+    uint64_t room = journal->capacity - h->head % journal->capacity;
+    size_t need = len + (room < len ? room : 0);
+    while (journal->capacity - (h->head - h->tail) < need) {
+        if (!drop_oldest) {
+            journal->stats.dropped++;
+            return -1;
+        }
+        drop_tail(journal);
+    }
+    
+    uint64_t head = h->head;
+    if (room < len) {
+        record_t *filler = record_at(journal, head);
+        filler->len = (uint32_t)room;
+        filler->state = RECORD_WRAP;
+        head += room;
+    }
+    
+    record_t *record = record_at(journal, head);
+    *record = (record_t){
+        .len = (uint32_t)len,
+        .state = RECORD_PENDING,
+        .qos = qos,
+        .retain = retain,
+        .topic_len = (uint16_t)topic_len,
+        .payload_len = (uint32_t)payload_len,
+        .seq = h->next_seq++,
+    };
+    uint8_t *p = (uint8_t *)(record + 1);
+    memcpy(p, topic, topic_len);
+    p += topic_len;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len) memcpy(p, iov[i].iov_base, iov[i].iov_len);
+        p += iov[i].iov_len;
+    }
+    record->crc = record_crc(record);
+    
+    // Complete before it is visible
+    __atomic_store_n(&h->head, head + len, __ATOMIC_RELEASE);
+    journal->pending++;
+    journal->stats.appended++;
+    return 0;
+}
+
+bool nrx_journal_peek(nrx_journal_t *journal, uint64_t *cursor, nrx_journal_entry_t *entry) {
+    if (!journal || !cursor || !entry) return false;
+    
+    const journal_header_t *h = journal->header;
+    if (*cursor < h->tail) *cursor = h->tail;
+    while (*cursor < h->head) {
+        const record_t *record = record_at(journal, *cursor);
+        if (record->state == RECORD_PENDING) {
+            const char *topic = (const char *)(record + 1);
+            *entry = (nrx_journal_entry_t){
+                .offset = *cursor,
+                .next = *cursor + record->len,
+                .seq = record->seq,
+                .qos = record->qos,
+                .retain = record->retain,
+                .topic = topic,
+                .topic_len = record->topic_len,
+                .payload = (const uint8_t *)topic + record->topic_len,
+                .payload_len = record->payload_len,
+            };
+            return true;
+        }
+        *cursor += record->len;
+    }
+    return false;
+}
+
+void nrx_journal_take(nrx_journal_t *journal, uint64_t offset) {
+    if (!journal) return;
+    const journal_header_t *h = journal->header;
+    if (offset < h->tail || offset >= h->head) return;
+    
+    record_t *record = record_at(journal, offset);
+    if (record->state == RECORD_PENDING) record->state = RECORD_TAKEN;
+}
+
+void nrx_journal_done(nrx_journal_t *journal, uint64_t offset) {
+    if (!journal) return;
+    journal_header_t *h = journal->header;
+    if (offset < h->tail || offset >= h->head) return;
+    
+    record_t *record = record_at(journal, offset);
+    if (record->state != RECORD_PENDING && record->state != RECORD_TAKEN) return;
+    record->state = RECORD_DONE;
+    journal->pending--;
+    
+    // Space comes back once everything before it is done too
+    while (h->tail < h->head && (record_at(journal, h->tail)->state == RECORD_DONE ||
+                                 record_at(journal, h->tail)->state == RECORD_WRAP)) {
+        __atomic_store_n(&h->tail, h->tail + record_at(journal, h->tail)->len, __ATOMIC_RELEASE);
+    }
+}
+
+uint64_t nrx_journal_head(const nrx_journal_t *journal) {
+    return journal ? journal->header->head : 0;
+}
+
+void nrx_journal_get_stats(const nrx_journal_t *journal, nrx_journal_stats_t *stats) {
+    if (!journal || !stats) return;
+    *stats = journal->stats;
+    stats->pending = journal->pending;
+    stats->used_bytes = (size_t)(journal->header->head - journal->header->tail);
+    stats->capacity = (size_t)journal->capacity;
+}
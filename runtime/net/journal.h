@@ -0,0 +1,70 @@
+#ifndef NEUROX_JOURNAL_H
+#define NEUROX_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+// Message journal
+// A bounded append-only ring of messages in a memory-mapped file, used by
+// the MQTT client to store messages for forwarding later. Records are
+// written in place and become visible when the header's head moves past
+// them, so a process that dies mid-append leaves the journal as it was
+// before. Opening an existing journal checks every live record's CRC and
+// cuts the ring at the first bad one. Delivered records are marked done
+// and the tail moves past them; the space is then reused.
+//
+// Offsets are logical and only ever grow (the file position is offset
+// modulo the ring size), so an offset below the tail is known to be gone.
+typedef struct nrx_journal_t nrx_journal_t;
+
+typedef struct {
+    uint64_t offset;            // Of this record
+    uint64_t next;              // Offset just past it
+    uint64_t seq;
+    uint8_t qos;
+    bool retain;
+    const char *topic;          // Not NUL-terminated
+    uint16_t topic_len;
+    const uint8_t *payload;
+    size_t payload_len;
+} nrx_journal_entry_t;
+
+typedef struct {
+    uint64_t appended;
+    uint64_t dropped;           // Pending records overwritten or refused when full;
+                                // taken ones still go out and are not counted
+    uint64_t recovered;         // Pending records found when opened
+    uint64_t truncated;         // Bytes cut off at a bad record when opened
+    size_t pending;
+    size_t used_bytes;
+    size_t capacity;
+} nrx_journal_stats_t;
+
+// Creates the file, or reopens and checks an existing one (whose size then
+// wins over size)
+nrx_journal_t *nrx_journal_open(const char *path, size_t size);
+void nrx_journal_close(nrx_journal_t *journal);
+void nrx_journal_sync(nrx_journal_t *journal);
+
+// When full, drop_oldest makes room by dropping the oldest records,
+// delivered or not; otherwise the new message is refused (-1)
+int nrx_journal_append(nrx_journal_t *journal, uint8_t qos, bool retain,
+                       const char *topic, size_t topic_len,
+                       const struct iovec *iov, int iovcnt, bool drop_oldest);
+
+// First pending record at or after *cursor, without consuming it; a cursor
+// left behind by dropped records moves up to the tail
+bool nrx_journal_peek(nrx_journal_t *journal, uint64_t *cursor, nrx_journal_entry_t *entry);
+
+// A taken record has been copied out by a sender: it is pending until done,
+// but peek skips it and overwriting it is not a drop. Reopening the
+// journal makes it pending again.
+void nrx_journal_take(nrx_journal_t *journal, uint64_t offset);
+void nrx_journal_done(nrx_journal_t *journal, uint64_t offset);
+uint64_t nrx_journal_head(const nrx_journal_t *journal);
+
+void nrx_journal_get_stats(const nrx_journal_t *journal, nrx_journal_stats_t *stats);
+
+#endif // NEUROX_JOURNAL_H
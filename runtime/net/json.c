@@ -0,0 +1,686 @@
+#include "json.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK 64
+
+// Per-block bitmasks, bit i for byte i
+typedef struct {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;                // { } [ ] : ,
+    uint64_t space;
+    uint64_t ctrl;              // Below 0x20
+    uint64_t high;              // Non-ASCII
+} block_t;
+
+// Block classification
+#if defined(__SSE2__) && !defined(NRX_JSON_NO_SIMD)
+#include <emmintrin.h>
+
+static inline uint64_t mask64(const __m128i m[4]) {
+    return (uint64_t)(uint16_t)_mm_movemask_epi8(m[0]) |
+           (uint64_t)(uint16_t)_mm_movemask_epi8(m[1]) << 16 |
+           (uint64_t)(uint16_t)_mm_movemask_epi8(m[2]) << 32 |
+           (uint64_t)(uint16_t)_mm_movemask_epi8(m[3]) << 48;
+}
+
+static inline void classify(const uint8_t *p, block_t *b) {
+    __m128i v[4], quote[4], backslash[4], op[4], space[4], ctrl[4];
+    for (int i = 0; i < 4; i++) {
+        v[i] = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        // '[' and ']' are '{' and '}' without bit 5
+        __m128i folded = _mm_or_si128(v[i], _mm_set1_epi8(0x20));
+        quote[i] = _mm_cmpeq_epi8(v[i], _mm_set1_epi8('"'));
+        backslash[i] = _mm_cmpeq_epi8(v[i], _mm_set1_epi8('\\'));
+        op[i] = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                                          _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+                             _mm_or_si128(_mm_cmpeq_epi8(v[i], _mm_set1_epi8(':')),
+                                          _mm_cmpeq_epi8(v[i], _mm_set1_epi8(','))));
+        space[i] = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v[i], _mm_set1_epi8(' ')),
+                                             _mm_cmpeq_epi8(v[i], _mm_set1_epi8('\n'))),
+                                _mm_or_si128(_mm_cmpeq_epi8(v[i], _mm_set1_epi8('\r')),
+                                             _mm_cmpeq_epi8(v[i], _mm_set1_epi8('\t'))));
+        ctrl[i] = _mm_cmpeq_epi8(_mm_max_epu8(v[i], _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+    }
+    b->quote = mask64(quote);
+    b->backslash = mask64(backslash);
+    b->op = mask64(op);
+    b->space = mask64(space);
+    b->ctrl = mask64(ctrl);
+    b->high = mask64(v);
+}
+
+#else
+
+enum {
+    C_QUOTE = 1,
+    C_BACKSLASH = 2,
+    C_OP = 4,
+    C_SPACE = 8,
+    C_CTRL = 16,
+    C_HIGH = 32,
+};
+
+static uint8_t char_class[256];
+
+static void class_init(void) {
+    for (int c = 0; c < 256; c++) {
+        char_class[c] = c < 0x20 ? C_CTRL : c >= 0x80 ? C_HIGH : 0;
+    }
+    char_class['"'] = C_QUOTE;
+    char_class['\\'] = C_BACKSLASH;
+    char_class['{'] = char_class['}'] = char_class['['] = char_class[']'] = C_OP;
+    char_class[':'] = char_class[','] = C_OP;
+    char_class[' '] = C_SPACE;
+    char_class['\t'] = char_class['\n'] = char_class['\r'] = C_SPACE | C_CTRL;
+}
+
+static inline void classify(const uint8_t *p, block_t *b) {
+    if (!char_class['"']) class_init();
+    *b = (block_t){ 0 };
+    for (int i = 0; i < BLOCK; i++) {
+        uint8_t c = char_class[p[i]];
+        uint64_t bit = 1ULL << i;
+        if (c & C_QUOTE) b->quote |= bit;
+        if (c & C_BACKSLASH) b->backslash |= bit;
+        if (c & C_OP) b->op |= bit;
+        if (c & C_SPACE) b->space |= bit;
+        if (c & C_CTRL) b->ctrl |= bit;
+        if (c & C_HIGH) b->high |= bit;
+    }
+}
+
+#endif
+
+// Characters escaped by a backslash, odd runs of backslashes counting; a
+// run that ends the block escapes the first byte of the next one
+static inline uint64_t find_escaped(uint64_t backslash, uint64_t *carry) {
+    const uint64_t even = 0x5555555555555555ULL;
+    uint64_t escaped = *carry;
+    backslash &= ~escaped;
+    uint64_t follows = backslash << 1 | escaped;
+    uint64_t odd_starts = backslash & ~even & ~follows;
+    uint64_t sum;
+    *carry = __builtin_add_overflow(odd_starts, backslash, &sum);
+    return (even ^ (sum << 1)) & follows;
+}
+
+// Bit i set when an odd number of bits up to i are
+static inline uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Structure
+typedef enum {
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_END,        // After '['
+    EXPECT_KEY,
+    EXPECT_KEY_OR_END,          // After '{'
+    EXPECT_COLON,
+    EXPECT_COMMA_OR_END,
+    IN_STRING,
+    IN_KEY,
+    EXPECT_NOTHING,             // After the root value
+} state_t;
+
+typedef struct {
+    nrx_json_tape_t *tape;
+    const uint8_t *json;
+    const uint8_t *end;
+    state_t state;
+    uint32_t string;            // Node of the open string
+    uint32_t depth;
+    uint32_t stack[NRX_JSON_MAX_DEPTH];
+} parser_t;
+
+static inline bool is_scalar_char(uint8_t c) {
+    return !(c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '"' ||
+             c == ',' || c == ':' || c == '[' || c == ']' || c == '{' || c == '}');
+}
+
+static inline bool is_digit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+static int hex4(const uint8_t *p) {
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t c = p[i];
+        int d = is_digit(c) ? c - '0' : (c | 0x20) >= 'a' && (c | 0x20) <= 'f' ? (c | 0x20) - 'a' + 10 : -1;
+        if (d < 0) return -1;
+        v = v << 4 | d;
+    }
+    return v;
+}
+
+static bool valid_escapes(const uint8_t *p, const uint8_t *end) {
+    while ((p = memchr(p, '\\', (size_t)(end - p)))) {
+        p++;
+        switch (*p) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                p++;
+                break;
+            case 'u': {
+                int cp = end - p >= 5 ? hex4(p + 1) : -1;
+                if (cp < 0 || (cp >= 0xDC00 && cp <= 0xDFFF)) return false;
+                p += 5;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    int low = end - p >= 6 && p[0] == '\\' && p[1] == 'u' ? hex4(p + 2) : -1;
+                    if (low < 0xDC00 || low > 0xDFFF) return false;
+                    p += 6;
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// Strict UTF-8: no overlong forms, surrogates or code points past U+10FFFF
+static bool valid_utf8(const uint8_t *p, const uint8_t *end) {
+    while (p < end) {
+        uint8_t c = *p;
+        if (c < 0x80) {
+            p++;
+            continue;
+        }
+        size_t n = c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+        if (n == 0 || (size_t)(end - p) < n) return false;
+        for (size_t i = 1; i < n; i++) {
+            if ((p[i] & 0xC0) != 0x80) return false;
+        }
+        if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] > 0x9F) ||
+            (c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] > 0x8F)) return false;
+        p += n;
+    }
+    return true;
+}
+
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Integers exactly; other numbers exactly when the digits fit 53 bits and
+// the power of ten is itself exact, and through strtod otherwise
+static const uint8_t *parse_number(const uint8_t *p, const uint8_t *end, nrx_json_node_t *node) {
+    const uint8_t *start = p;
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+    if (p == end || !is_digit(*p)) return NULL;
+    
+    uint64_t mantissa = 0;
+    int exp10 = 0;
+    bool integer = true;
+    bool truncated = false;
+    if (*p == '0') {
+        p++;
+    } else {
+        for (; p < end && is_digit(*p); p++) {
+            unsigned d = *p - '0';
+            if (!truncated && mantissa <= (UINT64_MAX - d) / 10) {
+                mantissa = mantissa * 10 + d;
+            } else {
+                truncated = true;
+                exp10++;
+            }
+        }
+    }
+    if (p < end && *p == '.') {
+        integer = false;
+        p++;
+        if (p == end || !is_digit(*p)) return NULL;
+        for (; p < end && is_digit(*p); p++) {
+            unsigned d = *p - '0';
+            if (!truncated && mantissa <= (UINT64_MAX - d) / 10) {
+                mantissa = mantissa * 10 + d;
+                exp10--;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+    if (p < end && (*p | 0x20) == 'e') {
+        integer = false;
+        p++;
+        bool negative_exp = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        if (p == end || !is_digit(*p)) return NULL;
+        int e = 0;
+        for (; p < end && is_digit(*p); p++) {
+            if (e < 100000) e = e * 10 + (*p - '0');
+        }
+        exp10 += negative_exp ? -e : e;
+    }
+    
+    node->type = NRX_JSON_NUMBER;
+    if (integer && !truncated) {
+        if (!negative && mantissa > (uint64_t)INT64_MAX) {
+            node->flags = NRX_JSON_UINT;
+            node->as.u = mantissa;
+            return p;
+        }
+        if (mantissa <= (uint64_t)INT64_MAX + 1) {
+            node->flags = NRX_JSON_INT;
+            node->as.i = negative ? (int64_t)(0 - mantissa) : (int64_t)mantissa;
+            return p;
+        }
+    }
+    if (!truncated && mantissa <= 1ULL << 53 && exp10 >= -22 && exp10 <= 22) {
+        double v = (double)mantissa;
+        v = exp10 < 0 ? v / pow10_exact[-exp10] : v * pow10_exact[exp10];
+        node->as.f = negative ? -v : v;
+        return p;
+    }
+    
+    char text[128];
+    size_t len = (size_t)(p - start);
+    if (len >= sizeof(text)) return NULL;
+    memcpy(text, start, len);
+    text[len] = '\0';
+    node->as.f = strtod(text, NULL);
+    return p;
+}
+
+static inline uint32_t new_node(parser_t *parser, nrx_json_type_t type) {
+    nrx_json_tape_t *tape = parser->tape;
+    if (tape->count == tape->capacity) return NRX_JSON_NONE;
+    uint32_t index = tape->count++;
+    nrx_json_node_t *node = &tape->nodes[index];
+    node->type = (uint8_t)type;
+    node->flags = 0;
+    node->reserved = 0;
+    node->next = index + 1;
+    return index;
+}
+
+static inline void value_done(parser_t *parser) {
+    parser->state = parser->depth ? EXPECT_COMMA_OR_END : EXPECT_NOTHING;
+}
+
+static inline bool in_object(const parser_t *parser) {
+    return parser->tape->nodes[parser->stack[parser->depth - 1]].type == NRX_JSON_OBJECT;
+}
+
+static inline bool open_string(parser_t *parser, uint32_t pos) {
+    uint32_t node = new_node(parser, NRX_JSON_STRING);
+    if (node == NRX_JSON_NONE) return false;
+    parser->tape->nodes[node].as.str.start = pos + 1;
+    parser->string = node;
+    return true;
+}
+
+static bool scalar(parser_t *parser, uint32_t pos) {
+    uint32_t index = new_node(parser, NRX_JSON_NULL);
+    if (index == NRX_JSON_NONE) return false;
+    nrx_json_node_t *node = &parser->tape->nodes[index];
+    const uint8_t *p = parser->json + pos;
+    size_t room = (size_t)(parser->end - p);
+    
+    if (room >= 4 && memcmp(p, "null", 4) == 0) {
+        p += 4;
+    } else if (room >= 4 && memcmp(p, "true", 4) == 0) {
+        node->type = NRX_JSON_BOOL;
+        node->as.b = true;
+        p += 4;
+    } else if (room >= 5 && memcmp(p, "false", 5) == 0) {
+        node->type = NRX_JSON_BOOL;
+        node->as.b = false;
+        p += 5;
+    } else if (!(p = parse_number(p, parser->end, node))) {
+        return false;
+    }
+    return p == parser->end || !is_scalar_char(*p);
+}
+
+static bool value(parser_t *parser, uint32_t pos) {
+    uint8_t c = parser->json[pos];
+    if (parser->depth && !in_object(parser)) parser->tape->nodes[parser->stack[parser->depth - 1]].as.count++;
+    
+    if (c == '{' || c == '[') {
+        if (parser->depth == NRX_JSON_MAX_DEPTH) return false;
+        uint32_t node = new_node(parser, c == '{' ? NRX_JSON_OBJECT : NRX_JSON_ARRAY);
+        if (node == NRX_JSON_NONE) return false;
+        parser->tape->nodes[node].as.count = 0;
+        parser->stack[parser->depth++] = node;
+        parser->state = c == '{' ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+        return true;
+    }
+    if (c == '"') {
+        parser->state = IN_STRING;
+        return open_string(parser, pos);
+    }
+    if (c == '}' || c == ']' || c == ',' || c == ':') return false;
+    if (!scalar(parser, pos)) return false;
+    value_done(parser);
+    return true;
+}
+
+static void close_container(parser_t *parser) {
+    nrx_json_tape_t *tape = parser->tape;
+    tape->nodes[parser->stack[--parser->depth]].next = tape->count;
+    value_done(parser);
+}
+
+// One structural character: a bracket, colon, comma, either quote, or the
+// first byte of a number or literal
+static inline bool step(parser_t *parser, uint32_t pos) {
+    uint8_t c = parser->json[pos];
+    switch (parser->state) {
+        case IN_STRING:
+        case IN_KEY: {
+            nrx_json_node_t *node = &parser->tape->nodes[parser->string];
+            const uint8_t *start = parser->json + node->as.str.start;
+            node->as.str.len = pos - node->as.str.start;
+            if (memchr(start, '\\', node->as.str.len)) {
+                if (!valid_escapes(start, parser->json + pos)) return false;
+                node->flags = NRX_JSON_ESCAPED;
+            }
+            if (parser->state == IN_KEY) parser->state = EXPECT_COLON;
+            else value_done(parser);
+            return true;
+        }
+        case EXPECT_COLON:
+            parser->state = EXPECT_VALUE;
+            return c == ':';
+        case EXPECT_COMMA_OR_END:
+            if (c == ',') {
+                parser->state = in_object(parser) ? EXPECT_KEY : EXPECT_VALUE;
+                return true;
+            }
+            if (c != (in_object(parser) ? '}' : ']')) return false;
+            close_container(parser);
+            return true;
+        case EXPECT_KEY_OR_END:
+            if (c == '}') {
+                close_container(parser);
+                return true;
+            }
+            // Fall through
+        case EXPECT_KEY:
+            if (c != '"') return false;
+            parser->tape->nodes[parser->stack[parser->depth - 1]].as.count++;
+            parser->state = IN_KEY;
+            return open_string(parser, pos);
+        case EXPECT_VALUE_OR_END:
+            if (c == ']') {
+                close_container(parser);
+                return true;
+            }
+            // Fall through
+        case EXPECT_VALUE:
+            return value(parser, pos);
+        case EXPECT_NOTHING:
+            return false;
+    }
+    return false;
+}
+
+int nrx_json_parse(nrx_json_tape_t *tape, nrx_json_node_t *nodes, size_t capacity,
+                   const char *json, size_t len) {
+    if (!tape) return -1;
+    *tape = (nrx_json_tape_t){
+        .json = json,
+        .len = len,
+        .nodes = nodes,
+        .capacity = capacity < NRX_JSON_NONE ? (uint32_t)capacity : NRX_JSON_NONE - 1,
+    };
+    if (!json || !nodes || len >= NRX_JSON_NONE) return -1;
+    
+    parser_t parser = {
+        .tape = tape,
+        .json = (const uint8_t *)json,
+        .end = (const uint8_t *)json + len,
+        .state = EXPECT_VALUE,
+    };
+    uint64_t escape_carry = 0;
+    uint64_t in_string_carry = 0;
+    uint64_t scalar_carry = 0;
+    uint64_t high = 0;
+    
+    for (size_t base = 0; base < len; base += BLOCK) {
+        block_t b;
+        if (len - base >= BLOCK) {
+            classify(parser.json + base, &b);
+        } else {
+            // The tail, padded with whitespace
+            uint8_t last[BLOCK];
+            memset(last, ' ', sizeof(last));
+            memcpy(last, parser.json + base, len - base);
+            classify(last, &b);
+        }
+        
+        // Unescaped quotes toggle in and out of strings; a string's bits
+        // cover its opening quote and contents but not its closing quote
+        uint64_t quote = b.quote & ~find_escaped(b.backslash, &escape_carry);
+        uint64_t in_string = prefix_xor(quote) ^ in_string_carry;
+        in_string_carry = (uint64_t)((int64_t)in_string >> 63);
+        
+        // Numbers and literals start where a run of other bytes begins
+        uint64_t scalar = ~(b.op | b.space | quote | in_string);
+        uint64_t scalar_start = scalar & ~(scalar << 1 | scalar_carry);
+        scalar_carry = scalar >> 63;
+        
+        uint64_t bad = b.ctrl & in_string;
+        uint64_t structural = (b.op & ~in_string) | quote | scalar_start;
+        if (bad) {
+            // Stop at the control character, unless the structure breaks first
+            structural &= (bad & -bad) - 1;
+        }
+        high |= b.high;
+        
+        while (structural) {
+            uint32_t pos = (uint32_t)(base + (size_t)__builtin_ctzll(structural));
+            structural &= structural - 1;
+            if (!step(&parser, pos)) {
+                tape->error_at = pos;
+                return -1;
+            }
+        }
+        if (bad) {
+            tape->error_at = base + (size_t)__builtin_ctzll(bad);
+            return -1;
+        }
+    }
+    
+    if (parser.state != EXPECT_NOTHING || (high && !valid_utf8(parser.json, parser.end))) {
+        tape->error_at = len;
+        return -1;
+    }
+    return 0;
+}
+
+// Queries
+static const nrx_json_node_t *node_at(const nrx_json_tape_t *tape, uint32_t node, nrx_json_type_t type) {
+    if (!tape || node >= tape->count || tape->nodes[node].type != type) return NULL;
+    return &tape->nodes[node];
+}
+
+static size_t put_utf8(char *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | cp >> 12);
+        out[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | cp >> 18);
+    out[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    out[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// The parser has already checked every escape
+static bool unescape(const uint8_t *p, size_t len, char *out, size_t cap, size_t *out_len) {
+    const uint8_t *end = p + len;
+    size_t n = 0;
+    while (p < end) {
+        if (*p != '\\') {
+            if (n + 1 >= cap) return false;
+            out[n++] = (char)*p++;
+            continue;
+        }
+        
+        uint8_t e = p[1];
+        p += 2;
+        if (e == 'u') {
+            uint32_t cp = (uint32_t)hex4(p);
+            p += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint32_t)hex4(p + 2) - 0xDC00);
+                p += 6;
+            }
+            char utf8[4];
+            size_t m = put_utf8(utf8, cp);
+            if (n + m >= cap) return false;
+            memcpy(out + n, utf8, m);
+            n += m;
+            continue;
+        }
+        if (n + 1 >= cap) return false;
+        out[n++] = e == 'b' ? '\b' : e == 'f' ? '\f' : e == 'n' ? '\n' : e == 'r' ? '\r' : e == 't' ? '\t' : (char)e;
+    }
+    if (cap == 0) return false;
+    out[n] = '\0';
+    if (out_len) *out_len = n;
+    return true;
+}
+
+static bool key_equals(const nrx_json_tape_t *tape, const nrx_json_node_t *key, const nrx_json_step_t *step) {
+    const char *text = tape->json + key->as.str.start;
+    if (!(key->flags & NRX_JSON_ESCAPED)) {
+        return key->as.str.len == step->len && memcmp(text, step->key, step->len) == 0;
+    }
+    
+    char plain[256];
+    size_t len;
+    return unescape((const uint8_t *)text, key->as.str.len, plain, sizeof(plain), &len) &&
+           len == step->len && memcmp(plain, step->key, len) == 0;
+}
+
+uint32_t nrx_json_find(const nrx_json_tape_t *tape, uint32_t node,
+                       const nrx_json_step_t *path, size_t steps) {
+    for (size_t s = 0; s < steps; s++) {
+        const nrx_json_node_t *parent = node_at(tape, node, path[s].key ? NRX_JSON_OBJECT : NRX_JSON_ARRAY);
+        if (!parent) return NRX_JSON_NONE;
+        
+        uint32_t child = node + 1;
+        if (path[s].key) {
+            while (child < parent->next && !key_equals(tape, &tape->nodes[child], &path[s])) {
+                child = tape->nodes[child + 1].next;
+            }
+            if (child == parent->next) return NRX_JSON_NONE;
+            node = child + 1;
+        } else {
+            if (path[s].len >= parent->as.count) return NRX_JSON_NONE;
+            for (uint32_t i = 0; i < path[s].len; i++) child = tape->nodes[child].next;
+            node = child;
+        }
+    }
+    return node;
+}
+
+bool nrx_json_lookup(const nrx_json_tape_t *tape, uint32_t object,
+                     const nrx_json_step_t *keys, size_t count, uint32_t *found) {
+    const nrx_json_node_t *parent = node_at(tape, object, NRX_JSON_OBJECT);
+    for (size_t i = 0; i < count; i++) found[i] = NRX_JSON_NONE;
+    if (!parent) return false;
+    
+    size_t missing = count;
+    size_t expected = 0;
+    for (uint32_t member = object + 1; member < parent->next && missing; member = tape->nodes[member + 1].next) {
+        const nrx_json_node_t *key = &tape->nodes[member];
+        size_t j = expected;
+        for (size_t tries = 0; tries < count; tries++) {
+            if (found[j] == NRX_JSON_NONE && key_equals(tape, key, &keys[j])) {
+                found[j] = member + 1;
+                missing--;
+                expected = j + 1 == count ? 0 : j + 1;
+                break;
+            }
+            j = j + 1 == count ? 0 : j + 1;
+        }
+    }
+    return missing == 0;
+}
+
+bool nrx_json_get_bool(const nrx_json_tape_t *tape, uint32_t node, bool *value) {
+    const nrx_json_node_t *n = node_at(tape, node, NRX_JSON_BOOL);
+    if (!n) return false;
+    *value = n->as.b;
+    return true;
+}
+
+bool nrx_json_get_i64(const nrx_json_tape_t *tape, uint32_t node, int64_t *value) {
+    const nrx_json_node_t *n = node_at(tape, node, NRX_JSON_NUMBER);
+    if (!n || (n->flags & NRX_JSON_UINT)) return false;
+    if (n->flags & NRX_JSON_INT) {
+        *value = n->as.i;
+        return true;
+    }
+    double f = n->as.f;
+    if (!(f >= -9223372036854775808.0 && f < 9223372036854775808.0) || f != (double)(int64_t)f) return false;
+    *value = (int64_t)f;
+    return true;
+}
+
+bool nrx_json_get_u64(const nrx_json_tape_t *tape, uint32_t node, uint64_t *value) {
+    const nrx_json_node_t *n = node_at(tape, node, NRX_JSON_NUMBER);
+    if (!n) return false;
+    if (n->flags & NRX_JSON_UINT) {
+        *value = n->as.u;
+        return true;
+    }
+    if (n->flags & NRX_JSON_INT) {
+        if (n->as.i < 0) return false;
+        *value = (uint64_t)n->as.i;
+        return true;
+    }
+    double f = n->as.f;
+    if (!(f >= 0.0 && f < 18446744073709551616.0) || f != (double)(uint64_t)f) return false;
+    *value = (uint64_t)f;
+    return true;
+}
+
+bool nrx_json_get_f64(const nrx_json_tape_t *tape, uint32_t node, double *value) {
+    const nrx_json_node_t *n = node_at(tape, node, NRX_JSON_NUMBER);
+    if (!n) return false;
+    *value = n->flags & NRX_JSON_INT ? (double)n->as.i : n->flags & NRX_JSON_UINT ? (double)n->as.u : n->as.f;
+    return true;
+}
+
+bool nrx_json_get_f32(const nrx_json_tape_t *tape, uint32_t node, float *value) {
+    double v;
+    if (!nrx_json_get_f64(tape, node, &v)) return false;
+    
+    // Converting a finite double beyond the float range is undefined
+    if (isfinite(v) && fabs(v) > FLT_MAX) return false;
+    *value = (float)v;
+    return true;
+}
+
+bool nrx_json_get_string(const nrx_json_tape_t *tape, uint32_t node, char *out, size_t cap, size_t *len) {
+    const nrx_json_node_t *n = node_at(tape, node, NRX_JSON_STRING);
+    if (!n || !out) return false;
+    return unescape((const uint8_t *)tape->json + n->as.str.start, n->as.str.len, out, cap, len);
+}
@@ -0,0 +1,109 @@
+#ifndef NEUROX_JSON_H
+#define NEUROX_JSON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// JSON parser
+// A validating parser for inbound messages that allocates nothing: it
+// fills a tape of nodes in storage the caller supplies, and strings on the
+// tape point back into the received buffer. The input is scanned 64 bytes
+// at a time. Each block is classified with SSE2 (or a plain loop; define
+// NRX_JSON_NO_SIMD to force it) into bitmasks of quotes, backslashes,
+// structural characters and whitespace. Escaped quotes and string
+// interiors are then worked out with bit arithmetic, so only the
+// structural positions are visited one by one.
+//
+// Values are laid out in document order. An object's node is followed by
+// key, value, key, value..., an array's by its elements. Every node's
+// `next` is the index just past the value and everything in it, so
+// siblings are one hop apart. The root value is node 0.
+//
+// Generated message decoders look fields up with constant key tables,
+// see nrx_json_lookup().
+typedef enum {
+    NRX_JSON_NULL,
+    NRX_JSON_BOOL,
+    NRX_JSON_NUMBER,
+    NRX_JSON_STRING,
+    NRX_JSON_ARRAY,
+    NRX_JSON_OBJECT,
+} nrx_json_type_t;
+
+// Node flags
+#define NRX_JSON_INT 0x01       // Integer number, in as.i
+#define NRX_JSON_UINT 0x02      // Integer above INT64_MAX, in as.u
+#define NRX_JSON_ESCAPED 0x04   // String with escapes, left as they are in as.str
+
+#define NRX_JSON_NONE UINT32_MAX
+#define NRX_JSON_MAX_DEPTH 64
+
+// Tape size for a flat message of the given field count, with room to
+// spare for members the decoder does not know
+#define NRX_JSON_MESSAGE_NODES(fields) (2 * (fields) + 33)
+
+typedef struct {
+    uint8_t type;               // nrx_json_type_t
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t next;
+    union {
+        struct {
+            uint32_t start;     // Byte offset, just past the opening quote
+            uint32_t len;
+        } str;
+        uint32_t count;         // Object members or array elements
+        bool b;
+        int64_t i;
+        uint64_t u;
+        double f;
+    } as;
+} nrx_json_node_t;
+
+typedef struct {
+    const char *json;
+    size_t len;
+    nrx_json_node_t *nodes;
+    uint32_t capacity;
+    uint32_t count;
+    size_t error_at;            // Byte offset of the first problem
+} nrx_json_tape_t;
+
+// 0 on success; -1 if the input is not valid JSON (including bad UTF-8,
+// bad escapes and nesting deeper than NRX_JSON_MAX_DEPTH) or does not fit
+// in capacity nodes. Numbers longer than 127 characters are refused.
+int nrx_json_parse(nrx_json_tape_t *tape, nrx_json_node_t *nodes, size_t capacity,
+                   const char *json, size_t len);
+
+// One step of a path: an object key, or with key NULL an array index
+typedef struct {
+    const char *key;
+    uint32_t len;               // Key length, or the index
+} nrx_json_step_t;
+
+#define NRX_JSON_KEY(s) { s, sizeof(s) - 1 }
+#define NRX_JSON_INDEX(i) { NULL, i }
+
+// Node at the end of the path from node, or NRX_JSON_NONE
+uint32_t nrx_json_find(const nrx_json_tape_t *tape, uint32_t node,
+                       const nrx_json_step_t *path, size_t steps);
+
+// The values of several keys of one object in a single pass, expecting
+// them roughly in the order given; found[i] is NRX_JSON_NONE for a missing
+// key. True when every key was found. With duplicate keys the first wins.
+bool nrx_json_lookup(const nrx_json_tape_t *tape, uint32_t object,
+                     const nrx_json_step_t *keys, size_t count, uint32_t *found);
+
+// Typed reads; false on the wrong type or a number that does not fit.
+// Integer reads accept floats with no fractional part.
+bool nrx_json_get_bool(const nrx_json_tape_t *tape, uint32_t node, bool *value);
+bool nrx_json_get_i64(const nrx_json_tape_t *tape, uint32_t node, int64_t *value);
+bool nrx_json_get_u64(const nrx_json_tape_t *tape, uint32_t node, uint64_t *value);
+bool nrx_json_get_f64(const nrx_json_tape_t *tape, uint32_t node, double *value);
+bool nrx_json_get_f32(const nrx_json_tape_t *tape, uint32_t node, float *value);
+
+// Unescaped and NUL-terminated into out; false if it does not fit
+bool nrx_json_get_string(const nrx_json_tape_t *tape, uint32_t node, char *out, size_t cap, size_t *len);
+
+#endif // NEUROX_JSON_H
@@ -1,37 +1,1186 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "mqtt.h"
+#include "scheduler.h"
+#include "log.h"
+#include "journal.h"
+#include "topic_trie.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
-// Mock MQTT implementation for testing
-// In production, this would use a real MQTT library like Paho or Mosquitto
+#define MQTT_DEFAULT_PORT "1883"
+#define MQTT_DEFAULT_TLS_PORT "8883"
+#define MQTT_CONNECT_TIMEOUT_US 10000000ULL
+#define MQTT_RX_QOS2_MAX 32             // Incoming QoS 2 messages awaiting PUBREL
+#define MQTT_SEND_BATCH 16              // Queued messages handed to one sendmsg
+#define MQTT_MATCH_MAX 32               // Subscriptions one message is delivered to
+
+// Packet types
+enum {
+    MQTT_CONNECT = 1,
+    MQTT_CONNACK,
+    MQTT_PUBLISH,
+    MQTT_PUBACK,
+    MQTT_PUBREC,
+    MQTT_PUBREL,
+    MQTT_PUBCOMP,
+    MQTT_SUBSCRIBE,
+    MQTT_SUBACK,
+    MQTT_UNSUBSCRIBE,
+    MQTT_UNSUBACK,
+    MQTT_PINGREQ,
+    MQTT_PINGRESP,
+    MQTT_DISCONNECT,
+};
+
+// MQTT 5 properties this client reads
+enum {
+    MQTT_PROP_SERVER_KEEP_ALIVE = 0x13,
+    MQTT_PROP_RECEIVE_MAXIMUM = 0x21,
+    MQTT_PROP_TOPIC_ALIAS_MAXIMUM = 0x22,
+    MQTT_PROP_TOPIC_ALIAS = 0x23,
+    MQTT_PROP_MAXIMUM_PACKET_SIZE = 0x27,
+};
+
+// Outgoing QoS 1/2 message, kept encoded until the broker has it
+typedef enum {
+    SLOT_FREE,
+    SLOT_UNSENT,                // Queued offline or over the broker's receive maximum
+    SLOT_WAIT_ACK,              // PUBLISH sent, waiting for PUBACK or PUBREC
+    SLOT_WAIT_COMP,             // PUBREL sent, waiting for PUBCOMP
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    uint16_t packet_id;
+    bool sent_before;           // Resend with DUP
+    uint32_t seq;               // Publish order
+    size_t len;
+    uint8_t *packet;
+    
+    // Published through a handle: the header may need rewriting on a new
+    // connection, where the broker no longer knows the alias
+    nrx_mqtt_topic_t *topic;
+    uint16_t alias;
+    bool alias_only;
+    size_t head_len;
+    
+    // Loaded from the journal: marked done there once acknowledged
+    bool journaled;
+    uint64_t journal_offset;
+} inflight_t;
+
+struct nrx_mqtt_topic_t {
+    nrx_mqtt_client_t *client;
+    nrx_mqtt_topic_t *next;
+    nrx_mqtt_qos_t qos;
+    bool retain;
+    uint16_t alias;             // Fixed per handle; used if the broker allows it
+    bool alias_live;            // Broker has seen name and alias on this connection
+    uint8_t *head;              // Scratch for the header of the next publish
+    
+    // Latest-value-wins: QoS 0 values wait here for the next write, and a
+    // newer value replaces an older one still waiting (QoS 1/2: still unsent)
+    bool latest;
+    bool journaled;             // QoS 0 kept in the journal while offline
+    bool dirty;
+    uint8_t *state;
+    size_t state_len;
+    nrx_mqtt_topic_t *next_dirty;
+    size_t encoded_len;         // Last payload from publish_encoded, to size its header
+    size_t name_len;
+    uint8_t name[];             // Encoded topic name: length prefix and bytes
+};
+
+// Value of a filter in the subscription trie
+typedef struct {
+    nrx_mqtt_qos_t qos;
+    nrx_mqtt_message_cb_t callback;
+    void *user_data;
+} subscription_t;
 
 struct nrx_mqtt_client_t {
     nrx_mqtt_config_t config;
     nrx_mqtt_state_t state;
     nrx_mqtt_stats_t stats;
     
-    // Subscription list
-    char **subscriptions;
-    size_t subscription_count;
+    // Connection
+    char *host;
+    char port[8];
+    int fd;
+    bool want_connected;        // Between connect() and disconnect()
+    bool tcp_up;                // Socket connected, CONNECT sent
+    bool was_connected;
+    uint64_t connect_started_us;
+    uint64_t last_tx_us;
+    bool ping_pending;
+    uint64_t ping_sent_us;
+    uint32_t keepalive_us;
+    uint32_t attempt;           // Failed connects in a row
+    uint64_t retry_at_us;
+    uint32_t rng;
+    
+    // Broker limits (MQTT 5), defaults otherwise
+    uint16_t send_quota;
+    uint32_t server_max_packet;
+    uint16_t alias_max;
+    
+    // Buffers, all allocated at create
+    uint8_t *tx;
+    size_t tx_off, tx_len, tx_cap;
+    uint8_t *rx;
+    size_t rx_len, rx_cap;
+    char *topic;                // NUL-terminated topic of the message being delivered
+    uint8_t *scratch;           // Encoded payloads on their way to a slot or the journal
+    
+    // Batching: packets wait in tx until the window closes, the queue is half
+    // full or a control packet needs to go
+    bool batch_open;
+    bool tx_urgent;
+    uint64_t batch_start_us;
+    nrx_mqtt_topic_t *dirty_head;
+    nrx_mqtt_topic_t **dirty_tail;
+    
+    inflight_t *inflight;
+    uint16_t inflight_sent;     // Slots in WAIT_ACK or WAIT_COMP
+    uint16_t next_id;
+    uint32_t next_seq;
+    uint16_t rx_qos2[MQTT_RX_QOS2_MAX];
+    size_t rx_qos2_count;
+    
+    // Subscriptions, restored on every connect
+    nrx_topic_trie_t *subscriptions;
+    
+    nrx_mqtt_topic_t *topics;
+    uint16_t topic_count;
+    
+    // Store and forward: messages are loaded from feed_cursor on, and the
+    // backlog found on connecting (before replay_end) spends replay credit
+    nrx_journal_t *journal;
+    uint64_t feed_cursor;
+    uint64_t replay_end;
+    uint64_t replay_credit;     // Messages, in millionths
+    uint64_t replay_refill_us;
 };
 
+// Encoding
+typedef struct {
+    uint8_t *p;
+    size_t len;
+} writer_t;
+
+static void w_byte(writer_t *w, uint8_t b) {
+    w->p[w->len++] = b;
+}
+
+static void w_u16(writer_t *w, uint16_t v) {
+    w->p[w->len++] = (uint8_t)(v >> 8);
+    w->p[w->len++] = (uint8_t)v;
+}
+
+static void w_u32(writer_t *w, uint32_t v) {
+    w_u16(w, (uint16_t)(v >> 16));
+    w_u16(w, (uint16_t)v);
+}
+
+static void w_bytes(writer_t *w, const void *data, size_t len) {
+    if (len) memcpy(w->p + w->len, data, len);
+    w->len += len;
+}
+
+static void w_str(writer_t *w, const char *s, size_t len) {
+    w_u16(w, (uint16_t)len);
+    w_bytes(w, s, len);
+}
+
+static void w_varint(writer_t *w, uint32_t v) {
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        w_byte(w, v ? b | 0x80 : b);
+    } while (v);
+}
+
+static size_t varint_len(uint32_t v) {
+    return v < 128 ? 1 : v < 16384 ? 2 : v < 2097152 ? 3 : 4;
+}
+
+// Bytes for a fixed header with this remaining length
+static size_t packet_len(size_t remaining) {
+    return 1 + varint_len((uint32_t)remaining) + remaining;
+}
+
+// Timestamps taken during this loop pass can be later than its `now`
+static uint64_t elapsed_us(uint64_t now, uint64_t then) {
+    return now > then ? now - then : 0;
+}
+
+static bool is_v5(const nrx_mqtt_client_t *client) {
+    return client->config.protocol_version == NRX_MQTT_V5;
+}
+
+static size_t publish_remaining(const nrx_mqtt_client_t *client, size_t topic_len, size_t len, nrx_mqtt_qos_t qos) {
+    return 2 + topic_len + (qos ? 2 : 0) + (is_v5(client) ? 1 : 0) + len;
+}
+
+// Whole PUBLISH into buf; 0 when it does not fit
+static size_t encode_publish(const nrx_mqtt_client_t *client, uint8_t *buf, size_t cap,
+                             const char *topic, size_t topic_len, const uint8_t *payload, size_t len,
+                             nrx_mqtt_qos_t qos, bool retain, uint16_t packet_id) {
+    if (topic_len > UINT16_MAX) return 0;
+    
+    size_t remaining = publish_remaining(client, topic_len, len, qos);
+    size_t total = packet_len(remaining);
+    if (total > cap || total > client->server_max_packet) return 0;
+    
+    writer_t w = { buf, 0 };
+    w_byte(&w, (uint8_t)(MQTT_PUBLISH << 4 | qos << 1 | (retain ? 1 : 0)));
+    w_varint(&w, (uint32_t)remaining);
+    w_str(&w, topic, topic_len);
+    if (qos) w_u16(&w, packet_id);
+    if (is_v5(client)) w_byte(&w, 0);       // No properties
+    w_bytes(&w, payload, len);
+    return w.len;
+}
+
+// Everything before the payload of a PUBLISH through a handle, into
+// topic->head. The name is left empty once the broker knows the alias.
+static size_t encode_topic_head(const nrx_mqtt_client_t *client, nrx_mqtt_topic_t *topic, size_t len,
+                                uint16_t packet_id, uint16_t *alias, bool *alias_only) {
+    bool use_alias = is_v5(client) && topic->alias <= client->alias_max;
+    *alias = use_alias ? topic->alias : 0;
+    *alias_only = use_alias && topic->alias_live;
+    
+    size_t remaining = (*alias_only ? 2 : topic->name_len) + (topic->qos ? 2 : 0) +
+                       (is_v5(client) ? (use_alias ? 4 : 1) : 0) + len;
+    if (packet_len(remaining) > client->server_max_packet) return 0;
+    
+    writer_t w = { topic->head, 0 };
+    w_byte(&w, (uint8_t)(MQTT_PUBLISH << 4 | topic->qos << 1 | (topic->retain ? 1 : 0)));
+    w_varint(&w, (uint32_t)remaining);
+    if (*alias_only) w_u16(&w, 0);
+    else w_bytes(&w, topic->name, topic->name_len);
+    if (topic->qos) w_u16(&w, packet_id);
+    if (use_alias) {
+        w_byte(&w, 3);
+        w_byte(&w, MQTT_PROP_TOPIC_ALIAS);
+        w_u16(&w, topic->alias);
+    } else if (is_v5(client)) {
+        w_byte(&w, 0);
+    }
+    return w.len;
+}
+
+// Sending
+static void connection_lost(nrx_mqtt_client_t *client, int reason, const char *cause);
+
+static void tx_flush(nrx_mqtt_client_t *client);
+
+// Room for n more bytes at the end of the TX queue, or NULL
+static uint8_t *tx_reserve(nrx_mqtt_client_t *client, size_t n) {
+    // A batch that fills the queue goes out early rather than dropping
+    if (client->tx_len + n > client->tx_cap && client->config.batch_window_us && client->tx_off < client->tx_len) {
+        tx_flush(client);
+        if (client->fd < 0) return NULL;
+    }
+    if (client->tx_len + n > client->tx_cap && client->tx_off > 0) {
+        memmove(client->tx, client->tx + client->tx_off, client->tx_len - client->tx_off);
+        client->tx_len -= client->tx_off;
+        client->tx_off = 0;
+    }
+    if (client->tx_len + n > client->tx_cap) return NULL;
+    return client->tx + client->tx_len;
+}
+
+static bool tx_queue(nrx_mqtt_client_t *client, const uint8_t *data, size_t len) {
+    uint8_t *p = tx_reserve(client, len);
+    if (!p) return false;
+    memcpy(p, data, len);
+    client->tx_len += len;
+    return true;
+}
+
+static void tx_flush(nrx_mqtt_client_t *client) {
+    while (client->fd >= 0 && client->tcp_up && client->tx_off < client->tx_len) {
+        ssize_t n = send(client->fd, client->tx + client->tx_off, client->tx_len - client->tx_off,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            client->tx_off += (size_t)n;
+            client->stats.bytes_sent += (uint32_t)n;
+            client->stats.writes++;
+            client->last_tx_us = nrx_time_now_us();
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            connection_lost(client, errno, "send failed");
+            return;
+        }
+    }
+    
+    if (client->tx_off == client->tx_len) {
+        client->tx_off = 0;
+        client->tx_len = 0;
+    }
+}
+
+// Queued bytes and then iov in one sendmsg, straight from the callers'
+// buffers; whatever the socket does not take is copied to the queue. While
+// batching, everything is queued. False, with nothing sent, if there would
+// be no room to queue the rest.
+static bool tx_sendv(nrx_mqtt_client_t *client, const struct iovec *iov, int count, size_t total) {
+    if (!tx_reserve(client, total)) return false;
+    
+    struct iovec vec[MQTT_SEND_BATCH + 1];
+    size_t pending = client->tx_len - client->tx_off;
+    int n_vec = 0;
+    if (pending) vec[n_vec++] = (struct iovec){ client->tx + client->tx_off, pending };
+    for (int i = 0; i < count; i++) vec[n_vec++] = iov[i];
+    
+    size_t sent = 0;
+    if (client->fd >= 0 && client->tcp_up && !client->config.batch_window_us) {
+        struct msghdr msg = { .msg_iov = vec, .msg_iovlen = (size_t)n_vec };
+        ssize_t n;
+        do {
+            n = sendmsg(client->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (n < 0 && errno == EINTR);
+        
+        if (n > 0) {
+            sent = (size_t)n;
+            client->stats.bytes_sent += (uint32_t)n;
+            client->stats.writes++;
+            client->last_tx_us = nrx_time_now_us();
+        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            connection_lost(client, errno, "send failed");
+            return false;
+        }
+    }
+    
+    if (sent >= pending) {
+        client->tx_off = client->tx_len = 0;
+        sent -= pending;
+    } else {
+        client->tx_off += sent;
+        sent = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        size_t skip = sent < iov[i].iov_len ? sent : iov[i].iov_len;
+        sent -= skip;
+        memcpy(client->tx + client->tx_len, (const uint8_t *)iov[i].iov_base + skip, iov[i].iov_len - skip);
+        client->tx_len += iov[i].iov_len - skip;
+    }
+    return true;
+}
+
+static void drop_state(nrx_mqtt_client_t *client) {
+    while (client->dirty_head) {
+        client->dirty_head->dirty = false;
+        client->dirty_head = client->dirty_head->next_dirty;
+        client->stats.messages_dropped++;
+    }
+    client->dirty_tail = &client->dirty_head;
+}
+
+// Waiting state values into the queue, oldest topic first
+static void emit_state(nrx_mqtt_client_t *client) {
+    while (client->dirty_head) {
+        nrx_mqtt_topic_t *topic = client->dirty_head;
+        uint16_t alias;
+        bool alias_only;
+        size_t head_len = encode_topic_head(client, topic, topic->state_len, 0, &alias, &alias_only);
+        uint8_t *p = head_len ? tx_reserve(client, head_len + topic->state_len) : NULL;
+        if (!p && head_len && client->fd >= 0) return;      // Socket backed up: next time
+        
+        client->dirty_head = topic->next_dirty;
+        if (!client->dirty_head) client->dirty_tail = &client->dirty_head;
+        topic->dirty = false;
+        if (!p) {
+            client->stats.messages_dropped++;
+            if (client->fd < 0) drop_state(client);
+            continue;
+        }
+        
+        memcpy(p, topic->head, head_len);
+        if (topic->state_len) memcpy(p + head_len, topic->state, topic->state_len);
+        client->tx_len += head_len + topic->state_len;
+        if (alias) topic->alias_live = true;
+        if (alias_only) client->stats.aliased++;
+        client->stats.messages_sent++;
+    }
+}
+
+// Send what is queued now, unless batching and the window is still open
+static void tx_kick(nrx_mqtt_client_t *client) {
+    if (client->tx_off == client->tx_len && !client->dirty_head) {
+        client->batch_open = false;
+        return;
+    }
+    
+    uint64_t now = nrx_time_now_us();
+    if (!client->batch_open) {
+        client->batch_open = true;
+        client->batch_start_us = now;
+    }
+    if (client->tx_urgent || client->config.batch_window_us == 0 ||
+        elapsed_us(now, client->batch_start_us) >= client->config.batch_window_us ||
+        client->tx_len - client->tx_off >= client->tx_cap / 2) {
+        emit_state(client);
+        tx_flush(client);
+        client->tx_urgent = false;
+        if (client->tx_off == client->tx_len && !client->dirty_head) client->batch_open = false;
+    }
+}
+
+// PUBACK, PUBREC, PUBREL, PUBCOMP (and the 2-byte ones)
+static void send_ack(nrx_mqtt_client_t *client, uint8_t type, uint16_t packet_id) {
+    uint8_t packet[4] = {
+        (uint8_t)(type << 4 | (type == MQTT_PUBREL ? 0x02 : 0)), 2,
+        (uint8_t)(packet_id >> 8), (uint8_t)packet_id,
+    };
+    if (!tx_queue(client, packet, sizeof(packet))) {
+        connection_lost(client, ENOBUFS, "send queue full");
+    }
+    client->tx_urgent = true;
+}
+
+static uint16_t next_packet_id(nrx_mqtt_client_t *client) {
+    for (;;) {
+        uint16_t id = ++client->next_id;
+        if (id == 0) continue;
+        
+        bool in_use = false;
+        for (uint16_t i = 0; i < client->config.max_inflight && !in_use; i++) {
+            in_use = client->inflight[i].state != SLOT_FREE && client->inflight[i].packet_id == id;
+        }
+        if (!in_use) return id;
+    }
+}
+
+static bool send_subscribe(nrx_mqtt_client_t *client, const char *topic, nrx_mqtt_qos_t qos, bool subscribe) {
+    size_t topic_len = strlen(topic);
+    size_t remaining = 2 + (is_v5(client) ? 1 : 0) + 2 + topic_len + (subscribe ? 1 : 0);
+    uint8_t *p = tx_reserve(client, packet_len(remaining));
+    if (!p || topic_len > UINT16_MAX) return false;
+    
+    writer_t w = { p, 0 };
+    w_byte(&w, subscribe ? MQTT_SUBSCRIBE << 4 | 0x02 : MQTT_UNSUBSCRIBE << 4 | 0x02);
+    w_varint(&w, (uint32_t)remaining);
+    w_u16(&w, next_packet_id(client));
+    if (is_v5(client)) w_byte(&w, 0);
+    w_str(&w, topic, topic_len);
+    if (subscribe) w_byte(&w, (uint8_t)qos);
+    client->tx_len += w.len;
+    client->tx_urgent = true;
+    return true;
+}
+
+static bool send_connect(nrx_mqtt_client_t *client) {
+    const nrx_mqtt_config_t *c = &client->config;
+    size_t id_len = strlen(c->client_id);
+    size_t user_len = c->username ? strlen(c->username) : 0;
+    size_t pass_len = c->password ? strlen(c->password) : 0;
+    
+    // MQTT 5: tell the broker how much we can take
+    size_t props_len = is_v5(client) ? (1 + 2) + (1 + 4) : 0;
+    size_t remaining = 6 + 1 + 1 + 2 +
+                       (is_v5(client) ? varint_len((uint32_t)props_len) + props_len : 0) +
+                       2 + id_len +
+                       (c->username ? 2 + user_len : 0) +
+                       (c->password ? 2 + pass_len : 0);
+    uint8_t *p = tx_reserve(client, packet_len(remaining));
+    if (!p) return false;
+    
+    uint8_t flags = c->clean_session ? 0x02 : 0;
+    if (c->username) flags |= 0x80;
+    if (c->password) flags |= 0x40;
+    
+    writer_t w = { p, 0 };
+    w_byte(&w, MQTT_CONNECT << 4);
+    w_varint(&w, (uint32_t)remaining);
+    w_str(&w, "MQTT", 4);
+    w_byte(&w, c->protocol_version);
+    w_byte(&w, flags);
+    w_u16(&w, c->keepalive_sec);
+    if (is_v5(client)) {
+        w_varint(&w, (uint32_t)props_len);
+        w_byte(&w, MQTT_PROP_RECEIVE_MAXIMUM);
+        w_u16(&w, MQTT_RX_QOS2_MAX);
+        w_byte(&w, MQTT_PROP_MAXIMUM_PACKET_SIZE);
+        w_u32(&w, (uint32_t)client->rx_cap);
+    }
+    w_str(&w, c->client_id, id_len);
+    if (c->username) w_str(&w, c->username, user_len);
+    if (c->password) w_str(&w, c->password, pass_len);
+    client->tx_len += w.len;
+    client->tx_urgent = true;
+    return true;
+}
+
+// Rewrite a handle's stored PUBLISH for this connection: the name goes back
+// in if the broker has not seen the alias yet, and the alias comes out if
+// it is no longer allowed. False if it no longer fits.
+static bool refresh_topic_head(nrx_mqtt_client_t *client, inflight_t *slot) {
+    nrx_mqtt_topic_t *topic = slot->topic;
+    bool stale = (slot->alias_only && !topic->alias_live) || slot->alias > client->alias_max ||
+                 (is_v5(client) && topic->alias <= client->alias_max && !slot->alias);
+    if (!stale) return true;
+    
+    size_t len = slot->len - slot->head_len;
+    uint16_t alias;
+    bool alias_only;
+    size_t head_len = encode_topic_head(client, topic, len, slot->packet_id, &alias, &alias_only);
+    if (head_len == 0 || head_len + len > client->config.max_packet_size) return false;
+    
+    memmove(slot->packet + head_len, slot->packet + slot->head_len, len);
+    memcpy(slot->packet, topic->head, head_len);
+    slot->head_len = head_len;
+    slot->len = head_len + len;
+    slot->alias = alias;
+    slot->alias_only = alias_only;
+    return true;
+}
+
+// Queued QoS 1/2 messages in publish order, as the broker's receive maximum
+// allows, handed to the socket in batches straight from their slots
+static void send_pending(nrx_mqtt_client_t *client) {
+    while (client->state == NRX_MQTT_CONNECTED && client->inflight_sent < client->send_quota) {
+        inflight_t *batch[MQTT_SEND_BATCH];
+        bool named[MQTT_SEND_BATCH];
+        struct iovec iov[MQTT_SEND_BATCH];
+        size_t room = client->tx_cap - (client->tx_len - client->tx_off);
+        size_t total = 0;
+        int count = 0;
+        
+        while (count < MQTT_SEND_BATCH && client->inflight_sent + count < client->send_quota) {
+            inflight_t *oldest = NULL;
+            for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+                inflight_t *slot = &client->inflight[i];
+                if (slot->state == SLOT_UNSENT && (!oldest || slot->seq - oldest->seq > UINT32_MAX / 2)) {
+                    oldest = slot;
+                }
+            }
+            if (!oldest) break;
+            
+            if (oldest->topic && !refresh_topic_head(client, oldest)) {
+                oldest->state = SLOT_FREE;
+                client->stats.messages_dropped++;
+                continue;
+            }
+            if (total + oldest->len > room) break;
+            
+            // The first message naming an alias teaches it to the broker
+            named[count] = oldest->topic && oldest->alias && !oldest->alias_only && !oldest->topic->alias_live;
+            if (named[count]) oldest->topic->alias_live = true;
+            
+            if (oldest->sent_before) oldest->packet[0] |= 0x08;    // DUP
+            oldest->state = SLOT_WAIT_ACK;
+            iov[count] = (struct iovec){ oldest->packet, oldest->len };
+            total += oldest->len;
+            batch[count++] = oldest;
+        }
+        if (count == 0) return;
+        
+        if (!tx_sendv(client, iov, count, total)) {
+            for (int i = 0; i < count; i++) {
+                if (batch[i]->state == SLOT_WAIT_ACK) batch[i]->state = SLOT_UNSENT;
+                if (named[i]) batch[i]->topic->alias_live = false;
+            }
+            return;
+        }
+        for (int i = 0; i < count; i++) {
+            batch[i]->sent_before = true;
+            if (batch[i]->alias_only) client->stats.aliased++;
+        }
+        client->inflight_sent += (uint16_t)count;
+        client->stats.messages_sent += (uint32_t)count;
+    }
+}
+
+static inflight_t *free_slot(nrx_mqtt_client_t *client) {
+    for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+        if (client->inflight[i].state == SLOT_FREE) return &client->inflight[i];
+    }
+    return NULL;
+}
+
+// Store and forward
+// A message goes into the journal whole, or not at all
+static int journal_store(nrx_mqtt_client_t *client, nrx_mqtt_qos_t qos, bool retain,
+                         const char *topic, size_t topic_len, const struct iovec *iov, int iovcnt, size_t len) {
+    if (topic_len > UINT16_MAX ||
+        packet_len(publish_remaining(client, topic_len, len, qos)) > client->config.max_packet_size) {
+        client->stats.messages_dropped++;
+        return -1;
+    }
+    bool drop_oldest = client->config.drop_policy == NRX_MQTT_DROP_OLDEST;
+    if (nrx_journal_append(client->journal, (uint8_t)qos, retain, topic, topic_len, iov, iovcnt, drop_oldest) != 0) {
+        return -1;      // Counted by the journal
+    }
+    client->stats.journaled++;
+    return 0;
+}
+
+// Journaled messages in order while connected: QoS 1/2 into free slots,
+// QoS 0 into the send queue. Offline everything stays in the journal, so
+// the drop policy sees all of it. The backlog from before this connection
+// waits for replay credit.
+static void journal_feed(nrx_mqtt_client_t *client) {
+    if (!client->journal || client->state != NRX_MQTT_CONNECTED) return;
+    
+    uint64_t now = nrx_time_now_us();
+    uint64_t rate = client->config.replay_rate;
+    uint64_t burst = (uint64_t)client->config.max_inflight * 1000000u;
+    uint64_t idle = elapsed_us(now, client->replay_refill_us);
+    if (idle > 60000000u) idle = 60000000u;
+    client->replay_credit += idle * rate;
+    if (client->replay_credit > burst) client->replay_credit = burst;
+    client->replay_refill_us = now;
+    
+    nrx_journal_entry_t entry;
+    while (nrx_journal_peek(client->journal, &client->feed_cursor, &entry)) {
+        bool backlog = entry.offset < client->replay_end;
+        if (backlog && rate && client->replay_credit < 1000000u) return;
+        
+        if (entry.qos == NRX_MQTT_QOS_0) {
+            size_t total = packet_len(publish_remaining(client, entry.topic_len, entry.payload_len, NRX_MQTT_QOS_0));
+            uint8_t *p = tx_reserve(client, total);
+            if (!p || client->state != NRX_MQTT_CONNECTED) return;
+            
+            size_t n = encode_publish(client, p, total, entry.topic, entry.topic_len, entry.payload,
+                                      entry.payload_len, NRX_MQTT_QOS_0, entry.retain, 0);
+            client->tx_len += n;
+            if (n) client->stats.messages_sent++;
+            else client->stats.messages_dropped++;
+            nrx_journal_done(client->journal, entry.offset);
+        } else {
+            inflight_t *slot = free_slot(client);
+            if (!slot) return;
+            
+            uint16_t packet_id = next_packet_id(client);
+            size_t n = encode_publish(client, slot->packet, client->config.max_packet_size, entry.topic,
+                                      entry.topic_len, entry.payload, entry.payload_len,
+                                      (nrx_mqtt_qos_t)entry.qos, entry.retain, packet_id);
+            if (n == 0) {
+                client->stats.messages_dropped++;
+                nrx_journal_done(client->journal, entry.offset);
+            } else {
+                *slot = (inflight_t){
+                    .state = SLOT_UNSENT,
+                    .packet_id = packet_id,
+                    .seq = client->next_seq++,
+                    .len = n,
+                    .packet = slot->packet,
+                    .journaled = true,
+                    .journal_offset = entry.offset,
+                };
+                nrx_journal_take(client->journal, entry.offset);
+            }
+        }
+        
+        client->feed_cursor = entry.next;
+        if (backlog) {
+            client->stats.replayed++;
+            if (rate) client->replay_credit -= 1000000u;
+        }
+    }
+}
+
+// Connection management
+static uint32_t backoff_ms(nrx_mqtt_client_t *client) {
+    uint32_t delay = client->config.reconnect_min_ms;
+    for (uint32_t i = 0; i < client->attempt && delay < client->config.reconnect_max_ms; i++) {
+        delay *= 2;
+    }
+    if (delay > client->config.reconnect_max_ms) delay = client->config.reconnect_max_ms;
+    
+    // Half fixed, half random, so a fleet does not reconnect in lockstep
+    client->rng ^= client->rng << 13;
+    client->rng ^= client->rng >> 17;
+    client->rng ^= client->rng << 5;
+    return delay / 2 + client->rng % (delay / 2 + 1);
+}
+
+static void connection_lost(nrx_mqtt_client_t *client, int reason, const char *cause) {
+    if (client->fd >= 0) close(client->fd);
+    client->fd = -1;
+    client->tcp_up = false;
+    client->state = client->want_connected ? NRX_MQTT_ERROR : NRX_MQTT_DISCONNECTED;
+    client->tx_off = client->tx_len = 0;
+    client->rx_len = 0;
+    client->ping_pending = false;
+    client->stats.connection_errors++;
+    drop_state(client);
+    
+    // Everything unacknowledged goes again on the next connection
+    for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+        if (client->inflight[i].state == SLOT_WAIT_ACK) client->inflight[i].state = SLOT_UNSENT;
+    }
+    client->inflight_sent = 0;
+    
+    uint32_t delay = backoff_ms(client);
+    client->attempt++;
+    client->retry_at_us = nrx_time_now_us() + (uint64_t)delay * 1000;
+    nrx_log_event(NRX_LOG_MQTT_LOST, reason, (int32_t)delay, 0, 0.0f, 0.0f, cause);
+}
+
+static void start_connect(nrx_mqtt_client_t *client) {
+    client->connect_started_us = nrx_time_now_us();
+    client->state = NRX_MQTT_CONNECTING;
+    
+    if (client->config.use_tls) {
+        connection_lost(client, EPROTONOSUPPORT, "TLS not available");
+        return;
+    }
+    
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addrs = NULL;
+    if (getaddrinfo(client->host, client->port, &hints, &addrs) != 0 || !addrs) {
+        connection_lost(client, EHOSTUNREACH, "resolve failed");
+        return;
+    }
+    
+    int fd = socket(addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(addrs);
+        connection_lost(client, errno, "socket failed");
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    
+    client->fd = fd;
+    int result = connect(fd, addrs->ai_addr, addrs->ai_addrlen);
+    freeaddrinfo(addrs);
+    
+    if (result == 0) {
+        client->tcp_up = true;
+        send_connect(client);
+    } else if (errno != EINPROGRESS) {
+        connection_lost(client, errno, "connect failed");
+    }
+}
+
+static void resubscribe(const char *filter, void *value, void *ctx) {
+    send_subscribe(ctx, filter, ((subscription_t *)value)->qos, true);
+}
+
+static void connected(nrx_mqtt_client_t *client, bool session_present) {
+    client->state = NRX_MQTT_CONNECTED;
+    client->attempt = 0;
+    if (client->was_connected) client->stats.reconnects++;
+    client->was_connected = true;
+    if (!session_present) client->rx_qos2_count = 0;
+    for (nrx_mqtt_topic_t *topic = client->topics; topic; topic = topic->next) {
+        topic->alias_live = false;
+    }
+    
+    // Unfinished QoS 2 releases first, then everything unsent
+    for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+        inflight_t *slot = &client->inflight[i];
+        if (slot->state == SLOT_WAIT_COMP) {
+            send_ack(client, MQTT_PUBREL, slot->packet_id);
+            client->inflight_sent++;
+        }
+    }
+    nrx_topic_trie_foreach(client->subscriptions, resubscribe, client);
+    client->replay_end = nrx_journal_head(client->journal);
+    journal_feed(client);
+    send_pending(client);
+    
+    nrx_log(NRX_LOG_MQTT_CONNECTED, session_present, client->config.protocol_version);
+}
+
+// Receiving
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool error;
+} reader_t;
+
+static uint8_t r_byte(reader_t *r) {
+    if (r->p + 1 > r->end) {
+        r->error = true;
+        return 0;
+    }
+    return *r->p++;
+}
+
+static uint16_t r_u16(reader_t *r) {
+    if (r->p + 2 > r->end) {
+        r->error = true;
+        return 0;
+    }
+    uint16_t v = (uint16_t)(r->p[0] << 8 | r->p[1]);
+    r->p += 2;
+    return v;
+}
+
+static uint32_t r_u32(reader_t *r) {
+    uint32_t hi = r_u16(r);
+    return hi << 16 | r_u16(r);
+}
+
+static uint32_t r_varint(reader_t *r) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        uint8_t b = r_byte(r);
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    r->error = true;
+    return 0;
+}
+
+static void r_skip(reader_t *r, size_t n) {
+    if ((size_t)(r->end - r->p) < n) {
+        r->error = true;
+        return;
+    }
+    r->p += n;
+}
+
+// Walks an MQTT 5 property block, keeping the ones the client acts on
+static void read_properties(nrx_mqtt_client_t *client, reader_t *r, bool connack) {
+    uint32_t len = r_varint(r);
+    if (r->error || (size_t)(r->end - r->p) < len) {
+        r->error = true;
+        return;
+    }
+    
+    reader_t props = { r->p, r->p + len, false };
+    r->p += len;
+    
+    while (props.p < props.end && !props.error) {
+        uint8_t id = r_byte(&props);
+        switch (id) {
+            case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+                r_skip(&props, 1);
+                break;
+            case MQTT_PROP_SERVER_KEEP_ALIVE:
+                if (connack) client->keepalive_us = (uint32_t)r_u16(&props) * 1000000u;
+                else r_skip(&props, 2);
+                break;
+            case MQTT_PROP_RECEIVE_MAXIMUM: {
+                uint16_t quota = r_u16(&props);
+                if (connack && quota && quota < client->send_quota) client->send_quota = quota;
+                break;
+            }
+            case MQTT_PROP_TOPIC_ALIAS_MAXIMUM: {
+                uint16_t max = r_u16(&props);
+                if (connack) client->alias_max = max;
+                break;
+            }
+            case MQTT_PROP_TOPIC_ALIAS:
+                r_skip(&props, 2);
+                break;
+            case MQTT_PROP_MAXIMUM_PACKET_SIZE: {
+                uint32_t max = r_u32(&props);
+                if (connack && max) client->server_max_packet = max;
+                break;
+            }
+            case 0x02: case 0x11: case 0x18:
+                r_skip(&props, 4);
+                break;
+            case 0x0B:
+                r_varint(&props);
+                break;
+            case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+                r_skip(&props, r_u16(&props));
+                break;
+            case 0x26:
+                r_skip(&props, r_u16(&props));
+                r_skip(&props, r_u16(&props));
+                break;
+            default:
+                props.error = true;
+                break;
+        }
+    }
+    if (props.error) r->error = true;
+}
+
+static inflight_t *find_slot(nrx_mqtt_client_t *client, uint16_t packet_id, slot_state_t state) {
+    for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+        inflight_t *slot = &client->inflight[i];
+        if (slot->state == state && slot->packet_id == packet_id) return slot;
+    }
+    return NULL;
+}
+
+static void release_slot(nrx_mqtt_client_t *client, inflight_t *slot) {
+    if (slot->journaled) nrx_journal_done(client->journal, slot->journal_offset);
+    slot->journaled = false;
+    slot->state = SLOT_FREE;
+    client->inflight_sent--;
+    journal_feed(client);
+    send_pending(client);
+}
+
+static bool rx_qos2_seen(nrx_mqtt_client_t *client, uint16_t packet_id, bool remove) {
+    for (size_t i = 0; i < client->rx_qos2_count; i++) {
+        if (client->rx_qos2[i] == packet_id) {
+            if (remove) client->rx_qos2[i] = client->rx_qos2[--client->rx_qos2_count];
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct {
+    subscription_t subs[MQTT_MATCH_MAX];
+    size_t count;
+} match_set_t;
+
+static void collect_match(void *value, void *ctx) {
+    match_set_t *matches = ctx;
+    if (matches->count < MQTT_MATCH_MAX) matches->subs[matches->count++] = *(subscription_t *)value;
+}
+
+static void handle_publish(nrx_mqtt_client_t *client, uint8_t flags, reader_t *r) {
+    nrx_mqtt_qos_t qos = (nrx_mqtt_qos_t)((flags >> 1) & 0x03);
+    uint16_t topic_len = r_u16(r);
+    const uint8_t *topic = r->p;
+    r_skip(r, topic_len);
+    uint16_t packet_id = qos ? r_u16(r) : 0;
+    if (is_v5(client)) read_properties(client, r, false);
+    if (r->error || qos > NRX_MQTT_QOS_2) {
+        r->error = true;
+        return;
+    }
+    
+    // Exactly once: a repeat of a message not yet released is acknowledged
+    // again but not delivered again. With the table full a new message is
+    // dropped unacknowledged, so the broker sends it again later instead
+    // of it being delivered without a record
+    bool deliver = true;
+    if (qos == NRX_MQTT_QOS_2) {
+        if (rx_qos2_seen(client, packet_id, false)) {
+            deliver = false;
+        } else if (client->rx_qos2_count < MQTT_RX_QOS2_MAX) {
+            client->rx_qos2[client->rx_qos2_count++] = packet_id;
+        } else {
+            return;
+        }
+    }
+    
+    if (deliver) {
+        memcpy(client->topic, topic, topic_len);
+        client->topic[topic_len] = '\0';
+        
+        nrx_mqtt_message_t message = {
+            .topic = client->topic,
+            .payload = r->p,
+            .payload_len = (size_t)(r->end - r->p),
+            .qos = qos,
+            .retained = flags & 0x01,
+        };
+        client->stats.messages_received++;
+        client->stats.last_message_time_us = nrx_time_now_us();
+        
+        // Copied out first, so callbacks may subscribe and unsubscribe
+        match_set_t matches = { .count = 0 };
+        nrx_topic_trie_match(client->subscriptions, client->topic, topic_len, collect_match, &matches);
+        for (size_t i = 0; i < matches.count; i++) {
+            if (matches.subs[i].callback) matches.subs[i].callback(&message, matches.subs[i].user_data);
+        }
+    }
+    
+    if (qos == NRX_MQTT_QOS_1) send_ack(client, MQTT_PUBACK, packet_id);
+    if (qos == NRX_MQTT_QOS_2) send_ack(client, MQTT_PUBREC, packet_id);
+}
+
+// MQTT 5 acks may carry a reason code; 0x80 and up is a refusal
+static uint8_t ack_reason(const nrx_mqtt_client_t *client, reader_t *r) {
+    return is_v5(client) && r->p < r->end ? r_byte(r) : 0;
+}
+
+static void handle_packet(nrx_mqtt_client_t *client, uint8_t header, reader_t *r) {
+    uint8_t type = header >> 4;
+    
+    if (client->state != NRX_MQTT_CONNECTED && type != MQTT_CONNACK) {
+        r->error = true;
+        return;
+    }
+    
+    switch (type) {
+        case MQTT_CONNACK: {
+            bool session_present = r_byte(r) & 0x01;
+            uint8_t code = r_byte(r);
+            if (is_v5(client) && !r->error) read_properties(client, r, true);
+            if (r->error) return;
+            if (code != 0) {
+                nrx_log(NRX_LOG_MQTT_REJECTED, MQTT_CONNACK, code);
+                connection_lost(client, code, "connection refused");
+                return;
+            }
+            connected(client, session_present);
+            break;
+        }
+        case MQTT_PUBLISH:
+            handle_publish(client, header & 0x0F, r);
+            break;
+        case MQTT_PUBACK:
+        case MQTT_PUBREC: {
+            uint16_t packet_id = r_u16(r);
+            uint8_t reason = ack_reason(client, r);
+            inflight_t *slot = find_slot(client, packet_id, SLOT_WAIT_ACK);
+            if (!slot) break;
+            
+            if (reason >= 0x80) {
+                client->stats.messages_dropped++;
+                nrx_log(NRX_LOG_MQTT_REJECTED, type, reason);
+                release_slot(client, slot);
+            } else if (type == MQTT_PUBACK) {
+                release_slot(client, slot);
+            } else {
+                slot->state = SLOT_WAIT_COMP;
+                send_ack(client, MQTT_PUBREL, packet_id);
+            }
+            break;
+        }
+        case MQTT_PUBREL: {
+            uint16_t packet_id = r_u16(r);
+            rx_qos2_seen(client, packet_id, true);
+            send_ack(client, MQTT_PUBCOMP, packet_id);
+            break;
+        }
+        case MQTT_PUBCOMP: {
+            inflight_t *slot = find_slot(client, r_u16(r), SLOT_WAIT_COMP);
+            if (slot) release_slot(client, slot);
+            break;
+        }
+        case MQTT_SUBACK: {
+            r_u16(r);
+            if (is_v5(client)) read_properties(client, r, false);
+            while (r->p < r->end && !r->error) {
+                uint8_t code = r_byte(r);
+                if (code >= 0x80) nrx_log(NRX_LOG_MQTT_REJECTED, MQTT_SUBACK, code);
+            }
+            break;
+        }
+        case MQTT_UNSUBACK:
+            break;
+        case MQTT_PINGRESP:
+            client->ping_pending = false;
+            break;
+        case MQTT_DISCONNECT:
+            connection_lost(client, r->p < r->end ? r_byte(r) : 0, "broker disconnected");
+            break;
+        default:
+            r->error = true;
+            break;
+    }
+}
+
+static void receive(nrx_mqtt_client_t *client) {
+    for (;;) {
+        ssize_t n = recv(client->fd, client->rx + client->rx_len, client->rx_cap - client->rx_len, MSG_DONTWAIT);
+        if (n == 0) {
+            connection_lost(client, ECONNRESET, "closed by broker");
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) connection_lost(client, errno, "receive failed");
+            return;
+        }
+        client->rx_len += (size_t)n;
+        client->stats.bytes_received += (uint32_t)n;
+        
+        // Every complete packet, then keep the partial one at the front
+        size_t offset = 0;
+        while (client->fd >= 0 && client->rx_len - offset >= 2) {
+            reader_t header = { client->rx + offset + 1, client->rx + client->rx_len, false };
+            uint32_t remaining = r_varint(&header);
+            if (header.error) {
+                if (client->rx_len - offset >= 5) {
+                    connection_lost(client, EPROTO, "malformed packet");
+                    return;
+                }
+                break;
+            }
+            
+            size_t total = (size_t)(header.p - (client->rx + offset)) + remaining;
+            if (total > client->rx_cap) {
+                connection_lost(client, EMSGSIZE, "packet too large");
+                return;
+            }
+            if (client->rx_len - offset < total) break;
+            
+            reader_t body = { header.p, header.p + remaining, false };
+            handle_packet(client, client->rx[offset], &body);
+            if (body.error && client->fd >= 0) {
+                connection_lost(client, EPROTO, "protocol error");
+                return;
+            }
+            offset += total;
+        }
+        if (client->fd < 0) return;
+        
+        memmove(client->rx, client->rx + offset, client->rx_len - offset);
+        client->rx_len -= offset;
+    }
+}
+
+// Public API
+static bool parse_url(nrx_mqtt_client_t *client, const char *url) {
+    const char *port = MQTT_DEFAULT_PORT;
+    const char *scheme_end = strstr(url, "://");
+    if (scheme_end) {
+        if (strncmp(url, "mqtts", 5) == 0 || strncmp(url, "ssl", 3) == 0) {
+            client->config.use_tls = true;
+        }
+        url = scheme_end + 3;
+    }
+    if (client->config.use_tls) port = MQTT_DEFAULT_TLS_PORT;
+    
+    // [v6]:port, host:port or host
+    const char *host = url, *host_end;
+    if (*url == '[') {
+        host = url + 1;
+        host_end = strchr(host, ']');
+        if (!host_end) return false;
+        if (host_end[1] == ':') port = host_end + 2;
+    } else {
+        host_end = strchr(url, ':');
+        if (host_end) port = host_end + 1;
+        else host_end = url + strlen(url);
+    }
+    
+    size_t port_len = strcspn(port, "/");
+    if (host_end == host || port_len == 0 || port_len >= sizeof(client->port)) return false;
+    
+    client->host = strndup(host, (size_t)(host_end - host));
+    memcpy(client->port, port, port_len);
+    client->port[port_len] = '\0';
+    return client->host != NULL;
+}
+
 nrx_mqtt_client_t *nrx_mqtt_create(nrx_mqtt_config_t *config) {
     if (!config || !config->broker_url || !config->client_id) {
         return NULL;
     }
     
-    nrx_mqtt_client_t *client = malloc(sizeof(nrx_mqtt_client_t));
+    nrx_mqtt_client_t *client = calloc(1, sizeof(nrx_mqtt_client_t));
     if (!client) return NULL;
     
-    memset(client, 0, sizeof(nrx_mqtt_client_t));
-    
     // Copy configuration
     client->config = *config;
     client->config.broker_url = strdup(config->broker_url);
     client->config.client_id = strdup(config->client_id);
+    client->config.journal_path = NULL;
     
     if (config->username) {
         client->config.username = strdup(config->username);
@@ -40,14 +1189,65 @@ nrx_mqtt_client_t *nrx_mqtt_create(nrx_mqtt_config_t *config) {
         client->config.password = strdup(config->password);
     }
     
+    nrx_mqtt_config_t *c = &client->config;
+    if (c->protocol_version != NRX_MQTT_V5) c->protocol_version = NRX_MQTT_V311;
+    if (c->max_packet_size < 128) c->max_packet_size = 4096;
+    if (c->max_inflight == 0) c->max_inflight = 16;
+    if (c->reconnect_min_ms == 0) c->reconnect_min_ms = 500;
+    if (c->reconnect_max_ms < c->reconnect_min_ms) c->reconnect_max_ms = c->reconnect_min_ms > 30000 ? c->reconnect_min_ms : 30000;
+    if (c->journal_size == 0) c->journal_size = 1u << 20;
+    
+    client->fd = -1;
     client->state = NRX_MQTT_DISCONNECTED;
+    client->dirty_tail = &client->dirty_head;
+    client->send_quota = c->max_inflight;
+    client->server_max_packet = c->max_packet_size;
+    client->rng = (uint32_t)(uintptr_t)client ^ (uint32_t)nrx_time_now_us() ^ 0x9E3779B9u;
+    if (!client->rng) client->rng = 1;
+    
+    // One allocation per buffer, for the life of the client
+    client->rx_cap = c->max_packet_size;
+    client->tx_cap = 4 * (size_t)c->max_packet_size;
+    client->rx = malloc(client->rx_cap);
+    client->tx = malloc(client->tx_cap);
+    client->topic = malloc(client->rx_cap + 1);
+    client->scratch = malloc(c->max_packet_size);
+    client->inflight = calloc(c->max_inflight, sizeof(inflight_t));
+    client->subscriptions = nrx_topic_trie_create();
+    uint8_t *store = malloc((size_t)c->max_inflight * c->max_packet_size);
+    
+    if (!c->broker_url || !c->client_id || !client->rx || !client->tx || !client->topic || !client->scratch ||
+        !client->inflight || !client->subscriptions || !store || !parse_url(client, c->broker_url)) {
+        free(store);
+        nrx_mqtt_destroy(client);
+        return NULL;
+    }
+    for (uint16_t i = 0; i < c->max_inflight; i++) {
+        client->inflight[i].packet = store + (size_t)i * c->max_packet_size;
+    }
     
-    printf("[MQTT] Client created: broker=%s, client_id=%s\n",
-           config->broker_url, config->client_id);
+    // Whatever an earlier run left in the journal goes out on the first
+    // connection
+    if (config->journal_path) {
+        client->journal = nrx_journal_open(config->journal_path, c->journal_size);
+        if (!client->journal) {
+            nrx_mqtt_destroy(client);
+            return NULL;
+        }
+        nrx_journal_stats_t js;
+        nrx_journal_get_stats(client->journal, &js);
+        if (js.recovered || js.truncated) nrx_log(NRX_LOG_MQTT_JOURNAL, (int32_t)js.recovered, (int32_t)js.truncated);
+    }
     
     return client;
 }
 
+static void free_subscription(const char *filter, void *value, void *ctx) {
+    (void)filter;
+    (void)ctx;
+    free(value);
+}
+
 void nrx_mqtt_destroy(nrx_mqtt_client_t *client) {
     if (!client) return;
     
@@ -57,47 +1257,72 @@ void nrx_mqtt_destroy(nrx_mqtt_client_t *client) {
     free((void *)client->config.client_id);
     free((void *)client->config.username);
     free((void *)client->config.password);
+    free(client->host);
+    
+    nrx_topic_trie_foreach(client->subscriptions, free_subscription, NULL);
+    nrx_topic_trie_destroy(client->subscriptions);
     
-    for (size_t i = 0; i < client->subscription_count; i++) {
-        free(client->subscriptions[i]);
+    while (client->topics) {
+        nrx_mqtt_topic_t *next = client->topics->next;
+        free(client->topics->state);
+        free(client->topics);
+        client->topics = next;
     }
-    free(client->subscriptions);
     
+    free(client->rx);
+    free(client->tx);
+    free(client->topic);
+    free(client->scratch);
+    if (client->inflight) free(client->inflight[0].packet);
+    free(client->inflight);
+    nrx_journal_close(client->journal);
     free(client);
-    
-    printf("[MQTT] Client destroyed\n");
 }
 
 int nrx_mqtt_connect(nrx_mqtt_client_t *client) {
     if (!client) return -1;
     
-    if (client->state == NRX_MQTT_CONNECTED) {
-        return 0; // Already connected
-    }
+    client->want_connected = true;
+    if (client->fd >= 0) return 0;
     
-    client->state = NRX_MQTT_CONNECTING;
-    
-    printf("[MQTT] Connecting to %s...\n", client->config.broker_url);
-    
-    // Mock connection - in production, use real MQTT library
-    client->state = NRX_MQTT_CONNECTED;
-    
-    printf("[MQTT] Connected successfully\n");
-    
-    return 0;
+    client->attempt = 0;
+    client->send_quota = client->config.max_inflight;
+    client->server_max_packet = client->config.max_packet_size;
+    client->alias_max = 0;
+    client->keepalive_us = (uint32_t)client->config.keepalive_sec * 1000000u;
+    start_connect(client);
+    return client->state == NRX_MQTT_CONNECTING ? 0 : -1;
 }
 
 int nrx_mqtt_disconnect(nrx_mqtt_client_t *client) {
     if (!client) return -1;
     
-    if (client->state == NRX_MQTT_DISCONNECTED) {
+    client->want_connected = false;
+    if (client->fd < 0) {
+        client->state = NRX_MQTT_DISCONNECTED;
         return 0;
     }
     
-    printf("[MQTT] Disconnecting...\n");
+    // Best effort: whatever is queued, then a clean DISCONNECT
+    if (client->state == NRX_MQTT_CONNECTED) {
+        static const uint8_t packet[2] = { MQTT_DISCONNECT << 4, 0 };
+        emit_state(client);
+        tx_queue(client, packet, sizeof(packet));
+        tx_flush(client);
+    }
+    drop_state(client);
+    nrx_journal_sync(client->journal);
     
+    if (client->fd >= 0) close(client->fd);
+    client->fd = -1;
+    client->tcp_up = false;
     client->state = NRX_MQTT_DISCONNECTED;
-    
+    client->tx_off = client->tx_len = 0;
+    client->rx_len = 0;
+    for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+        if (client->inflight[i].state == SLOT_WAIT_ACK) client->inflight[i].state = SLOT_UNSENT;
+    }
+    client->inflight_sent = 0;
     return 0;
 }
 
@@ -107,76 +1332,383 @@ nrx_mqtt_state_t nrx_mqtt_get_state(nrx_mqtt_client_t *client) {
 
 int nrx_mqtt_publish(nrx_mqtt_client_t *client, const char *topic,
                      const uint8_t *payload, size_t len, nrx_mqtt_qos_t qos) {
-    if (!client || !topic || !payload) return -1;
+    if (!client || !topic || (!payload && len) || qos > NRX_MQTT_QOS_2) return -1;
+    size_t topic_len = strlen(topic);
+    
+    // At most once: only while connected, straight into the send queue
+    if (qos == NRX_MQTT_QOS_0) {
+        size_t total = packet_len(publish_remaining(client, topic_len, len, qos));
+        uint8_t *p = client->state == NRX_MQTT_CONNECTED ? tx_reserve(client, total) : NULL;
+        size_t n = p ? encode_publish(client, p, client->tx_cap - client->tx_len, topic, topic_len, payload, len, qos, false, 0) : 0;
+        if (n == 0) {
+            client->stats.messages_dropped++;
+            return -1;
+        }
+        client->tx_len += n;
+        client->stats.messages_sent++;
+        tx_kick(client);
+        return 0;
+    }
+    
+    // At least / exactly once: journaled first when there is a journal,
+    // then held in a slot until acknowledged
+    if (client->journal) {
+        struct iovec iov = { (void *)payload, len };
+        if (journal_store(client, qos, false, topic, topic_len, &iov, 1, len) != 0) return -1;
+        journal_feed(client);
+        send_pending(client);
+        tx_kick(client);
+        return 0;
+    }
     
-    if (client->state != NRX_MQTT_CONNECTED) {
-        printf("[MQTT] Cannot publish - not connected\n");
+    inflight_t *slot = free_slot(client);
+    uint16_t packet_id = slot ? next_packet_id(client) : 0;
+    size_t n = slot ? encode_publish(client, slot->packet, client->config.max_packet_size,
+                                     topic, topic_len, payload, len, qos, false, packet_id) : 0;
+    if (n == 0) {
+        client->stats.messages_dropped++;
         return -1;
     }
     
-    printf("[MQTT] Publish: topic='%s', len=%zu, qos=%d\n", topic, len, qos);
+    slot->state = SLOT_UNSENT;
+    slot->packet_id = packet_id;
+    slot->sent_before = false;
+    slot->seq = client->next_seq++;
+    slot->len = n;
+    slot->topic = NULL;
+    slot->alias = 0;
+    slot->alias_only = false;
+    send_pending(client);
+    tx_kick(client);
+    return 0;
+}
+
+nrx_mqtt_topic_t *nrx_mqtt_topic_register(nrx_mqtt_client_t *client, const char *topic,
+                                          nrx_mqtt_qos_t qos, bool retain) {
+    if (!client || !topic || qos > NRX_MQTT_QOS_2) return NULL;
+    size_t topic_len = strlen(topic);
+    if (topic_len == 0 || topic_len > UINT16_MAX || client->topic_count == UINT16_MAX) return NULL;
+    
+    // Name and header scratch share the handle's allocation
+    size_t name_len = 2 + topic_len;
+    size_t head_cap = 1 + 4 + name_len + 2 + 4;
+    nrx_mqtt_topic_t *handle = malloc(sizeof(nrx_mqtt_topic_t) + name_len + head_cap);
+    if (!handle) return NULL;
     
-    // Mock publish
-    client->stats.messages_sent++;
-    client->stats.bytes_sent += len;
+    handle->client = client;
+    handle->qos = qos;
+    handle->retain = retain;
+    handle->alias = ++client->topic_count;
+    handle->alias_live = false;
+    handle->latest = false;
+    handle->journaled = false;
+    handle->dirty = false;
+    handle->state = NULL;
+    handle->state_len = 0;
+    handle->next_dirty = NULL;
+    handle->encoded_len = 0;
+    handle->name_len = name_len;
+    handle->head = handle->name + name_len;
+    writer_t w = { handle->name, 0 };
+    w_str(&w, topic, topic_len);
     
+    handle->next = client->topics;
+    client->topics = handle;
+    return handle;
+}
+
+int nrx_mqtt_topic_set_latest(nrx_mqtt_topic_t *topic, bool latest) {
+    if (!topic) return -1;
+    if (latest && !topic->state && topic->qos == NRX_MQTT_QOS_0) {
+        topic->state = malloc(topic->client->config.max_packet_size);
+        if (!topic->state) return -1;
+    }
+    topic->latest = latest;
     return 0;
 }
 
-int nrx_mqtt_subscribe(nrx_mqtt_client_t *client, const char *topic, nrx_mqtt_qos_t qos) {
-    if (!client || !topic) return -1;
+int nrx_mqtt_topic_set_journaled(nrx_mqtt_topic_t *topic, bool journaled) {
+    if (!topic || (journaled && !topic->client->journal)) return -1;
+    topic->journaled = journaled;
+    return 0;
+}
+
+int nrx_mqtt_topic_publish(nrx_mqtt_topic_t *topic, const uint8_t *payload, size_t len) {
+    struct iovec iov = { (void *)payload, len };
+    return nrx_mqtt_topic_publishv(topic, &iov, 1);
+}
+
+int nrx_mqtt_topic_publishv(nrx_mqtt_topic_t *topic, const struct iovec *iov, int iovcnt) {
+    if (!topic || iovcnt < 0 || iovcnt > NRX_MQTT_IOV_MAX || (iovcnt && !iov)) return -1;
+    nrx_mqtt_client_t *client = topic->client;
+    
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (!iov[i].iov_base && iov[i].iov_len) return -1;
+        len += iov[i].iov_len;
+    }
+    
+    uint16_t alias;
+    bool alias_only;
+    
+    // Latest value wins: kept until the batch goes out, replacing any value
+    // still waiting
+    if (topic->qos == NRX_MQTT_QOS_0 && topic->latest) {
+        if (client->state != NRX_MQTT_CONNECTED || len > client->config.max_packet_size) {
+            client->stats.messages_dropped++;
+            return -1;
+        }
+        if (topic->dirty) {
+            client->stats.messages_coalesced++;
+        } else {
+            topic->dirty = true;
+            topic->next_dirty = NULL;
+            *client->dirty_tail = topic;
+            client->dirty_tail = &topic->next_dirty;
+        }
+        topic->state_len = 0;
+        for (int i = 0; i < iovcnt; i++) {
+            if (iov[i].iov_len) memcpy(topic->state + topic->state_len, iov[i].iov_base, iov[i].iov_len);
+            topic->state_len += iov[i].iov_len;
+        }
+        tx_kick(client);
+        return 0;
+    }
+    
+    // Through the journal: QoS 0 while offline, QoS 1/2 always
+    const char *name = (const char *)topic->name + 2;
+    if (client->journal && (topic->qos != NRX_MQTT_QOS_0 ? !topic->latest :
+                            topic->journaled && client->state != NRX_MQTT_CONNECTED)) {
+        if (journal_store(client, topic->qos, topic->retain, name, topic->name_len - 2, iov, iovcnt, len) != 0) {
+            return -1;
+        }
+        journal_feed(client);
+        send_pending(client);
+        tx_kick(client);
+        return 0;
+    }
+    
+    // At most once: header and payload leave in one send, nothing copied
+    // unless the socket is backed up (or batching)
+    if (topic->qos == NRX_MQTT_QOS_0) {
+        size_t head_len = client->state == NRX_MQTT_CONNECTED ?
+                          encode_topic_head(client, topic, len, 0, &alias, &alias_only) : 0;
+        struct iovec vec[NRX_MQTT_IOV_MAX + 1];
+        vec[0] = (struct iovec){ topic->head, head_len };
+        for (int i = 0; i < iovcnt; i++) vec[i + 1] = iov[i];
+        
+        if (head_len == 0 || !tx_sendv(client, vec, iovcnt + 1, head_len + len)) {
+            client->stats.messages_dropped++;
+            return -1;
+        }
+        if (alias) topic->alias_live = true;
+        if (alias_only) client->stats.aliased++;
+        client->stats.messages_sent++;
+        tx_kick(client);
+        return 0;
+    }
     
-    if (client->state != NRX_MQTT_CONNECTED) {
-        printf("[MQTT] Cannot subscribe - not connected\n");
+    // At least / exactly once: gathered once into a slot, sent from there.
+    // A state topic's message that has not gone out yet is overwritten.
+    inflight_t *slot = NULL;
+    for (uint16_t i = 0; i < client->config.max_inflight && topic->latest && !slot; i++) {
+        inflight_t *waiting = &client->inflight[i];
+        if (waiting->state == SLOT_UNSENT && waiting->topic == topic && !waiting->sent_before) slot = waiting;
+    }
+    bool replace = slot != NULL;
+    for (uint16_t i = 0; i < client->config.max_inflight && !slot; i++) {
+        if (client->inflight[i].state == SLOT_FREE) slot = &client->inflight[i];
+    }
+    uint16_t packet_id = replace ? slot->packet_id : slot ? next_packet_id(client) : 0;
+    size_t head_len = slot ? encode_topic_head(client, topic, len, packet_id, &alias, &alias_only) : 0;
+    if (head_len == 0 || head_len + len > client->config.max_packet_size) {
+        client->stats.messages_dropped++;
         return -1;
     }
     
-    printf("[MQTT] Subscribe: topic='%s', qos=%d\n", topic, qos);
+    memcpy(slot->packet, topic->head, head_len);
+    size_t off = head_len;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len) memcpy(slot->packet + off, iov[i].iov_base, iov[i].iov_len);
+        off += iov[i].iov_len;
+    }
+    
+    if (replace) {
+        client->stats.messages_coalesced++;
+    } else {
+        slot->seq = client->next_seq++;
+    }
+    slot->state = SLOT_UNSENT;
+    slot->packet_id = packet_id;
+    slot->sent_before = false;
+    slot->len = off;
+    slot->topic = topic;
+    slot->alias = alias;
+    slot->alias_only = alias_only;
+    slot->head_len = head_len;
+    send_pending(client);
+    tx_kick(client);
+    return 0;
+}
+
+int nrx_mqtt_topic_publish_encoded(nrx_mqtt_topic_t *topic, nrx_mqtt_encode_t encode, const void *message) {
+    if (!topic || !encode) return -1;
+    nrx_mqtt_client_t *client = topic->client;
+    size_t max = client->config.max_packet_size;
+    
+    // At most once, online: the payload is encoded where it will be sent
+    // from, and the header slid up against it if its length changed size
+    if (topic->qos == NRX_MQTT_QOS_0 && !topic->latest && client->state == NRX_MQTT_CONNECTED) {
+        uint16_t alias;
+        bool alias_only;
+        size_t guess = encode_topic_head(client, topic, topic->encoded_len, 0, &alias, &alias_only);
+        uint8_t *p = guess ? tx_reserve(client, max) : NULL;
+        size_t len = p && guess + 3 < max ? encode(message, p + guess, max - guess - 3) : 0;
+        size_t head_len = len ? encode_topic_head(client, topic, len, 0, &alias, &alias_only) : 0;
+        if (head_len == 0 || head_len + len > max) {
+            client->stats.messages_dropped++;
+            return -1;
+        }
+        
+        if (head_len != guess) memmove(p + head_len, p + guess, len);
+        memcpy(p, topic->head, head_len);
+        client->tx_len += head_len + len;
+        topic->encoded_len = len;
+        if (alias) topic->alias_live = true;
+        if (alias_only) client->stats.aliased++;
+        client->stats.messages_sent++;
+        tx_kick(client);
+        return 0;
+    }
+    
+    size_t len = encode(message, client->scratch, max);
+    if (len == 0) {
+        client->stats.messages_dropped++;
+        return -1;
+    }
+    return nrx_mqtt_topic_publish(topic, client->scratch, len);
+}
+
+int nrx_mqtt_subscribe(nrx_mqtt_client_t *client, const char *topic, nrx_mqtt_qos_t qos) {
+    if (!client) return -1;
+    return nrx_mqtt_subscribe_cb(client, topic, qos, client->config.message_callback, client->config.user_data);
+}
+
+int nrx_mqtt_subscribe_cb(nrx_mqtt_client_t *client, const char *filter, nrx_mqtt_qos_t qos,
+                          nrx_mqtt_message_cb_t callback, void *user_data) {
+    if (!client || !nrx_topic_filter_valid(filter) || qos > NRX_MQTT_QOS_2) return -1;
     
-    // Add to subscription list
-    size_t new_count = client->subscription_count + 1;
-    client->subscriptions = realloc(client->subscriptions, new_count * sizeof(char *));
-    client->subscriptions[client->subscription_count] = strdup(topic);
-    client->subscription_count = new_count;
+    // Subscribing again to a filter replaces its QoS and callback
+    subscription_t *sub = nrx_topic_trie_find(client->subscriptions, filter);
+    if (!sub) {
+        sub = malloc(sizeof(subscription_t));
+        if (!sub) return -1;
+        if (nrx_topic_trie_insert(client->subscriptions, filter, sub) != 0) {
+            free(sub);
+            return -1;
+        }
+    }
+    sub->qos = qos;
+    sub->callback = callback;
+    sub->user_data = user_data;
     
+    // Offline subscriptions go out on connect
+    if (client->state == NRX_MQTT_CONNECTED) {
+        if (!send_subscribe(client, filter, qos, true)) return -1;
+        tx_kick(client);
+    }
     return 0;
 }
 
 int nrx_mqtt_unsubscribe(nrx_mqtt_client_t *client, const char *topic) {
     if (!client || !topic) return -1;
     
-    printf("[MQTT] Unsubscribe: topic='%s'\n", topic);
+    free(nrx_topic_trie_remove(client->subscriptions, topic));
     
-    // Remove from subscription list
-    for (size_t i = 0; i < client->subscription_count; i++) {
-        if (strcmp(client->subscriptions[i], topic) == 0) {
-            free(client->subscriptions[i]);
-            
-            // Shift remaining subscriptions
-            for (size_t j = i; j < client->subscription_count - 1; j++) {
-                client->subscriptions[j] = client->subscriptions[j + 1];
-            }
-            
-            client->subscription_count--;
-            break;
-        }
+    if (client->state == NRX_MQTT_CONNECTED) {
+        if (!send_subscribe(client, topic, NRX_MQTT_QOS_0, false)) return -1;
+        tx_kick(client);
     }
-    
     return 0;
 }
 
 void nrx_mqtt_loop(nrx_mqtt_client_t *client) {
-    if (!client || client->state != NRX_MQTT_CONNECTED) {
+    if (!client) return;
+    uint64_t now = nrx_time_now_us();
+    
+    if (client->fd < 0) {
+        if (!client->want_connected || now < client->retry_at_us) return;
+        client->send_quota = client->config.max_inflight;
+        client->server_max_packet = client->config.max_packet_size;
+        client->alias_max = 0;
+        client->keepalive_us = (uint32_t)client->config.keepalive_sec * 1000000u;
+        start_connect(client);
+        if (client->fd < 0) return;
+    }
+    
+    // Non-blocking connect finishes when the socket turns writable
+    if (!client->tcp_up) {
+        struct pollfd pfd = { .fd = client->fd, .events = POLLOUT };
+        if (poll(&pfd, 1, 0) > 0) {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(client->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+            if (error) {
+                connection_lost(client, error, "connect failed");
+                return;
+            }
+            client->tcp_up = true;
+            send_connect(client);
+        } else if (elapsed_us(now, client->connect_started_us) >= MQTT_CONNECT_TIMEOUT_US) {
+            connection_lost(client, ETIMEDOUT, "connect timed out");
+            return;
+        } else {
+            return;
+        }
+    }
+    
+    receive(client);
+    if (client->fd < 0) return;
+    
+    if (client->state == NRX_MQTT_CONNECTING && elapsed_us(now, client->connect_started_us) >= MQTT_CONNECT_TIMEOUT_US) {
+        connection_lost(client, ETIMEDOUT, "no CONNACK");
         return;
     }
     
-    // Mock message processing
-    // In production, this would call the MQTT library's loop function
-    // and invoke the message callback when messages arrive
+    // Keepalive: ping after a quiet period, give up if the answer never comes
+    if (client->state == NRX_MQTT_CONNECTED && client->keepalive_us) {
+        if (client->ping_pending && elapsed_us(now, client->ping_sent_us) >= client->keepalive_us) {
+            connection_lost(client, ETIMEDOUT, "keepalive timed out");
+            return;
+        }
+        if (!client->ping_pending && elapsed_us(now, client->last_tx_us) >= client->keepalive_us) {
+            static const uint8_t packet[2] = { MQTT_PINGREQ << 4, 0 };
+            if (tx_queue(client, packet, sizeof(packet))) {
+                client->ping_pending = true;
+                client->ping_sent_us = now;
+                client->tx_urgent = true;
+            }
+        }
+    }
+    
+    // Backlog waiting on replay credit
+    journal_feed(client);
+    send_pending(client);
+    tx_kick(client);
 }
 
 void nrx_mqtt_get_stats(nrx_mqtt_client_t *client, nrx_mqtt_stats_t *stats) {
     if (client && stats) {
         *stats = client->stats;
+        stats->inflight = 0;
+        for (uint16_t i = 0; i < client->config.max_inflight; i++) {
+            if (client->inflight[i].state != SLOT_FREE) stats->inflight++;
+        }
+        if (client->journal) {
+            nrx_journal_stats_t js;
+            nrx_journal_get_stats(client->journal, &js);
+            stats->messages_dropped += (uint32_t)js.dropped;
+            stats->journal_pending = (uint32_t)js.pending;
+        }
     }
 }
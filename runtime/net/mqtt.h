@@ -4,6 +4,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <sys/uio.h>
+
+// MQTT client
+// Native MQTT 3.1.1 and 5 over a non-blocking TCP socket. Nothing happens
+// in the background: nrx_mqtt_loop() connects, reads, sends, keeps the
+// connection alive and reconnects with backoff, so call it often (e.g. from
+// a periodic task). All buffers are sized by the config and allocated at
+// create; steady-state traffic allocates nothing. Not thread-safe: use a
+// client from one thread. TLS is not built in, so TLS configs fail to
+// connect.
+
+#define NRX_MQTT_V311 4
+#define NRX_MQTT_V5 5
 
 // QoS levels
 typedef enum {
@@ -29,6 +42,12 @@ typedef struct {
     bool retained;
 } nrx_mqtt_message_t;
 
+// What a full journal gives up
+typedef enum {
+    NRX_MQTT_DROP_OLDEST,        // Oldest stored messages make room
+    NRX_MQTT_DROP_NEWEST,        // New messages are refused
+} nrx_mqtt_drop_policy_t;
+
 // Message callback
 typedef void (*nrx_mqtt_message_cb_t)(const nrx_mqtt_message_t *message, void *user_data);
 
@@ -46,6 +65,29 @@ typedef struct {
     
     uint16_t keepalive_sec;
     bool clean_session;
+    uint8_t protocol_version;    // NRX_MQTT_V311 (default) or NRX_MQTT_V5
+    
+    // Zero selects the default
+    uint32_t max_packet_size;    // Largest packet either way, 4096
+    uint16_t max_inflight;       // Outgoing QoS 1/2 messages held for acks, 16
+    uint32_t reconnect_min_ms;   // First retry delay, 500
+    uint32_t reconnect_max_ms;   // Backoff ceiling, 30000
+    
+    // Batching: outgoing packets are held for up to this long and written
+    // together (acks, pings and subscriptions go at once and take the batch
+    // with them). 0 sends every publish as it is made; 1 gives one write per
+    // loop call.
+    uint32_t batch_window_us;
+    
+    // Store and forward: with a journal, QoS 1/2 messages (and QoS 0 ones of
+    // handles marked with nrx_mqtt_topic_set_journaled(), while offline) are
+    // appended to a memory-mapped file and kept there until delivered, so
+    // neither max_inflight nor a restart loses them. The backlog found on
+    // connecting is sent at replay_rate, in bursts of up to max_inflight.
+    const char *journal_path;    // NULL: no journal
+    uint32_t journal_size;       // Bytes, 1 MiB if zero; an existing file keeps its size
+    nrx_mqtt_drop_policy_t drop_policy;
+    uint32_t replay_rate;        // Backlog messages per second, 0 = no limit
     
     nrx_mqtt_message_cb_t message_callback;
     void *user_data;
@@ -58,17 +100,68 @@ typedef struct nrx_mqtt_client_t nrx_mqtt_client_t;
 nrx_mqtt_client_t *nrx_mqtt_create(nrx_mqtt_config_t *config);
 void nrx_mqtt_destroy(nrx_mqtt_client_t *client);
 
+// Starts connecting and keeps the client connected until disconnect; the
+// state becomes CONNECTED in a later loop call. QoS 1/2 publishes and
+// subscriptions made while offline go out once connected.
 int nrx_mqtt_connect(nrx_mqtt_client_t *client);
 int nrx_mqtt_disconnect(nrx_mqtt_client_t *client);
 nrx_mqtt_state_t nrx_mqtt_get_state(nrx_mqtt_client_t *client);
 
 int nrx_mqtt_publish(nrx_mqtt_client_t *client, const char *topic,
                      const uint8_t *payload, size_t len, nrx_mqtt_qos_t qos);
+
+// Filters may use `+` and `#`. Each incoming message goes to the callback
+// of every subscription whose filter matches it, found through a topic
+// trie in time proportional to the topic's depth; messages matching no
+// subscription are dropped. nrx_mqtt_subscribe() uses the config's
+// message_callback. Subscribing again to a filter replaces its QoS and
+// callback. Callbacks may subscribe and unsubscribe.
 int nrx_mqtt_subscribe(nrx_mqtt_client_t *client, const char *topic, nrx_mqtt_qos_t qos);
+int nrx_mqtt_subscribe_cb(nrx_mqtt_client_t *client, const char *filter, nrx_mqtt_qos_t qos,
+                          nrx_mqtt_message_cb_t callback, void *user_data);
 int nrx_mqtt_unsubscribe(nrx_mqtt_client_t *client, const char *topic);
 
 void nrx_mqtt_loop(nrx_mqtt_client_t *client);
 
+// Publish handles
+// For topics known up front, such as telemetry declared with `topic`.
+// Registering encodes the topic name once; a publish then only writes the
+// fixed header and packet id. QoS 0 payloads go from the caller's buffers
+// to the socket in one scatter/gather send (copied only if the socket does
+// not take them whole); QoS 1/2 payloads are gathered once into their
+// in-flight slot. Over MQTT 5, when the broker allows topic aliases, the
+// name is sent once per connection and a 2-byte alias after that. Handles
+// live until the client is destroyed.
+#define NRX_MQTT_IOV_MAX 8
+
+typedef struct nrx_mqtt_topic_t nrx_mqtt_topic_t;
+
+nrx_mqtt_topic_t *nrx_mqtt_topic_register(nrx_mqtt_client_t *client, const char *topic,
+                                          nrx_mqtt_qos_t qos, bool retain);
+int nrx_mqtt_topic_publish(nrx_mqtt_topic_t *topic, const uint8_t *payload, size_t len);
+
+// State topics (pose, battery, mode) where only the newest value matters:
+// a publish replaces a value of the same handle that has not been written
+// yet, so a batch carries at most one value per state topic.
+int nrx_mqtt_topic_set_latest(nrx_mqtt_topic_t *topic, bool latest);
+int nrx_mqtt_topic_publishv(nrx_mqtt_topic_t *topic, const struct iovec *iov, int iovcnt);
+
+// Encoded publish, for the encoders generated from `message` declarations
+// (see codec.h): encode writes the payload of message into buf, at most cap
+// bytes, and returns its length or 0 if it does not fit. A QoS 0 message
+// is encoded in place in the send queue, behind a header sized for the
+// handle's previous payload; others are encoded once into scratch space and
+// then published as usual.
+typedef size_t (*nrx_mqtt_encode_t)(const void *message, uint8_t *buf, size_t cap);
+
+int nrx_mqtt_topic_publish_encoded(nrx_mqtt_topic_t *topic, nrx_mqtt_encode_t encode, const void *message);
+
+// QoS 0 messages of a journaled handle are stored while offline instead of
+// dropped, and sent in order on reconnect. Needs the client's journal; a
+// latest-value handle is never journaled. Handle messages from the journal
+// carry the full topic name.
+int nrx_mqtt_topic_set_journaled(nrx_mqtt_topic_t *topic, bool journaled);
+
 // Statistics
 typedef struct {
     uint32_t messages_sent;
@@ -77,6 +170,15 @@ typedef struct {
     uint32_t bytes_received;
     uint32_t connection_errors;
     uint64_t last_message_time_us;
+    uint32_t messages_dropped;   // No room to queue, refused by the broker or the journal
+    uint32_t reconnects;
+    uint32_t inflight;           // QoS 1/2 messages not yet acknowledged
+    uint32_t aliased;            // Published with a topic alias instead of the name
+    uint32_t messages_coalesced; // Replaced by a newer value before being sent
+    uint32_t writes;             // Socket writes
+    uint32_t journaled;          // Stored in the journal
+    uint32_t replayed;           // Backlog from the journal sent after connecting
+    uint32_t journal_pending;    // In the journal, not yet acknowledged
 } nrx_mqtt_stats_t;
 
 void nrx_mqtt_get_stats(nrx_mqtt_client_t *client, nrx_mqtt_stats_t *stats);
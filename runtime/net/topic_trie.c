@@ -0,0 +1,451 @@
+#include "topic_trie.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIE_ROOT 0
+#define TRIE_NONE 0                 // No child; the root is nobody's child
+
+typedef enum {
+    NODE_FREE,
+    NODE_LEVEL,
+    NODE_PLUS,
+    NODE_HASH,
+} node_kind_t;
+
+typedef struct {
+    uint32_t parent;                // Next free node while free
+    uint32_t segment;               // Interned level, for NODE_LEVEL
+    uint32_t plus;
+    uint32_t hash;
+    uint32_t children;              // Literal and wildcard children
+    uint8_t kind;
+    void *value;
+} node_t;
+
+// Interned level strings, kept back to back in one buffer
+typedef struct {
+    uint32_t offset;
+    uint32_t len;
+    uint32_t hash;
+} segment_t;
+
+// Literal child of parent for a level; child == TRIE_NONE marks an empty slot
+typedef struct {
+    uint32_t parent;
+    uint32_t segment;
+    uint32_t child;
+} edge_t;
+
+struct nrx_topic_trie_t {
+    node_t *nodes;
+    uint32_t node_count, node_cap;
+    uint32_t free_nodes;            // TRIE_NONE when empty
+    size_t value_count;
+    
+    char *chars;
+    size_t chars_len, chars_cap;
+    segment_t *segments;
+    uint32_t segment_count, segment_cap;
+    uint32_t *segment_slots;        // Segment index + 1, 0 empty
+    uint32_t segment_mask;
+    
+    edge_t *edges;
+    uint32_t edge_count;
+    uint32_t edge_mask;
+    
+    char *scratch;                  // Filters rebuilt for foreach
+    size_t scratch_cap;
+};
+
+static uint32_t hash_bytes(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t hash_edge(uint32_t parent, uint32_t segment) {
+    uint64_t key = ((uint64_t)parent << 32 | segment) * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(key >> 32);
+}
+
+static bool grow(void **array, uint32_t *cap, size_t item, uint32_t need) {
+    if (need <= *cap) return true;
+    uint32_t new_cap = *cap ? *cap * 2 : 16;
+    while (new_cap < need) new_cap *= 2;
+    void *p = realloc(*array, (size_t)new_cap * item);
+    if (!p) return false;
+    *array = p;
+    *cap = new_cap;
+    return true;
+}
+
+// Segments
+static uint32_t segment_find(const nrx_topic_trie_t *trie, const char *s, size_t len, uint32_t hash) {
+    for (uint32_t i = hash & trie->segment_mask;; i = (i + 1) & trie->segment_mask) {
+        uint32_t slot = trie->segment_slots[i];
+        if (slot == 0) return UINT32_MAX;
+        const segment_t *seg = &trie->segments[slot - 1];
+        if (seg->hash == hash && seg->len == len && memcmp(trie->chars + seg->offset, s, len) == 0) {
+            return slot - 1;
+        }
+    }
+}
+
+static bool segment_rehash(nrx_topic_trie_t *trie, uint32_t slots) {
+    uint32_t *table = calloc(slots, sizeof(uint32_t));
+    if (!table) return false;
+    for (uint32_t id = 0; id < trie->segment_count; id++) {
+        uint32_t i = trie->segments[id].hash & (slots - 1);
+        while (table[i]) i = (i + 1) & (slots - 1);
+        table[i] = id + 1;
+    }
+    free(trie->segment_slots);
+    trie->segment_slots = table;
+    trie->segment_mask = slots - 1;
+    return true;
+}
+
+static uint32_t segment_intern(nrx_topic_trie_t *trie, const char *s, size_t len) {
+    uint32_t hash = hash_bytes(s, len);
+    uint32_t id = segment_find(trie, s, len, hash);
+    if (id != UINT32_MAX) return id;
+    
+    if ((trie->segment_count + 1) * 2 > trie->segment_mask + 1 &&
+        !segment_rehash(trie, (trie->segment_mask + 1) * 2)) {
+        return UINT32_MAX;
+    }
+    if (!grow((void **)&trie->segments, &trie->segment_cap, sizeof(segment_t), trie->segment_count + 1)) {
+        return UINT32_MAX;
+    }
+    if (trie->chars_len + len > trie->chars_cap) {
+        size_t cap = trie->chars_cap ? trie->chars_cap * 2 : 256;
+        while (cap < trie->chars_len + len) cap *= 2;
+        char *chars = realloc(trie->chars, cap);
+        if (!chars) return UINT32_MAX;
+        trie->chars = chars;
+        trie->chars_cap = cap;
+    }
+    
+    id = trie->segment_count++;
+    trie->segments[id] = (segment_t){ (uint32_t)trie->chars_len, (uint32_t)len, hash };
+    if (len) memcpy(trie->chars + trie->chars_len, s, len);
+    trie->chars_len += len;
+    
+    uint32_t i = hash & trie->segment_mask;
+    while (trie->segment_slots[i]) i = (i + 1) & trie->segment_mask;
+    trie->segment_slots[i] = id + 1;
+    return id;
+}
+
+// Edges
+static uint32_t edge_find(const nrx_topic_trie_t *trie, uint32_t parent, uint32_t segment) {
+    for (uint32_t i = hash_edge(parent, segment) & trie->edge_mask;; i = (i + 1) & trie->edge_mask) {
+        const edge_t *e = &trie->edges[i];
+        if (e->child == TRIE_NONE) return TRIE_NONE;
+        if (e->parent == parent && e->segment == segment) return e->child;
+    }
+}
+
+static void edge_place(edge_t *table, uint32_t mask, edge_t edge) {
+    uint32_t i = hash_edge(edge.parent, edge.segment) & mask;
+    while (table[i].child != TRIE_NONE) i = (i + 1) & mask;
+    table[i] = edge;
+}
+
+static bool edge_add(nrx_topic_trie_t *trie, uint32_t parent, uint32_t segment, uint32_t child) {
+    if ((trie->edge_count + 1) * 2 > trie->edge_mask + 1) {
+        uint32_t slots = (trie->edge_mask + 1) * 2;
+        edge_t *table = calloc(slots, sizeof(edge_t));
+        if (!table) return false;
+        for (uint32_t i = 0; i <= trie->edge_mask; i++) {
+            if (trie->edges[i].child != TRIE_NONE) edge_place(table, slots - 1, trie->edges[i]);
+        }
+        free(trie->edges);
+        trie->edges = table;
+        trie->edge_mask = slots - 1;
+    }
+    edge_place(trie->edges, trie->edge_mask, (edge_t){ parent, segment, child });
+    trie->edge_count++;
+    return true;
+}
+
+// Linear probing delete: pull later entries of the run back into the hole
+static void edge_remove(nrx_topic_trie_t *trie, uint32_t parent, uint32_t segment) {
+    uint32_t mask = trie->edge_mask;
+    uint32_t i = hash_edge(parent, segment) & mask;
+    while (trie->edges[i].parent != parent || trie->edges[i].segment != segment) {
+        if (trie->edges[i].child == TRIE_NONE) return;
+        i = (i + 1) & mask;
+    }
+    
+    for (uint32_t j = (i + 1) & mask; trie->edges[j].child != TRIE_NONE; j = (j + 1) & mask) {
+        uint32_t home = hash_edge(trie->edges[j].parent, trie->edges[j].segment) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            trie->edges[i] = trie->edges[j];
+            i = j;
+        }
+    }
+    trie->edges[i].child = TRIE_NONE;
+    trie->edge_count--;
+}
+
+// Nodes
+static uint32_t node_new(nrx_topic_trie_t *trie, uint32_t parent, node_kind_t kind, uint32_t segment) {
+    uint32_t id = trie->free_nodes;
+    if (id != TRIE_NONE) {
+        trie->free_nodes = trie->nodes[id].parent;
+    } else {
+        if (!grow((void **)&trie->nodes, &trie->node_cap, sizeof(node_t), trie->node_count + 1)) {
+            return TRIE_NONE;
+        }
+        id = trie->node_count++;
+    }
+    trie->nodes[id] = (node_t){ .parent = parent, .segment = segment, .kind = (uint8_t)kind };
+    trie->nodes[parent].children++;
+    return id;
+}
+
+// Drop empty nodes from id up towards the root
+static void node_prune(nrx_topic_trie_t *trie, uint32_t id) {
+    while (id != TRIE_ROOT && !trie->nodes[id].value && trie->nodes[id].children == 0) {
+        node_t *node = &trie->nodes[id];
+        uint32_t parent = node->parent;
+        if (node->kind == NODE_PLUS) trie->nodes[parent].plus = TRIE_NONE;
+        else if (node->kind == NODE_HASH) trie->nodes[parent].hash = TRIE_NONE;
+        else edge_remove(trie, parent, node->segment);
+        trie->nodes[parent].children--;
+        
+        node->kind = NODE_FREE;
+        node->parent = trie->free_nodes;
+        trie->free_nodes = id;
+        id = parent;
+    }
+}
+
+static bool level_is(const char *level, size_t len, char c) {
+    return len == 1 && level[0] == c;
+}
+
+// Node for filter; with create, missing levels are added
+static uint32_t node_walk(nrx_topic_trie_t *trie, const char *filter, bool create, uint32_t *last) {
+    uint32_t id = TRIE_ROOT;
+    const char *p = filter;
+    for (;;) {
+        const char *slash = strchr(p, '/');
+        size_t len = slash ? (size_t)(slash - p) : strlen(p);
+        *last = id;
+        
+        uint32_t next;
+        if (level_is(p, len, '+') || level_is(p, len, '#')) {
+            bool plus = p[0] == '+';
+            next = plus ? trie->nodes[id].plus : trie->nodes[id].hash;
+            if (next == TRIE_NONE && create) {
+                next = node_new(trie, id, plus ? NODE_PLUS : NODE_HASH, 0);
+                if (next != TRIE_NONE) {
+                    if (plus) trie->nodes[id].plus = next;
+                    else trie->nodes[id].hash = next;
+                }
+            }
+        } else {
+            uint32_t segment = create ? segment_intern(trie, p, len) : segment_find(trie, p, len, hash_bytes(p, len));
+            next = segment == UINT32_MAX ? TRIE_NONE : edge_find(trie, id, segment);
+            if (next == TRIE_NONE && create && segment != UINT32_MAX) {
+                next = node_new(trie, id, NODE_LEVEL, segment);
+                if (next != TRIE_NONE && !edge_add(trie, id, segment, next)) {
+                    trie->nodes[id].children--;
+                    trie->nodes[next].kind = NODE_FREE;
+                    trie->nodes[next].parent = trie->free_nodes;
+                    trie->free_nodes = next;
+                    next = TRIE_NONE;
+                }
+            }
+        }
+        
+        if (next == TRIE_NONE) return TRIE_NONE;
+        id = next;
+        *last = id;
+        if (!slash) return id;
+        p = slash + 1;
+    }
+}
+
+nrx_topic_trie_t *nrx_topic_trie_create(void) {
+    nrx_topic_trie_t *trie = calloc(1, sizeof(nrx_topic_trie_t));
+    if (!trie) return NULL;
+    
+    trie->segment_slots = calloc(64, sizeof(uint32_t));
+    trie->edges = calloc(64, sizeof(edge_t));
+    trie->segment_mask = 63;
+    trie->edge_mask = 63;
+    trie->free_nodes = TRIE_NONE;
+    if (!trie->segment_slots || !trie->edges || node_new(trie, TRIE_ROOT, NODE_LEVEL, 0) != TRIE_ROOT) {
+        nrx_topic_trie_destroy(trie);
+        return NULL;
+    }
+    trie->nodes[TRIE_ROOT].children = 0;
+    return trie;
+}
+
+void nrx_topic_trie_destroy(nrx_topic_trie_t *trie) {
+    if (!trie) return;
+    free(trie->nodes);
+    free(trie->chars);
+    free(trie->segments);
+    free(trie->segment_slots);
+    free(trie->edges);
+    free(trie->scratch);
+    free(trie);
+}
+
+bool nrx_topic_filter_valid(const char *filter) {
+    if (!filter || !filter[0]) return false;
+    
+    for (const char *p = filter; *p; p++) {
+        bool starts_level = p == filter || p[-1] == '/';
+        bool ends_level = p[1] == '\0' || p[1] == '/';
+        if (*p == '+' && !(starts_level && ends_level)) return false;
+        if (*p == '#' && !(starts_level && p[1] == '\0')) return false;
+    }
+    return true;
+}
+
+int nrx_topic_trie_insert(nrx_topic_trie_t *trie, const char *filter, void *value) {
+    if (!trie || !value || !nrx_topic_filter_valid(filter)) return -1;
+    
+    uint32_t last;
+    uint32_t id = node_walk(trie, filter, true, &last);
+    if (id == TRIE_NONE) {
+        node_prune(trie, last);
+        return -1;
+    }
+    
+    size_t len = strlen(filter) + 1;
+    if (len > trie->scratch_cap) {
+        char *scratch = realloc(trie->scratch, len);
+        if (!scratch) {
+            node_prune(trie, id);
+            return -1;
+        }
+        trie->scratch = scratch;
+        trie->scratch_cap = len;
+    }
+    
+    if (!trie->nodes[id].value) trie->value_count++;
+    trie->nodes[id].value = value;
+    return 0;
+}
+
+void *nrx_topic_trie_remove(nrx_topic_trie_t *trie, const char *filter) {
+    if (!trie || !nrx_topic_filter_valid(filter)) return NULL;
+    
+    uint32_t last;
+    uint32_t id = node_walk(trie, filter, false, &last);
+    if (id == TRIE_NONE || !trie->nodes[id].value) return NULL;
+    
+    void *value = trie->nodes[id].value;
+    trie->nodes[id].value = NULL;
+    trie->value_count--;
+    node_prune(trie, id);
+    return value;
+}
+
+void *nrx_topic_trie_find(const nrx_topic_trie_t *trie, const char *filter) {
+    if (!trie || !nrx_topic_filter_valid(filter)) return NULL;
+    
+    uint32_t last;
+    uint32_t id = node_walk((nrx_topic_trie_t *)trie, filter, false, &last);
+    return id == TRIE_NONE ? NULL : trie->nodes[id].value;
+}
+
+size_t nrx_topic_trie_count(const nrx_topic_trie_t *trie) {
+    return trie ? trie->value_count : 0;
+}
+
+// Matching
+typedef struct {
+    const nrx_topic_trie_t *trie;
+    const char *end;
+    nrx_topic_match_cb_t callback;
+    void *ctx;
+    size_t matched;
+} match_t;
+
+static void match_visit(match_t *m, uint32_t id) {
+    if (id != TRIE_NONE && m->trie->nodes[id].value) {
+        m->callback(m->trie->nodes[id].value, m->ctx);
+        m->matched++;
+    }
+}
+
+// Level starting at p under node id
+static void match_level(match_t *m, uint32_t id, const char *p, bool first) {
+    const node_t *node = &m->trie->nodes[id];
+    bool wildcards = !(first && p < m->end && *p == '$');
+    
+    // `#` takes this level and everything after it
+    if (wildcards) match_visit(m, node->hash);
+    
+    const char *slash = memchr(p, '/', (size_t)(m->end - p));
+    const char *level_end = slash ? slash : m->end;
+    size_t len = (size_t)(level_end - p);
+    uint32_t segment = segment_find(m->trie, p, len, hash_bytes(p, len));
+    
+    uint32_t next[2] = {
+        segment == UINT32_MAX ? TRIE_NONE : edge_find(m->trie, id, segment),
+        wildcards ? node->plus : TRIE_NONE,
+    };
+    for (int i = 0; i < 2; i++) {
+        if (next[i] == TRIE_NONE) continue;
+        if (slash) {
+            match_level(m, next[i], slash + 1, false);
+        } else {
+            // Last level: the filter itself, or the filter followed by `/#`
+            match_visit(m, next[i]);
+            match_visit(m, m->trie->nodes[next[i]].hash);
+        }
+    }
+}
+
+size_t nrx_topic_trie_match(const nrx_topic_trie_t *trie, const char *topic, size_t len,
+                            nrx_topic_match_cb_t callback, void *ctx) {
+    if (!trie || !topic || !callback || trie->value_count == 0) return 0;
+    
+    match_t m = { trie, topic + len, callback, ctx, 0 };
+    match_level(&m, TRIE_ROOT, topic, true);
+    return m.matched;
+}
+
+// Filter of a node, rebuilt from its parents into the scratch buffer
+static const char *node_filter(nrx_topic_trie_t *trie, uint32_t id) {
+    size_t len = 0;
+    for (uint32_t n = id; n != TRIE_ROOT; n = trie->nodes[n].parent) {
+        const node_t *node = &trie->nodes[n];
+        len += (node->kind == NODE_LEVEL ? trie->segments[node->segment].len : 1) + 1;
+    }
+    
+    char *p = trie->scratch + len - 1;
+    *p = '\0';
+    for (uint32_t n = id; n != TRIE_ROOT; n = trie->nodes[n].parent) {
+        const node_t *node = &trie->nodes[n];
+        if (n != id) *--p = '/';
+        if (node->kind == NODE_LEVEL) {
+            const segment_t *seg = &trie->segments[node->segment];
+            p -= seg->len;
+            memcpy(p, trie->chars + seg->offset, seg->len);
+        } else {
+            *--p = node->kind == NODE_PLUS ? '+' : '#';
+        }
+    }
+    return p;
+}
+
+void nrx_topic_trie_foreach(nrx_topic_trie_t *trie, nrx_topic_foreach_cb_t callback, void *ctx) {
+    if (!trie || !callback) return;
+    for (uint32_t id = 1; id < trie->node_count; id++) {
+        if (trie->nodes[id].kind != NODE_FREE && trie->nodes[id].value) {
+            callback(node_filter(trie, id), trie->nodes[id].value, ctx);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef NEUROX_TOPIC_TRIE_H
+#define NEUROX_TOPIC_TRIE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Topic trie
+// Maps MQTT topic filters to values, one value per filter, and finds every
+// filter matching a topic name. Nodes are topic levels; each level string
+// is interned once and a node's literal children are found through one
+// hash table keyed on (node, level), so matching costs one lookup per
+// level plus the `+` branches taken. `+` matches one level, `#` the rest
+// of the topic including its parent level, and neither matches a first
+// level starting with `$`, as MQTT requires.
+typedef struct nrx_topic_trie_t nrx_topic_trie_t;
+
+typedef void (*nrx_topic_match_cb_t)(void *value, void *ctx);
+typedef void (*nrx_topic_foreach_cb_t)(const char *filter, void *value, void *ctx);
+
+nrx_topic_trie_t *nrx_topic_trie_create(void);
+void nrx_topic_trie_destroy(nrx_topic_trie_t *trie);
+
+// `+` and `#` must fill a level, and `#` must be the last one
+bool nrx_topic_filter_valid(const char *filter);
+
+// Insert replaces the value of a filter already present; value must not be
+// NULL. Remove and find return NULL when the filter is absent.
+int nrx_topic_trie_insert(nrx_topic_trie_t *trie, const char *filter, void *value);
+void *nrx_topic_trie_remove(nrx_topic_trie_t *trie, const char *filter);
+void *nrx_topic_trie_find(const nrx_topic_trie_t *trie, const char *filter);
+size_t nrx_topic_trie_count(const nrx_topic_trie_t *trie);
+
+// Calls back once per matching filter and returns how many matched. The
+// trie must not change during the walk.
+size_t nrx_topic_trie_match(const nrx_topic_trie_t *trie, const char *topic, size_t len,
+                            nrx_topic_match_cb_t callback, void *ctx);
+void nrx_topic_trie_foreach(nrx_topic_trie_t *trie, nrx_topic_foreach_cb_t callback, void *ctx);
+
+#endif // NEUROX_TOPIC_TRIE_H
@@ -0,0 +1,246 @@
+#include "assign.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define CANDIDATES 8            // Cheapest columns each market row remembers
+
+typedef struct {
+    float cost;
+    uint32_t row;
+} bid_t;
+
+struct nrx_assign_t {
+    size_t max_rows;
+    size_t max_cols;
+    
+    // Hungarian, numbered from 1 with 0 as the virtual row and column
+    double *u, *v;              // Row and column potentials
+    double *minv;
+    uint32_t *match;            // Row held by each column
+    uint32_t *way;              // Previous column on the augmenting path
+    bool *used;
+    
+    // Market
+    int32_t *cand;              // Per row, cheapest first
+    uint8_t *cand_count;
+    uint8_t *cand_next;
+    bool *taken;
+    bid_t *heap;
+};
+
+nrx_assign_t *nrx_assign_create(size_t max_rows, size_t max_cols) {
+    if (max_rows == 0 || max_cols == 0 || max_rows >= UINT32_MAX || max_cols >= UINT32_MAX) return NULL;
+    
+    nrx_assign_t *s = calloc(1, sizeof(nrx_assign_t));
+    if (!s) return NULL;
+    size_t n = (max_rows > max_cols ? max_rows : max_cols) + 1;
+    s->max_rows = max_rows;
+    s->max_cols = max_cols;
+    s->u = malloc(n * sizeof(double));
+    s->v = malloc(n * sizeof(double));
+    s->minv = malloc(n * sizeof(double));
+    s->match = malloc(n * sizeof(uint32_t));
+    s->way = malloc(n * sizeof(uint32_t));
+    s->used = malloc(n * sizeof(bool));
+    s->cand = malloc(max_rows * CANDIDATES * sizeof(int32_t));
+    s->cand_count = malloc(max_rows);
+    s->cand_next = malloc(max_rows);
+    s->taken = malloc(max_cols * sizeof(bool));
+    s->heap = malloc(max_rows * sizeof(bid_t));
+    if (!s->u || !s->v || !s->minv || !s->match || !s->way || !s->used || !s->cand ||
+        !s->cand_count || !s->cand_next || !s->taken || !s->heap) {
+        nrx_assign_destroy(s);
+        return NULL;
+    }
+    return s;
+}
+
+void nrx_assign_destroy(nrx_assign_t *s) {
+    if (!s) return;
+    free(s->u);
+    free(s->v);
+    free(s->minv);
+    free(s->match);
+    free(s->way);
+    free(s->used);
+    free(s->cand);
+    free(s->cand_count);
+    free(s->cand_next);
+    free(s->taken);
+    free(s->heap);
+    free(s);
+}
+
+static bool fits(const nrx_assign_t *s, const float *cost, size_t rows, size_t cols, const int32_t *out) {
+    return s && (cost || rows == 0 || cols == 0) && (out || rows == 0) &&
+           rows <= s->max_rows && cols <= s->max_cols;
+}
+
+// Hungarian method
+int nrx_assign_optimal(nrx_assign_t *s, const float *cost, size_t rows, size_t cols,
+                       int32_t *row_to_col) {
+    if (!fits(s, cost, rows, cols, row_to_col)) return -1;
+    for (size_t i = 0; i < rows; i++) row_to_col[i] = -1;
+    if (rows == 0 || cols == 0) return 0;
+    
+    // Every one of the n rows gets one of the m columns, so the side with
+    // fewer entries plays the rows
+    bool swap = rows > cols;
+    size_t n = swap ? cols : rows, m = swap ? rows : cols;
+#define COST(i, j) (swap ? cost[(j) * cols + (i)] : cost[(i) * cols + (j)])
+    double *u = s->u, *v = s->v, *minv = s->minv;
+    uint32_t *match = s->match, *way = s->way;
+    bool *used = s->used;
+    for (size_t i = 0; i <= n; i++) u[i] = 0.0;
+    for (size_t j = 0; j <= m; j++) {
+        v[j] = 0.0;
+        match[j] = 0;
+    }
+    
+    // Add rows one at a time, each along the shortest path in reduced
+    // costs, then adjust the potentials so reduced costs stay non-negative
+    for (size_t i = 1; i <= n; i++) {
+        match[0] = (uint32_t)i;
+        size_t j0 = 0;
+        for (size_t j = 0; j <= m; j++) {
+            minv[j] = INFINITY;
+            used[j] = false;
+        }
+        do {
+            used[j0] = true;
+            size_t i0 = match[j0], j1 = 0;
+            double delta = INFINITY;
+            for (size_t j = 1; j <= m; j++) {
+                if (used[j]) continue;
+                double cur = COST(i0 - 1, j - 1) - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = (uint32_t)j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= m; j++) {
+                if (used[j]) {
+                    u[match[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (match[j0] != 0);
+        
+        // Flip the path
+        do {
+            size_t j1 = way[j0];
+            match[j0] = match[j1];
+            j0 = j1;
+        } while (j0);
+    }
+#undef COST
+    
+    for (size_t j = 1; j <= m; j++) {
+        if (match[j] == 0) continue;
+        if (swap) row_to_col[j - 1] = (int32_t)(match[j] - 1);
+        else row_to_col[match[j] - 1] = (int32_t)(j - 1);
+    }
+    return (int)n;
+}
+
+// Market
+static bool cheaper(bid_t a, bid_t b) {
+    return a.cost < b.cost || (a.cost == b.cost && a.row < b.row);
+}
+
+static void push_bid(nrx_assign_t *s, size_t *len, bid_t bid) {
+    size_t i = (*len)++;
+    while (i > 0 && cheaper(bid, s->heap[(i - 1) / 2])) {
+        s->heap[i] = s->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s->heap[i] = bid;
+}
+
+static bid_t pop_bid(nrx_assign_t *s, size_t *len) {
+    bid_t top = s->heap[0], last = s->heap[--*len];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= *len) break;
+        if (child + 1 < *len && cheaper(s->heap[child + 1], s->heap[child])) child++;
+        if (!cheaper(s->heap[child], last)) break;
+        s->heap[i] = s->heap[child];
+        i = child;
+    }
+    s->heap[i] = last;
+    return top;
+}
+
+// The row's cheapest free columns, by insertion into a short sorted list
+static void refill(nrx_assign_t *s, const float *cost, size_t cols, size_t row) {
+    int32_t *cand = s->cand + row * CANDIDATES;
+    const float *c = cost + row * cols;
+    size_t count = 0;
+    for (size_t j = 0; j < cols; j++) {
+        if (s->taken[j]) continue;
+        float cj = c[j];
+        if (count == CANDIDATES && cj >= c[cand[CANDIDATES - 1]]) continue;
+        size_t k = count < CANDIDATES ? count++ : CANDIDATES - 1;
+        while (k > 0 && c[cand[k - 1]] > cj) {
+            cand[k] = cand[k - 1];
+            k--;
+        }
+        cand[k] = (int32_t)j;
+    }
+    s->cand_count[row] = (uint8_t)count;
+    s->cand_next[row] = 0;
+}
+
+// A short list held every free column, so once it is used up there are none
+static int32_t best_free(nrx_assign_t *s, const float *cost, size_t cols, size_t row) {
+    for (;;) {
+        while (s->cand_next[row] < s->cand_count[row]) {
+            int32_t j = s->cand[row * CANDIDATES + s->cand_next[row]];
+            if (!s->taken[j]) return j;
+            s->cand_next[row]++;
+        }
+        if (s->cand_count[row] < CANDIDATES) return -1;
+        refill(s, cost, cols, row);
+    }
+}
+
+int nrx_assign_market(nrx_assign_t *s, const float *cost, size_t rows, size_t cols,
+                      int32_t *row_to_col) {
+    if (!fits(s, cost, rows, cols, row_to_col)) return -1;
+    for (size_t j = 0; j < cols; j++) s->taken[j] = false;
+    
+    size_t len = 0;
+    for (size_t r = 0; r < rows; r++) {
+        row_to_col[r] = -1;
+        if (cols == 0) continue;
+        refill(s, cost, cols, r);
+        push_bid(s, &len, (bid_t){ cost[r * cols + s->cand[r * CANDIDATES]], (uint32_t)r });
+    }
+    
+    // The lowest standing bid wins its column; a bid whose column has gone
+    // meanwhile goes back in at the row's next price
+    size_t limit = rows < cols ? rows : cols;
+    int pairs = 0;
+    while (len > 0 && (size_t)pairs < limit) {
+        bid_t bid = pop_bid(s, &len);
+        int32_t j = best_free(s, cost, cols, bid.row);
+        if (j < 0) continue;
+        float price = cost[bid.row * cols + (size_t)j];
+        if (price > bid.cost) {
+            push_bid(s, &len, (bid_t){ price, bid.row });
+            continue;
+        }
+        s->taken[j] = true;
+        row_to_col[bid.row] = j;
+        pairs++;
+    }
+    return pairs;
+}
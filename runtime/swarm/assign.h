@@ -0,0 +1,35 @@
+#ifndef NEUROX_ASSIGN_H
+#define NEUROX_ASSIGN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Assignment solvers
+// Match rows (robots) to columns (tasks) over a row-major cost matrix,
+// each row to at most one column and each column to at most one row, as
+// many pairs as min(rows, cols). Costs must be finite. The workspace is
+// sized at create, so solving does not allocate.
+//
+// nrx_assign_optimal() finds the minimum total cost with the Hungarian
+// method (shortest augmenting paths with potentials), O(n^2 m) for n rows
+// and m columns: exact, and fast enough up to a hundred or so.
+//
+// nrx_assign_market() runs a market: every row bids for its cheapest free
+// column, the lowest bid in the market wins, and outbid rows bid again.
+// Each row keeps a short list of its cheapest columns and rescans only
+// when that runs out, so a solve costs about one pass over the matrix.
+// It is greedy, not optimal, and each row's bid needs only its own costs.
+typedef struct nrx_assign_t nrx_assign_t;
+
+nrx_assign_t *nrx_assign_create(size_t max_rows, size_t max_cols);
+void nrx_assign_destroy(nrx_assign_t *solver);
+
+// Both fill row_to_col (-1 for an unmatched row) and return the number of
+// pairs, or -1 if the matrix is larger than the workspace
+int nrx_assign_optimal(nrx_assign_t *solver, const float *cost, size_t rows, size_t cols,
+                       int32_t *row_to_col);
+int nrx_assign_market(nrx_assign_t *solver, const float *cost, size_t rows, size_t cols,
+                      int32_t *row_to_col);
+
+#endif // NEUROX_ASSIGN_H
@@ -0,0 +1,272 @@
+#include "coverage.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MAX_SIDE (1u << 24)     // Cells along either axis
+
+struct nrx_coverage_grid_t {
+    double min_x, min_y;
+    double cell_size;
+    size_t width, height;       // In cells
+    size_t stride;              // Words per row
+    uint64_t tail;              // Cells in each row's last word
+    uint64_t *visited;
+    uint64_t *frontier;
+    size_t visited_count;
+    size_t frontier_count;
+};
+
+nrx_coverage_grid_t *nrx_coverage_create(const nrx_coverage_area_t *area) {
+    if (!area || !isfinite(area->min_x) || !isfinite(area->min_y) ||
+        !(area->max_x > area->min_x) || !(area->max_y > area->min_y) || !(area->cell_size > 0.0f)) {
+        return NULL;
+    }
+    double w = ceil(((double)area->max_x - area->min_x) / area->cell_size);
+    double h = ceil(((double)area->max_y - area->min_y) / area->cell_size);
+    if (!(w <= MAX_SIDE && h <= MAX_SIDE)) return NULL;
+    
+    nrx_coverage_grid_t *grid = calloc(1, sizeof(nrx_coverage_grid_t));
+    if (!grid) return NULL;
+    grid->min_x = area->min_x;
+    grid->min_y = area->min_y;
+    grid->cell_size = area->cell_size;
+    grid->width = (size_t)w;
+    grid->height = (size_t)h;
+    grid->stride = (grid->width + 63) / 64;
+    grid->tail = grid->width % 64 ? (1ULL << (grid->width % 64)) - 1 : ~0ULL;
+    if (grid->stride > SIZE_MAX / sizeof(uint64_t) / grid->height) {
+        free(grid);
+        return NULL;
+    }
+    grid->visited = calloc(grid->stride * grid->height, sizeof(uint64_t));
+    grid->frontier = calloc(grid->stride * grid->height, sizeof(uint64_t));
+    if (!grid->visited || !grid->frontier) {
+        nrx_coverage_destroy(grid);
+        return NULL;
+    }
+    return grid;
+}
+
+void nrx_coverage_destroy(nrx_coverage_grid_t *grid) {
+    if (!grid) return;
+    free(grid->visited);
+    free(grid->frontier);
+    free(grid);
+}
+
+// Cell coordinates, with cell centres on whole numbers. Points beyond
+// the largest radius from the grid are pulled in to that distance, so
+// far-off points stay representable.
+static double cell_coord(double v, double origin, double cell_size, size_t n) {
+    double c = (v - origin) / cell_size - 0.5, margin = 2.0 * MAX_SIDE;
+    if (c < -margin) return -margin;
+    if (c > (double)n + margin) return (double)n + margin;
+    return c;
+}
+
+static long clamp_index(double c, size_t n) {
+    if (c < 0.0) return 0;
+    if (c > (double)(n - 1)) return (long)(n - 1);
+    return (long)c;
+}
+
+// The frontier word from the visited cells in it and around it
+static void refresh_frontier(nrx_coverage_grid_t *grid, size_t row, size_t word) {
+    size_t i = row * grid->stride + word;
+    uint64_t v = grid->visited[i];
+    uint64_t near = (v << 1) | (v >> 1);
+    if (word > 0) near |= grid->visited[i - 1] >> 63;
+    if (word + 1 < grid->stride) near |= grid->visited[i + 1] << 63;
+    if (row > 0) near |= grid->visited[i - grid->stride];
+    if (row + 1 < grid->height) near |= grid->visited[i + grid->stride];
+    
+    uint64_t f = near & ~v;
+    if (word + 1 == grid->stride) f &= grid->tail;
+    grid->frontier_count += (size_t)__builtin_popcountll(f);
+    grid->frontier_count -= (size_t)__builtin_popcountll(grid->frontier[i]);
+    grid->frontier[i] = f;
+}
+
+// Visits columns c0..c1 of a row; how many were new
+static size_t fill_span(nrx_coverage_grid_t *grid, size_t row, size_t c0, size_t c1) {
+    uint64_t *words = grid->visited + row * grid->stride;
+    size_t added = 0;
+    for (size_t w = c0 / 64; w <= c1 / 64; w++) {
+        uint64_t mask = ~0ULL;
+        if (w == c0 / 64) mask &= ~0ULL << (c0 % 64);
+        if (w == c1 / 64) mask &= ~0ULL >> (63 - c1 % 64);
+        added += (size_t)__builtin_popcountll(mask & ~words[w]);
+        words[w] |= mask;
+    }
+    return added;
+}
+
+int nrx_coverage_mark(nrx_coverage_grid_t *grid, float x, float y, float radius) {
+    if (!grid || !isfinite(x) || !isfinite(y)) return -1;
+    double gx = cell_coord(x, grid->min_x, grid->cell_size, grid->width);
+    double gy = cell_coord(y, grid->min_y, grid->cell_size, grid->height);
+    double r = radius > 0.0f ? fmin(radius / grid->cell_size, (double)MAX_SIDE) : 0.0;
+    double home_col = floor(gx + 0.5), home_row = floor(gy + 0.5);
+    
+    double row0 = fmin(ceil(gy - r), home_row), row1 = fmax(floor(gy + r), home_row);
+    if (row1 < 0.0 || row0 > (double)(grid->height - 1)) return -1;
+    size_t added = 0;
+    long rmin = -1, rmax = -1;
+    size_t cmin = SIZE_MAX, cmax = 0;
+    for (long row = clamp_index(row0, grid->height); row <= clamp_index(row1, grid->height); row++) {
+        // Columns whose centres are within the circle on this row; the
+        // home cell's centre is the nearest in its row, so the span always
+        // reaches it when it is not empty
+        double dy = row - gy, half = r * r - dy * dy;
+        double c0 = 1.0, c1 = 0.0;
+        if (half >= 0.0) {
+            c0 = ceil(gx - sqrt(half));
+            c1 = floor(gx + sqrt(half));
+        }
+        if (row == (long)home_row && c0 > c1) c0 = c1 = home_col;
+        if (c0 > c1 || c1 < 0.0 || c0 > (double)(grid->width - 1)) continue;
+        
+        size_t a = (size_t)clamp_index(c0, grid->width), b = (size_t)clamp_index(c1, grid->width);
+        added += fill_span(grid, (size_t)row, a, b);
+        if (rmin < 0) rmin = row;
+        rmax = row;
+        if (a < cmin) cmin = a;
+        if (b > cmax) cmax = b;
+    }
+    if (rmin < 0) return -1;
+    grid->visited_count += added;
+    if (added == 0) return 0;
+    
+    // The frontier can change one cell around what was marked
+    size_t r0 = rmin > 0 ? (size_t)rmin - 1 : 0;
+    size_t r1 = (size_t)rmax + 1 < grid->height ? (size_t)rmax + 1 : (size_t)rmax;
+    size_t w0 = (cmin > 0 ? cmin - 1 : 0) / 64;
+    size_t w1 = (cmax + 1 < grid->width ? cmax + 1 : cmax) / 64;
+    for (size_t row = r0; row <= r1; row++) {
+        for (size_t w = w0; w <= w1; w++) refresh_frontier(grid, row, w);
+    }
+    return (int)(added > INT32_MAX ? INT32_MAX : added);
+}
+
+bool nrx_coverage_is_visited(const nrx_coverage_grid_t *grid, float x, float y) {
+    if (!grid || !isfinite(x) || !isfinite(y)) return false;
+    double col = floor(cell_coord(x, grid->min_x, grid->cell_size, grid->width) + 0.5);
+    double row = floor(cell_coord(y, grid->min_y, grid->cell_size, grid->height) + 0.5);
+    if (col < 0.0 || row < 0.0 || col >= (double)grid->width || row >= (double)grid->height) return false;
+    size_t c = (size_t)col;
+    return (grid->visited[(size_t)row * grid->stride + c / 64] >> (c % 64)) & 1;
+}
+
+// Nearest search
+typedef struct {
+    const nrx_coverage_grid_t *grid;
+    bool unvisited;             // Search unvisited cells rather than the frontier
+    double gx, gy;
+    double best;                // Squared distance in cells
+    size_t col, row;
+} search_t;
+
+static uint64_t search_word(const search_t *s, size_t row, size_t word) {
+    const nrx_coverage_grid_t *grid = s->grid;
+    size_t i = row * grid->stride + word;
+    if (!s->unvisited) return grid->frontier[i];
+    uint64_t w = ~grid->visited[i];
+    return word + 1 == grid->stride ? w & grid->tail : w;
+}
+
+static void consider(search_t *s, size_t row, size_t col, double dy2) {
+    double dx = (double)col - s->gx, d = dx * dx + dy2;
+    if (d < s->best) {
+        s->best = d;
+        s->col = col;
+        s->row = row;
+    }
+}
+
+// The nearest cell of one row on either side of the query column, a word
+// at a time, giving up on a side once its next word is farther than the
+// best so far
+static void search_row(search_t *s, size_t row) {
+    double dy = (double)row - s->gy, dy2 = dy * dy;
+    size_t start = (size_t)clamp_index(floor(s->gx + 0.5), s->grid->width);
+    
+    size_t w = start / 64;
+    uint64_t bits = search_word(s, row, w) & (~0ULL << (start % 64));
+    for (;;) {
+        if (bits) {
+            consider(s, row, w * 64 + (size_t)__builtin_ctzll(bits), dy2);
+            break;
+        }
+        if (++w == s->grid->stride) break;
+        double dx = (double)(w * 64) - s->gx;
+        if (dx * dx + dy2 >= s->best) break;
+        bits = search_word(s, row, w);
+    }
+    
+    if (start == 0) return;
+    w = (start - 1) / 64;
+    bits = search_word(s, row, w) & (~0ULL >> (63 - (start - 1) % 64));
+    for (;;) {
+        if (bits) {
+            consider(s, row, w * 64 + 63 - (size_t)__builtin_clzll(bits), dy2);
+            break;
+        }
+        if (w-- == 0) break;
+        double dx = s->gx - (double)(w * 64 + 63);
+        if (dx * dx + dy2 >= s->best) break;
+        bits = search_word(s, row, w);
+    }
+}
+
+bool nrx_coverage_nearest(const nrx_coverage_grid_t *grid, float x, float y,
+                          float *target_x, float *target_y) {
+    if (!grid || !target_x || !target_y || !isfinite(x) || !isfinite(y)) return false;
+    if (grid->visited_count == grid->width * grid->height) return false;
+    
+    search_t s = {
+        .grid = grid,
+        .unvisited = grid->frontier_count == 0,
+        .gx = cell_coord(x, grid->min_x, grid->cell_size, grid->width),
+        .gy = cell_coord(y, grid->min_y, grid->cell_size, grid->height),
+        .best = INFINITY,
+    };
+    
+    // Rows in order of distance, until they are farther than the best cell
+    size_t home = (size_t)clamp_index(floor(s.gy + 0.5), grid->height);
+    search_row(&s, home);
+    for (size_t k = 1; k < grid->height; k++) {
+        bool more = false;
+        if (home >= k) {
+            double dy = s.gy - (double)(home - k);
+            if (dy * dy < s.best) {
+                search_row(&s, home - k);
+                more = true;
+            }
+        }
+        if (home + k < grid->height) {
+            double dy = (double)(home + k) - s.gy;
+            if (dy * dy < s.best) {
+                search_row(&s, home + k);
+                more = true;
+            }
+        }
+        if (!more) break;
+    }
+    
+    *target_x = (float)(grid->min_x + (s.col + 0.5) * grid->cell_size);
+    *target_y = (float)(grid->min_y + (s.row + 0.5) * grid->cell_size);
+    return true;
+}
+
+size_t nrx_coverage_cell_count(const nrx_coverage_grid_t *grid) {
+    return grid ? grid->width * grid->height : 0;
+}
+
+size_t nrx_coverage_visited_count(const nrx_coverage_grid_t *grid) {
+    return grid ? grid->visited_count : 0;
+}
+
+size_t nrx_coverage_frontier_count(const nrx_coverage_grid_t *grid) {
+    return grid ? grid->frontier_count : 0;
+}
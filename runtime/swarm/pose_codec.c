@@ -0,0 +1,178 @@
+#include "pose_codec.h"
+#include "codec.h"
+#include <math.h>
+
+#define KIND_KEYFRAME 0
+#define KIND_DELTA 1
+#define TWO_PI 6.283185307179586
+
+// Quantization
+static int32_t steps(double v) {
+    double s = nearbyint(v);
+    if (!(s > (double)INT32_MIN)) return INT32_MIN;     // Also NaN
+    if (s > (double)INT32_MAX) return INT32_MAX;
+    return (int32_t)s;
+}
+
+void nrx_pose_quantize(const nrx_robot_pose_t *pose, const nrx_pose_rate_t *rate,
+                       uint32_t resolution_um, nrx_pose_q_t *q) {
+    double per_m = 1e6 / resolution_um;
+    q->x = steps(pose->x * per_m);
+    q->y = steps(pose->y * per_m);
+    q->z = steps(pose->z * per_m);
+    q->vx = steps(rate->vx * per_m);
+    q->vy = steps(rate->vy * per_m);
+    q->yaw_rate = steps(rate->yaw_rate / TWO_PI * 65536.0);
+    double turns = isfinite(pose->heading) ? nearbyint(pose->heading / TWO_PI * 65536.0) : 0.0;
+    q->heading = (uint16_t)((uint64_t)(int64_t)fmod(turns, 65536.0) & 0xFFFF);
+    q->timestamp_us = pose->timestamp_us;
+}
+
+void nrx_pose_dequantize(const nrx_pose_q_t *q, uint32_t resolution_um, nrx_robot_pose_t *pose,
+                         nrx_pose_rate_t *rate) {
+    double m = resolution_um * 1e-6;
+    pose->x = (float)(q->x * m);
+    pose->y = (float)(q->y * m);
+    pose->z = (float)(q->z * m);
+    int32_t h = q->heading >= 32768 ? (int32_t)q->heading - 65536 : q->heading;
+    pose->heading = (float)(h * (TWO_PI / 65536.0));
+    pose->timestamp_us = q->timestamp_us;
+    rate->vx = (float)(q->vx * m);
+    rate->vy = (float)(q->vy * m);
+    rate->yaw_rate = (float)(q->yaw_rate * (TWO_PI / 65536.0));
+}
+
+void nrx_pose_predict(const nrx_robot_pose_t *pose, const nrx_pose_rate_t *rate, uint64_t time_us,
+                      uint64_t horizon_us, nrx_robot_pose_t *out) {
+    *out = *pose;
+    if (time_us <= pose->timestamp_us) return;
+    uint64_t ahead = time_us - pose->timestamp_us;
+    if (horizon_us && ahead > horizon_us) ahead = horizon_us;
+    float dt = (float)ahead * 1e-6f;
+    out->x += rate->vx * dt;
+    out->y += rate->vy * dt;
+    out->heading = remainderf(pose->heading + rate->yaw_rate * dt, (float)TWO_PI);
+    out->timestamp_us = time_us;
+}
+
+// Varints, zigzag for signed values
+static void put_varint(nrx_codec_writer_t *w, uint64_t v) {
+    do {
+        uint8_t *p = nrx_codec_take(w, 1);
+        if (!p) return;
+        *p = (uint8_t)((v & 0x7F) | (v > 0x7F ? 0x80 : 0));
+        v >>= 7;
+    } while (v);
+}
+
+static void put_signed(nrx_codec_writer_t *w, int64_t v) {
+    put_varint(w, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+typedef struct {
+    const uint8_t *p;
+    size_t len;
+    size_t pos;
+    bool bad;
+} reader_t;
+
+static uint64_t get_varint(reader_t *r) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && r->pos < r->len; shift += 7) {
+        uint8_t b = r->p[r->pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    r->bad = true;
+    return 0;
+}
+
+static int64_t get_signed(reader_t *r) {
+    uint64_t v = get_varint(r);
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Payload: kind, keyframe sequence, then the fields
+size_t nrx_pose_encode_keyframe(nrx_pose_keyframe_t *key, const nrx_pose_q_t *q,
+                                uint32_t resolution_um, uint8_t *buf) {
+    uint8_t seq = key->valid ? (uint8_t)(key->seq + 1) : 0;
+    nrx_codec_writer_t w = nrx_codec_writer(buf, NRX_POSE_MAX_PAYLOAD);
+    nrx_bin_uint(&w, KIND_KEYFRAME, 1);
+    nrx_bin_uint(&w, seq, 1);
+    put_varint(&w, resolution_um);
+    put_varint(&w, q->timestamp_us);
+    put_signed(&w, q->x);
+    put_signed(&w, q->y);
+    put_signed(&w, q->z);
+    nrx_bin_uint(&w, q->heading, 2);
+    put_signed(&w, q->vx);
+    put_signed(&w, q->vy);
+    put_signed(&w, q->yaw_rate);
+    
+    *key = (nrx_pose_keyframe_t){ *q, resolution_um, seq, true };
+    return nrx_codec_end(&w);
+}
+
+size_t nrx_pose_encode_delta(const nrx_pose_keyframe_t *key, const nrx_pose_q_t *q, uint8_t *buf) {
+    const nrx_pose_q_t *k = &key->state;
+    nrx_codec_writer_t w = nrx_codec_writer(buf, NRX_POSE_MAX_PAYLOAD);
+    nrx_bin_uint(&w, KIND_DELTA, 1);
+    nrx_bin_uint(&w, key->seq, 1);
+    put_signed(&w, (int64_t)(q->timestamp_us - k->timestamp_us));
+    put_signed(&w, (int64_t)q->x - k->x);
+    put_signed(&w, (int64_t)q->y - k->y);
+    put_signed(&w, (int64_t)q->z - k->z);
+    int32_t turn = (q->heading - k->heading) & 0xFFFF;
+    put_signed(&w, turn >= 32768 ? turn - 65536 : turn);
+    put_signed(&w, (int64_t)q->vx - k->vx);
+    put_signed(&w, (int64_t)q->vy - k->vy);
+    put_signed(&w, (int64_t)q->yaw_rate - k->yaw_rate);
+    return nrx_codec_end(&w);
+}
+
+// A varint delta can be anything up to INT64_MAX, so range-check it before
+// adding rather than checking a sum that may already have overflowed
+static bool add_steps(int32_t base, int64_t delta, int32_t *out) {
+    if (delta < (int64_t)INT32_MIN - base || delta > (int64_t)INT32_MAX - base) return false;
+    *out = (int32_t)(base + delta);
+    return true;
+}
+
+int nrx_pose_decode(nrx_pose_keyframe_t *key, const uint8_t *buf, size_t len, nrx_pose_q_t *q) {
+    if (!buf || len < 2) return -1;
+    reader_t r = { buf, len, 2, false };
+    uint8_t seq = buf[1];
+    
+    if (buf[0] == KIND_KEYFRAME) {
+        uint64_t resolution = get_varint(&r);
+        q->timestamp_us = get_varint(&r);
+        int64_t x = get_signed(&r), y = get_signed(&r), z = get_signed(&r);
+        if (r.bad || len - r.pos < 2) return -1;
+        q->heading = (uint16_t)nrx_bin_read_uint(buf + r.pos, 2);
+        r.pos += 2;
+        int64_t vx = get_signed(&r), vy = get_signed(&r), yaw = get_signed(&r);
+        if (r.bad || r.pos != len || resolution == 0 || resolution > UINT32_MAX ||
+            !add_steps(0, x, &q->x) || !add_steps(0, y, &q->y) || !add_steps(0, z, &q->z) ||
+            !add_steps(0, vx, &q->vx) || !add_steps(0, vy, &q->vy) || !add_steps(0, yaw, &q->yaw_rate)) {
+            return -1;
+        }
+        *key = (nrx_pose_keyframe_t){ *q, (uint32_t)resolution, seq, true };
+        return 0;
+    }
+    
+    if (buf[0] != KIND_DELTA || !key->valid || key->seq != seq) return -1;
+    const nrx_pose_q_t *k = &key->state;
+    int64_t dt = get_signed(&r);
+    int64_t dx = get_signed(&r), dy = get_signed(&r), dz = get_signed(&r);
+    int64_t dh = get_signed(&r);
+    int64_t dvx = get_signed(&r), dvy = get_signed(&r), dyaw = get_signed(&r);
+    if (r.bad || r.pos != len || dh < INT16_MIN || dh > INT16_MAX ||
+        !add_steps(k->x, dx, &q->x) || !add_steps(k->y, dy, &q->y) || !add_steps(k->z, dz, &q->z) ||
+        !add_steps(k->vx, dvx, &q->vx) || !add_steps(k->vy, dvy, &q->vy) ||
+        !add_steps(k->yaw_rate, dyaw, &q->yaw_rate)) {
+        return -1;
+    }
+    q->heading = (uint16_t)(k->heading + dh);
+    q->timestamp_us = k->timestamp_us + (uint64_t)dt;
+    return 0;
+}
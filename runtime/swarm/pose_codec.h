@@ -0,0 +1,59 @@
+#ifndef NEUROX_POSE_CODEC_H
+#define NEUROX_POSE_CODEC_H
+
+#include "swarm.h"
+
+// Pose coding
+// Poses travel quantized: positions and velocities in steps of a
+// resolution carried by the keyframe, heading and yaw rate in 1/65536
+// turns. A keyframe
+// has the whole state; deltas in between hold only the difference from
+// the last keyframe as zigzag varints. They do not chain, so a lost delta
+// costs nothing, and a lost keyframe only until the next one. Receivers
+// extrapolate from velocity and yaw rate; senders run the same prediction
+// and stay quiet while it is close enough.
+typedef struct {
+    float vx, vy;               // m/s
+    float yaw_rate;             // rad/s
+} nrx_pose_rate_t;
+
+typedef struct {
+    int32_t x, y, z;            // Resolution steps
+    uint16_t heading;           // 1/65536 turn
+    int32_t vx, vy;             // Resolution steps per second
+    int32_t yaw_rate;           // 1/65536 turn per second
+    uint64_t timestamp_us;
+} nrx_pose_q_t;
+
+// The last keyframe on either end of a link
+typedef struct {
+    nrx_pose_q_t state;
+    uint32_t resolution_um;
+    uint8_t seq;
+    bool valid;
+} nrx_pose_keyframe_t;
+
+#define NRX_POSE_MAX_PAYLOAD 48
+
+void nrx_pose_quantize(const nrx_robot_pose_t *pose, const nrx_pose_rate_t *rate,
+                       uint32_t resolution_um, nrx_pose_q_t *q);
+void nrx_pose_dequantize(const nrx_pose_q_t *q, uint32_t resolution_um, nrx_robot_pose_t *pose,
+                         nrx_pose_rate_t *rate);
+
+// Where a robot is expected at time_us, going no further than horizon_us
+// past the pose (0 = no limit). The same arithmetic runs on both ends, so
+// the sender knows what receivers believe.
+void nrx_pose_predict(const nrx_robot_pose_t *pose, const nrx_pose_rate_t *rate, uint64_t time_us,
+                      uint64_t horizon_us, nrx_robot_pose_t *out);
+
+// Encoders return the payload length. A keyframe replaces key, with the
+// next sequence number.
+size_t nrx_pose_encode_keyframe(nrx_pose_keyframe_t *key, const nrx_pose_q_t *q,
+                                uint32_t resolution_um, uint8_t *buf);
+size_t nrx_pose_encode_delta(const nrx_pose_keyframe_t *key, const nrx_pose_q_t *q, uint8_t *buf);
+
+// 0 with the state in q (and key updated by a keyframe), or -1 for a
+// malformed payload or a delta whose keyframe this end does not have
+int nrx_pose_decode(nrx_pose_keyframe_t *key, const uint8_t *buf, size_t len, nrx_pose_q_t *q);
+
+#endif // NEUROX_POSE_CODEC_H
@@ -0,0 +1,706 @@
+#include "raft.h"
+#include "codec.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ELECTION_TIMEOUT_MS 150
+#define DEFAULT_LOG_CAPACITY 1024
+#define DEFAULT_MAX_BATCH 32
+#define DEFAULT_MAX_INFLIGHT 4
+
+// Message kinds; every message starts with the kind and the sender's term
+#define MSG_VOTE 1              // pre u8, last index u32, last term u32
+#define MSG_VOTE_REPLY 2        // pre u8, granted u8
+#define MSG_APPEND 3            // prev u32, prev term u32, commit u32, sent u64, count u16, entries
+#define MSG_APPEND_REPLY 4      // ok u8, match u32, count u16, sent u64
+#define MSG_SNAPSHOT 5          // index u32, term u32, round u32, proposer u32, value f32, sent u64
+#define MSG_PROPOSE 6           // proposer u32, value f32
+
+#define HEADER_SIZE 5
+#define ENTRY_SIZE 12
+
+typedef struct {
+    uint32_t term;
+    uint32_t proposer;          // 0 for the entry a leader opens its term with
+    float value;
+} entry_t;
+
+typedef struct {
+    uint32_t id;
+    uint32_t next;              // Next index to send
+    uint32_t match;             // Highest index known to be replicated
+    uint32_t inflight;          // AppendEntries with entries, unanswered
+    uint64_t last_reply_us;
+    uint64_t progress_us;       // Last acknowledgement, or when the window opened
+    uint64_t srtt_us;           // Smoothed round trip
+    uint64_t rewound_us;        // Replies to what was sent before this are stale
+    uint64_t lease_from_us;     // When the latest acknowledged AppendEntries was sent
+    bool voted;                 // For this robot in the current (pre-)election
+} peer_t;
+
+// An AppendEntries that overtook the one before it
+typedef struct {
+    size_t len;                 // 0 when free
+    uint8_t body[NRX_RAFT_MAX_PAYLOAD - HEADER_SIZE];
+} held_t;
+
+struct nrx_raft_t {
+    nrx_raft_config_t config;
+    peer_t peers[NRX_RAFT_MAX_MEMBERS - 1];
+    size_t peer_count;
+    size_t quorum;
+    
+    nrx_raft_role_t role;
+    bool pre_voting;
+    uint32_t term;
+    uint32_t voted_for;
+    uint32_t leader;
+    uint32_t term_start;        // Index of this leader's first entry
+    uint64_t leader_contact_us;
+    uint64_t election_due_us;
+    uint64_t heartbeat_due_us;
+    uint64_t lease_us;
+    uint64_t rng;
+    
+    // Entries base+1..last, entry i at log[i % capacity]; base is the
+    // snapshot, with the value committed up to it
+    entry_t *log;
+    uint32_t base;
+    uint32_t base_term;
+    nrx_consensus_value_t base_value;
+    uint32_t last;
+    uint32_t commit;
+    nrx_consensus_value_t value;   // At commit; round 0 until a value is committed
+    held_t *held;                  // max_inflight of them
+    
+    uint8_t buf[NRX_RAFT_MAX_PAYLOAD];
+};
+
+// Log
+static uint32_t term_at(const nrx_raft_t *raft, uint32_t index) {
+    if (index == raft->base) return raft->base_term;
+    if (index < raft->base || index > raft->last) return 0;
+    return raft->log[index % raft->config.log_capacity].term;
+}
+
+static entry_t *entry_at(const nrx_raft_t *raft, uint32_t index) {
+    return &raft->log[index % raft->config.log_capacity];
+}
+
+// Committed entries give up their room, oldest first
+static bool append(nrx_raft_t *raft, const entry_t *e) {
+    if (raft->last - raft->base == raft->config.log_capacity) {
+        if (raft->base == raft->commit) return false;
+        const entry_t *old = entry_at(raft, raft->base + 1);
+        raft->base++;
+        raft->base_term = old->term;
+        if (old->proposer) raft->base_value = (nrx_consensus_value_t){ old->value, old->proposer, raft->base };
+    }
+    raft->last++;
+    *entry_at(raft, raft->last) = *e;
+    return true;
+}
+
+static void commit_to(nrx_raft_t *raft, uint32_t index) {
+    if (index > raft->last) index = raft->last;
+    for (uint32_t i = raft->commit + 1; i <= index; i++) {
+        const entry_t *e = entry_at(raft, i);
+        if (e->proposer) raft->value = (nrx_consensus_value_t){ e->value, e->proposer, i };
+    }
+    if (index > raft->commit) raft->commit = index;
+}
+
+// Roles
+static uint64_t random_next(nrx_raft_t *raft) {
+    raft->rng ^= raft->rng << 13;
+    raft->rng ^= raft->rng >> 7;
+    raft->rng ^= raft->rng << 17;
+    return raft->rng;
+}
+
+static void reset_election(nrx_raft_t *raft, uint64_t now_us) {
+    uint64_t t = (uint64_t)raft->config.election_timeout_ms * 1000;
+    raft->election_due_us = now_us + t + random_next(raft) % t;
+}
+
+static void become_follower(nrx_raft_t *raft, uint32_t term, uint64_t now_us) {
+    if (term > raft->term) {
+        raft->term = term;
+        raft->voted_for = 0;
+        raft->leader = 0;
+    }
+    raft->role = NRX_RAFT_FOLLOWER;
+    raft->pre_voting = false;
+    reset_election(raft, now_us);
+}
+
+static void send_message(nrx_raft_t *raft, uint32_t to, nrx_codec_writer_t *w) {
+    size_t len = nrx_codec_end(w);
+    if (len) raft->config.send(to, raft->buf, len, raft->config.send_ctx);
+}
+
+static nrx_codec_writer_t start_message(nrx_raft_t *raft, uint8_t kind) {
+    nrx_codec_writer_t w = nrx_codec_writer(raft->buf, sizeof(raft->buf));
+    nrx_bin_uint(&w, kind, 1);
+    nrx_bin_uint(&w, raft->term, 4);
+    return w;
+}
+
+// Replication
+static void send_append(nrx_raft_t *raft, peer_t *peer, uint64_t now_us) {
+    if (peer->next <= raft->base) {
+        nrx_codec_writer_t w = start_message(raft, MSG_SNAPSHOT);
+        nrx_bin_uint(&w, raft->base, 4);
+        nrx_bin_uint(&w, raft->base_term, 4);
+        nrx_bin_uint(&w, raft->base_value.round, 4);
+        nrx_bin_uint(&w, raft->base_value.proposer_id, 4);
+        nrx_bin_f32(&w, raft->base_value.value);
+        nrx_bin_uint(&w, now_us, 8);
+        send_message(raft, peer->id, &w);
+        if (peer->inflight++ == 0) peer->progress_us = now_us;
+        peer->next = raft->base + 1;
+        return;
+    }
+    
+    uint32_t count = raft->last >= peer->next ? raft->last - peer->next + 1 : 0;
+    if (count > raft->config.max_batch) count = (uint32_t)raft->config.max_batch;
+    uint32_t prev = peer->next - 1;
+    nrx_codec_writer_t w = start_message(raft, MSG_APPEND);
+    nrx_bin_uint(&w, prev, 4);
+    nrx_bin_uint(&w, term_at(raft, prev), 4);
+    nrx_bin_uint(&w, raft->commit, 4);
+    nrx_bin_uint(&w, now_us, 8);
+    nrx_bin_uint(&w, count, 2);
+    for (uint32_t i = 0; i < count; i++) {
+        const entry_t *e = entry_at(raft, peer->next + i);
+        nrx_bin_uint(&w, e->term, 4);
+        nrx_bin_uint(&w, e->proposer, 4);
+        nrx_bin_f32(&w, e->value);
+    }
+    send_message(raft, peer->id, &w);
+    if (count) {
+        if (peer->inflight++ == 0) peer->progress_us = now_us;
+        peer->next += count;
+    }
+}
+
+// Fills the follower's window with what it has not been sent
+static void replicate(nrx_raft_t *raft, peer_t *peer, uint64_t now_us) {
+    while (peer->inflight < raft->config.max_inflight && peer->next <= raft->last) {
+        send_append(raft, peer, now_us);
+    }
+}
+
+// Empty, and from what the follower is known to hold, so it is accepted
+// even while entries are on their way
+static void send_heartbeat(nrx_raft_t *raft, peer_t *peer, uint64_t now_us) {
+    nrx_codec_writer_t w = start_message(raft, MSG_APPEND);
+    nrx_bin_uint(&w, peer->match, 4);
+    nrx_bin_uint(&w, term_at(raft, peer->match), 4);
+    nrx_bin_uint(&w, raft->commit, 4);
+    nrx_bin_uint(&w, now_us, 8);
+    nrx_bin_uint(&w, 0, 2);
+    send_message(raft, peer->id, &w);
+}
+
+// Start again from what the follower is known to hold
+static void rewind(peer_t *peer, uint64_t now_us) {
+    peer->next = peer->match + 1;
+    peer->inflight = 0;
+    peer->rewound_us = now_us;
+    peer->progress_us = now_us;
+}
+
+// Followers hold AppendEntries that arrive out of order, so a window
+// that has gone unacknowledged for a few round trips lost something
+static void check_stall(nrx_raft_t *raft, peer_t *peer, uint64_t now_us) {
+    uint64_t wait = 2000ULL * raft->config.heartbeat_ms;
+    if (peer->srtt_us && 4 * peer->srtt_us < wait) wait = 4 * peer->srtt_us > 1000 ? 4 * peer->srtt_us : 1000;
+    if (peer->inflight && now_us - peer->progress_us >= wait) rewind(peer, now_us);
+}
+
+static void heartbeat(nrx_raft_t *raft, uint64_t now_us) {
+    for (size_t i = 0; i < raft->peer_count; i++) {
+        peer_t *peer = &raft->peers[i];
+        check_stall(raft, peer, now_us);
+        if (peer->inflight < raft->config.max_inflight && peer->next <= raft->last) replicate(raft, peer, now_us);
+        else send_heartbeat(raft, peer, now_us);
+    }
+    raft->heartbeat_due_us = now_us + 1000ULL * raft->config.heartbeat_ms;
+}
+
+typedef enum { BY_MATCH, BY_LEASE, BY_REPLY } peer_field_t;
+
+// The quorum-th largest of a field over the members; this robot counts
+// as self_value
+static uint64_t quorum_value(const nrx_raft_t *raft, uint64_t self_value, peer_field_t field) {
+    uint64_t v[NRX_RAFT_MAX_MEMBERS];
+    size_t n = 0;
+    v[n++] = self_value;
+    for (size_t i = 0; i < raft->peer_count; i++) {
+        const peer_t *peer = &raft->peers[i];
+        v[n++] = field == BY_MATCH ? peer->match : field == BY_LEASE ? peer->lease_from_us : peer->last_reply_us;
+    }
+    for (size_t i = 1; i < n; i++) {
+        uint64_t x = v[i];
+        size_t j = i;
+        for (; j > 0 && v[j - 1] < x; j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    return v[raft->quorum - 1];
+}
+
+// Only entries of the leader's own term are committed by counting copies
+static void advance_commit(nrx_raft_t *raft) {
+    uint32_t index = (uint32_t)quorum_value(raft, raft->last, BY_MATCH);
+    if (index > raft->commit && term_at(raft, index) == raft->term) commit_to(raft, index);
+}
+
+static void become_leader(nrx_raft_t *raft, uint64_t now_us) {
+    // An entry of its own term lets earlier ones commit, and the lease
+    // serves reads only after it has. Proposals leave half the log free,
+    // so there is room unless elections keep failing; then it is safer
+    // to let another robot try than to drop entries that may be committed.
+    entry_t opening = { raft->term, 0, 0.0f };
+    if (!append(raft, &opening)) {
+        become_follower(raft, raft->term, now_us);
+        return;
+    }
+    raft->term_start = raft->last;
+    
+    raft->role = NRX_RAFT_LEADER;
+    raft->pre_voting = false;
+    raft->leader = raft->config.id;
+    for (size_t i = 0; i < raft->peer_count; i++) {
+        peer_t *peer = &raft->peers[i];
+        peer->next = raft->last + 1;
+        peer->match = 0;
+        peer->inflight = 0;
+        peer->last_reply_us = now_us;
+        peer->progress_us = now_us;
+        peer->rewound_us = now_us;
+        peer->lease_from_us = 0;
+    }
+    advance_commit(raft);
+    heartbeat(raft, now_us);
+}
+
+// Elections
+static void request_votes(nrx_raft_t *raft, bool pre) {
+    nrx_codec_writer_t w = nrx_codec_writer(raft->buf, sizeof(raft->buf));
+    nrx_bin_uint(&w, MSG_VOTE, 1);
+    nrx_bin_uint(&w, pre ? raft->term + 1 : raft->term, 4);
+    nrx_bin_uint(&w, pre, 1);
+    nrx_bin_uint(&w, raft->last, 4);
+    nrx_bin_uint(&w, term_at(raft, raft->last), 4);
+    size_t len = nrx_codec_end(&w);
+    for (size_t i = 0; i < raft->peer_count; i++) {
+        raft->config.send(raft->peers[i].id, raft->buf, len, raft->config.send_ctx);
+    }
+}
+
+static bool won(const nrx_raft_t *raft) {
+    size_t votes = 1;
+    for (size_t i = 0; i < raft->peer_count; i++) votes += raft->peers[i].voted;
+    return votes >= raft->quorum;
+}
+
+static void campaign(nrx_raft_t *raft, bool pre, uint64_t now_us) {
+    for (size_t i = 0; i < raft->peer_count; i++) raft->peers[i].voted = false;
+    reset_election(raft, now_us);
+    if (pre) {
+        raft->pre_voting = true;
+    } else {
+        raft->pre_voting = false;
+        raft->role = NRX_RAFT_CANDIDATE;
+        raft->term++;
+        raft->voted_for = raft->config.id;
+        raft->leader = 0;
+    }
+    if (won(raft)) {
+        if (pre) campaign(raft, false, now_us);
+        else become_leader(raft, now_us);
+        return;
+    }
+    request_votes(raft, pre);
+}
+
+static bool heard_from_leader(const nrx_raft_t *raft, uint64_t now_us) {
+    if (raft->role == NRX_RAFT_LEADER) return true;
+    return raft->leader && now_us - raft->leader_contact_us < 1000ULL * raft->config.election_timeout_ms;
+}
+
+static void receive_vote(nrx_raft_t *raft, uint32_t from, uint32_t term, const uint8_t *p, size_t len,
+                         uint64_t now_us) {
+    if (len != 9) return;
+    bool pre = p[0] != 0;
+    uint32_t last = (uint32_t)nrx_bin_read_uint(p + 1, 4), last_term = (uint32_t)nrx_bin_read_uint(p + 5, 4);
+    uint32_t my_last_term = term_at(raft, raft->last);
+    bool up_to_date = last_term > my_last_term || (last_term == my_last_term && last >= raft->last);
+    
+    // While a leader is heard from, nobody else may win; that is what
+    // makes the leader's lease safe
+    bool granted = false;
+    uint32_t reply_term = raft->term;
+    if (heard_from_leader(raft, now_us)) {
+        granted = false;
+    } else if (pre) {
+        granted = term > raft->term && up_to_date;
+        if (granted) reply_term = term;
+    } else {
+        if (term > raft->term) become_follower(raft, term, now_us);
+        granted = term == raft->term && up_to_date && (raft->voted_for == 0 || raft->voted_for == from);
+        if (granted) {
+            raft->voted_for = from;
+            reset_election(raft, now_us);
+        }
+        reply_term = raft->term;
+    }
+    
+    nrx_codec_writer_t w = nrx_codec_writer(raft->buf, sizeof(raft->buf));
+    nrx_bin_uint(&w, MSG_VOTE_REPLY, 1);
+    nrx_bin_uint(&w, reply_term, 4);
+    nrx_bin_uint(&w, pre, 1);
+    nrx_bin_uint(&w, granted, 1);
+    send_message(raft, from, &w);
+}
+
+static peer_t *find_peer(nrx_raft_t *raft, uint32_t id) {
+    for (size_t i = 0; i < raft->peer_count; i++) {
+        if (raft->peers[i].id == id) return &raft->peers[i];
+    }
+    return NULL;
+}
+
+static void receive_vote_reply(nrx_raft_t *raft, peer_t *peer, uint32_t term, const uint8_t *p, size_t len,
+                               uint64_t now_us) {
+    if (len != 2) return;
+    bool pre = p[0] != 0, granted = p[1] != 0;
+    if (pre) {
+        if (!raft->pre_voting || !granted || term != raft->term + 1) return;
+        peer->voted = true;
+        if (won(raft)) campaign(raft, false, now_us);
+        return;
+    }
+    if (term > raft->term) {
+        become_follower(raft, term, now_us);
+        return;
+    }
+    if (raft->role != NRX_RAFT_CANDIDATE || term != raft->term || !granted) return;
+    peer->voted = true;
+    if (won(raft)) become_leader(raft, now_us);
+}
+
+// Following
+static void reply_append(nrx_raft_t *raft, uint32_t to, bool ok, uint32_t match, uint32_t count,
+                         uint64_t sent_us) {
+    nrx_codec_writer_t w = start_message(raft, MSG_APPEND_REPLY);
+    nrx_bin_uint(&w, ok, 1);
+    nrx_bin_uint(&w, match, 4);
+    nrx_bin_uint(&w, count, 2);
+    nrx_bin_uint(&w, sent_us, 8);
+    send_message(raft, to, &w);
+}
+
+// A message from the leader of term, or false (and the sender told our
+// term) when that term is over
+static bool accept_leader(nrx_raft_t *raft, uint32_t from, uint32_t term, uint64_t now_us) {
+    if (term < raft->term) {
+        reply_append(raft, from, false, 0, 0, 0);
+        return false;
+    }
+    if (term != raft->term || from != raft->leader) {
+        for (size_t i = 0; i < raft->config.max_inflight; i++) raft->held[i].len = 0;
+    }
+    become_follower(raft, term, now_us);
+    raft->leader = from;
+    raft->leader_contact_us = now_us;
+    return true;
+}
+
+// Already checked for length; true when it extended the log
+static bool apply_append(nrx_raft_t *raft, uint32_t from, const uint8_t *p, size_t len) {
+    uint32_t prev = (uint32_t)nrx_bin_read_uint(p, 4);
+    uint32_t prev_term = (uint32_t)nrx_bin_read_uint(p + 4, 4);
+    uint32_t leader_commit = (uint32_t)nrx_bin_read_uint(p + 8, 4);
+    uint64_t sent_us = nrx_bin_read_uint(p + 12, 8);
+    uint32_t count = (uint32_t)nrx_bin_read_uint(p + 20, 2);
+    const uint8_t *entries = p + 22;
+    
+    // Entries already folded into the snapshot are committed, so they match
+    if (prev < raft->base) {
+        uint32_t skip = raft->base - prev;
+        if (skip > count) skip = count;
+        prev += skip;
+        count -= skip;
+        entries += (size_t)skip * ENTRY_SIZE;
+        prev_term = term_at(raft, prev);
+    }
+    
+    // Entries that overtook the ones before them wait for those, if there
+    // is room; otherwise the leader hears where to resume
+    if (prev > raft->last) {
+        held_t *free_slot = NULL;
+        for (size_t i = 0; i < raft->config.max_inflight && count; i++) {
+            held_t *h = &raft->held[i];
+            if (h->len && nrx_bin_read_uint(h->body, 4) == nrx_bin_read_uint(p, 4)) return false;
+            if (!h->len && !free_slot) free_slot = h;
+        }
+        if (free_slot) {
+            memcpy(free_slot->body, p, len);
+            free_slot->len = len;
+        } else {
+            reply_append(raft, from, false, raft->last, count, sent_us);
+        }
+        return false;
+    }
+    
+    // A different entry at prev: skip back over the whole term that
+    // disagrees
+    uint32_t have = term_at(raft, prev);
+    if (prev >= raft->base && have != prev_term) {
+        uint32_t hint = prev - 1;
+        while (hint > raft->commit && term_at(raft, hint) == have) hint--;
+        reply_append(raft, from, false, hint, count, sent_us);
+        return false;
+    }
+    
+    uint32_t index = prev;
+    for (uint32_t i = 0; i < count; i++, entries += ENTRY_SIZE) {
+        entry_t e = {
+            .term = (uint32_t)nrx_bin_read_uint(entries, 4),
+            .proposer = (uint32_t)nrx_bin_read_uint(entries + 4, 4),
+            .value = nrx_bin_read_f32(entries + 8),
+        };
+        if (index + 1 <= raft->last) {
+            if (term_at(raft, index + 1) == e.term) {
+                index++;
+                continue;
+            }
+            raft->last = index;     // Uncommitted, from a leader that lost
+        }
+        if (!append(raft, &e)) break;
+        index++;
+    }
+    commit_to(raft, leader_commit < index ? leader_commit : index);
+    reply_append(raft, from, true, index, count, sent_us);
+    return true;
+}
+
+static void receive_append(nrx_raft_t *raft, uint32_t from, uint32_t term, const uint8_t *p, size_t len,
+                           uint64_t now_us) {
+    if (len < 22) return;
+    uint32_t prev = (uint32_t)nrx_bin_read_uint(p, 4);
+    uint32_t count = (uint32_t)nrx_bin_read_uint(p + 20, 2);
+    if (len != 22 + (size_t)count * ENTRY_SIZE || (uint64_t)prev + count > UINT32_MAX) return;
+    if (!accept_leader(raft, from, term, now_us) || !apply_append(raft, from, p, len)) return;
+    
+    // Held entries that now follow on
+    for (bool more = true; more;) {
+        more = false;
+        for (size_t i = 0; i < raft->config.max_inflight; i++) {
+            held_t *h = &raft->held[i];
+            if (!h->len || nrx_bin_read_uint(h->body, 4) > raft->last) continue;
+            apply_append(raft, from, h->body, h->len);
+            h->len = 0;
+            more = true;
+        }
+    }
+}
+
+static void receive_snapshot(nrx_raft_t *raft, uint32_t from, uint32_t term, const uint8_t *p, size_t len,
+                             uint64_t now_us) {
+    if (len != 28 || !accept_leader(raft, from, term, now_us)) return;
+    uint32_t index = (uint32_t)nrx_bin_read_uint(p, 4);
+    if (index > raft->commit) {
+        raft->base = raft->last = raft->commit = index;
+        raft->base_term = (uint32_t)nrx_bin_read_uint(p + 4, 4);
+        raft->base_value = (nrx_consensus_value_t){
+            .round = (uint32_t)nrx_bin_read_uint(p + 8, 4),
+            .proposer_id = (uint32_t)nrx_bin_read_uint(p + 12, 4),
+            .value = nrx_bin_read_f32(p + 16),
+        };
+        raft->value = raft->base_value;
+    }
+    reply_append(raft, from, true, index, 1, nrx_bin_read_uint(p + 20, 8));
+}
+
+// Leading
+static void receive_append_reply(nrx_raft_t *raft, peer_t *peer, uint32_t term, const uint8_t *p, size_t len,
+                                 uint64_t now_us) {
+    if (len != 15) return;
+    if (term > raft->term) {
+        become_follower(raft, term, now_us);
+        return;
+    }
+    if (raft->role != NRX_RAFT_LEADER || term != raft->term) return;
+    bool ok = p[0] != 0;
+    uint32_t match = (uint32_t)nrx_bin_read_uint(p + 1, 4);
+    uint32_t count = (uint32_t)nrx_bin_read_uint(p + 5, 2);
+    uint64_t sent_us = nrx_bin_read_uint(p + 7, 8);
+    
+    // Any answer in this term means the follower took this robot as
+    // leader when the message was sent
+    peer->last_reply_us = now_us;
+    if (sent_us > peer->lease_from_us) peer->lease_from_us = sent_us;
+    if (sent_us && sent_us <= now_us) {
+        uint64_t rtt = now_us - sent_us;
+        peer->srtt_us = peer->srtt_us ? peer->srtt_us - peer->srtt_us / 8 + rtt / 8 : rtt;
+    }
+    if (match > raft->last) return;
+    
+    bool stale = sent_us < peer->rewound_us;
+    if (ok) {
+        if (count && peer->inflight && !stale) {
+            peer->inflight--;
+            peer->progress_us = now_us;
+        }
+        if (match > peer->match) {
+            peer->match = match;
+            if (peer->next <= match) peer->next = match + 1;
+            advance_commit(raft);
+        }
+    } else if (!stale) {
+        uint32_t next = (match > peer->match ? match : peer->match) + 1;
+        rewind(peer, now_us);
+        if (next > peer->next) peer->next = next;
+    }
+    replicate(raft, peer, now_us);
+}
+
+static void receive_propose(nrx_raft_t *raft, const uint8_t *p, size_t len) {
+    if (len != 8 || raft->role != NRX_RAFT_LEADER) return;
+    nrx_raft_propose(raft, nrx_bin_read_f32(p + 4), (uint32_t)nrx_bin_read_uint(p, 4));
+}
+
+// Public interface
+nrx_raft_t *nrx_raft_create(const nrx_raft_config_t *config, uint64_t now_us) {
+    if (!config || config->id == 0 || !config->send || !config->members || config->member_count == 0 ||
+        config->member_count > NRX_RAFT_MAX_MEMBERS) {
+        return NULL;
+    }
+    
+    nrx_raft_t *raft = calloc(1, sizeof(nrx_raft_t));
+    if (!raft) return NULL;
+    raft->config = *config;
+    nrx_raft_config_t *c = &raft->config;
+    if (c->election_timeout_ms == 0) c->election_timeout_ms = DEFAULT_ELECTION_TIMEOUT_MS;
+    if (c->heartbeat_ms == 0) c->heartbeat_ms = c->election_timeout_ms / 3 ? c->election_timeout_ms / 3 : 1;
+    if (c->log_capacity == 0) c->log_capacity = DEFAULT_LOG_CAPACITY;
+    if (c->max_batch == 0) c->max_batch = DEFAULT_MAX_BATCH;
+    if (c->max_batch > NRX_RAFT_MAX_BATCH) c->max_batch = NRX_RAFT_MAX_BATCH;
+    if (c->max_inflight == 0) c->max_inflight = DEFAULT_MAX_INFLIGHT;
+    c->members = NULL;
+    
+    bool member = false;
+    for (size_t i = 0; i < config->member_count; i++) {
+        uint32_t id = config->members[i];
+        if (id == config->id) member = true;
+        else if (id != 0 && !find_peer(raft, id)) raft->peers[raft->peer_count++].id = id;
+    }
+    raft->log = malloc(c->log_capacity * sizeof(entry_t));
+    raft->held = calloc(c->max_inflight, sizeof(held_t));
+    if (!member || !raft->log || !raft->held) {
+        nrx_raft_destroy(raft);
+        return NULL;
+    }
+    raft->quorum = (raft->peer_count + 1) / 2 + 1;
+    raft->lease_us = 900ULL * c->election_timeout_ms;
+    raft->rng = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)config->id * 0xD1B54A32D192ED03ULL);
+    reset_election(raft, now_us);
+    return raft;
+}
+
+void nrx_raft_destroy(nrx_raft_t *raft) {
+    if (!raft) return;
+    free(raft->log);
+    free(raft->held);
+    free(raft);
+}
+
+void nrx_raft_tick(nrx_raft_t *raft, uint64_t now_us) {
+    if (!raft) return;
+    if (raft->role == NRX_RAFT_LEADER) {
+        // Cut off from a majority, it cannot commit; let the rest elect
+        uint64_t quiet = 2000ULL * raft->config.election_timeout_ms;
+        if (raft->peer_count && now_us - quorum_value(raft, now_us, BY_REPLY) >= quiet) {
+            become_follower(raft, raft->term, now_us);
+            raft->leader = 0;
+            return;
+        }
+        if (now_us >= raft->heartbeat_due_us) {
+            heartbeat(raft, now_us);
+            return;
+        }
+        for (size_t i = 0; i < raft->peer_count; i++) {
+            check_stall(raft, &raft->peers[i], now_us);
+            replicate(raft, &raft->peers[i], now_us);
+        }
+    } else if (now_us >= raft->election_due_us) {
+        campaign(raft, true, now_us);
+    }
+}
+
+void nrx_raft_receive(nrx_raft_t *raft, uint32_t from, const uint8_t *payload, size_t len,
+                      uint64_t now_us) {
+    if (!raft || !payload || len < HEADER_SIZE) return;
+    peer_t *peer = find_peer(raft, from);
+    if (!peer) return;
+    uint32_t term = (uint32_t)nrx_bin_read_uint(payload + 1, 4);
+    const uint8_t *p = payload + HEADER_SIZE;
+    len -= HEADER_SIZE;
+    
+    switch (payload[0]) {
+        case MSG_VOTE: receive_vote(raft, from, term, p, len, now_us); break;
+        case MSG_VOTE_REPLY: receive_vote_reply(raft, peer, term, p, len, now_us); break;
+        case MSG_APPEND: receive_append(raft, from, term, p, len, now_us); break;
+        case MSG_APPEND_REPLY: receive_append_reply(raft, peer, term, p, len, now_us); break;
+        case MSG_SNAPSHOT: receive_snapshot(raft, from, term, p, len, now_us); break;
+        case MSG_PROPOSE: receive_propose(raft, p, len); break;
+        default: break;
+    }
+}
+
+int nrx_raft_propose(nrx_raft_t *raft, float value, uint32_t proposer) {
+    if (!raft || proposer == 0) return -1;
+    if (raft->role == NRX_RAFT_LEADER) {
+        entry_t e = { raft->term, proposer, value };
+        if (raft->last - raft->commit >= raft->config.log_capacity / 2 || !append(raft, &e)) return -1;
+        advance_commit(raft);       // Alone, it needs nobody
+        return 0;
+    }
+    if (raft->leader == 0) return -1;
+    
+    nrx_codec_writer_t w = start_message(raft, MSG_PROPOSE);
+    nrx_bin_uint(&w, proposer, 4);
+    nrx_bin_f32(&w, value);
+    send_message(raft, raft->leader, &w);
+    return 0;
+}
+
+int nrx_raft_read(const nrx_raft_t *raft, uint64_t now_us, nrx_consensus_value_t *value) {
+    if (!raft || !value || raft->value.round == 0) return -1;
+    *value = raft->value;
+    if (raft->role != NRX_RAFT_LEADER || raft->commit < raft->term_start) return 0;
+    return now_us < quorum_value(raft, now_us, BY_LEASE) + raft->lease_us ? 1 : 0;
+}
+
+nrx_raft_role_t nrx_raft_role(const nrx_raft_t *raft) {
+    return raft ? raft->role : NRX_RAFT_FOLLOWER;
+}
+
+uint32_t nrx_raft_leader(const nrx_raft_t *raft) {
+    return raft ? raft->leader : 0;
+}
+
+uint32_t nrx_raft_term(const nrx_raft_t *raft) {
+    return raft ? raft->term : 0;
+}
+
+uint32_t nrx_raft_commit_index(const nrx_raft_t *raft) {
+    return raft ? raft->commit : 0;
+}
+
+uint32_t nrx_raft_last_index(const nrx_raft_t *raft) {
+    return raft ? raft->last : 0;
+}
@@ -0,0 +1,89 @@
+#ifndef NEUROX_RAFT_H
+#define NEUROX_RAFT_H
+
+#include "swarm.h"
+
+// Raft consensus
+// A fixed group of robots agrees on a log of values. One robot leads: it
+// appends the values proposed to it and replicates them to the others;
+// an entry is committed once a majority holds it, and the agreed value is
+// the last committed one. Followers that stop hearing from the leader
+// for an election timeout start an election, after a pre-vote that
+// checks they could win, so a robot cut off on its own cannot push up
+// the term and unseat a working leader when it comes back.
+//
+// Replication is batched and pipelined: each AppendEntries carries up to
+// max_batch entries, and up to max_inflight of them go to a follower
+// before the first is answered. A follower holds back one that overtook
+// its predecessor until that arrives. When one is lost, the rest go
+// unanswered; after a few round trips the leader resends from what the
+// follower last held. The log
+// is a ring of log_capacity entries; committed entries make room for new
+// ones, and a follower too far behind gets the committed value as a
+// snapshot instead.
+//
+// Reads on the leader use a lease. Followers ignore elections while they
+// are hearing from a leader, so for an election timeout after a majority
+// acknowledged an AppendEntries nobody else can become leader, and the
+// leader's committed value is the latest without a round trip. The lease
+// is shortened by a tenth for clock drift.
+//
+// Nothing is written to storage: a robot that restarts comes back with
+// an empty log and may vote again in a term it has voted in.
+//
+// The module only moves bytes and reads no clock: messages go out
+// through the send callback, arrive through nrx_raft_receive(), and time
+// passes as the now_us arguments.
+#define NRX_RAFT_MAX_MEMBERS 16
+#define NRX_RAFT_MAX_BATCH 64
+#define NRX_RAFT_MAX_PAYLOAD (27 + 12 * NRX_RAFT_MAX_BATCH)
+
+typedef struct nrx_raft_t nrx_raft_t;
+
+typedef enum {
+    NRX_RAFT_FOLLOWER,
+    NRX_RAFT_CANDIDATE,
+    NRX_RAFT_LEADER,
+} nrx_raft_role_t;
+
+typedef void (*nrx_raft_send_t)(uint32_t to, const uint8_t *payload, size_t len, void *ctx);
+
+typedef struct {
+    uint32_t id;
+    const uint32_t *members;        // Voting members, this one included
+    size_t member_count;
+    uint32_t election_timeout_ms;   // Each wait is drawn from [t, 2t) (default 150)
+    uint32_t heartbeat_ms;          // Leader's idle AppendEntries (default t / 3)
+    size_t log_capacity;            // Entries kept (default 1024)
+    size_t max_batch;               // Entries per AppendEntries (default 32)
+    size_t max_inflight;            // Unanswered AppendEntries per follower (default 4)
+    nrx_raft_send_t send;
+    void *send_ctx;
+} nrx_raft_config_t;
+
+nrx_raft_t *nrx_raft_create(const nrx_raft_config_t *config, uint64_t now_us);
+void nrx_raft_destroy(nrx_raft_t *raft);
+
+// Timers: elections, heartbeats, and sending entries proposed since the
+// last tick in batches. Call it at least every few milliseconds.
+void nrx_raft_tick(nrx_raft_t *raft, uint64_t now_us);
+void nrx_raft_receive(nrx_raft_t *raft, uint32_t from, const uint8_t *payload, size_t len,
+                      uint64_t now_us);
+
+// The leader appends the value; a follower forwards it to the leader it
+// knows, and it is lost if that message is. -1 with no leader known or
+// half the log uncommitted.
+int nrx_raft_propose(nrx_raft_t *raft, float value, uint32_t proposer);
+
+// The last committed value, with its log index as the round. 1 on the
+// leader while its lease holds, so nothing newer can have been committed;
+// 0 when it may be behind; -1 when nothing has been committed yet.
+int nrx_raft_read(const nrx_raft_t *raft, uint64_t now_us, nrx_consensus_value_t *value);
+
+nrx_raft_role_t nrx_raft_role(const nrx_raft_t *raft);
+uint32_t nrx_raft_leader(const nrx_raft_t *raft);      // 0 when none is known
+uint32_t nrx_raft_term(const nrx_raft_t *raft);
+uint32_t nrx_raft_commit_index(const nrx_raft_t *raft);
+uint32_t nrx_raft_last_index(const nrx_raft_t *raft);
+
+#endif // NEUROX_RAFT_H
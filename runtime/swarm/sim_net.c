@@ -0,0 +1,215 @@
+#include "sim_net.h"
+#include "scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_LATENCY_US 1000
+#define DEFAULT_CAPACITY 4096
+
+typedef struct {
+    uint64_t due_us;
+    uint64_t seq;               // Keeps equal due times in sending order
+    nrx_swarm_msg_type_t type;
+    uint32_t sender_id;
+    uint32_t target_id;
+    uint64_t timestamp_us;
+    size_t len;
+    uint8_t payload[NRX_SIM_NET_MAX_PAYLOAD];
+} packet_t;
+
+typedef struct {
+    uint32_t id;
+    nrx_swarm_t *swarm;
+    uint32_t group;
+} node_t;
+
+struct nrx_sim_net_t {
+    nrx_sim_net_config_t config;
+    node_t nodes[NRX_SIM_NET_MAX_ROBOTS];
+    size_t node_count;
+    
+    // Packets in flight: a min-heap by due time over a pool
+    packet_t *packets;
+    uint32_t *free_list;
+    size_t free_count;
+    uint32_t *heap;
+    size_t heap_len;
+    uint64_t seq;
+    
+    uint64_t rng;
+    nrx_sim_net_stats_t stats;
+};
+
+nrx_sim_net_t *nrx_sim_net_create(const nrx_sim_net_config_t *config) {
+    nrx_sim_net_t *net = calloc(1, sizeof(nrx_sim_net_t));
+    if (!net) return NULL;
+    if (config) net->config = *config;
+    if (net->config.latency_us == 0) net->config.latency_us = DEFAULT_LATENCY_US;
+    if (net->config.capacity == 0) net->config.capacity = DEFAULT_CAPACITY;
+    
+    size_t n = net->config.capacity;
+    net->packets = malloc(n * sizeof(packet_t));
+    net->free_list = malloc(n * sizeof(uint32_t));
+    net->heap = malloc(n * sizeof(uint32_t));
+    if (!net->packets || !net->free_list || !net->heap) {
+        nrx_sim_net_destroy(net);
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) net->free_list[i] = (uint32_t)(n - 1 - i);
+    net->free_count = n;
+    net->rng = net->config.seed * 0x9E3779B97F4A7C15ULL + 1;
+    return net;
+}
+
+void nrx_sim_net_destroy(nrx_sim_net_t *net) {
+    if (!net) return;
+    free(net->packets);
+    free(net->free_list);
+    free(net->heap);
+    free(net);
+}
+
+static uint64_t random_next(nrx_sim_net_t *net) {
+    net->rng ^= net->rng << 13;
+    net->rng ^= net->rng >> 7;
+    net->rng ^= net->rng << 17;
+    return net->rng;
+}
+
+static float random_unit(nrx_sim_net_t *net) {
+    return (float)(random_next(net) >> 40) / (float)(1 << 24);
+}
+
+static node_t *find_node(nrx_sim_net_t *net, uint32_t id) {
+    for (size_t i = 0; i < net->node_count; i++) {
+        if (net->nodes[i].id == id) return &net->nodes[i];
+    }
+    return NULL;
+}
+
+// Heap
+static bool earlier(const nrx_sim_net_t *net, uint32_t a, uint32_t b) {
+    const packet_t *pa = &net->packets[a], *pb = &net->packets[b];
+    return pa->due_us < pb->due_us || (pa->due_us == pb->due_us && pa->seq < pb->seq);
+}
+
+static void push(nrx_sim_net_t *net, uint32_t slot) {
+    size_t i = net->heap_len++;
+    while (i > 0 && earlier(net, slot, net->heap[(i - 1) / 2])) {
+        net->heap[i] = net->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    net->heap[i] = slot;
+}
+
+static uint32_t pop(nrx_sim_net_t *net) {
+    uint32_t top = net->heap[0], last = net->heap[--net->heap_len];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= net->heap_len) break;
+        if (child + 1 < net->heap_len && earlier(net, net->heap[child + 1], net->heap[child])) child++;
+        if (!earlier(net, net->heap[child], last)) break;
+        net->heap[i] = net->heap[child];
+        i = child;
+    }
+    net->heap[i] = last;
+    return top;
+}
+
+// Sending
+int nrx_sim_net_transport(const nrx_swarm_message_t *msg, void *ctx) {
+    nrx_sim_net_t *net = ctx;
+    if (!net || !msg || msg->payload_len > NRX_SIM_NET_MAX_PAYLOAD) return -1;
+    net->stats.sent++;
+    if (net->free_count == 0) {
+        net->stats.dropped++;
+        return 0;
+    }
+    
+    uint32_t slot = net->free_list[--net->free_count];
+    packet_t *p = &net->packets[slot];
+    uint64_t jitter = net->config.jitter_us ? random_next(net) % (net->config.jitter_us + 1ULL) : 0;
+    p->due_us = nrx_time_now_us() + net->config.latency_us + jitter;
+    p->seq = net->seq++;
+    p->type = msg->type;
+    p->sender_id = msg->sender_id;
+    p->target_id = msg->target_id;
+    p->timestamp_us = msg->timestamp_us;
+    p->len = msg->payload_len;
+    if (msg->payload_len) memcpy(p->payload, msg->payload, msg->payload_len);
+    push(net, slot);
+    return 0;
+}
+
+static void deliver(nrx_sim_net_t *net, const packet_t *p) {
+    const node_t *sender = find_node(net, p->sender_id);
+    nrx_swarm_message_t msg = {
+        .type = p->type,
+        .sender_id = p->sender_id,
+        .target_id = p->target_id,
+        .payload = (uint8_t *)p->payload,
+        .payload_len = p->len,
+        .timestamp_us = p->timestamp_us,
+    };
+    for (size_t i = 0; i < net->node_count; i++) {
+        const node_t *node = &net->nodes[i];
+        if (node->id == p->sender_id || (p->target_id && node->id != p->target_id)) continue;
+        if (!sender || node->group != sender->group || random_unit(net) < net->config.loss) {
+            net->stats.dropped++;
+            continue;
+        }
+        net->stats.delivered++;
+        nrx_swarm_receive(node->swarm, &msg);
+    }
+}
+
+// Robots
+int nrx_sim_net_attach(nrx_sim_net_t *net, uint32_t robot_id, nrx_swarm_t *swarm) {
+    if (!net || !swarm || robot_id == 0 || find_node(net, robot_id)) return -1;
+    if (net->node_count == NRX_SIM_NET_MAX_ROBOTS) return -1;
+    net->nodes[net->node_count++] = (node_t){ robot_id, swarm, 0 };
+    return 0;
+}
+
+void nrx_sim_net_detach(nrx_sim_net_t *net, uint32_t robot_id) {
+    node_t *node = net ? find_node(net, robot_id) : NULL;
+    if (!node) return;
+    *node = net->nodes[--net->node_count];
+}
+
+void nrx_sim_net_set_group(nrx_sim_net_t *net, uint32_t robot_id, uint32_t group) {
+    node_t *node = net ? find_node(net, robot_id) : NULL;
+    if (node) node->group = group;
+}
+
+void nrx_sim_net_heal(nrx_sim_net_t *net) {
+    if (!net) return;
+    for (size_t i = 0; i < net->node_count; i++) net->nodes[i].group = 0;
+}
+
+void nrx_sim_net_run(nrx_sim_net_t *net, uint64_t duration_us, uint32_t step_us) {
+    if (!net) return;
+    if (!nrx_time_is_virtual()) nrx_time_set_virtual(true, nrx_time_now_us());
+    if (step_us == 0) step_us = 1000;
+    
+    uint64_t end = nrx_time_now_us() + duration_us;
+    for (uint64_t now = nrx_time_now_us(); now < end; now = nrx_time_now_us()) {
+        nrx_time_advance_us(end - now < step_us ? end - now : step_us);
+        now = nrx_time_now_us();
+        
+        // What was sent while delivering goes out no sooner than the
+        // latency, so this ends
+        while (net->heap_len && net->packets[net->heap[0]].due_us <= now) {
+            uint32_t slot = pop(net);
+            deliver(net, &net->packets[slot]);
+            net->free_list[net->free_count++] = slot;
+        }
+        for (size_t i = 0; i < net->node_count; i++) nrx_swarm_loop(net->nodes[i].swarm);
+    }
+}
+
+void nrx_sim_net_get_stats(const nrx_sim_net_t *net, nrx_sim_net_stats_t *stats) {
+    if (!net || !stats) return;
+    *stats = net->stats;
+}
@@ -0,0 +1,51 @@
+#ifndef NEUROX_SIM_NET_H
+#define NEUROX_SIM_NET_H
+
+#include "swarm.h"
+
+// Simulated network
+// Carries swarm messages between robots in one process on the virtual
+// clock. Each message arrives after the latency plus a uniform jitter, so
+// later messages can overtake earlier ones. Each receiver may drop it at
+// random, and it never crosses between partition groups. Robots name
+// nrx_sim_net_transport in their config, with the network as its
+// context, and are then attached. nrx_sim_net_run() moves virtual time on
+// in steps, delivering what is due and running every attached robot's
+// nrx_swarm_loop().
+#define NRX_SIM_NET_MAX_ROBOTS 64
+#define NRX_SIM_NET_MAX_PAYLOAD 1024
+
+typedef struct {
+    uint32_t latency_us;        // Default 1000
+    uint32_t jitter_us;         // Added, from 0 up to this
+    float loss;                 // Fraction lost, per receiver
+    uint64_t seed;
+    size_t capacity;            // Messages in flight (default 4096)
+} nrx_sim_net_config_t;
+
+typedef struct {
+    size_t sent;
+    size_t delivered;           // Per receiver
+    size_t dropped;             // Lost, partitioned, or the network full
+} nrx_sim_net_stats_t;
+
+typedef struct nrx_sim_net_t nrx_sim_net_t;
+
+nrx_sim_net_t *nrx_sim_net_create(const nrx_sim_net_config_t *config);
+void nrx_sim_net_destroy(nrx_sim_net_t *net);
+
+int nrx_sim_net_transport(const nrx_swarm_message_t *msg, void *ctx);
+int nrx_sim_net_attach(nrx_sim_net_t *net, uint32_t robot_id, nrx_swarm_t *swarm);
+
+// The robot stops: nothing reaches it and its loop no longer runs
+void nrx_sim_net_detach(nrx_sim_net_t *net, uint32_t robot_id);
+
+// Robots hear only their own group; all start in group 0
+void nrx_sim_net_set_group(nrx_sim_net_t *net, uint32_t robot_id, uint32_t group);
+void nrx_sim_net_heal(nrx_sim_net_t *net);
+
+// Turns on virtual time if it is not already
+void nrx_sim_net_run(nrx_sim_net_t *net, uint64_t duration_us, uint32_t step_us);
+void nrx_sim_net_get_stats(const nrx_sim_net_t *net, nrx_sim_net_stats_t *stats);
+
+#endif // NEUROX_SIM_NET_H
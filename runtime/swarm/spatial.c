@@ -0,0 +1,143 @@
+#include "spatial.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define NONE UINT32_MAX
+#define CELL_LIMIT 1000000000.0f    // Cell coordinates are clamped to this
+
+typedef struct {
+    float x, y;
+    int32_t cx, cy;
+    uint32_t next;
+    uint32_t prev;              // NONE at the head of a bucket
+    bool present;
+} item_t;
+
+struct nrx_spatial_grid_t {
+    item_t *items;
+    size_t capacity;
+    uint32_t *buckets;          // Head item per bucket
+    size_t bucket_mask;
+    float inv_cell;
+};
+
+static int32_t cell_of(float v, float inv_cell) {
+    float c = floorf(v * inv_cell);
+    if (!(c > -CELL_LIMIT)) c = -CELL_LIMIT;    // Also NaN
+    if (c > CELL_LIMIT) c = CELL_LIMIT;
+    return (int32_t)c;
+}
+
+static size_t bucket_of(const nrx_spatial_grid_t *grid, int32_t cx, int32_t cy) {
+    uint32_t h = (uint32_t)cx * 0x9E3779B1u ^ (uint32_t)cy * 0x85EBCA77u;
+    h ^= h >> 15;
+    return h & grid->bucket_mask;
+}
+
+nrx_spatial_grid_t *nrx_spatial_create(size_t capacity, float cell_size) {
+    if (capacity == 0 || capacity >= NONE || !(cell_size > 0.0f)) return NULL;
+    
+    // About two buckets per item keeps the chains short
+    size_t buckets = 16;
+    while (buckets < 2 * capacity) buckets *= 2;
+    
+    nrx_spatial_grid_t *grid = calloc(1, sizeof(nrx_spatial_grid_t));
+    if (!grid) return NULL;
+    grid->items = calloc(capacity, sizeof(item_t));
+    grid->buckets = malloc(buckets * sizeof(uint32_t));
+    if (!grid->items || !grid->buckets) {
+        nrx_spatial_destroy(grid);
+        return NULL;
+    }
+    for (size_t i = 0; i < buckets; i++) grid->buckets[i] = NONE;
+    grid->capacity = capacity;
+    grid->bucket_mask = buckets - 1;
+    grid->inv_cell = 1.0f / cell_size;
+    return grid;
+}
+
+void nrx_spatial_destroy(nrx_spatial_grid_t *grid) {
+    if (!grid) return;
+    free(grid->items);
+    free(grid->buckets);
+    free(grid);
+}
+
+static void unlink_item(nrx_spatial_grid_t *grid, uint32_t index) {
+    item_t *item = &grid->items[index];
+    if (item->prev == NONE) grid->buckets[bucket_of(grid, item->cx, item->cy)] = item->next;
+    else grid->items[item->prev].next = item->next;
+    if (item->next != NONE) grid->items[item->next].prev = item->prev;
+}
+
+static void link_item(nrx_spatial_grid_t *grid, uint32_t index) {
+    item_t *item = &grid->items[index];
+    uint32_t *head = &grid->buckets[bucket_of(grid, item->cx, item->cy)];
+    item->prev = NONE;
+    item->next = *head;
+    if (*head != NONE) grid->items[*head].prev = index;
+    *head = index;
+}
+
+void nrx_spatial_update(nrx_spatial_grid_t *grid, uint32_t index, float x, float y) {
+    if (!grid || index >= grid->capacity) return;
+    
+    item_t *item = &grid->items[index];
+    int32_t cx = cell_of(x, grid->inv_cell);
+    int32_t cy = cell_of(y, grid->inv_cell);
+    item->x = x;
+    item->y = y;
+    if (item->present && item->cx == cx && item->cy == cy) return;
+    
+    if (item->present) unlink_item(grid, index);
+    item->cx = cx;
+    item->cy = cy;
+    item->present = true;
+    link_item(grid, index);
+}
+
+void nrx_spatial_remove(nrx_spatial_grid_t *grid, uint32_t index) {
+    if (!grid || index >= grid->capacity || !grid->items[index].present) return;
+    unlink_item(grid, index);
+    grid->items[index].present = false;
+}
+
+bool nrx_spatial_contains(const nrx_spatial_grid_t *grid, uint32_t index) {
+    return grid && index < grid->capacity && grid->items[index].present;
+}
+
+void nrx_spatial_query(const nrx_spatial_grid_t *grid, float x, float y, float radius,
+                       nrx_spatial_cb_t callback, void *ctx) {
+    if (!grid || !callback || !(radius >= 0.0f)) return;
+    
+    float r2 = radius * radius;
+    int32_t cx0 = cell_of(x - radius, grid->inv_cell), cx1 = cell_of(x + radius, grid->inv_cell);
+    int32_t cy0 = cell_of(y - radius, grid->inv_cell), cy1 = cell_of(y + radius, grid->inv_cell);
+    
+    // A circle wider than the table walks every bucket once instead
+    double cells = ((double)cx1 - cx0 + 1) * ((double)cy1 - cy0 + 1);
+    if (cells > (double)(grid->bucket_mask + 1)) {
+        for (size_t b = 0; b <= grid->bucket_mask; b++) {
+            for (uint32_t i = grid->buckets[b]; i != NONE; i = grid->items[i].next) {
+                const item_t *item = &grid->items[i];
+                float dx = item->x - x, dy = item->y - y;
+                float d2 = dx * dx + dy * dy;
+                if (d2 <= r2) callback(i, item->x, item->y, d2, ctx);
+            }
+        }
+        return;
+    }
+    
+    // Cells sharing a bucket are told apart by their coordinates
+    for (int32_t cy = cy0; cy <= cy1; cy++) {
+        for (int32_t cx = cx0; cx <= cx1; cx++) {
+            for (uint32_t i = grid->buckets[bucket_of(grid, cx, cy)]; i != NONE; i = grid->items[i].next) {
+                const item_t *item = &grid->items[i];
+                if (item->cx != cx || item->cy != cy) continue;
+                float dx = item->x - x, dy = item->y - y;
+                float d2 = dx * dx + dy * dy;
+                if (d2 <= r2) callback(i, item->x, item->y, d2, ctx);
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef NEUROX_SPATIAL_H
+#define NEUROX_SPATIAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Spatial grid
+// A uniform grid over the plane for radius queries, kept up to date one
+// item at a time. Items are numbered 0..capacity-1 by the caller. Cells are
+// hashed into a fixed table, so the world needs no bounds and only occupied
+// cells cost anything. Each item sits on an intrusive list in its cell's
+// bucket: moving within a cell only stores the new position, and moving to
+// another cell is an unlink and a link. A query visits the cells that
+// overlap the circle, so it costs the items nearby rather than all of them.
+// Pick a cell size near the usual query radius.
+typedef struct nrx_spatial_grid_t nrx_spatial_grid_t;
+
+typedef void (*nrx_spatial_cb_t)(uint32_t item, float x, float y, float dist_sq, void *ctx);
+
+nrx_spatial_grid_t *nrx_spatial_create(size_t capacity, float cell_size);
+void nrx_spatial_destroy(nrx_spatial_grid_t *grid);
+
+// Inserts the item, or moves it if it is already in
+void nrx_spatial_update(nrx_spatial_grid_t *grid, uint32_t item, float x, float y);
+void nrx_spatial_remove(nrx_spatial_grid_t *grid, uint32_t item);
+bool nrx_spatial_contains(const nrx_spatial_grid_t *grid, uint32_t item);
+
+// Every item within radius of (x, y), in no particular order
+void nrx_spatial_query(const nrx_spatial_grid_t *grid, float x, float y, float radius,
+                       nrx_spatial_cb_t callback, void *ctx);
+
+#endif // NEUROX_SPATIAL_H
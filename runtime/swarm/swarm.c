@@ -0,0 +1,857 @@
+#include "swarm.h"
+#include "spatial.h"
+#include "pose_codec.h"
+#include "assign.h"
+#include "coverage.h"
+#include "raft.h"
+#include "codec.h"
+#include "scheduler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MAX_ROBOTS 256
+#define DEFAULT_MAX_TASKS 256
+#define DEFAULT_CELL_SIZE 5.0f
+#define DEFAULT_POSE_RESOLUTION 0.01f
+#define DEFAULT_POSE_THRESHOLD 0.05f
+#define DEFAULT_HEADING_THRESHOLD 0.05f
+#define DEFAULT_KEYFRAME_INTERVAL_MS 1000
+#define NONE UINT32_MAX
+
+#define TASK_PENDING 0
+#define TASK_ASSIGNED 1
+#define TASK_STARTED 2
+#define TASK_PAYLOAD_SIZE 21
+#define EXACT_LIMIT 100         // Robots or tasks up to which assignment is optimal
+#define KEEP_BONUS 0.5f         // Meters a new assignment must save
+
+typedef struct {
+    nrx_robot_pose_t pose;
+    nrx_pose_rate_t rate;       // Sent with the pose, or from the last two
+    nrx_pose_keyframe_t key;    // Last keyframe received from it
+    uint64_t last_seen_us;
+    bool used;
+    bool has_pose;
+} robot_t;
+
+struct nrx_swarm_t {
+    nrx_swarm_config_t config;
+    
+    // Robots by slot; the index maps ids to slot + 1 (0 is empty) with
+    // linear probing
+    robot_t *robots;
+    size_t capacity;
+    size_t count;
+    uint32_t *free_slots;
+    size_t free_count;
+    uint32_t *index;
+    size_t index_mask;
+    uint32_t self;
+    
+    nrx_spatial_grid_t *grid;
+    uint64_t horizon_us;        // Dead reckoning stops this far past a pose
+    
+    // What receivers last got from this robot, to predict as they do
+    uint32_t resolution_um;
+    nrx_pose_keyframe_t sent_key;
+    nrx_robot_pose_t sent;
+    nrx_pose_rate_t sent_rate;
+    
+    // Tasks; the solver and its buffers are allocated on first use, since
+    // usually only one robot assigns
+    nrx_swarm_task_t *tasks;
+    size_t task_count;
+    bool tasks_changed;
+    nrx_assign_t *solver;
+    float *costs;
+    int32_t *row_to_col;
+    uint32_t *row_slot;
+    uint32_t *col_task;
+    uint32_t *task_robot;
+    int32_t *slot_task;
+    
+    nrx_coverage_grid_t *coverage;
+    nrx_raft_t *raft;
+    
+    nrx_swarm_msg_cb_t callback;
+    void *user_data;
+    uint64_t last_sent_us;
+    nrx_swarm_stats_t stats;
+};
+
+// Robot table
+static size_t id_hash(const nrx_swarm_t *swarm, uint32_t id) {
+    return (id * 2654435761u) & swarm->index_mask;
+}
+
+static uint32_t find_slot(const nrx_swarm_t *swarm, uint32_t id) {
+    for (size_t i = id_hash(swarm, id);; i = (i + 1) & swarm->index_mask) {
+        uint32_t entry = swarm->index[i];
+        if (entry == 0) return NONE;
+        if (swarm->robots[entry - 1].pose.id == id) return entry - 1;
+    }
+}
+
+static uint32_t add_robot(nrx_swarm_t *swarm, uint32_t id) {
+    if (swarm->free_count == 0) return NONE;
+    uint32_t slot = swarm->free_slots[--swarm->free_count];
+    swarm->robots[slot] = (robot_t){ .pose.id = id, .used = true };
+    
+    size_t i = id_hash(swarm, id);
+    while (swarm->index[i]) i = (i + 1) & swarm->index_mask;
+    swarm->index[i] = slot + 1;
+    swarm->count++;
+    swarm->tasks_changed = true;
+    return slot;
+}
+
+// Backward-shift deletion keeps every probe run unbroken
+static void remove_robot(nrx_swarm_t *swarm, uint32_t slot) {
+    size_t mask = swarm->index_mask;
+    size_t i = id_hash(swarm, swarm->robots[slot].pose.id);
+    while (swarm->index[i] != slot + 1) i = (i + 1) & mask;
+    
+    swarm->index[i] = 0;
+    for (size_t j = (i + 1) & mask; swarm->index[j]; j = (j + 1) & mask) {
+        // An entry whose home lies between the hole and itself stays put
+        size_t home = id_hash(swarm, swarm->robots[swarm->index[j] - 1].pose.id);
+        if (i <= j ? (home > i && home <= j) : (home > i || home <= j)) continue;
+        swarm->index[i] = swarm->index[j];
+        swarm->index[j] = 0;
+        i = j;
+    }
+    
+    nrx_spatial_remove(swarm->grid, slot);
+    swarm->robots[slot].used = false;
+    swarm->free_slots[swarm->free_count++] = slot;
+    swarm->count--;
+    swarm->tasks_changed = true;
+}
+
+static bool store_pose(nrx_swarm_t *swarm, uint32_t slot, const nrx_robot_pose_t *pose) {
+    robot_t *robot = &swarm->robots[slot];
+    if (robot->has_pose) {
+        // Late arrivals are dropped; the velocity comes from the newest pair
+        if (pose->timestamp_us <= robot->pose.timestamp_us) return false;
+        float dt = (float)(pose->timestamp_us - robot->pose.timestamp_us) * 1e-6f;
+        robot->rate.vx = (pose->x - robot->pose.x) / dt;
+        robot->rate.vy = (pose->y - robot->pose.y) / dt;
+        robot->rate.yaw_rate = remainderf(pose->heading - robot->pose.heading, 6.2831853f) / dt;
+    }
+    uint32_t id = robot->pose.id;
+    robot->pose = *pose;
+    robot->pose.id = id;
+    robot->has_pose = true;
+    nrx_spatial_update(swarm->grid, slot, pose->x, pose->y);
+    return true;
+}
+
+// Others where they should be by now; this robot where it said it is
+static void current_pose(const nrx_swarm_t *swarm, uint32_t slot, uint64_t now, nrx_robot_pose_t *pose) {
+    const robot_t *robot = &swarm->robots[slot];
+    if (slot == swarm->self) *pose = robot->pose;
+    else nrx_pose_predict(&robot->pose, &robot->rate, now, swarm->horizon_us, pose);
+}
+
+static void release_solver(nrx_swarm_t *swarm) {
+    nrx_assign_destroy(swarm->solver);
+    free(swarm->costs);
+    free(swarm->row_to_col);
+    free(swarm->row_slot);
+    free(swarm->col_task);
+    free(swarm->task_robot);
+    free(swarm->slot_task);
+    swarm->solver = NULL;
+    swarm->costs = NULL;
+    swarm->row_to_col = NULL;
+    swarm->row_slot = NULL;
+    swarm->col_task = NULL;
+    swarm->task_robot = NULL;
+    swarm->slot_task = NULL;
+}
+
+static void send_consensus(uint32_t to, const uint8_t *payload, size_t len, void *ctx);
+
+nrx_swarm_t *nrx_swarm_init(nrx_swarm_config_t *config) {
+    if (!config || config->robot_id == 0) return NULL;
+    
+    nrx_swarm_t *swarm = calloc(1, sizeof(nrx_swarm_t));
+    if (!swarm) return NULL;
+    swarm->config = *config;
+    if (swarm->config.max_robots == 0) swarm->config.max_robots = DEFAULT_MAX_ROBOTS;
+    if (swarm->config.max_tasks == 0) swarm->config.max_tasks = DEFAULT_MAX_TASKS;
+    if (!(swarm->config.cell_size > 0.0f)) swarm->config.cell_size = DEFAULT_CELL_SIZE;
+    if (!(swarm->config.pose_resolution >= 1e-6f)) swarm->config.pose_resolution = DEFAULT_POSE_RESOLUTION;
+    if (!(swarm->config.pose_threshold > 0.0f)) swarm->config.pose_threshold = DEFAULT_POSE_THRESHOLD;
+    if (!(swarm->config.heading_threshold > 0.0f)) swarm->config.heading_threshold = DEFAULT_HEADING_THRESHOLD;
+    if (swarm->config.keyframe_interval_ms == 0) swarm->config.keyframe_interval_ms = DEFAULT_KEYFRAME_INTERVAL_MS;
+    swarm->resolution_um = (uint32_t)lrintf(fminf(swarm->config.pose_resolution, 1000.0f) * 1e6f);
+    swarm->horizon_us = 2000ULL * swarm->config.keyframe_interval_ms;
+    
+    size_t capacity = swarm->config.max_robots;
+    size_t index_size = 16;
+    while (index_size < 2 * capacity) index_size *= 2;
+    swarm->capacity = capacity;
+    swarm->index_mask = index_size - 1;
+    swarm->robots = calloc(capacity, sizeof(robot_t));
+    swarm->free_slots = malloc(capacity * sizeof(uint32_t));
+    swarm->index = calloc(index_size, sizeof(uint32_t));
+    swarm->grid = nrx_spatial_create(capacity, swarm->config.cell_size);
+    swarm->tasks = malloc(swarm->config.max_tasks * sizeof(nrx_swarm_task_t));
+    if (!swarm->robots || !swarm->free_slots || !swarm->index || !swarm->grid || !swarm->tasks) {
+        nrx_swarm_deinit(swarm);
+        return NULL;
+    }
+    
+    // Lowest slots first
+    for (size_t i = 0; i < capacity; i++) swarm->free_slots[i] = (uint32_t)(capacity - 1 - i);
+    swarm->free_count = capacity;
+    swarm->self = add_robot(swarm, config->robot_id);
+    swarm->robots[swarm->self].last_seen_us = nrx_time_now_us();
+    
+    if (config->consensus_member_count) {
+        nrx_raft_config_t raft = {
+            .id = config->robot_id,
+            .members = config->consensus_members,
+            .member_count = config->consensus_member_count,
+            .election_timeout_ms = config->election_timeout_ms,
+            .max_batch = config->consensus_max_batch,
+            .max_inflight = config->consensus_max_inflight,
+            .send = send_consensus,
+            .send_ctx = swarm,
+        };
+        swarm->raft = nrx_raft_create(&raft, nrx_time_now_us());
+        if (!swarm->raft) {
+            nrx_swarm_deinit(swarm);
+            return NULL;
+        }
+    }
+    swarm->config.consensus_members = NULL;
+    return swarm;
+}
+
+void nrx_swarm_deinit(nrx_swarm_t *swarm) {
+    if (!swarm) return;
+    nrx_spatial_destroy(swarm->grid);
+    free(swarm->robots);
+    free(swarm->free_slots);
+    free(swarm->index);
+    free(swarm->tasks);
+    release_solver(swarm);
+    nrx_coverage_destroy(swarm->coverage);
+    nrx_raft_destroy(swarm->raft);
+    free(swarm);
+}
+
+// Communication
+static int transmit(nrx_swarm_t *swarm, uint32_t target_id, nrx_swarm_msg_type_t type,
+                    const uint8_t *payload, size_t len) {
+    if (!swarm || !swarm->config.transport) return -1;
+    
+    nrx_swarm_message_t msg = {
+        .type = type,
+        .sender_id = swarm->config.robot_id,
+        .target_id = target_id,
+        .payload = (uint8_t *)payload,
+        .payload_len = len,
+        .timestamp_us = nrx_time_now_us(),
+    };
+    if (swarm->config.transport(&msg, swarm->config.transport_ctx) != 0) return -1;
+    swarm->last_sent_us = msg.timestamp_us;
+    swarm->stats.messages_sent++;
+    swarm->stats.bytes_sent += len;
+    return 0;
+}
+
+int nrx_swarm_broadcast(nrx_swarm_t *swarm, nrx_swarm_msg_type_t type,
+                        const uint8_t *payload, size_t len) {
+    return transmit(swarm, 0, type, payload, len);
+}
+
+int nrx_swarm_send(nrx_swarm_t *swarm, uint32_t target_id, nrx_swarm_msg_type_t type,
+                   const uint8_t *payload, size_t len) {
+    if (target_id == 0) return -1;
+    return transmit(swarm, target_id, type, payload, len);
+}
+
+static void send_consensus(uint32_t to, const uint8_t *payload, size_t len, void *ctx) {
+    transmit(ctx, to, NRX_MSG_CONSENSUS, payload, len);
+}
+
+void nrx_swarm_set_callback(nrx_swarm_t *swarm, nrx_swarm_msg_cb_t callback, void *user_data) {
+    if (!swarm) return;
+    swarm->callback = callback;
+    swarm->user_data = user_data;
+}
+
+static void receive_pose(nrx_swarm_t *swarm, uint32_t slot, const nrx_swarm_message_t *msg) {
+    robot_t *robot = &swarm->robots[slot];
+    nrx_pose_q_t q;
+    if (nrx_pose_decode(&robot->key, msg->payload, msg->payload_len, &q) != 0) return;
+    
+    nrx_robot_pose_t pose;
+    nrx_pose_rate_t rate;
+    nrx_pose_dequantize(&q, robot->key.resolution_um, &pose, &rate);
+    if (store_pose(swarm, slot, &pose)) robot->rate = rate;
+}
+
+// Task table
+static int32_t find_task(const nrx_swarm_t *swarm, uint32_t task_id) {
+    for (size_t i = 0; i < swarm->task_count; i++) {
+        if (swarm->tasks[i].task_id == task_id) return (int32_t)i;
+    }
+    return -1;
+}
+
+// Inserts or replaces; the index, or -1 when the table is full
+static int32_t store_task(nrx_swarm_t *swarm, const nrx_swarm_task_t *task) {
+    if (task->status > TASK_STARTED || (task->status != TASK_PENDING && task->assigned_robot_id == 0) ||
+        !isfinite(task->x) || !isfinite(task->y) || !isfinite(task->priority)) {
+        return -1;
+    }
+    int32_t i = find_task(swarm, task->task_id);
+    if (i < 0) {
+        if (swarm->task_count == swarm->config.max_tasks) return -1;
+        i = (int32_t)swarm->task_count++;
+    }
+    swarm->tasks[i] = *task;
+    if (task->status == TASK_PENDING) swarm->tasks[i].assigned_robot_id = 0;
+    return i;
+}
+
+static void drop_task(nrx_swarm_t *swarm, int32_t i) {
+    swarm->tasks[i] = swarm->tasks[--swarm->task_count];
+    swarm->tasks_changed = true;
+}
+
+// Task payload: id, robot, x, y, priority, status, little-endian
+static void share_task(nrx_swarm_t *swarm, const nrx_swarm_task_t *task) {
+    if (!swarm->config.transport) return;
+    uint8_t payload[TASK_PAYLOAD_SIZE];
+    nrx_codec_writer_t w = nrx_codec_writer(payload, sizeof(payload));
+    nrx_bin_uint(&w, task->task_id, 4);
+    nrx_bin_uint(&w, task->assigned_robot_id, 4);
+    nrx_bin_f32(&w, task->x);
+    nrx_bin_f32(&w, task->y);
+    nrx_bin_f32(&w, task->priority);
+    nrx_bin_uint(&w, task->status, 1);
+    nrx_swarm_broadcast(swarm, NRX_MSG_TASK_ASSIGN, payload, nrx_codec_end(&w));
+}
+
+static void receive_task(nrx_swarm_t *swarm, const nrx_swarm_message_t *msg) {
+    const uint8_t *p = msg->payload;
+    if (msg->type == NRX_MSG_TASK_COMPLETE) {
+        int32_t i = msg->payload_len == 4 ? find_task(swarm, (uint32_t)nrx_bin_read_uint(p, 4)) : -1;
+        if (i >= 0) drop_task(swarm, i);
+        return;
+    }
+    
+    if (msg->payload_len != TASK_PAYLOAD_SIZE) return;
+    nrx_swarm_task_t task = {
+        .task_id = (uint32_t)nrx_bin_read_uint(p, 4),
+        .assigned_robot_id = (uint32_t)nrx_bin_read_uint(p + 4, 4),
+        .x = nrx_bin_read_f32(p + 8),
+        .y = nrx_bin_read_f32(p + 12),
+        .priority = nrx_bin_read_f32(p + 16),
+        .status = p[20],
+    };
+    
+    // New work needs placing; an assignment is already someone's answer
+    if (store_task(swarm, &task) >= 0 && task.status == TASK_PENDING) swarm->tasks_changed = true;
+}
+
+void nrx_swarm_receive(nrx_swarm_t *swarm, const nrx_swarm_message_t *msg) {
+    if (!swarm || !msg || msg->sender_id == 0 || msg->sender_id == swarm->config.robot_id) return;
+    if (msg->target_id != 0 && msg->target_id != swarm->config.robot_id) return;
+    swarm->stats.messages_received++;
+    swarm->stats.bytes_received += msg->payload_len;
+    
+    // Anyone heard from is known; a full table still passes messages on
+    uint32_t slot = find_slot(swarm, msg->sender_id);
+    if (slot == NONE) slot = add_robot(swarm, msg->sender_id);
+    if (slot != NONE) {
+        swarm->robots[slot].last_seen_us = nrx_time_now_us();
+        if (msg->type == NRX_MSG_POSE) receive_pose(swarm, slot, msg);
+    }
+    if (msg->type == NRX_MSG_TASK_ASSIGN || msg->type == NRX_MSG_TASK_COMPLETE) receive_task(swarm, msg);
+    if (msg->type == NRX_MSG_CONSENSUS) {
+        nrx_raft_receive(swarm->raft, msg->sender_id, msg->payload, msg->payload_len, nrx_time_now_us());
+    }
+    
+    if (swarm->callback) swarm->callback((nrx_swarm_message_t *)msg, swarm->user_data);
+}
+
+void nrx_swarm_loop(nrx_swarm_t *swarm) {
+    if (!swarm) return;
+    uint64_t now = nrx_time_now_us();
+    nrx_raft_tick(swarm->raft, now);
+    
+    uint64_t interval = (uint64_t)swarm->config.heartbeat_interval_ms * 1000;
+    if (interval && swarm->config.transport && now - swarm->last_sent_us >= interval) {
+        nrx_swarm_broadcast(swarm, NRX_MSG_HEARTBEAT, NULL, 0);
+    }
+    
+    uint64_t timeout = (uint64_t)swarm->config.timeout_ms * 1000;
+    for (uint32_t slot = 0; slot < swarm->capacity; slot++) {
+        const robot_t *robot = &swarm->robots[slot];
+        if (!robot->used || slot == swarm->self) continue;
+        if (timeout && now - robot->last_seen_us > timeout) {
+            remove_robot(swarm, slot);
+        } else if (robot->has_pose && (robot->rate.vx != 0.0f || robot->rate.vy != 0.0f)) {
+            nrx_robot_pose_t pose;
+            current_pose(swarm, slot, now, &pose);
+            nrx_spatial_update(swarm->grid, slot, pose.x, pose.y);
+        }
+    }
+}
+
+// Robot discovery
+int nrx_swarm_get_robots(nrx_swarm_t *swarm, uint32_t *robot_ids, size_t max_robots) {
+    if (!swarm || (!robot_ids && max_robots)) return -1;
+    size_t n = 0;
+    for (size_t slot = 0; slot < swarm->capacity && n < max_robots; slot++) {
+        if (swarm->robots[slot].used) robot_ids[n++] = swarm->robots[slot].pose.id;
+    }
+    return (int)n;
+}
+
+size_t nrx_swarm_get_robot_count(nrx_swarm_t *swarm) {
+    return swarm ? swarm->count : 0;
+}
+
+bool nrx_swarm_is_robot_alive(nrx_swarm_t *swarm, uint32_t robot_id) {
+    if (!swarm) return false;
+    uint32_t slot = find_slot(swarm, robot_id);
+    if (slot == NONE) return false;
+    if (slot == swarm->self || swarm->config.timeout_ms == 0) return true;
+    return nrx_time_now_us() - swarm->robots[slot].last_seen_us <= (uint64_t)swarm->config.timeout_ms * 1000;
+}
+
+// Position sharing
+// Deltas are against the last keyframe, so receivers that missed some
+// still decode the next one
+static int share_pose(nrx_swarm_t *swarm) {
+    const robot_t *self = &swarm->robots[swarm->self];
+    const nrx_robot_pose_t *pose = &self->pose;
+    uint64_t interval = (uint64_t)swarm->config.keyframe_interval_ms * 1000;
+    bool keyframe = !swarm->sent_key.valid || pose->timestamp_us - swarm->sent_key.state.timestamp_us >= interval;
+    
+    if (!keyframe) {
+        nrx_robot_pose_t expected;
+        nrx_pose_predict(&swarm->sent, &swarm->sent_rate, pose->timestamp_us, swarm->horizon_us, &expected);
+        float dx = pose->x - expected.x, dy = pose->y - expected.y, dz = pose->z - expected.z;
+        float turn = remainderf(pose->heading - expected.heading, 6.2831853f);
+        float threshold = swarm->config.pose_threshold;
+        if (dx * dx + dy * dy + dz * dz <= threshold * threshold &&
+            fabsf(turn) <= swarm->config.heading_threshold) {
+            swarm->stats.poses_skipped++;
+            return 0;
+        }
+    }
+    
+    nrx_pose_q_t q;
+    nrx_pose_quantize(pose, &self->rate, swarm->resolution_um, &q);
+    nrx_pose_keyframe_t key = swarm->sent_key;
+    uint8_t payload[NRX_POSE_MAX_PAYLOAD];
+    size_t len = keyframe ? nrx_pose_encode_keyframe(&key, &q, swarm->resolution_um, payload)
+                          : nrx_pose_encode_delta(&key, &q, payload);
+    if (len == 0 || nrx_swarm_broadcast(swarm, NRX_MSG_POSE, payload, len) != 0) return -1;
+    swarm->sent_key = key;
+    nrx_pose_dequantize(&q, swarm->resolution_um, &swarm->sent, &swarm->sent_rate);
+    return 0;
+}
+
+int nrx_swarm_update_pose(nrx_swarm_t *swarm, nrx_robot_pose_t *pose) {
+    if (!swarm || !pose) return -1;
+    
+    nrx_robot_pose_t p = *pose;
+    bool own = p.id == 0 || p.id == swarm->config.robot_id;
+    if (own) p.id = swarm->config.robot_id;
+    if (p.timestamp_us == 0) p.timestamp_us = nrx_time_now_us();
+    
+    uint32_t slot = find_slot(swarm, p.id);
+    if (slot == NONE) slot = add_robot(swarm, p.id);
+    if (slot == NONE) return -1;
+    
+    // A late pose neither refreshes the robot nor is shared
+    if (!store_pose(swarm, slot, &p)) return 0;
+    swarm->robots[slot].last_seen_us = nrx_time_now_us();
+    
+    if (own && swarm->config.transport) return share_pose(swarm);
+    return 0;
+}
+
+int nrx_swarm_get_pose(nrx_swarm_t *swarm, uint32_t robot_id, nrx_robot_pose_t *pose) {
+    if (!swarm || !pose) return -1;
+    uint32_t slot = find_slot(swarm, robot_id);
+    if (slot == NONE || !swarm->robots[slot].has_pose) return -1;
+    current_pose(swarm, slot, nrx_time_now_us(), pose);
+    return 0;
+}
+
+typedef struct {
+    const nrx_swarm_t *swarm;
+    nrx_robot_pose_t *poses;
+    size_t max;
+    size_t count;
+    uint64_t now;
+} collect_t;
+
+static void collect_neighbor(uint32_t slot, float x, float y, float dist_sq, void *ctx) {
+    (void)x; (void)y; (void)dist_sq;
+    collect_t *c = ctx;
+    if (slot == c->swarm->self || c->count == c->max) return;
+    current_pose(c->swarm, slot, c->now, &c->poses[c->count++]);
+}
+
+size_t nrx_swarm_neighbors(nrx_swarm_t *swarm, float x, float y, float radius,
+                           nrx_robot_pose_t *poses, size_t max_poses) {
+    if (!swarm || !poses) return 0;
+    collect_t c = { swarm, poses, max_poses, 0, nrx_time_now_us() };
+    nrx_spatial_query(swarm->grid, x, y, radius, collect_neighbor, &c);
+    return c.count;
+}
+
+// Task allocation
+int nrx_swarm_add_task(nrx_swarm_t *swarm, nrx_swarm_task_t *task) {
+    if (!swarm || !task) return -1;
+    int32_t i = store_task(swarm, task);
+    if (i < 0) return -1;
+    swarm->tasks_changed = true;
+    share_task(swarm, &swarm->tasks[i]);
+    return 0;
+}
+
+static int prepare_solver(nrx_swarm_t *swarm) {
+    if (swarm->solver) return 0;
+    size_t robots = swarm->capacity, tasks = swarm->config.max_tasks;
+    swarm->solver = nrx_assign_create(robots, tasks);
+    swarm->costs = malloc(robots * tasks * sizeof(float));
+    swarm->row_to_col = malloc(robots * sizeof(int32_t));
+    swarm->row_slot = malloc(robots * sizeof(uint32_t));
+    swarm->col_task = malloc(tasks * sizeof(uint32_t));
+    swarm->task_robot = malloc(tasks * sizeof(uint32_t));
+    swarm->slot_task = malloc(robots * sizeof(int32_t));
+    if (!swarm->solver || !swarm->costs || !swarm->row_to_col || !swarm->row_slot ||
+        !swarm->col_task || !swarm->task_robot || !swarm->slot_task) {
+        release_solver(swarm);
+        return -1;
+    }
+    return 0;
+}
+
+// Assigned work the exact solve may move. A robot without a pose has no
+// row, so what it holds stays with it, as in the market.
+static bool task_movable(const nrx_swarm_t *swarm, size_t i) {
+    if (swarm->task_robot[i] == 0 || swarm->tasks[i].status != TASK_ASSIGNED) return false;
+    uint32_t slot = find_slot(swarm, swarm->task_robot[i]);
+    return slot != NONE && swarm->robots[slot].has_pose;
+}
+
+int nrx_swarm_assign_tasks(nrx_swarm_t *swarm) {
+    if (!swarm) return -1;
+    if (!swarm->tasks_changed) return 0;
+    if (prepare_solver(swarm) != 0) return -1;
+    
+    // Who holds what. Started work stays put; work held by a robot that
+    // has gone, or that holds something else, goes back to the pool.
+    for (size_t slot = 0; slot < swarm->capacity; slot++) swarm->slot_task[slot] = -1;
+    for (size_t i = 0; i < swarm->task_count; i++) swarm->task_robot[i] = 0;
+    for (uint8_t status = TASK_STARTED; status >= TASK_ASSIGNED; status--) {
+        for (size_t i = 0; i < swarm->task_count; i++) {
+            const nrx_swarm_task_t *task = &swarm->tasks[i];
+            if (task->status != status) continue;
+            uint32_t slot = find_slot(swarm, task->assigned_robot_id);
+            if (slot == NONE || swarm->slot_task[slot] >= 0) continue;
+            swarm->slot_task[slot] = (int32_t)i;
+            swarm->task_robot[i] = task->assigned_robot_id;
+        }
+    }
+    
+    size_t free_robots = 0, held = 0, open = 0;
+    for (size_t slot = 0; slot < swarm->capacity; slot++) {
+        if (swarm->robots[slot].used && swarm->robots[slot].has_pose && swarm->slot_task[slot] < 0) free_robots++;
+    }
+    for (size_t i = 0; i < swarm->task_count; i++) {
+        if (swarm->task_robot[i] == 0) open++;
+        else if (task_movable(swarm, i)) held++;
+    }
+    
+    // Small problems are solved whole, so assigned work can move; large
+    // ones place only open tasks on free robots
+    bool exact = free_robots + held <= EXACT_LIMIT && open + held <= EXACT_LIMIT;
+    size_t rows = 0, cols = 0;
+    for (uint32_t slot = 0; slot < swarm->capacity; slot++) {
+        const robot_t *robot = &swarm->robots[slot];
+        if (!robot->used || !robot->has_pose) continue;
+        int32_t holding = swarm->slot_task[slot];
+        if (holding < 0 || (exact && swarm->tasks[holding].status == TASK_ASSIGNED)) swarm->row_slot[rows++] = slot;
+    }
+    for (size_t i = 0; i < swarm->task_count; i++) {
+        if (swarm->task_robot[i] == 0 || (exact && task_movable(swarm, i))) {
+            swarm->col_task[cols++] = (uint32_t)i;
+        }
+    }
+    if (rows == 0 || cols == 0) {
+        rows = 0;
+        cols = 0;
+    }
+    
+    // Cost: distance from where the robot is now, less priority, less a
+    // bonus for keeping what it has
+    uint64_t now = nrx_time_now_us();
+    for (size_t r = 0; r < rows; r++) {
+        nrx_robot_pose_t pose;
+        current_pose(swarm, swarm->row_slot[r], now, &pose);
+        uint32_t id = swarm->robots[swarm->row_slot[r]].pose.id;
+        float *row = swarm->costs + r * cols;
+        for (size_t c = 0; c < cols; c++) {
+            uint32_t i = swarm->col_task[c];
+            const nrx_swarm_task_t *task = &swarm->tasks[i];
+            row[c] = hypotf(task->x - pose.x, task->y - pose.y) - task->priority;
+            if (swarm->task_robot[i] == id) row[c] -= KEEP_BONUS;
+        }
+    }
+    
+    int solved = exact ? nrx_assign_optimal(swarm->solver, swarm->costs, rows, cols, swarm->row_to_col)
+                       : nrx_assign_market(swarm->solver, swarm->costs, rows, cols, swarm->row_to_col);
+    if (solved < 0) return -1;
+    for (size_t c = 0; c < cols; c++) swarm->task_robot[swarm->col_task[c]] = 0;
+    for (size_t r = 0; r < rows; r++) {
+        int32_t c = swarm->row_to_col[r];
+        if (c >= 0) swarm->task_robot[swarm->col_task[c]] = swarm->robots[swarm->row_slot[r]].pose.id;
+    }
+    
+    int changed = 0;
+    for (size_t i = 0; i < swarm->task_count; i++) {
+        nrx_swarm_task_t *task = &swarm->tasks[i];
+        if (task->assigned_robot_id == swarm->task_robot[i]) continue;
+        task->assigned_robot_id = swarm->task_robot[i];
+        task->status = task->assigned_robot_id ? TASK_ASSIGNED : TASK_PENDING;
+        share_task(swarm, task);
+        changed++;
+    }
+    swarm->tasks_changed = false;
+    return changed;
+}
+
+int nrx_swarm_get_my_tasks(nrx_swarm_t *swarm, nrx_swarm_task_t *tasks, size_t max_tasks) {
+    if (!swarm || (!tasks && max_tasks)) return -1;
+    size_t n = 0;
+    for (size_t i = 0; i < swarm->task_count && n < max_tasks; i++) {
+        const nrx_swarm_task_t *task = &swarm->tasks[i];
+        if (task->status != TASK_PENDING && task->assigned_robot_id == swarm->config.robot_id) tasks[n++] = *task;
+    }
+    return (int)n;
+}
+
+int nrx_swarm_complete_task(nrx_swarm_t *swarm, uint32_t task_id) {
+    if (!swarm) return -1;
+    int32_t i = find_task(swarm, task_id);
+    if (i < 0) return -1;
+    drop_task(swarm, i);
+    
+    if (swarm->config.transport) {
+        uint8_t payload[4];
+        nrx_codec_writer_t w = nrx_codec_writer(payload, sizeof(payload));
+        nrx_bin_uint(&w, task_id, 4);
+        nrx_swarm_broadcast(swarm, NRX_MSG_TASK_COMPLETE, payload, nrx_codec_end(&w));
+    }
+    return 0;
+}
+
+// Consensus
+int nrx_swarm_consensus_propose(nrx_swarm_t *swarm, float value) {
+    if (!swarm) return -1;
+    return nrx_raft_propose(swarm->raft, value, swarm->config.robot_id);
+}
+
+int nrx_swarm_consensus_get_result(nrx_swarm_t *swarm, float *result) {
+    if (!swarm || !result) return -1;
+    nrx_consensus_value_t value;
+    int fresh = nrx_raft_read(swarm->raft, nrx_time_now_us(), &value);
+    if (fresh < 0) return -1;
+    *result = value.value;
+    return fresh ? 0 : 1;
+}
+
+// Flocking behavior
+typedef struct {
+    const nrx_swarm_t *swarm;
+    float x, y;
+    float sep_x, sep_y;         // Away from each neighbor, by 1/distance
+    float vel_x, vel_y;
+    float sum_x, sum_y;
+    float dist;
+    int count;
+} flock_t;
+
+static void flock_neighbor(uint32_t slot, float x, float y, float dist_sq, void *ctx) {
+    flock_t *f = ctx;
+    if (slot == f->swarm->self) return;
+    
+    const robot_t *robot = &f->swarm->robots[slot];
+    float d = sqrtf(dist_sq);
+    if (d > 1e-6f) {
+        f->sep_x += (f->x - x) / dist_sq;
+        f->sep_y += (f->y - y) / dist_sq;
+    }
+    f->vel_x += robot->rate.vx;
+    f->vel_y += robot->rate.vy;
+    f->sum_x += x;
+    f->sum_y += y;
+    f->dist += d;
+    f->count++;
+}
+
+static void clamp_speed(float *vx, float *vy, float max_speed) {
+    float speed = sqrtf(*vx * *vx + *vy * *vy);
+    if (max_speed > 0.0f && speed > max_speed) {
+        *vx *= max_speed / speed;
+        *vy *= max_speed / speed;
+    }
+}
+
+int nrx_swarm_flock_update(nrx_swarm_t *swarm, nrx_flock_params_t *params,
+                           float *velocity_x, float *velocity_y) {
+    if (!swarm || !params || !velocity_x || !velocity_y) return -1;
+    const robot_t *self = &swarm->robots[swarm->self];
+    if (!self->has_pose) return -1;
+    
+    flock_t f = { .swarm = swarm, .x = self->pose.x, .y = self->pose.y };
+    nrx_spatial_query(swarm->grid, f.x, f.y, params->neighbor_radius, flock_neighbor, &f);
+    if (f.count == 0) return 0;
+    
+    float n = (float)f.count;
+    float vx = *velocity_x, vy = *velocity_y;
+    vx += params->separation_weight * f.sep_x +
+          params->alignment_weight * (f.vel_x / n - *velocity_x) +
+          params->cohesion_weight * (f.sum_x / n - f.x);
+    vy += params->separation_weight * f.sep_y +
+          params->alignment_weight * (f.vel_y / n - *velocity_y) +
+          params->cohesion_weight * (f.sum_y / n - f.y);
+    clamp_speed(&vx, &vy, params->max_speed);
+    
+    *velocity_x = vx;
+    *velocity_y = vy;
+    swarm->stats.avg_distance_to_neighbors = f.dist / n;
+    return f.count;
+}
+
+// Coverage control
+int nrx_swarm_coverage_init(nrx_swarm_t *swarm, nrx_coverage_area_t *area) {
+    if (!swarm) return -1;
+    nrx_coverage_grid_t *grid = nrx_coverage_create(area);
+    if (!grid) return -1;
+    nrx_coverage_destroy(swarm->coverage);
+    swarm->coverage = grid;
+    return 0;
+}
+
+int nrx_swarm_coverage_get_target(nrx_swarm_t *swarm, float *x, float *y) {
+    if (!swarm || !swarm->coverage) return -1;
+    const robot_t *self = &swarm->robots[swarm->self];
+    if (!self->has_pose) return -1;
+    return nrx_coverage_nearest(swarm->coverage, self->pose.x, self->pose.y, x, y) ? 0 : -1;
+}
+
+int nrx_swarm_coverage_mark_visited(nrx_swarm_t *swarm, float x, float y) {
+    if (!swarm || !swarm->coverage) return -1;
+    return nrx_coverage_mark(swarm->coverage, x, y, 0.0f) < 0 ? -1 : 0;
+}
+
+float nrx_swarm_coverage_get_progress(nrx_swarm_t *swarm) {
+    if (!swarm || !swarm->coverage) return 0.0f;
+    return (float)((double)nrx_coverage_visited_count(swarm->coverage) /
+                   (double)nrx_coverage_cell_count(swarm->coverage));
+}
+
+// Collision avoidance
+typedef struct {
+    const nrx_swarm_t *swarm;
+    float x, y;
+    float vx, vy;
+    float min_distance;
+    int count;
+} avoid_t;
+
+static void avoid_neighbor(uint32_t slot, float x, float y, float dist_sq, void *ctx) {
+    avoid_t *a = ctx;
+    float d = sqrtf(dist_sq);
+    if (slot == a->swarm->self || d < 1e-6f) return;
+    
+    // Only the closing part of the velocity; full strength inside
+    // min_distance, fading out at twice that
+    float ux = (x - a->x) / d, uy = (y - a->y) / d;
+    float closing = a->vx * ux + a->vy * uy;
+    if (closing <= 0.0f) return;
+    float strength = d <= a->min_distance ? 1.0f : (2.0f * a->min_distance - d) / a->min_distance;
+    a->vx -= ux * closing * strength;
+    a->vy -= uy * closing * strength;
+    a->count++;
+}
+
+int nrx_swarm_avoid_collisions(nrx_swarm_t *swarm, nrx_collision_params_t *params,
+                               float *velocity_x, float *velocity_y) {
+    if (!swarm || !params || !velocity_x || !velocity_y) return -1;
+    const robot_t *self = &swarm->robots[swarm->self];
+    if (!self->has_pose) return -1;
+    
+    avoid_t a = {
+        .swarm = swarm,
+        .x = self->pose.x,
+        .y = self->pose.y,
+        .vx = *velocity_x,
+        .vy = *velocity_y,
+        .min_distance = params->min_distance,
+    };
+    if (!(a.min_distance > 0.0f)) return 0;
+    nrx_spatial_query(swarm->grid, a.x, a.y, 2.0f * a.min_distance, avoid_neighbor, &a);
+    if (a.count == 0) return 0;
+    
+    // Keep at least the allowed share of the original speed
+    float reduction = params->max_speed_reduction;
+    if (reduction > 0.0f && reduction < 1.0f) {
+        float before = sqrtf(*velocity_x * *velocity_x + *velocity_y * *velocity_y);
+        float after = sqrtf(a.vx * a.vx + a.vy * a.vy);
+        float floor_speed = (1.0f - reduction) * before;
+        if (after > 1e-6f && after < floor_speed) {
+            a.vx *= floor_speed / after;
+            a.vy *= floor_speed / after;
+        }
+    }
+    
+    *velocity_x = a.vx;
+    *velocity_y = a.vy;
+    return a.count;
+}
+
+// Leader election
+uint32_t nrx_swarm_elect_leader(nrx_swarm_t *swarm) {
+    if (!swarm) return 0;
+    if (swarm->raft) return nrx_raft_leader(swarm->raft);
+    
+    uint64_t now = nrx_time_now_us(), timeout = (uint64_t)swarm->config.timeout_ms * 1000;
+    uint32_t leader = swarm->config.robot_id;
+    for (uint32_t slot = 0; slot < swarm->capacity; slot++) {
+        const robot_t *robot = &swarm->robots[slot];
+        if (!robot->used || (slot != swarm->self && timeout && now - robot->last_seen_us > timeout)) continue;
+        if (robot->pose.id < leader) leader = robot->pose.id;
+    }
+    return leader;
+}
+
+bool nrx_swarm_is_leader(nrx_swarm_t *swarm) {
+    if (!swarm) return false;
+    if (swarm->raft) return nrx_raft_role(swarm->raft) == NRX_RAFT_LEADER;
+    return nrx_swarm_elect_leader(swarm) == swarm->config.robot_id;
+}
+
+// Statistics
+void nrx_swarm_get_stats(nrx_swarm_t *swarm, nrx_swarm_stats_t *stats) {
+    if (!swarm || !stats) return;
+    *stats = swarm->stats;
+    stats->robot_count = swarm->count;
+    stats->leader_id = nrx_swarm_elect_leader(swarm);
+}
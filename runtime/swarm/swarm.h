@@ -22,6 +22,7 @@ typedef enum {
     NRX_MSG_HEARTBEAT,      // Keep-alive
     NRX_MSG_COMMAND,        // Direct command
     NRX_MSG_DATA,           // Generic data
+    NRX_MSG_CONSENSUS,      // Raft (see raft.h)
 } nrx_swarm_msg_type_t;
 
 // Swarm message
@@ -34,6 +35,10 @@ typedef struct {
     uint64_t timestamp_us;
 } nrx_swarm_message_t;
 
+// Transport: hands a message to the network (MQTT, radio, or a simulated
+// link); 0 when it was taken
+typedef int (*nrx_swarm_transport_t)(const nrx_swarm_message_t *msg, void *ctx);
+
 // Swarm configuration
 typedef struct {
     uint32_t robot_id;
@@ -41,7 +46,21 @@ typedef struct {
     const char *discovery_topic;
     const char *command_topic;
     uint32_t heartbeat_interval_ms;
-    uint32_t timeout_ms;
+    uint32_t timeout_ms;         // Silent robots are dropped after this (0 = never)
+    size_t max_robots;           // Including this one (default 256)
+    size_t max_tasks;            // Tasks known at once (default 256)
+    float cell_size;             // Neighbor grid cell in meters (default 5)
+    float pose_resolution;       // Pose quantum in meters (default 0.01)
+    float pose_threshold;        // Send when receivers' estimate is off by more (m, default 0.05)
+    float heading_threshold;     // Or its heading (rad, default 0.05)
+    uint32_t keyframe_interval_ms;  // Full pose at least this often (default 1000)
+    const uint32_t *consensus_members;  // Robots that vote, this one included (none = no consensus)
+    size_t consensus_member_count;
+    uint32_t election_timeout_ms;       // Default 150
+    size_t consensus_max_batch;         // Entries per AppendEntries (default 32)
+    size_t consensus_max_inflight;      // Unanswered AppendEntries per robot (default 4)
+    nrx_swarm_transport_t transport;
+    void *transport_ctx;
 } nrx_swarm_config_t;
 
 // Swarm handle
@@ -51,9 +70,21 @@ typedef struct nrx_swarm_t nrx_swarm_t;
 typedef void (*nrx_swarm_msg_cb_t)(nrx_swarm_message_t *msg, void *user_data);
 
 // Swarm initialization
+// The swarm keeps a table of the robots it has heard from, with their last
+// pose, and a spatial grid over those poses for neighbor queries. Both are
+// sized from max_robots at init and updated in place as messages arrive.
 nrx_swarm_t *nrx_swarm_init(nrx_swarm_config_t *config);
 void nrx_swarm_deinit(nrx_swarm_t *swarm);
 
+// Feed in a message from the transport. Messages for other robots are
+// ignored; the rest update the sender's entry and reach the callback.
+void nrx_swarm_receive(nrx_swarm_t *swarm, const nrx_swarm_message_t *msg);
+
+// Sends a heartbeat when this robot has been quiet for
+// heartbeat_interval_ms, drops robots silent for timeout_ms and moves the
+// others in the grid to where they are expected to be
+void nrx_swarm_loop(nrx_swarm_t *swarm);
+
 // Communication
 int nrx_swarm_broadcast(nrx_swarm_t *swarm, nrx_swarm_msg_type_t type, 
                         const uint8_t *payload, size_t len);
@@ -61,15 +92,30 @@ int nrx_swarm_send(nrx_swarm_t *swarm, uint32_t target_id, nrx_swarm_msg_type_t
                    const uint8_t *payload, size_t len);
 void nrx_swarm_set_callback(nrx_swarm_t *swarm, nrx_swarm_msg_cb_t callback, void *user_data);
 
-// Robot discovery
+// Robot discovery (this robot included)
 int nrx_swarm_get_robots(nrx_swarm_t *swarm, uint32_t *robot_ids, size_t max_robots);
 size_t nrx_swarm_get_robot_count(nrx_swarm_t *swarm);
 bool nrx_swarm_is_robot_alive(nrx_swarm_t *swarm, uint32_t robot_id);
 
 // Position sharing
+// This robot's pose (id 0 or robot_id) is stored and shared; any other id
+// is stored only, for poses from another source such as motion capture.
+// Other robots are dead-reckoned from their last pose and velocity, and
+// this robot sends a pose only when that estimate has drifted past
+// pose_threshold or heading_threshold, or a keyframe is due. Call it at
+// the control rate; most calls send nothing. A pose no newer than the
+// stored one is ignored.
 int nrx_swarm_update_pose(nrx_swarm_t *swarm, nrx_robot_pose_t *pose);
+
+// The pose extrapolated to now (this robot's as last stored)
 int nrx_swarm_get_pose(nrx_swarm_t *swarm, uint32_t robot_id, nrx_robot_pose_t *pose);
 
+// Other robots within radius of (x, y) in the plane, through the grid;
+// returns how many were written to poses. The grid moves robots to their
+// extrapolated positions on each nrx_swarm_loop().
+size_t nrx_swarm_neighbors(nrx_swarm_t *swarm, float x, float y, float radius,
+                           nrx_robot_pose_t *poses, size_t max_poses);
+
 // Formation control
 typedef enum {
     NRX_FORMATION_LINE,
@@ -96,21 +142,42 @@ typedef struct {
     float priority;
     float x, y;             // Task location
     uint8_t status;         // 0=pending, 1=assigned, 2=in_progress, 3=complete
-} nrx_task_t;
-
-int nrx_swarm_add_task(nrx_swarm_t *swarm, nrx_task_t *task);
-int nrx_swarm_assign_tasks(nrx_swarm_t *swarm);  // Automatic allocation
-int nrx_swarm_get_my_tasks(nrx_swarm_t *swarm, nrx_task_t *tasks, size_t max_tasks);
+} nrx_swarm_task_t;
+
+// Tasks are shared: adding one (or adding it again to change it) and
+// completing one are broadcast, and every robot keeps the same table.
+// Adding a task with status 2 and a robot marks it started; it then stays
+// with that robot.
+int nrx_swarm_add_task(nrx_swarm_t *swarm, nrx_swarm_task_t *task);
+
+// Gives robots with a pose at most one task each, counting travel
+// distance less priority (in meters). Small problems are solved exactly,
+// and assigned tasks not yet started may move to another robot when that
+// saves more than half a meter. Large ones go through a market that
+// places only new work and free robots. Nothing is done unless tasks or
+// robots have come or gone since the last call. Assignments are
+// broadcast; returns how many tasks changed hands.
+int nrx_swarm_assign_tasks(nrx_swarm_t *swarm);
+int nrx_swarm_get_my_tasks(nrx_swarm_t *swarm, nrx_swarm_task_t *tasks, size_t max_tasks);
 int nrx_swarm_complete_task(nrx_swarm_t *swarm, uint32_t task_id);
 
 // Consensus algorithms
+// The consensus members run Raft over NRX_MSG_CONSENSUS messages (see
+// raft.h), driven by nrx_swarm_loop(). A proposal is appended to the
+// leader's log, directly or forwarded to it, and the result is the last
+// value a majority has committed.
 typedef struct {
     float value;
     uint32_t proposer_id;
-    uint32_t round;
+    uint32_t round;         // Log index it was committed at
 } nrx_consensus_value_t;
 
+// -1 without consensus members, a known leader or room in the log
 int nrx_swarm_consensus_propose(nrx_swarm_t *swarm, float value);
+
+// 0 with the result on the leader while its lease holds, so it is the
+// latest; 1 with what this robot has seen committed, which may be behind;
+// -1 before anything is committed
 int nrx_swarm_consensus_get_result(nrx_swarm_t *swarm, float *result);
 
 // Flocking behavior
@@ -122,31 +189,51 @@ typedef struct {
     float neighbor_radius;
 } nrx_flock_params_t;
 
+// Adjusts the commanded velocity (in and out) by separation, alignment and
+// cohesion over the neighbors within neighbor_radius; returns how many
+// there were, or -1 before this robot has a pose
 int nrx_swarm_flock_update(nrx_swarm_t *swarm, nrx_flock_params_t *params,
                            float *velocity_x, float *velocity_y);
 
 // Coverage control (area exploration)
+// The area is a grid of cells, two bits each (see coverage.h). A robot
+// marks the cells it has seen, and its target is the nearest frontier
+// cell, meaning an unvisited cell next to a visited one. Before any cell
+// is marked, the target is the nearest cell. Other robots' marks are not
+// shared.
 typedef struct {
     float min_x, max_x;
     float min_y, max_y;
     float cell_size;
 } nrx_coverage_area_t;
 
+// Starts over with nothing visited; -1 for an empty or oversized area
 int nrx_swarm_coverage_init(nrx_swarm_t *swarm, nrx_coverage_area_t *area);
+
+// A cell centre, from this robot's pose; -1 without a pose or once done
 int nrx_swarm_coverage_get_target(nrx_swarm_t *swarm, float *x, float *y);
+
+// -1 when the point is outside the area
 int nrx_swarm_coverage_mark_visited(nrx_swarm_t *swarm, float x, float y);
+
+// Fraction of cells visited
 float nrx_swarm_coverage_get_progress(nrx_swarm_t *swarm);
 
 // Collision avoidance
 typedef struct {
     float min_distance;
-    float max_speed_reduction;
+    float max_speed_reduction;  // Fraction of the speed that may be taken away (0 = all)
 } nrx_collision_params_t;
 
+// Removes the part of the commanded velocity that closes on robots nearer
+// than twice min_distance, all of it inside min_distance; returns how many
+// robots it steered around, or -1 before this robot has a pose
 int nrx_swarm_avoid_collisions(nrx_swarm_t *swarm, nrx_collision_params_t *params,
                                float *velocity_x, float *velocity_y);
 
 // Leader election
+// With consensus members, the Raft leader (0 during an election);
+// without, the lowest id among the robots alive
 uint32_t nrx_swarm_elect_leader(nrx_swarm_t *swarm);
 bool nrx_swarm_is_leader(nrx_swarm_t *swarm);
 
@@ -155,6 +242,9 @@ typedef struct {
     size_t robot_count;
     size_t messages_sent;
     size_t messages_received;
+    size_t bytes_sent;          // Payload bytes
+    size_t bytes_received;
+    size_t poses_skipped;       // Pose updates the receivers could predict
     float avg_distance_to_neighbors;
     float formation_error;
     uint32_t leader_id;
@@ -0,0 +1,154 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../runtime/core/fusion.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#define SAMPLES 1024
+#define ROUNDS 500
+#define DT 0.005f
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Pre-generated inputs, so the loops time only the kernels
+static float gyro[SAMPLES][3], accel[SAMPLES][3];
+static nrx_q16_t gyro_q[SAMPLES][3], accel_q[SAMPLES][3];
+static nrx_imu4_t imu4[SAMPLES];
+
+static void make_samples(void) {
+    for (int i = 0; i < SAMPLES; i++) {
+        float t = (float)i * DT;
+        gyro[i][0] = 0.3f * cosf(t);
+        gyro[i][1] = -0.2f * sinf(3.0f * t);
+        gyro[i][2] = 0.1f;
+        accel[i][0] = -sinf(0.2f * sinf(t));
+        accel[i][1] = sinf(0.3f * cosf(t));
+        accel[i][2] = 1.0f;
+        for (int k = 0; k < 3; k++) {
+            gyro_q[i][k] = NRX_Q16(gyro[i][k]);
+            accel_q[i][k] = NRX_Q16(accel[i][k]);
+        }
+        for (int l = 0; l < NRX_FUSION_LANES; l++) {
+            imu4[i].gx[l] = gyro[i][0]; imu4[i].gy[l] = gyro[i][1]; imu4[i].gz[l] = gyro[i][2];
+            imu4[i].ax[l] = accel[i][0]; imu4[i].ay[l] = accel[i][1]; imu4[i].az[l] = accel[i][2];
+        }
+    }
+}
+
+static void report(const char *name, uint64_t ns, int instances_per_call) {
+    double updates = (double)SAMPLES * ROUNDS * instances_per_call;
+    printf("%-22s %8.1f ns/update  %6.1f M updates/s\n", name, (double)ns / updates, updates * 1e3 / (double)ns);
+}
+
+static void bench_complementary(void) {
+    nrx_complementary_t f;
+    nrx_complementary4_t f4;
+    nrx_complementary_q16_t fq;
+    nrx_complementary_init(&f, 0.98f);
+    nrx_complementary4_init(&f4, 0.98f);
+    nrx_complementary_q16_init(&fq, NRX_Q16(0.98f));
+    
+    uint64_t start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) nrx_complementary_update(&f, gyro[i], accel[i], DT);
+    report("complementary", now_ns() - start, 1);
+    
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) nrx_complementary4_update(&f4, &imu4[i], DT);
+    report("complementary x4", now_ns() - start, NRX_FUSION_LANES);
+    
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) nrx_complementary_q16_update(&fq, gyro_q[i], accel_q[i], NRX_Q16(DT));
+    report("complementary q16", now_ns() - start, 1);
+    
+    // Keep the results live
+    if (f.roll + f4.roll[0] + (float)fq.roll == 12345.0f) printf("\n");
+}
+
+static void bench_madgwick(void) {
+    nrx_madgwick_t f;
+    nrx_madgwick4_t f4;
+    nrx_madgwick_q16_t fq;
+    nrx_madgwick_init(&f, 0.1f);
+    nrx_madgwick4_init(&f4, 0.1f);
+    nrx_madgwick_q16_init(&fq, NRX_Q16(0.1f));
+    
+    uint64_t start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) nrx_madgwick_update(&f, gyro[i], accel[i], DT);
+    report("madgwick", now_ns() - start, 1);
+    
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) nrx_madgwick4_update(&f4, &imu4[i], DT);
+    report("madgwick x4", now_ns() - start, NRX_FUSION_LANES);
+    
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) nrx_madgwick_q16_update(&fq, gyro_q[i], accel_q[i], NRX_Q16(DT));
+    report("madgwick q16", now_ns() - start, 1);
+    
+    if (f.q.w + f4.qw[0] + (float)fq.qw == 12345.0f) printf("\n");
+}
+
+static void bench_ekf(void) {
+    nrx_ekf_t f;
+    nrx_ekf4_t f4;
+    nrx_ekf_q16_t fq;
+    nrx_ekf_init(&f, 0.01f, 0.005f, 0.05f);
+    nrx_ekf4_init(&f4, 0.01f, 0.005f, 0.05f);
+    nrx_ekf_q16_init(&fq, NRX_Q16(0.01f), NRX_Q16(0.005f), NRX_Q16(0.05f));
+    const float v[NRX_FUSION_LANES] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    
+    // One predict plus one heading fix per update
+    uint64_t start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) {
+            nrx_ekf_predict(&f, 1.0f, gyro[i][2], DT);
+            nrx_ekf_update_heading(&f, f.theta + gyro[i][0] * DT);
+        }
+    report("ekf", now_ns() - start, 1);
+    
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) {
+            nrx_ekf4_predict(&f4, v, imu4[i].gz, DT);
+            nrx_ekf4_update_heading(&f4, f4.theta);
+        }
+    report("ekf x4", now_ns() - start, NRX_FUSION_LANES);
+    
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) {
+            nrx_ekf_q16_predict(&fq, NRX_Q16_ONE, gyro_q[i][2], NRX_Q16(DT));
+            nrx_ekf_q16_update_heading(&fq, fq.theta + nrx_q16_mul(gyro_q[i][0], NRX_Q16(DT)));
+        }
+    report("ekf q16", now_ns() - start, 1);
+    
+    if (f.x + f4.x[0] + (float)fq.x == 12345.0f) printf("\n");
+}
+
+int main(void) {
+#if defined(NRX_FUSION_NO_SIMD)
+    printf("Fusion benchmark (plain C lanes)\n");
+#elif defined(__SSE2__)
+    printf("Fusion benchmark (SSE2 lanes)\n");
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    printf("Fusion benchmark (NEON lanes)\n");
+#else
+    printf("Fusion benchmark (plain C lanes)\n");
+#endif
+    
+    make_samples();
+    bench_complementary();
+    bench_madgwick();
+    bench_ekf();
+    return 0;
+}
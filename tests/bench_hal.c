@@ -0,0 +1,81 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../runtime/hal/hal.h"
+#include "../runtime/hal/hal_linux.h"
+#include "../runtime/core/log.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BATCH 512
+#define BATCHES 2000
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Time BATCH calls at a time and drain the log between batches, so the
+// ring never fills and the measurement covers the real recording path
+static void bench_gpio_write(void) {
+    uint64_t total = 0;
+    
+    for (int b = 0; b < BATCHES; b++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < BATCH; i++) {
+            nrx_gpio_write(17, (nrx_gpio_state_t)(i & 1));
+        }
+        total += now_ns() - start;
+        nrx_log_drain();
+    }
+    
+    printf("nrx_gpio_write:        %8.1f ns/op\n", (double)total / (BATCH * BATCHES));
+}
+
+static void bench_motor_update(void) {
+    nrx_motor_t left, right;
+    nrx_motor_init(&left, 12, 5, 6);
+    nrx_motor_init(&right, 13, 19, 26);
+    uint64_t direct = 0, batched = 0;
+    
+    for (int b = 0; b < BATCHES; b++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < BATCH; i++) {
+            float power = (float)(i % 100) - 50.0f;
+            nrx_motor_set_power(&left, power);
+            nrx_motor_set_power(&right, -power);
+        }
+        direct += now_ns() - start;
+        nrx_log_drain();
+        
+        start = now_ns();
+        for (int i = 0; i < BATCH; i++) {
+            float power = (float)(i % 100) - 50.0f;
+            nrx_motor_stage_power(&left, power);
+            nrx_motor_stage_power(&right, -power);
+            nrx_actuator_commit();
+        }
+        batched += now_ns() - start;
+        nrx_log_drain();
+    }
+    
+    printf("differential (direct): %8.1f ns/update\n", (double)direct / (BATCH * BATCHES));
+    printf("differential (commit): %8.1f ns/update\n", (double)batched / (BATCH * BATCHES));
+}
+
+int main(void) {
+    FILE *sink = fopen("/dev/null", "w");
+    nrx_log_set_output(sink);
+    
+    nrx_hal_linux_init(NULL);
+    nrx_gpio_init(17, NRX_GPIO_MODE_OUTPUT);
+    printf("HAL benchmark (gpio %s, pwm %s)\n",
+           nrx_hal_linux_gpio_simulated() ? "simulated" : "gpiochip",
+           nrx_hal_linux_pwm_simulated() ? "simulated" : "sysfs");
+    
+    bench_gpio_write();
+    bench_motor_update();
+    
+    fclose(sink);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../runtime/net/json.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ROUNDS 200000
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// A typical drive command, as a generated decoder would read it
+typedef struct {
+    double x, y, theta;
+    float speed;
+    uint64_t seq;
+    int64_t gear;
+    bool armed;
+} command_t;
+
+static const char command[] =
+    "{\"x\": 1.25, \"y\": -3.5, \"theta\": 0.785398, \"speed\": 0.4, "
+    "\"seq\": 123456, \"gear\": 2, \"armed\": true}";
+
+static bool decode(command_t *c, const char *json, size_t len) {
+    static const nrx_json_step_t keys[] = {
+        NRX_JSON_KEY("x"), NRX_JSON_KEY("y"), NRX_JSON_KEY("theta"), NRX_JSON_KEY("speed"),
+        NRX_JSON_KEY("seq"), NRX_JSON_KEY("gear"), NRX_JSON_KEY("armed"),
+    };
+    nrx_json_node_t nodes[NRX_JSON_MESSAGE_NODES(7)];
+    nrx_json_tape_t t;
+    uint32_t at[7];
+    return nrx_json_parse(&t, nodes, NRX_JSON_MESSAGE_NODES(7), json, len) == 0 &&
+           nrx_json_lookup(&t, 0, keys, 7, at) &&
+           nrx_json_get_f64(&t, at[0], &c->x) && nrx_json_get_f64(&t, at[1], &c->y) &&
+           nrx_json_get_f64(&t, at[2], &c->theta) && nrx_json_get_f32(&t, at[3], &c->speed) &&
+           nrx_json_get_u64(&t, at[4], &c->seq) && nrx_json_get_i64(&t, at[5], &c->gear) &&
+           nrx_json_get_bool(&t, at[6], &c->armed);
+}
+
+static void bench_command(void) {
+    command_t c;
+    size_t len = strlen(command);
+    uint64_t start = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        if (!decode(&c, command, len)) {
+            printf("decode failed\n");
+            return;
+        }
+    }
+    uint64_t ns = now_ns() - start;
+    printf("%-22s %8.1f ns/message  (%zu bytes)\n", "command decode", (double)ns / ROUNDS, len);
+}
+
+// A longer document with text, to time the block scan
+static void bench_document(void) {
+    static char doc[16384];
+    static nrx_json_node_t nodes[2048];
+    size_t n = 0;
+    n += (size_t)sprintf(doc + n, "{\"waypoints\": [");
+    for (int i = 0; i < 100; i++) {
+        n += (size_t)sprintf(doc + n, "%s{\"x\": %d.5, \"y\": -%d.25, \"label\": \"waypoint number %d, \\\"quoted\\\"\"}",
+                             i ? ", " : "", i, i, i);
+    }
+    n += (size_t)sprintf(doc + n, "]}");
+    
+    nrx_json_tape_t t;
+    int rounds = ROUNDS / 100;
+    uint64_t start = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        if (nrx_json_parse(&t, nodes, 2048, doc, n) != 0) {
+            printf("parse failed\n");
+            return;
+        }
+    }
+    uint64_t ns = now_ns() - start;
+    double bytes = (double)n * rounds;
+    printf("%-22s %8.1f ns/doc      %6.0f MB/s  (%zu bytes)\n", "document parse", (double)ns / rounds,
+           bytes * 1e3 / (double)ns, n);
+}
+
+int main(void) {
+#if defined(NRX_JSON_NO_SIMD) || !defined(__SSE2__)
+    printf("JSON benchmark (plain C scan)\n");
+#else
+    printf("JSON benchmark (SSE2 scan)\n");
+#endif
+    
+    bench_command();
+    bench_document();
+    return 0;
+}
@@ -0,0 +1,372 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../runtime/swarm/spatial.h"
+#include "../runtime/swarm/swarm.h"
+#include "../runtime/swarm/assign.h"
+#include "../runtime/swarm/coverage.h"
+#include "../runtime/swarm/sim_net.h"
+#include "../runtime/core/scheduler.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TICKS 20
+#define RADIUS 3.0f
+#define DENSITY 0.05f       // Robots per square meter
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static float frand(float lo, float hi) {
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+static void count_hit(uint32_t item, float x, float y, float dist_sq, void *ctx) {
+    (void)item; (void)x; (void)y; (void)dist_sq;
+    (*(size_t *)ctx)++;
+}
+
+// One tick: every robot moves, then every robot asks for its neighbors
+static void bench_fleet(size_t n) {
+    float side = sqrtf((float)n / DENSITY);
+    float *x = malloc(n * sizeof(float)), *y = malloc(n * sizeof(float));
+    float *vx = malloc(n * sizeof(float)), *vy = malloc(n * sizeof(float));
+    float *x0 = malloc(n * sizeof(float)), *y0 = malloc(n * sizeof(float));
+    nrx_spatial_grid_t *grid = nrx_spatial_create(n, RADIUS);
+    srand(1);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = frand(0.0f, side);
+        y[i] = frand(0.0f, side);
+        vx[i] = frand(-0.5f, 0.5f);
+        vy[i] = frand(-0.5f, 0.5f);
+        x0[i] = x[i];
+        y0[i] = y[i];
+        nrx_spatial_update(grid, (uint32_t)i, x[i], y[i]);
+    }
+    
+    size_t grid_hits = 0;
+    uint64_t start = now_ns();
+    for (int t = 0; t < TICKS; t++) {
+        for (size_t i = 0; i < n; i++) {
+            x[i] += vx[i];
+            y[i] += vy[i];
+            nrx_spatial_update(grid, (uint32_t)i, x[i], y[i]);
+        }
+        for (size_t i = 0; i < n; i++) nrx_spatial_query(grid, x[i], y[i], RADIUS, count_hit, &grid_hits);
+    }
+    double grid_ns = (double)(now_ns() - start) / TICKS;
+    
+    // The same ticks again, scanning every pair
+    for (size_t i = 0; i < n; i++) {
+        x[i] = x0[i];
+        y[i] = y0[i];
+    }
+    size_t scan_hits = 0;
+    start = now_ns();
+    for (int t = 0; t < TICKS; t++) {
+        for (size_t i = 0; i < n; i++) {
+            x[i] += vx[i];
+            y[i] += vy[i];
+        }
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                float dx = x[j] - x[i], dy = y[j] - y[i];
+                if (dx * dx + dy * dy <= RADIUS * RADIUS) scan_hits++;
+            }
+        }
+    }
+    double scan_ns = (double)(now_ns() - start) / TICKS;
+    
+    printf("%6zu robots  grid %9.1f us/tick  scan %10.1f us/tick  %6.1fx  (%.1f neighbors)%s\n",
+           n, grid_ns / 1e3, scan_ns / 1e3, scan_ns / grid_ns, (double)grid_hits / TICKS / n - 1.0,
+           grid_hits == scan_hits ? "" : "  MISMATCH");
+    
+    nrx_spatial_destroy(grid);
+    free(x);
+    free(y);
+    free(vx);
+    free(vy);
+    free(x0);
+    free(y0);
+}
+
+// Pose traffic: robots wander at 1.5 m/s, changing their turn rate every
+// few seconds, and report poses at 50 Hz to one watcher
+#define FLEET 100
+#define SECONDS 60
+#define RATE_HZ 50
+
+static int to_watcher(const nrx_swarm_message_t *msg, void *ctx) {
+    nrx_swarm_receive(ctx, msg);
+    return 0;
+}
+
+static void bench_traffic(float threshold) {
+    nrx_time_set_virtual(true, 1000000);
+    nrx_swarm_config_t config = { .robot_id = 1000, .max_robots = FLEET + 1 };
+    nrx_swarm_t *watcher = nrx_swarm_init(&config);
+    
+    static nrx_swarm_t *robots[FLEET];
+    static float x[FLEET], y[FLEET], heading[FLEET], turn[FLEET];
+    srand(3);
+    for (int i = 0; i < FLEET; i++) {
+        config = (nrx_swarm_config_t){ .robot_id = (uint32_t)i + 1, .pose_threshold = threshold,
+                                       .transport = to_watcher, .transport_ctx = watcher };
+        robots[i] = nrx_swarm_init(&config);
+        x[i] = frand(0.0f, 100.0f);
+        y[i] = frand(0.0f, 100.0f);
+        heading[i] = frand(-3.14f, 3.14f);
+        turn[i] = 0.0f;
+    }
+    
+    double err_sum = 0.0;
+    float err_max = 0.0f;
+    size_t samples = 0;
+    float dt = 1.0f / RATE_HZ;
+    for (int tick = 0; tick < SECONDS * RATE_HZ; tick++) {
+        for (int i = 0; i < FLEET; i++) {
+            if (rand() % (3 * RATE_HZ) == 0) turn[i] = frand(-0.8f, 0.8f);
+            heading[i] += turn[i] * dt;
+            x[i] += cosf(heading[i]) * 1.5f * dt;
+            y[i] += sinf(heading[i]) * 1.5f * dt;
+            nrx_robot_pose_t pose = { .x = x[i], .y = y[i], .heading = heading[i] };
+            nrx_swarm_update_pose(robots[i], &pose);
+            
+            nrx_robot_pose_t seen;
+            if (tick > RATE_HZ && nrx_swarm_get_pose(watcher, (uint32_t)i + 1, &seen) == 0) {
+                float err = hypotf(seen.x - x[i], seen.y - y[i]);
+                err_sum += err;
+                if (err > err_max) err_max = err;
+                samples++;
+            }
+        }
+        nrx_time_advance_us(1000000 / RATE_HZ);
+    }
+    
+    nrx_swarm_stats_t stats;
+    nrx_swarm_get_stats(watcher, &stats);
+    double bytes = (double)stats.bytes_received / FLEET / SECONDS;
+    printf("threshold %.2f m  %5.1f msg/s  %6.1f B/s per robot (%4.1fx less)  error mean %.3f max %.3f m\n",
+           threshold, (double)stats.messages_received / FLEET / SECONDS, bytes, 28.0 * RATE_HZ / bytes,
+           err_sum / samples, err_max);
+    
+    for (int i = 0; i < FLEET; i++) nrx_swarm_deinit(robots[i]);
+    nrx_swarm_deinit(watcher);
+    nrx_time_set_virtual(false, 0);
+}
+
+// Task assignment: n robots and n tasks scattered over 100 m, cost by
+// distance
+static void bench_assign(size_t n) {
+    float *cost = malloc(n * n * sizeof(float));
+    int32_t *out = malloc(n * sizeof(int32_t));
+    nrx_assign_t *solver = nrx_assign_create(n, n);
+    srand(4);
+    float *tx = malloc(n * sizeof(float)), *ty = malloc(n * sizeof(float));
+    for (size_t j = 0; j < n; j++) {
+        tx[j] = frand(0.0f, 100.0f);
+        ty[j] = frand(0.0f, 100.0f);
+    }
+    for (size_t i = 0; i < n; i++) {
+        float rx = frand(0.0f, 100.0f), ry = frand(0.0f, 100.0f);
+        for (size_t j = 0; j < n; j++) cost[i * n + j] = hypotf(tx[j] - rx, ty[j] - ry);
+    }
+    
+    int rounds = n <= 30 ? 1000 : n <= 100 ? 50 : n <= 300 ? 3 : 1;
+    double sums[2] = { 0.0, 0.0 }, us[2];
+    for (int solver_kind = 0; solver_kind < 2; solver_kind++) {
+        uint64_t start = now_ns();
+        for (int r = 0; r < rounds; r++) {
+            if (solver_kind == 0) nrx_assign_optimal(solver, cost, n, n, out);
+            else nrx_assign_market(solver, cost, n, n, out);
+        }
+        us[solver_kind] = (double)(now_ns() - start) / rounds / 1e3;
+        for (size_t i = 0; i < n; i++) sums[solver_kind] += cost[i * n + (size_t)out[i]];
+    }
+    printf("%5zu x %-5zu  optimal %10.1f us  market %8.1f us  market cost +%.1f%%\n",
+           n, n, us[0], us[1], 100.0 * (sums[1] / sums[0] - 1.0));
+    
+    nrx_assign_destroy(solver);
+    free(cost);
+    free(out);
+    free(tx);
+    free(ty);
+}
+
+static volatile size_t sink;
+
+// A robot that marks 1.5 cells around it and moves to the nearest
+// frontier cell, against a byte per cell scanned in full for the nearest
+// unvisited one
+static void bench_coverage(size_t side, int steps) {
+    nrx_coverage_area_t area = { 0.0f, (float)side, 0.0f, (float)side, 1.0f };
+    nrx_coverage_grid_t *grid = nrx_coverage_create(&area);
+    float x = side / 2.0f, y = side / 2.0f;
+    int done = 0;
+    uint64_t start = now_ns();
+    for (; done < steps; done++) {
+        nrx_coverage_mark(grid, x, y, 1.5f);
+        if (!nrx_coverage_nearest(grid, x, y, &x, &y)) break;
+    }
+    double step_us = (double)(now_ns() - start) / done / 1e3;
+    
+    size_t cells = side * side;
+    uint8_t *seen = malloc(cells);
+    for (size_t r = 0; r < side; r++) {
+        for (size_t c = 0; c < side; c++) seen[r * side + c] = nrx_coverage_is_visited(grid, c + 0.5f, r + 0.5f);
+    }
+    int scans = 10;
+    size_t found = 0;
+    start = now_ns();
+    for (int i = 0; i < scans; i++) {
+        float best = INFINITY;
+        for (size_t k = 0; k < cells; k++) {
+            if (seen[k]) continue;
+            float dx = (float)(k % side) + 0.5f - x, dy = (float)(k / side) + 0.5f - y;
+            if (dx * dx + dy * dy < best) {
+                best = dx * dx + dy * dy;
+                found = k;
+            }
+        }
+    }
+    double scan_us = (double)(now_ns() - start) / scans / 1e3;
+    sink = found;
+    printf("%5zu^2 cells %7.2f MB  step %6.2f us (%d steps, %.1f%% covered)  byte-grid scan %9.1f us\n",
+           side, cells / 4.0 / 1e6, step_us, done,
+           100.0 * nrx_coverage_visited_count(grid) / nrx_coverage_cell_count(grid), scan_us);
+    free(seen);
+    nrx_coverage_destroy(grid);
+}
+
+// Consensus: five robots on a simulated network with 1-1.5 ms latency
+#define MEMBERS 5
+
+static const uint32_t member_ids[MEMBERS] = { 1, 2, 3, 4, 5 };
+
+static nrx_sim_net_t *start_group(nrx_swarm_t **robots, size_t batch, size_t inflight, uint64_t seed) {
+    nrx_sim_net_config_t net_config = { .latency_us = 1000, .jitter_us = 500, .seed = seed };
+    nrx_sim_net_t *net = nrx_sim_net_create(&net_config);
+    for (int i = 0; i < MEMBERS; i++) {
+        nrx_swarm_config_t config = {
+            .robot_id = member_ids[i],
+            .transport = nrx_sim_net_transport,
+            .transport_ctx = net,
+            .consensus_members = member_ids,
+            .consensus_member_count = MEMBERS,
+            .consensus_max_batch = batch,
+            .consensus_max_inflight = inflight,
+        };
+        robots[i] = nrx_swarm_init(&config);
+        nrx_sim_net_attach(net, member_ids[i], robots[i]);
+    }
+    return net;
+}
+
+static void stop_group(nrx_sim_net_t *net, nrx_swarm_t **robots) {
+    for (int i = 0; i < MEMBERS; i++) nrx_swarm_deinit(robots[i]);
+    nrx_sim_net_destroy(net);
+    nrx_time_set_virtual(false, 0);
+}
+
+static int find_leader(nrx_swarm_t **robots, int skip) {
+    for (int i = 0; i < MEMBERS; i++) {
+        if (i != skip && nrx_swarm_is_leader(robots[i])) return i;
+    }
+    return -1;
+}
+
+// The leader proposes all the log will take, each millisecond, for two
+// seconds of virtual time
+static void bench_consensus_throughput(size_t batch, size_t inflight) {
+    nrx_swarm_t *robots[MEMBERS];
+    nrx_time_set_virtual(true, 1000000);
+    nrx_sim_net_t *net = start_group(robots, batch, inflight, 1);
+    int lead;
+    while ((lead = find_leader(robots, -1)) < 0) nrx_sim_net_run(net, 10000, 1000);
+    
+    nrx_sim_net_stats_t before, after;
+    nrx_sim_net_get_stats(net, &before);
+    float next = 1.0f, committed = 0.0f;
+    uint64_t start = now_ns();
+    for (int ms = 0; ms < 2000; ms++) {
+        for (int k = 0; k < 256 && nrx_swarm_consensus_propose(robots[lead], next) == 0; k++) next += 1.0f;
+        nrx_sim_net_run(net, 1000, 1000);
+    }
+    double cpu_us = (double)(now_ns() - start) / 1e3;
+    nrx_swarm_consensus_get_result(robots[lead], &committed);
+    nrx_sim_net_get_stats(net, &after);
+    printf("batch %2zu, %zu in flight  %8.0f commits/s  %6.2f messages/commit  %5.2f us CPU/commit\n",
+           batch, inflight, committed / 2.0, (double)(after.sent - before.sent) / committed, cpu_us / committed);
+    stop_group(net, robots);
+}
+
+// The leader crashes at a different point of its heartbeat each time
+static void bench_failover(int trials) {
+    double elect_sum = 0.0, elect_max = 0.0, commit_sum = 0.0, commit_max = 0.0;
+    for (int t = 0; t < trials; t++) {
+        nrx_swarm_t *robots[MEMBERS];
+        nrx_time_set_virtual(true, 1000000);
+        nrx_sim_net_t *net = start_group(robots, 0, 0, (uint64_t)t + 1);
+        nrx_sim_net_run(net, 1000000 + 7000ULL * t, 1000);
+        int lead = find_leader(robots, -1);
+        if (lead < 0) {
+            stop_group(net, robots);
+            continue;
+        }
+        
+        nrx_sim_net_detach(net, member_ids[lead]);
+        uint64_t crash = nrx_time_now_us();
+        int next;
+        while ((next = find_leader(robots, lead)) < 0) nrx_sim_net_run(net, 1000, 1000);
+        double elected = (nrx_time_now_us() - crash) / 1e3;
+        
+        float value = 1000.0f + t, result = 0.0f;
+        nrx_swarm_consensus_propose(robots[next], value);
+        while (nrx_swarm_consensus_get_result(robots[next], &result) != 0 || result != value) {
+            nrx_sim_net_run(net, 1000, 1000);
+        }
+        double committed = (nrx_time_now_us() - crash) / 1e3;
+        
+        elect_sum += elected;
+        commit_sum += committed;
+        if (elected > elect_max) elect_max = elected;
+        if (committed > commit_max) commit_max = committed;
+        stop_group(net, robots);
+    }
+    printf("leader crash (%d runs)  new leader %.0f ms mean, %.0f ms worst  first commit %.0f ms mean, %.0f ms worst\n",
+           trials, elect_sum / trials, elect_max, commit_sum / trials, commit_max);
+}
+
+int main(void) {
+    printf("Swarm neighbor benchmark (radius %.0f m, %.2f robots/m^2)\n", RADIUS, DENSITY);
+    
+    static const size_t fleets[] = { 100, 1000, 5000, 20000 };
+    for (size_t i = 0; i < sizeof(fleets) / sizeof(fleets[0]); i++) bench_fleet(fleets[i]);
+    
+    printf("\nPose traffic (%d robots at %d Hz, against 28-byte poses at %d B/s)\n",
+           FLEET, RATE_HZ, 28 * RATE_HZ);
+    bench_traffic(0.02f);
+    bench_traffic(0.05f);
+    bench_traffic(0.10f);
+    
+    printf("\nTask assignment (robots x tasks, 100 m square)\n");
+    static const size_t sizes[] = { 10, 30, 100, 300, 1000 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) bench_assign(sizes[i]);
+    
+    printf("\nCoverage (mark and next target per step, 1 m cells)\n");
+    bench_coverage(200, 1000000);
+    bench_coverage(1000, 200000);
+    bench_coverage(4000, 200000);
+    
+    printf("\nConsensus (%d robots, 1-1.5 ms one way, 150 ms election timeout)\n", MEMBERS);
+    bench_consensus_throughput(1, 1);
+    bench_consensus_throughput(32, 1);
+    bench_consensus_throughput(32, 4);
+    bench_consensus_throughput(64, 8);
+    bench_failover(20);
+    return 0;
+}
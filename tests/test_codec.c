@@ -0,0 +1,174 @@
+#include "../runtime/net/codec.h"
+#include "../runtime/net/json.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Pose, generated by neuroxc from codec_fixture.neuro
+#include "codec_fixture.h"
+
+static const char *json(void (*put)(nrx_codec_writer_t *, double), double v) {
+    static char text[64];
+    nrx_codec_writer_t w = nrx_codec_writer((uint8_t *)text, sizeof(text) - 1);
+    put(&w, v);
+    text[nrx_codec_end(&w)] = '\0';
+    return text;
+}
+
+static void put_f32(nrx_codec_writer_t *w, double v) {
+    nrx_json_f32(w, (float)v);
+}
+
+static void put_f64(nrx_codec_writer_t *w, double v) {
+    nrx_json_f64(w, v);
+}
+
+static void put_int(nrx_codec_writer_t *w, double v) {
+    nrx_json_int(w, (int64_t)v);
+}
+
+void test_cbor() {
+    uint8_t buf[16];
+    nrx_codec_writer_t w;
+    
+    // Integers in their shortest form
+    static const struct {
+        int64_t value;
+        uint8_t bytes[9];
+        size_t len;
+    } ints[] = {
+        { 0, { 0x00 }, 1 },
+        { 23, { 0x17 }, 1 },
+        { 24, { 0x18, 0x18 }, 2 },
+        { 256, { 0x19, 0x01, 0x00 }, 3 },
+        { 100000, { 0x1A, 0x00, 0x01, 0x86, 0xA0 }, 5 },
+        { 5000000000LL, { 0x1B, 0x00, 0x00, 0x00, 0x01, 0x2A, 0x05, 0xF2, 0x00 }, 9 },
+        { -1, { 0x20 }, 1 },
+        { -500, { 0x39, 0x01, 0xF3 }, 3 },
+    };
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        w = nrx_codec_writer(buf, sizeof(buf));
+        nrx_cbor_int(&w, ints[i].value);
+        assert(nrx_codec_end(&w) == ints[i].len);
+        assert(memcmp(buf, ints[i].bytes, ints[i].len) == 0);
+    }
+    
+    // Floats at their declared width
+    w = nrx_codec_writer(buf, sizeof(buf));
+    nrx_cbor_f32(&w, 1.5f);
+    nrx_cbor_f64(&w, -2.0);
+    assert(nrx_codec_end(&w) == 14);
+    assert(memcmp(buf, "\xfa\x3f\xc0\x00\x00\xfb\xc0\x00\x00\x00\x00\x00\x00\x00", 14) == 0);
+    
+    // A whole message
+    Pose pose = { 1.5f, -2.0f, 1000, true };
+    uint8_t packet[64];
+    size_t len = Pose_encode_cbor(&pose, packet, sizeof(packet));
+    static const uint8_t expected[] = {
+        0xA4,
+        0x61, 'x', 0xFA, 0x3F, 0xC0, 0x00, 0x00,
+        0x61, 'y', 0xFA, 0xC0, 0x00, 0x00, 0x00,
+        0x65, 's', 't', 'a', 'm', 'p', 0x19, 0x03, 0xE8,
+        0x66, 'm', 'o', 'v', 'i', 'n', 'g', 0xF5,
+    };
+    assert(len == sizeof(expected) && memcmp(packet, expected, len) == 0);
+    
+    // Nothing half-written counts
+    assert(Pose_encode_cbor(&pose, packet, len - 1) == 0);
+    
+    printf("✓ CBOR test passed\n");
+}
+
+void test_fixed_layout() {
+    Pose pose = { 0.25f, 1e6f, 0x0102030405060708ULL, true };
+    uint8_t packet[Pose_BINARY_SIZE];
+    assert(Pose_encode_binary(&pose, packet, sizeof(packet)) == Pose_BINARY_SIZE);
+    assert(packet[8] == 0x08 && packet[15] == 0x01 && packet[16] == 1);
+    
+    Pose back;
+    assert(Pose_decode_binary(&back, packet, sizeof(packet)));
+    assert(back.x == pose.x && back.y == pose.y && back.stamp == pose.stamp && back.moving);
+    assert(!Pose_decode_binary(&back, packet, sizeof(packet) - 1));
+    assert(Pose_encode_binary(&pose, packet, sizeof(packet) - 1) == 0);
+    
+    printf("✓ Fixed layout test passed\n");
+}
+
+void test_json() {
+    assert(strcmp(json(put_int, 0), "0") == 0);
+    assert(strcmp(json(put_int, -42), "-42") == 0);
+    assert(strcmp(json(put_f32, 0.0), "0") == 0);
+    assert(strcmp(json(put_f32, 0.1), "0.1") == 0);
+    assert(strcmp(json(put_f32, -0.5), "-0.5") == 0);
+    assert(strcmp(json(put_f32, 1.25), "1.25") == 0);
+    assert(strcmp(json(put_f32, 100.0), "100") == 0);
+    assert(strcmp(json(put_f32, 3.0625), "3.0625") == 0);
+    assert(strcmp(json(put_f32, 0.004), "0.004") == 0);
+    assert(strcmp(json(put_f64, 1234.000000001), "1234.000000001") == 0);
+    assert(strcmp(json(put_f32, NAN), "null") == 0);
+    assert(strcmp(json(put_f64, -INFINITY), "null") == 0);
+    
+    // Outside the fixed-point range: exponent notation, still a JSON number
+    double back;
+    assert(sscanf(json(put_f32, 2.5e-5), "%lf", &back) == 1 && fabs(back - 2.5e-5) < 1e-12);
+    assert(strchr(json(put_f64, 3e20), 'e') != NULL);
+    
+    char text[32];
+    nrx_codec_writer_t w = nrx_codec_writer((uint8_t *)text, sizeof(text));
+    nrx_json_int(&w, INT64_MIN);
+    assert(nrx_codec_end(&w) == 20 && memcmp(text, "-9223372036854775808", 20) == 0);
+    w = nrx_codec_writer((uint8_t *)text, sizeof(text));
+    nrx_json_uint(&w, UINT64_MAX);
+    assert(nrx_codec_end(&w) == 20 && memcmp(text, "18446744073709551615", 20) == 0);
+    
+    Pose pose = { 1.5f, -0.25f, 42, false };
+    char packet[64];
+    size_t len = Pose_encode_json(&pose, (uint8_t *)packet, sizeof(packet) - 1);
+    packet[len] = '\0';
+    assert(strcmp(packet, "{\"x\":1.5,\"y\":-0.25,\"stamp\":42,\"moving\":false}") == 0);
+    assert(Pose_encode_json(&pose, (uint8_t *)packet, len - 1) == 0);
+    
+    printf("✓ JSON test passed\n");
+}
+
+void test_json_decode() {
+    Pose pose = { 1.5f, -0.25f, 1234567890123ULL, true };
+    uint8_t packet[96];
+    size_t len = Pose_encode_json(&pose, packet, sizeof(packet));
+    Pose back = { 0 };
+    assert(Pose_decode_json(&back, packet, len));
+    assert(back.x == pose.x && back.y == pose.y && back.stamp == pose.stamp && back.moving);
+    
+    // Any member order, unknown members skipped, every field required
+    const char *reordered = "{\"moving\": false, \"extra\": [1, {\"a\": null}], \"stamp\": 7, \"y\": 2, \"x\": 0.5}";
+    assert(Pose_decode_json(&back, (const uint8_t *)reordered, strlen(reordered)));
+    assert(back.x == 0.5f && back.y == 2.0f && back.stamp == 7 && !back.moving);
+    
+    static const char *rejected[] = {
+        "{\"x\": 1, \"y\": 2, \"stamp\": 3}",
+        "{\"x\": 1, \"y\": 2, \"stamp\": -3, \"moving\": true}",
+        "{\"x\": 1, \"y\": 2, \"stamp\": 3.5, \"moving\": true}",
+        "{\"x\": \"1\", \"y\": 2, \"stamp\": 3, \"moving\": true}",
+        "{\"x\": 1, \"y\": 2, \"stamp\": 3, \"moving\": 1}",
+        "{\"x\": 1, \"y\": 2, \"stamp\": 3, \"moving\": true",
+        "[1, 2, 3, true]",
+    };
+    for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+        assert(!Pose_decode_json(&back, (const uint8_t *)rejected[i], strlen(rejected[i])));
+    }
+    
+    printf("✓ JSON decode test passed\n");
+}
+
+int main() {
+    printf("Running codec tests...\n\n");
+    
+    test_cbor();
+    test_fixed_layout();
+    test_json();
+    test_json_decode();
+    
+    printf("\n✓ All codec tests passed!\n");
+    return 0;
+}
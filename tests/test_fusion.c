@@ -0,0 +1,285 @@
+#define _DEFAULT_SOURCE
+
+#include "../runtime/core/fusion.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#define DT 0.01f
+
+// Gravity seen by a sensor rolled by `roll` and pitched by `pitch`
+static void gravity(float roll, float pitch, float accel[3]) {
+    accel[0] = -sinf(pitch);
+    accel[1] = sinf(roll) * cosf(pitch);
+    accel[2] = cosf(roll) * cosf(pitch);
+}
+
+void test_q16_math() {
+    for (float x = -3.0f; x <= 3.0f; x += 0.05f) {
+        nrx_q16_t q = NRX_Q16(x);
+        assert(fabsf(NRX_Q16_TO_FLOAT(nrx_q16_sin(q)) - sinf(x)) < 1e-3f);
+        assert(fabsf(NRX_Q16_TO_FLOAT(nrx_q16_cos(q)) - cosf(x)) < 1e-3f);
+        assert(fabsf(NRX_Q16_TO_FLOAT(nrx_q16_atan2(q, NRX_Q16(0.7f))) - atan2f(x, 0.7f)) < 3e-3f);
+        assert(fabsf(NRX_Q16_TO_FLOAT(nrx_q16_atan2(NRX_Q16(-0.4f), q)) - atan2f(-0.4f, x)) < 3e-3f);
+    }
+    
+    assert(nrx_q16_mul(NRX_Q16(1.5f), NRX_Q16(-2.0f)) == NRX_Q16(-3.0f));
+    assert(nrx_q16_div(NRX_Q16(3.0f), NRX_Q16(4.0f)) == NRX_Q16(0.75f));
+    assert(nrx_q16_div(NRX_Q16(1.0f), 0) == INT32_MAX);
+    assert(nrx_q16_sqrt(NRX_Q16(2.25f)) == NRX_Q16(1.5f));
+    assert(nrx_q16_sqrt(-1) == 0);
+    
+    printf("✓ Q16 math test passed\n");
+}
+
+void test_complementary() {
+    const float gyro[3] = {0};
+    float accel[3];
+    gravity(0.3f, -0.2f, accel);
+    
+    nrx_complementary_t filter;
+    nrx_complementary_init(&filter, 0.98f);
+    
+    // Primes straight from the accelerometer, then holds with a still gyro
+    for (int i = 0; i < 100; i++) {
+        nrx_complementary_update(&filter, gyro, accel, DT);
+    }
+    assert(fabsf(filter.roll - 0.3f) < 1e-4f);
+    assert(fabsf(filter.pitch + 0.2f) < 1e-4f);
+    
+    // A gyro bias is bounded by the accelerometer pull: alpha/(1-alpha) * bias * dt
+    const float biased[3] = { 0.1f, 0.0f, 0.5f };
+    for (int i = 0; i < 1000; i++) {
+        nrx_complementary_update(&filter, biased, accel, DT);
+    }
+    assert(fabsf(filter.roll - 0.3f) < 0.06f);
+    assert(fabsf(filter.yaw - (5.0f - 2.0f * (float)M_PI)) < 1e-3f);
+    
+    printf("✓ Complementary filter test passed\n");
+}
+
+void test_madgwick_converges() {
+    const float gyro[3] = {0};
+    float accel[3];
+    gravity(-0.5f, 0.25f, accel);
+    
+    nrx_madgwick_t filter;
+    nrx_madgwick_init(&filter, 0.1f);
+    for (int i = 0; i < 3000; i++) {
+        nrx_madgwick_update(&filter, gyro, accel, DT);
+    }
+    
+    float roll, pitch, yaw;
+    nrx_quat_to_euler(&filter.q, &roll, &pitch, &yaw);
+    assert(fabsf(roll + 0.5f) < 0.01f);
+    assert(fabsf(pitch - 0.25f) < 0.01f);
+    
+    // Pure rotation about z integrates into yaw
+    const float spin[3] = { 0.0f, 0.0f, 0.2f };
+    const float level[3] = { 0.0f, 0.0f, 1.0f };
+    nrx_madgwick_init(&filter, 0.1f);
+    for (int i = 0; i < 500; i++) {
+        nrx_madgwick_update(&filter, spin, level, DT);
+    }
+    nrx_quat_to_euler(&filter.q, NULL, NULL, &yaw);
+    assert(fabsf(yaw - 1.0f) < 0.01f);
+    
+    // A zero accelerometer reading falls back to the gyro
+    const float none[3] = {0};
+    nrx_madgwick_update(&filter, spin, none, DT);
+    assert(isfinite(filter.q.w));
+    
+    printf("✓ Madgwick filter test passed\n");
+}
+
+void test_ekf() {
+    nrx_ekf_t ekf;
+    nrx_ekf_init(&ekf, 0.01f, 0.005f, 0.05f);
+    
+    // Drive a quarter circle: uncertainty grows while dead reckoning
+    for (int i = 0; i < 100; i++) {
+        nrx_ekf_predict(&ekf, 1.0f, (float)M_PI / 2.0f, DT);
+    }
+    float grown = ekf.p22;
+    assert(fabsf(ekf.theta - (float)M_PI / 2.0f) < 1e-4f);
+    assert(fabsf(ekf.x - 2.0f / (float)M_PI) < 0.01f);
+    assert(fabsf(ekf.y - 2.0f / (float)M_PI) < 0.01f);
+    assert(ekf.p00 > 0.0f && ekf.p11 > 0.0f);
+    
+    // Heading fixes pull theta in and shrink its variance
+    for (int i = 0; i < 200; i++) {
+        nrx_ekf_update_heading(&ekf, 1.5f);
+    }
+    assert(fabsf(ekf.theta - 1.5f) < 0.01f);
+    assert(ekf.p22 < grown);
+    assert(ekf.p00 * ekf.p11 >= ekf.p01 * ekf.p01);
+    
+    // Innovation wraps: a fix just across +-pi is a small correction
+    nrx_ekf_init(&ekf, 0.01f, 0.005f, 0.05f);
+    ekf.theta = 3.1f;
+    ekf.p22 = 0.1f;
+    nrx_ekf_update_heading(&ekf, -3.1f);
+    assert(fabsf(ekf.theta) > 3.1f);
+    
+    printf("✓ EKF test passed\n");
+}
+
+// Each lane of a batched kernel tracks the scalar reference
+void test_lanes_match_scalar() {
+    nrx_imu4_t imu;
+    nrx_complementary_t comp[NRX_FUSION_LANES];
+    nrx_madgwick_t madg[NRX_FUSION_LANES];
+    nrx_ekf_t ekf[NRX_FUSION_LANES];
+    nrx_complementary4_t comp4;
+    nrx_madgwick4_t madg4;
+    nrx_ekf4_t ekf4;
+    
+    nrx_complementary4_init(&comp4, 0.98f);
+    nrx_madgwick4_init(&madg4, 0.1f);
+    nrx_ekf4_init(&ekf4, 0.01f, 0.005f, 0.05f);
+    for (int l = 0; l < NRX_FUSION_LANES; l++) {
+        nrx_complementary_init(&comp[l], 0.98f);
+        nrx_madgwick_init(&madg[l], 0.1f);
+        nrx_ekf_init(&ekf[l], 0.01f, 0.005f, 0.05f);
+    }
+    
+    for (int i = 0; i < 500; i++) {
+        float v[NRX_FUSION_LANES], omega[NRX_FUSION_LANES], heading[NRX_FUSION_LANES];
+        for (int l = 0; l < NRX_FUSION_LANES; l++) {
+            float t = (float)i * DT;
+            float gyro[3] = { 0.3f * cosf(t + l), -0.2f * sinf(2.0f * t), 0.1f * (float)(l + 1) };
+            float accel[3];
+            gravity(0.4f * sinf(t + l), 0.3f * cosf(t * (float)(l + 1)), accel);
+            
+            imu.gx[l] = gyro[0]; imu.gy[l] = gyro[1]; imu.gz[l] = gyro[2];
+            imu.ax[l] = accel[0]; imu.ay[l] = accel[1]; imu.az[l] = accel[2];
+            nrx_complementary_update(&comp[l], gyro, accel, DT);
+            nrx_madgwick_update(&madg[l], gyro, accel, DT);
+            
+            v[l] = 0.5f * (float)(l + 1);
+            omega[l] = 0.7f - 0.4f * (float)l;
+            heading[l] = ekf[l].theta + 0.01f;
+            nrx_ekf_predict(&ekf[l], v[l], omega[l], DT);
+            if (i % 10 == 0) nrx_ekf_update_heading(&ekf[l], heading[l]);
+        }
+        nrx_complementary4_update(&comp4, &imu, DT);
+        nrx_madgwick4_update(&madg4, &imu, DT);
+        nrx_ekf4_predict(&ekf4, v, omega, DT);
+        if (i % 10 == 0) nrx_ekf4_update_heading(&ekf4, heading);
+    }
+    
+    for (int l = 0; l < NRX_FUSION_LANES; l++) {
+        // The batched atan2 is a polynomial (error ~0.0015 rad)
+        assert(fabsf(comp4.roll[l] - comp[l].roll) < 3e-3f);
+        assert(fabsf(comp4.pitch[l] - comp[l].pitch) < 3e-3f);
+        assert(fabsf(comp4.yaw[l] - comp[l].yaw) < 1e-3f);
+        
+        assert(fabsf(madg4.qw[l] - madg[l].q.w) < 1e-4f);
+        assert(fabsf(madg4.qx[l] - madg[l].q.x) < 1e-4f);
+        assert(fabsf(madg4.qy[l] - madg[l].q.y) < 1e-4f);
+        assert(fabsf(madg4.qz[l] - madg[l].q.z) < 1e-4f);
+        
+        assert(fabsf(ekf4.x[l] - ekf[l].x) < 1e-3f);
+        assert(fabsf(ekf4.y[l] - ekf[l].y) < 1e-3f);
+        assert(fabsf(ekf4.theta[l] - ekf[l].theta) < 1e-3f);
+        assert(fabsf(ekf4.p00[l] - ekf[l].p00) < 1e-4f);
+        assert(fabsf(ekf4.p22[l] - ekf[l].p22) < 1e-5f);
+    }
+    
+    printf("✓ SIMD lanes match scalar\n");
+}
+
+// The fixed-point kernels track the float reference
+void test_q16_matches_float() {
+    nrx_complementary_t comp;
+    nrx_complementary_q16_t comp_q;
+    nrx_madgwick_t madg;
+    nrx_madgwick_q16_t madg_q;
+    nrx_ekf_t ekf;
+    nrx_ekf_q16_t ekf_q;
+    
+    nrx_complementary_init(&comp, 0.98f);
+    nrx_complementary_q16_init(&comp_q, NRX_Q16(0.98f));
+    nrx_madgwick_init(&madg, 0.1f);
+    nrx_madgwick_q16_init(&madg_q, NRX_Q16(0.1f));
+    nrx_ekf_init(&ekf, 0.01f, 0.005f, 0.05f);
+    nrx_ekf_q16_init(&ekf_q, NRX_Q16(0.01f), NRX_Q16(0.005f), NRX_Q16(0.05f));
+    
+    for (int i = 0; i < 1000; i++) {
+        float t = (float)i * DT;
+        float gyro[3] = { 0.2f * cosf(t), 0.1f, -0.3f * sinf(t) };
+        float accel[3];
+        gravity(0.3f * sinf(t), -0.2f, accel);
+        
+        nrx_q16_t gyro_q[3], accel_q[3];
+        for (int k = 0; k < 3; k++) {
+            gyro_q[k] = NRX_Q16(gyro[k]);
+            accel_q[k] = NRX_Q16(accel[k]);
+        }
+        
+        nrx_complementary_update(&comp, gyro, accel, DT);
+        nrx_complementary_q16_update(&comp_q, gyro_q, accel_q, NRX_Q16(DT));
+        nrx_madgwick_update(&madg, gyro, accel, DT);
+        nrx_madgwick_q16_update(&madg_q, gyro_q, accel_q, NRX_Q16(DT));
+        
+        nrx_ekf_predict(&ekf, 0.8f, 0.4f, DT);
+        nrx_ekf_q16_predict(&ekf_q, NRX_Q16(0.8f), NRX_Q16(0.4f), NRX_Q16(DT));
+        if (i % 20 == 0) {
+            nrx_ekf_update_heading(&ekf, ekf.theta + 0.05f);
+            nrx_ekf_q16_update_heading(&ekf_q, NRX_Q16(ekf.theta + 0.05f));
+        }
+    }
+    
+    assert(fabsf(NRX_Q16_TO_FLOAT(comp_q.roll) - comp.roll) < 0.01f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(comp_q.pitch) - comp.pitch) < 0.01f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(comp_q.yaw) - comp.yaw) < 0.01f);
+    
+    assert(fabsf(NRX_Q16_TO_FLOAT(madg_q.qw) - madg.q.w) < 0.01f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(madg_q.qx) - madg.q.x) < 0.01f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(madg_q.qy) - madg.q.y) < 0.01f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(madg_q.qz) - madg.q.z) < 0.01f);
+    
+    assert(fabsf(NRX_Q16_TO_FLOAT(ekf_q.x) - ekf.x) < 0.02f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(ekf_q.y) - ekf.y) < 0.02f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(ekf_q.theta) - ekf.theta) < 0.01f);
+    assert(fabsf(NRX_Q16_TO_FLOAT(ekf_q.p22) - ekf.p22) < 0.002f);
+    
+    printf("✓ Q16 kernels match float\n");
+}
+
+void test_builtin_types() {
+    nrx_fusion_t imu, odo;
+    nrx_fusion_init(&imu, NRX_FUSION_MADGWICK);
+    nrx_fusion_init(&odo, NRX_FUSION_EKF);
+    
+    const float gyro[3] = { 0.0f, 0.0f, 0.3f };
+    const float accel[3] = { 0.0f, 0.0f, 9.81f };
+    for (int i = 0; i < 100; i++) {
+        nrx_fusion_update_imu(&imu, gyro, accel, DT);
+        nrx_fusion_update_imu(&odo, gyro, accel, DT);       // Ignored
+        nrx_fusion_update_odometry(&odo, 1.0f, 0.3f, DT);
+    }
+    
+    float roll, pitch, yaw;
+    nrx_fusion_get_attitude(&imu, &roll, &pitch, &yaw);
+    assert(fabsf(yaw - 0.3f) < 0.01f);
+    nrx_fusion_get_attitude(&odo, &roll, &pitch, &yaw);
+    assert(fabsf(yaw - 0.3f) < 1e-4f && roll == 0.0f && pitch == 0.0f);
+    
+    printf("✓ Built-in sensor type test passed\n");
+}
+
+int main() {
+    printf("Running sensor fusion tests...\n");
+    
+    test_q16_math();
+    test_complementary();
+    test_madgwick_converges();
+    test_ekf();
+    test_lanes_match_scalar();
+    test_q16_matches_float();
+    test_builtin_types();
+    
+    printf("\n✓ All sensor fusion tests passed!\n");
+    return 0;
+}
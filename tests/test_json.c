@@ -0,0 +1,241 @@
+#include "../runtime/net/json.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static nrx_json_node_t nodes[256];
+static nrx_json_tape_t tape;
+
+static int parse(const char *json) {
+    return nrx_json_parse(&tape, nodes, 256, json, strlen(json));
+}
+
+static uint32_t find(const char *key) {
+    nrx_json_step_t step = { key, (uint32_t)strlen(key) };
+    return nrx_json_find(&tape, 0, &step, 1);
+}
+
+void test_structure() {
+    const char *json = " {\"a\": [1, true, null, {\"b\": \"c\"}], \"d\": {}, \"e\": []} ";
+    assert(parse(json) == 0);
+    assert(tape.count == 13);
+    
+    // Document order, with next skipping over whole values
+    assert(nodes[0].type == NRX_JSON_OBJECT && nodes[0].as.count == 3 && nodes[0].next == 13);
+    assert(nodes[1].type == NRX_JSON_STRING && nodes[1].as.str.len == 1);
+    assert(nodes[2].type == NRX_JSON_ARRAY && nodes[2].as.count == 4 && nodes[2].next == 9);
+    assert(nodes[3].type == NRX_JSON_NUMBER && nodes[3].as.i == 1);
+    assert(nodes[4].type == NRX_JSON_BOOL && nodes[4].as.b);
+    assert(nodes[5].type == NRX_JSON_NULL);
+    assert(nodes[6].type == NRX_JSON_OBJECT && nodes[6].as.count == 1 && nodes[6].next == 9);
+    assert(nodes[10].type == NRX_JSON_OBJECT && nodes[10].as.count == 0 && nodes[10].next == 11);
+    assert(nodes[12].type == NRX_JSON_ARRAY && nodes[12].as.count == 0);
+    
+    // Scalars at the root
+    assert(parse("42") == 0 && tape.count == 1 && nodes[0].as.i == 42);
+    assert(parse(" \"x\" ") == 0 && nodes[0].type == NRX_JSON_STRING);
+    assert(parse("false") == 0 && nodes[0].type == NRX_JSON_BOOL && !nodes[0].as.b);
+    
+    printf("✓ Structure test passed\n");
+}
+
+void test_numbers() {
+    static const struct {
+        const char *text;
+        double value;
+    } floats[] = {
+        { "0.1", 0.1 },
+        { "-2.5", -2.5 },
+        { "1e3", 1000.0 },
+        { "1.5E-3", 0.0015 },
+        { "0.785398", 0.785398 },
+        { "123456.789e-2", 1234.56789 },
+        { "3.141592653589793238462643", 3.141592653589793 },
+        { "1e-300", 1e-300 },
+        { "-0.0", -0.0 },
+        { "12345678901234567890123", 12345678901234567890123.0 },
+    };
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        double v;
+        assert(parse(floats[i].text) == 0);
+        assert(nrx_json_get_f64(&tape, 0, &v) && v == floats[i].value);
+    }
+    
+    int64_t i;
+    uint64_t u;
+    assert(parse("-9223372036854775808") == 0 && nodes[0].flags == NRX_JSON_INT);
+    assert(nrx_json_get_i64(&tape, 0, &i) && i == INT64_MIN);
+    assert(!nrx_json_get_u64(&tape, 0, &u));
+    assert(parse("18446744073709551615") == 0 && nodes[0].flags == NRX_JSON_UINT);
+    assert(nrx_json_get_u64(&tape, 0, &u) && u == UINT64_MAX);
+    assert(!nrx_json_get_i64(&tape, 0, &i));
+    
+    // Integers written as floats still read as integers, fractions do not
+    assert(parse("2.0e2") == 0 && nrx_json_get_i64(&tape, 0, &i) && i == 200);
+    assert(parse("2.5") == 0 && !nrx_json_get_i64(&tape, 0, &i) && !nrx_json_get_u64(&tape, 0, &u));
+    assert(parse("-1") == 0 && !nrx_json_get_u64(&tape, 0, &u));
+    
+    float f;
+    bool b;
+    assert(parse("[0.25, \"1\"]") == 0);
+    assert(nrx_json_get_f32(&tape, 1, &f) && f == 0.25f);
+    assert(!nrx_json_get_f32(&tape, 2, &f) && !nrx_json_get_bool(&tape, 1, &b));
+    assert(parse("[1e300, -1e300, 3.4e38]") == 0);
+    assert(!nrx_json_get_f32(&tape, 1, &f) && !nrx_json_get_f32(&tape, 2, &f));
+    assert(nrx_json_get_f32(&tape, 3, &f) && f == 3.4e38f);
+    
+    printf("✓ Numbers test passed\n");
+}
+
+void test_strings() {
+    char text[64];
+    size_t len;
+    
+    assert(parse("[\"plain\", \"a\\\"b\\\\c\\/d\\n\", \"\\u00e9\\u20AC\\ud83d\\ude00\", \"\xc3\xa9\"]") == 0);
+    assert(!(nodes[1].flags & NRX_JSON_ESCAPED) && (nodes[2].flags & NRX_JSON_ESCAPED));
+    assert(nrx_json_get_string(&tape, 1, text, sizeof(text), &len) && len == 5 && strcmp(text, "plain") == 0);
+    assert(nrx_json_get_string(&tape, 2, text, sizeof(text), &len) && strcmp(text, "a\"b\\c/d\n") == 0);
+    assert(nrx_json_get_string(&tape, 3, text, sizeof(text), &len) && strcmp(text, "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80") == 0);
+    assert(nrx_json_get_string(&tape, 4, text, sizeof(text), &len) && strcmp(text, "\xc3\xa9") == 0);
+    
+    // Too small for the text and its terminator
+    assert(!nrx_json_get_string(&tape, 1, text, 5, &len));
+    assert(nrx_json_get_string(&tape, 1, text, 6, &len));
+    
+    // Structural characters inside strings are just text
+    assert(parse("{\"k\": \"{[,:]}\"}") == 0 && tape.count == 3);
+    
+    printf("✓ Strings test passed\n");
+}
+
+void test_invalid() {
+    static const char *bad[] = {
+        "", " ", "{", "}", "[1,]", "[,1]", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{a:1}",
+        "[1 2]", "1 2", "[1]]", "{\"a\":1]", "tru", "truex", "nul", "01", "-", "1.", ".5",
+        "1e", "+1", "0x10", "[\"a\"\"b\"]", "\"abc", "\"\\x\"", "\"\\u12G4\"", "\"\\ud800\"",
+        "\"\\udc00\"", "\"\\ud800\\u0041\"", "\"tab\there\"", "\"\xc3\"", "\"\xc0\x80\"",
+        "\"\xed\xa0\x80\"", "\"\xf4\x90\x80\x80\"", "[1]\xc3\xa9", "{\"a\" 1}", "[1:2]",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (parse(bad[i]) != -1) {
+            printf("accepted: %s\n", bad[i]);
+            assert(0);
+        }
+    }
+    
+    // Where the problem is
+    assert(parse("{\"a\": 1, \"b\" 2}") == -1 && tape.error_at == 13);
+    assert(parse("[\"ok\", \"x\ny\"]") == -1 && tape.error_at == 9);
+    
+    // Nesting and tape size are bounded
+    char deep[2 * NRX_JSON_MAX_DEPTH + 3];
+    for (int n = NRX_JSON_MAX_DEPTH; n <= NRX_JSON_MAX_DEPTH + 1; n++) {
+        memset(deep, '[', (size_t)n);
+        memset(deep + n, ']', (size_t)n);
+        deep[2 * n] = '\0';
+        assert(parse(deep) == (n <= NRX_JSON_MAX_DEPTH ? 0 : -1));
+    }
+    assert(nrx_json_parse(&tape, nodes, 2, "[1,2]", 5) == -1);
+    assert(nrx_json_parse(&tape, nodes, 3, "[1,2", 4) == -1);
+    assert(nrx_json_parse(&tape, nodes, 3, "[1,\"x\"]", 7) == 0);
+    
+    printf("✓ Invalid input test passed\n");
+}
+
+// Strings with runs of backslashes and quotes placed across 64-byte blocks
+void test_block_edges() {
+    char json[256], expected[256], text[256];
+    for (int pad = 0; pad < 70; pad++) {
+        for (int run = 1; run <= 5; run++) {
+            // ["<pad x's><run escaped backslashes>\"", 7]
+            size_t n = 0, e = 0;
+            json[n++] = '[';
+            json[n++] = '"';
+            for (int i = 0; i < pad; i++) json[n++] = expected[e++] = 'x';
+            for (int i = 0; i < run; i++) {
+                json[n++] = '\\';
+                json[n++] = '\\';
+                expected[e++] = '\\';
+            }
+            json[n++] = '\\';
+            json[n++] = '"';
+            expected[e++] = '"';
+            expected[e] = '\0';
+            n += (size_t)sprintf(json + n, "\", 7]");
+            
+            size_t len;
+            int64_t seven;
+            assert(nrx_json_parse(&tape, nodes, 256, json, n) == 0);
+            assert(tape.count == 3 && nodes[0].as.count == 2);
+            assert(nrx_json_get_string(&tape, 1, text, sizeof(text), &len) && strcmp(text, expected) == 0);
+            assert(nrx_json_get_i64(&tape, 2, &seven) && seven == 7);
+        }
+    }
+    
+    // Numbers and literals that straddle a block boundary
+    for (int pad = 50; pad < 70; pad++) {
+        char doc[128];
+        int n = sprintf(doc, "[%*s-12.5e1, true]", pad, "");
+        double v;
+        bool b;
+        assert(nrx_json_parse(&tape, nodes, 256, doc, (size_t)n) == 0);
+        assert(nrx_json_get_f64(&tape, 1, &v) && v == -125.0);
+        assert(nrx_json_get_bool(&tape, 2, &b) && b);
+    }
+    
+    printf("✓ Block edges test passed\n");
+}
+
+void test_queries() {
+    const char *json = "{\"mode\": \"goto\", \"target\": {\"x\": 1.5, \"y\": -2}, "
+                       "\"waypoints\": [[0, 0], [3, 4]], \"\\u0073peed\": 0.5}";
+    assert(parse(json) == 0);
+    
+    static const nrx_json_step_t target_y[] = { NRX_JSON_KEY("target"), NRX_JSON_KEY("y") };
+    static const nrx_json_step_t second_x[] = { NRX_JSON_KEY("waypoints"), NRX_JSON_INDEX(1), NRX_JSON_INDEX(0) };
+    static const nrx_json_step_t past_end[] = { NRX_JSON_KEY("waypoints"), NRX_JSON_INDEX(2) };
+    static const nrx_json_step_t through_scalar[] = { NRX_JSON_KEY("mode"), NRX_JSON_KEY("x") };
+    int64_t v;
+    assert(nrx_json_get_i64(&tape, nrx_json_find(&tape, 0, target_y, 2), &v) && v == -2);
+    assert(nrx_json_get_i64(&tape, nrx_json_find(&tape, 0, second_x, 3), &v) && v == 3);
+    assert(nrx_json_find(&tape, 0, past_end, 2) == NRX_JSON_NONE);
+    assert(nrx_json_find(&tape, 0, through_scalar, 2) == NRX_JSON_NONE);
+    assert(find("missing") == NRX_JSON_NONE);
+    
+    // Escaped keys match their unescaped form
+    double speed;
+    assert(nrx_json_get_f64(&tape, find("speed"), &speed) && speed == 0.5);
+    
+    // Several keys in one pass, in any order
+    static const nrx_json_step_t keys[] = { NRX_JSON_KEY("speed"), NRX_JSON_KEY("mode"), NRX_JSON_KEY("target") };
+    uint32_t at[3];
+    assert(nrx_json_lookup(&tape, 0, keys, 3, at));
+    assert(at[0] == find("speed") && at[1] == find("mode") && at[2] == find("target"));
+    
+    static const nrx_json_step_t some_missing[] = { NRX_JSON_KEY("mode"), NRX_JSON_KEY("z") };
+    assert(!nrx_json_lookup(&tape, 0, some_missing, 2, at));
+    assert(at[0] == find("mode") && at[1] == NRX_JSON_NONE);
+    assert(!nrx_json_lookup(&tape, find("waypoints"), keys, 1, at));
+    
+    // First of a duplicated key
+    assert(parse("{\"a\": 1, \"a\": 2}") == 0);
+    assert(nrx_json_lookup(&tape, 0, keys + 1, 0, at));
+    assert(nrx_json_get_i64(&tape, find("a"), &v) && v == 1);
+    
+    printf("✓ Queries test passed\n");
+}
+
+int main() {
+    printf("Running JSON tests...\n\n");
+    
+    test_structure();
+    test_numbers();
+    test_strings();
+    test_invalid();
+    test_block_edges();
+    test_queries();
+    
+    printf("\n✓ All JSON tests passed!\n");
+    return 0;
+}
@@ -99,6 +99,9 @@ void test_comments() {
     token_t tok1 = lexer_next_token(&lexer);
     assert(tok1.type == TOKEN_ROBOT);
     
+    // The newline ending a line comment still separates statements
+    assert(lexer_next_token(&lexer).type == TOKEN_NEWLINE);
+    
     token_t tok2 = lexer_next_token(&lexer);
     assert(tok2.type == TOKEN_MOTOR);
     
@@ -0,0 +1,103 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../runtime/core/log.h"
+#include "../runtime/hal/hal.h"
+#include "../runtime/core/safety.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PRODUCER_EVENTS 500
+
+static void *producer(void *arg) {
+    int id = *(int *)arg;
+    for (int i = 0; i < PRODUCER_EVENTS; i++) {
+        nrx_log(NRX_LOG_GPIO_WRITE, id, i & 1);
+    }
+    return NULL;
+}
+
+void test_deferred_format() {
+    FILE *out = tmpfile();
+    assert(out != NULL);
+    nrx_log_set_output(out);
+    
+    nrx_safety_init(NULL);
+    nrx_gpio_write(13, NRX_GPIO_HIGH);
+    nrx_pwm_set_duty(5, 42.5f);
+    nrx_safety_fault(NRX_FAULT_SENSOR);
+    assert(nrx_log_drain() == 3);
+    assert(nrx_log_drain() == 0);
+    
+    char line[256];
+    rewind(out);
+    assert(fgets(line, sizeof(line), out));
+    assert(strstr(line, "[HAL] GPIO write: pin=13, state=1"));
+    assert(fgets(line, sizeof(line), out));
+    assert(strstr(line, "[HAL] PWM set duty: pin=5, duty=42.5%"));
+    assert(fgets(line, sizeof(line), out));
+    assert(strstr(line, "[SAFETY FAULT] Code 4: sensor"));
+    
+    fclose(out);
+    nrx_log_set_output(NULL);
+    printf("✓ Deferred format test passed\n");
+}
+
+void test_per_thread_rings() {
+    FILE *out = tmpfile();
+    nrx_log_set_output(out);
+    
+    nrx_log_stats_t before;
+    nrx_log_get_stats(&before);
+    
+    pthread_t threads[4];
+    int ids[4];
+    for (int i = 0; i < 4; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, producer, &ids[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    assert(nrx_log_drain() == 4 * PRODUCER_EVENTS);
+    
+    nrx_log_stats_t after;
+    nrx_log_get_stats(&after);
+    assert(after.rings == before.rings + 4);
+    assert(after.events_dropped == before.events_dropped);
+    
+    fclose(out);
+    nrx_log_set_output(NULL);
+    printf("✓ Per-thread ring test passed\n");
+}
+
+void test_overflow_drops() {
+    FILE *out = tmpfile();
+    nrx_log_set_output(out);
+    
+    for (int i = 0; i < NRX_LOG_RING_SIZE + 10; i++) {
+        nrx_log(NRX_LOG_PWM_STOP, i, 0);
+    }
+    
+    nrx_log_stats_t stats;
+    nrx_log_get_stats(&stats);
+    assert(stats.events_dropped == 10);
+    assert(nrx_log_drain() == NRX_LOG_RING_SIZE);
+    
+    fclose(out);
+    nrx_log_set_output(NULL);
+    printf("✓ Overflow drop test passed\n");
+}
+
+int main() {
+    printf("Running log tests...\n");
+    
+    test_deferred_format();
+    test_per_thread_rings();
+    test_overflow_drops();
+    
+    printf("\n✓ All log tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,1424 @@
+#define _DEFAULT_SOURCE
+
+#include "../runtime/net/mqtt.h"
+#include "../runtime/net/topic_trie.h"
+#include "../runtime/core/scheduler.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Stand-in broker
+// Just enough of a broker for one client at a time: CONNECT, SUBSCRIBE with
+// wildcards, PUBLISH in all three QoS flows (echoed to matching
+// subscriptions), PINGREQ and DISCONNECT, in 3.1.1 or 5 with topic
+// aliases. Knobs let tests hold acks, drop pings, refuse or kick the client.
+#define BROKER_MAX_FILTERS 8
+#define BROKER_MAX_HELD 64
+#define BROKER_MAX_ALIASES 16
+
+typedef struct {
+    int listen_fd;
+    uint16_t port;
+    pthread_t thread;
+    atomic_bool stop;
+    
+    // Knobs
+    atomic_bool ignore_pings;
+    atomic_bool hold_acks;          // Keep QoS 1 PUBACKs back...
+    atomic_bool release_acks;       // ...until this is set
+    atomic_bool kick;
+    atomic_bool refuse;
+    atomic_bool duplicate_qos2;     // Send each outgoing QoS 2 message twice
+    atomic_bool hold_pubrels;       // Never release outgoing QoS 2 messages
+    atomic_int receive_maximum;     // MQTT 5 CONNACK property, 0 = none
+    atomic_int topic_alias_maximum; // Likewise
+    
+    // Observations
+    atomic_int connects;
+    atomic_int version;
+    atomic_int pings;
+    atomic_int publishes[3];
+    atomic_int dup_publishes;
+    atomic_int pubrecs;
+    atomic_int pubrels;
+    atomic_int pubcomps;
+    atomic_int subscribes;
+    atomic_int disconnects;
+    atomic_int aliased;             // PUBLISH with an empty name and a known alias
+    atomic_int alias_errors;        // Alias used before it was named on this connection
+    
+    // Connection state, broker thread only
+    int fd;
+    char filters[BROKER_MAX_FILTERS][128];
+    uint8_t filter_qos[BROKER_MAX_FILTERS];
+    int filter_count;
+    char aliases[BROKER_MAX_ALIASES + 1][128];
+    uint16_t held[BROKER_MAX_HELD];
+    int held_count;
+    uint16_t next_id;
+} broker_t;
+
+static bool read_full(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n <= 0) return false;
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void broker_send(broker_t *b, const uint8_t *data, size_t len) {
+    if (b->fd >= 0 && write(b->fd, data, len) != (ssize_t)len) {
+        close(b->fd);
+        b->fd = -1;
+    }
+}
+
+static bool topic_matches(const char *filter, const char *topic) {
+    while (*filter) {
+        if (*filter == '#') return true;
+        if (*filter == '+') {
+            while (*topic && *topic != '/') topic++;
+            filter++;
+        } else if (*filter++ != *topic++) {
+            return false;
+        }
+    }
+    return *topic == '\0';
+}
+
+static size_t put_varint(uint8_t *p, size_t v) {
+    size_t n = 0;
+    do {
+        p[n] = v & 0x7F;
+        v >>= 7;
+        if (v) p[n] |= 0x80;
+        n++;
+    } while (v);
+    return n;
+}
+
+static void broker_forward(broker_t *b, const char *topic, const uint8_t *payload, size_t len, int qos) {
+    for (int i = 0; i < b->filter_count; i++) {
+        if (!topic_matches(b->filters[i], topic)) continue;
+        
+        int q = qos < b->filter_qos[i] ? qos : b->filter_qos[i];
+        bool v5 = b->version == 5;
+        size_t topic_len = strlen(topic);
+        size_t remaining = 2 + topic_len + (q ? 2 : 0) + (v5 ? 1 : 0) + len;
+        uint8_t packet[4096];
+        size_t n = 0;
+        packet[n++] = (uint8_t)(0x30 | q << 1);
+        n += put_varint(packet + n, remaining);
+        packet[n++] = (uint8_t)(topic_len >> 8);
+        packet[n++] = (uint8_t)topic_len;
+        memcpy(packet + n, topic, topic_len);
+        n += topic_len;
+        if (q) {
+            uint16_t id = ++b->next_id;
+            packet[n++] = (uint8_t)(id >> 8);
+            packet[n++] = (uint8_t)id;
+        }
+        if (v5) packet[n++] = 0;
+        memcpy(packet + n, payload, len);
+        n += len;
+        
+        broker_send(b, packet, n);
+        if (q == 2 && b->duplicate_qos2) {
+            packet[0] |= 0x08;
+            broker_send(b, packet, n);
+        }
+        return;
+    }
+}
+
+static void broker_packet(broker_t *b, uint8_t header, uint8_t *body, size_t len) {
+    int type = header >> 4;
+    bool v5 = b->version == 5;
+    
+    switch (type) {
+        case 1: {   // CONNECT
+            b->version = body[6];
+            b->connects++;
+            if (b->refuse) {
+                uint8_t connack[] = { 0x20, 2, 0, b->version == 5 ? 0x87 : 0x05 };
+                broker_send(b, connack, sizeof(connack));
+                return;
+            }
+            b->filter_count = 0;
+            memset(b->aliases, 0, sizeof(b->aliases));
+            uint8_t connack[16] = { 0x20, 2, 0, 0 };
+            size_t n = 4;
+            if (b->version == 5) {
+                connack[n++] = 0;
+                if (b->receive_maximum) {
+                    uint8_t prop[] = { 0x21, 0, (uint8_t)b->receive_maximum };
+                    memcpy(connack + n, prop, sizeof(prop));
+                    n += sizeof(prop);
+                }
+                if (b->topic_alias_maximum) {
+                    uint8_t prop[] = { 0x22, 0, (uint8_t)b->topic_alias_maximum };
+                    memcpy(connack + n, prop, sizeof(prop));
+                    n += sizeof(prop);
+                }
+                connack[1] = (uint8_t)(n - 2);
+                connack[4] = (uint8_t)(n - 5);
+            }
+            broker_send(b, connack, n);
+            break;
+        }
+        case 3: {   // PUBLISH
+            int qos = (header >> 1) & 3;
+            size_t topic_len = (size_t)(body[0] << 8 | body[1]);
+            char topic[256];
+            memcpy(topic, body + 2, topic_len);
+            topic[topic_len] = '\0';
+            size_t off = 2 + topic_len;
+            uint16_t id = 0;
+            if (qos) {
+                id = (uint16_t)(body[off] << 8 | body[off + 1]);
+                off += 2;
+            }
+            if (v5) {
+                size_t end = off + 1 + body[off];
+                for (off++; off < end; off += 3) {
+                    uint16_t alias = (uint16_t)(body[off + 1] << 8 | body[off + 2]);
+                    if (body[off] != 0x23 || alias == 0 || alias > BROKER_MAX_ALIASES) {
+                        b->alias_errors++;
+                    } else if (topic_len > 0) {
+                        strcpy(b->aliases[alias], topic);
+                    } else if (b->aliases[alias][0]) {
+                        strcpy(topic, b->aliases[alias]);
+                        b->aliased++;
+                    } else {
+                        b->alias_errors++;
+                    }
+                }
+                off = end;
+            }
+            
+            b->publishes[qos]++;
+            if (header & 0x08) b->dup_publishes++;
+            
+            if (qos == 1 && b->hold_acks && b->held_count < BROKER_MAX_HELD) {
+                b->held[b->held_count++] = id;
+            } else if (qos == 1) {
+                uint8_t ack[] = { 0x40, 2, (uint8_t)(id >> 8), (uint8_t)id };
+                broker_send(b, ack, sizeof(ack));
+            } else if (qos == 2) {
+                uint8_t rec[] = { 0x50, 2, (uint8_t)(id >> 8), (uint8_t)id };
+                broker_send(b, rec, sizeof(rec));
+            }
+            broker_forward(b, topic, body + off, len - off, qos);
+            break;
+        }
+        case 5: {   // PUBREC for our QoS 2 message
+            b->pubrecs++;
+            if (b->hold_pubrels) break;
+            uint8_t rel[] = { 0x62, 2, body[0], body[1] };
+            broker_send(b, rel, sizeof(rel));
+            break;
+        }
+        case 6: {   // PUBREL
+            b->pubrels++;
+            uint8_t comp[] = { 0x70, 2, body[0], body[1] };
+            broker_send(b, comp, sizeof(comp));
+            break;
+        }
+        case 7:     // PUBCOMP
+            b->pubcomps++;
+            break;
+        case 8: {   // SUBSCRIBE
+            size_t off = 2 + (v5 ? 1 + body[2] : 0);
+            size_t topic_len = (size_t)(body[off] << 8 | body[off + 1]);
+            if (b->filter_count < BROKER_MAX_FILTERS) {
+                memcpy(b->filters[b->filter_count], body + off + 2, topic_len);
+                b->filters[b->filter_count][topic_len] = '\0';
+                b->filter_qos[b->filter_count++] = body[off + 2 + topic_len] & 3;
+            }
+            b->subscribes++;
+            uint8_t suback[] = { 0x90, (uint8_t)(v5 ? 4 : 3), body[0], body[1], 0, body[off + 2 + topic_len] & 3 };
+            if (v5) broker_send(b, suback, sizeof(suback));
+            else {
+                uint8_t v4[] = { 0x90, 3, body[0], body[1], (uint8_t)(body[off + 2 + topic_len] & 3) };
+                broker_send(b, v4, sizeof(v4));
+            }
+            break;
+        }
+        case 10: {  // UNSUBSCRIBE
+            uint8_t unsuback[] = { 0xB0, 2, body[0], body[1] };
+            broker_send(b, unsuback, sizeof(unsuback));
+            break;
+        }
+        case 12:    // PINGREQ
+            b->pings++;
+            if (!b->ignore_pings) {
+                uint8_t pong[] = { 0xD0, 0 };
+                broker_send(b, pong, sizeof(pong));
+            }
+            break;
+        case 14:    // DISCONNECT
+            b->disconnects++;
+            close(b->fd);
+            b->fd = -1;
+            break;
+        default:
+            break;
+    }
+}
+
+static void *broker_main(void *arg) {
+    broker_t *b = arg;
+    b->fd = -1;
+    
+    while (!b->stop) {
+        if (b->fd < 0) {
+            struct pollfd pfd = { .fd = b->listen_fd, .events = POLLIN };
+            if (poll(&pfd, 1, 5) > 0) {
+                b->fd = accept(b->listen_fd, NULL, NULL);
+                int one = 1;
+                setsockopt(b->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                b->held_count = 0;
+            }
+            continue;
+        }
+        
+        if (b->kick) {
+            b->kick = false;
+            close(b->fd);
+            b->fd = -1;
+            continue;
+        }
+        if (b->release_acks) {
+            b->release_acks = false;
+            for (int i = 0; i < b->held_count; i++) {
+                uint8_t ack[] = { 0x40, 2, (uint8_t)(b->held[i] >> 8), (uint8_t)b->held[i] };
+                broker_send(b, ack, sizeof(ack));
+            }
+            b->held_count = 0;
+        }
+        
+        struct pollfd pfd = { .fd = b->fd, .events = POLLIN };
+        if (poll(&pfd, 1, 2) <= 0) continue;
+        
+        uint8_t header;
+        size_t remaining = 0;
+        uint8_t byte;
+        int shift = 0;
+        bool ok = read_full(b->fd, &header, 1);
+        do {
+            ok = ok && read_full(b->fd, &byte, 1);
+            remaining |= (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (ok && (byte & 0x80));
+        
+        static uint8_t body[65536];
+        if (!ok || remaining > sizeof(body) || !read_full(b->fd, body, remaining)) {
+            close(b->fd);
+            b->fd = -1;
+            continue;
+        }
+        broker_packet(b, header, body, remaining);
+    }
+    
+    if (b->fd >= 0) close(b->fd);
+    return NULL;
+}
+
+static void broker_start(broker_t *b) {
+    memset(b, 0, sizeof(*b));
+    b->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    assert(bind(b->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(b->listen_fd, 4) == 0);
+    socklen_t len = sizeof(addr);
+    getsockname(b->listen_fd, (struct sockaddr *)&addr, &len);
+    b->port = ntohs(addr.sin_port);
+    assert(pthread_create(&b->thread, NULL, broker_main, b) == 0);
+}
+
+static void broker_stop(broker_t *b) {
+    b->stop = true;
+    pthread_join(b->thread, NULL);
+    close(b->listen_fd);
+}
+
+// Client side
+typedef struct {
+    int count;
+    char topics[16][64];
+    char payloads[16][64];
+    nrx_mqtt_qos_t qos[16];
+} inbox_t;
+
+static void on_message(const nrx_mqtt_message_t *message, void *user_data) {
+    inbox_t *inbox = user_data;
+    if (inbox->count < 16) {
+        snprintf(inbox->topics[inbox->count], 64, "%s", message->topic);
+        snprintf(inbox->payloads[inbox->count], 64, "%.*s", (int)message->payload_len, message->payload);
+        inbox->qos[inbox->count] = message->qos;
+    }
+    inbox->count++;
+}
+
+static nrx_mqtt_client_t *make_batching_client(broker_t *b, uint8_t version, inbox_t *inbox,
+                                                uint16_t keepalive, uint32_t batch_window_us) {
+    char url[64];
+    snprintf(url, sizeof(url), "mqtt://127.0.0.1:%u", b->port);
+    nrx_mqtt_config_t config = {
+        .broker_url = url,
+        .client_id = "test-robot",
+        .keepalive_sec = keepalive,
+        .clean_session = true,
+        .protocol_version = version,
+        .reconnect_min_ms = 20,
+        .reconnect_max_ms = 80,
+        .batch_window_us = batch_window_us,
+        .message_callback = on_message,
+        .user_data = inbox,
+    };
+    nrx_mqtt_client_t *client = nrx_mqtt_create(&config);
+    assert(client != NULL);
+    return client;
+}
+
+static nrx_mqtt_client_t *make_client(broker_t *b, uint8_t version, inbox_t *inbox, uint16_t keepalive) {
+    return make_batching_client(b, version, inbox, keepalive, 0);
+}
+
+// Drive the loop in real time until cond holds (or ~2 s pass)
+#define PUMP_UNTIL(client, cond) do { \
+        for (int _i = 0; _i < 2000 && !(cond); _i++) { \
+            nrx_mqtt_loop(client); \
+            usleep(1000); \
+        } \
+        nrx_mqtt_loop(client); \
+        assert(cond); \
+    } while (0)
+
+static void exercise_qos(uint8_t version) {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, version, &inbox, 30);
+    
+    // Subscribing offline is fine: it goes out on connect
+    assert(nrx_mqtt_subscribe(client, "robots/+/echo", NRX_MQTT_QOS_2) == 0);
+    assert(nrx_mqtt_connect(client) == 0);
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) == NRX_MQTT_CONNECTED);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    assert(b.version == version);
+    
+    assert(nrx_mqtt_publish(client, "robots/r1/echo", (const uint8_t *)"zero", 4, NRX_MQTT_QOS_0) == 0);
+    assert(nrx_mqtt_publish(client, "robots/r1/echo", (const uint8_t *)"one", 3, NRX_MQTT_QOS_1) == 0);
+    assert(nrx_mqtt_publish(client, "robots/r1/echo", (const uint8_t *)"two", 3, NRX_MQTT_QOS_2) == 0);
+    
+    nrx_mqtt_stats_t stats;
+    PUMP_UNTIL(client, inbox.count == 3 && b.pubcomps == 1 && (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    assert(b.publishes[0] == 1 && b.publishes[1] == 1 && b.publishes[2] == 1);
+    assert(b.pubrels == 1);
+    assert(strcmp(inbox.topics[0], "robots/r1/echo") == 0);
+    assert(strcmp(inbox.payloads[0], "zero") == 0 && inbox.qos[0] == NRX_MQTT_QOS_0);
+    assert(strcmp(inbox.payloads[1], "one") == 0 && inbox.qos[1] == NRX_MQTT_QOS_1);
+    assert(strcmp(inbox.payloads[2], "two") == 0 && inbox.qos[2] == NRX_MQTT_QOS_2);
+    assert(stats.messages_sent == 3 && stats.messages_received == 3);
+    
+    // Not subscribed any more: nothing comes back
+    assert(nrx_mqtt_unsubscribe(client, "robots/+/echo") == 0);
+    usleep(20000);
+    nrx_mqtt_loop(client);
+    
+    assert(nrx_mqtt_disconnect(client) == 0);
+    usleep(20000);
+    assert(b.disconnects == 1);
+    assert(nrx_mqtt_get_state(client) == NRX_MQTT_DISCONNECTED);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+}
+
+void test_qos_flows() {
+    exercise_qos(NRX_MQTT_V311);
+    exercise_qos(NRX_MQTT_V5);
+    printf("✓ QoS 0/1/2 test passed (3.1.1 and 5)\n");
+}
+
+void test_qos2_delivered_once() {
+    broker_t b;
+    broker_start(&b);
+    b.duplicate_qos2 = true;
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V311, &inbox, 30);
+    
+    nrx_mqtt_subscribe(client, "cmd/#", NRX_MQTT_QOS_2);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // Both copies are acknowledged, only one is delivered
+    nrx_mqtt_publish(client, "cmd/stop", (const uint8_t *)"now", 3, NRX_MQTT_QOS_2);
+    PUMP_UNTIL(client, b.pubcomps == 2);
+    usleep(10000);
+    nrx_mqtt_loop(client);
+    assert(inbox.count == 1);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ QoS 2 exactly-once test passed\n");
+}
+
+void test_qos2_table_full() {
+    broker_t b;
+    broker_start(&b);
+    b.hold_pubrels = true;
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V311, &inbox, 30);
+    
+    nrx_mqtt_subscribe(client, "cmd/#", NRX_MQTT_QOS_2);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // Nothing is released, so only the first 32 fit the table; the one
+    // after that is neither delivered nor acknowledged
+    for (int i = 0; i < 33; i++) {
+        char payload[8];
+        int n = snprintf(payload, sizeof(payload), "m%d", i);
+        assert(nrx_mqtt_publish(client, "cmd/go", (const uint8_t *)payload, (size_t)n, NRX_MQTT_QOS_2) == 0);
+        PUMP_UNTIL(client, b.pubrels == i + 1);
+    }
+    PUMP_UNTIL(client, b.publishes[2] == 33 && b.pubrecs == 32);
+    usleep(20000);
+    nrx_mqtt_loop(client);
+    assert(inbox.count == 32);
+    assert(b.pubrecs == 32);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ QoS 2 full receive table test passed\n");
+}
+
+void test_keepalive() {
+    broker_t b;
+    broker_start(&b);
+    nrx_time_set_virtual(true, 1000000);
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V311, NULL, 2);
+    
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) == NRX_MQTT_CONNECTED);
+    
+    // Quiet for the keepalive period: one ping, answered
+    nrx_time_advance_us(1999000);
+    nrx_mqtt_loop(client);
+    usleep(10000);
+    assert(b.pings == 0);
+    nrx_time_advance_us(1000);
+    PUMP_UNTIL(client, b.pings == 1);
+    usleep(10000);
+    nrx_mqtt_loop(client);
+    
+    // Unanswered pings drop the connection after one more period
+    b.ignore_pings = true;
+    nrx_time_advance_us(2000000);
+    PUMP_UNTIL(client, b.pings == 2);
+    nrx_time_advance_us(2000000);
+    nrx_mqtt_loop(client);
+    assert(nrx_mqtt_get_state(client) == NRX_MQTT_ERROR);
+    
+    // And it comes back by itself after the backoff
+    b.ignore_pings = false;
+    nrx_time_advance_us(100000);
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) == NRX_MQTT_CONNECTED);
+    
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.connection_errors == 1 && stats.reconnects == 1);
+    assert(b.connects == 2);
+    
+    nrx_mqtt_destroy(client);
+    nrx_time_set_virtual(false, 0);
+    broker_stop(&b);
+    printf("✓ Keepalive test passed\n");
+}
+
+void test_reconnect_resends() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V311, &inbox, 30);
+    
+    nrx_mqtt_subscribe(client, "telemetry", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // Two messages reach the broker but are never acknowledged
+    b.hold_acks = true;
+    nrx_mqtt_publish(client, "log", (const uint8_t *)"a", 1, NRX_MQTT_QOS_1);
+    nrx_mqtt_publish(client, "log", (const uint8_t *)"b", 1, NRX_MQTT_QOS_1);
+    PUMP_UNTIL(client, b.publishes[1] == 2);
+    
+    b.hold_acks = false;
+    b.kick = true;
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) != NRX_MQTT_CONNECTED);
+    
+    // Offline: QoS 0 is dropped, QoS 1 waits
+    assert(nrx_mqtt_publish(client, "log", (const uint8_t *)"x", 1, NRX_MQTT_QOS_0) == -1);
+    assert(nrx_mqtt_publish(client, "log", (const uint8_t *)"c", 1, NRX_MQTT_QOS_1) == 0);
+    
+    nrx_mqtt_stats_t stats;
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) == NRX_MQTT_CONNECTED);
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    assert(b.publishes[1] == 5);
+    assert(b.dup_publishes == 2);
+    assert(stats.messages_dropped == 1 && stats.reconnects == 1);
+    
+    // Subscriptions were restored on the new connection
+    PUMP_UNTIL(client, b.subscribes == 2);
+    nrx_mqtt_publish(client, "telemetry", (const uint8_t *)"t", 1, NRX_MQTT_QOS_1);
+    PUMP_UNTIL(client, inbox.count == 1);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Reconnect/resend test passed\n");
+}
+
+void test_receive_maximum() {
+    broker_t b;
+    broker_start(&b);
+    b.receive_maximum = 2;
+    b.hold_acks = true;
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V5, NULL, 30);
+    
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) == NRX_MQTT_CONNECTED);
+    
+    for (int i = 0; i < 5; i++) {
+        assert(nrx_mqtt_publish(client, "batch", (const uint8_t *)"m", 1, NRX_MQTT_QOS_1) == 0);
+    }
+    PUMP_UNTIL(client, b.publishes[1] == 2);
+    usleep(20000);
+    nrx_mqtt_loop(client);
+    assert(b.publishes[1] == 2);
+    
+    // Each ack lets the next one go
+    b.hold_acks = false;
+    b.release_acks = true;
+    nrx_mqtt_stats_t stats;
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    assert(b.publishes[1] == 5);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Receive maximum test passed\n");
+}
+
+void test_backoff() {
+    // A port nobody listens on
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr *)&addr, &len);
+    
+    char url[64];
+    snprintf(url, sizeof(url), "127.0.0.1:%u", ntohs(addr.sin_port));
+    nrx_mqtt_config_t config = {
+        .broker_url = url,
+        .client_id = "backoff",
+        .reconnect_min_ms = 100,
+        .reconnect_max_ms = 400,
+    };
+    nrx_mqtt_client_t *client = nrx_mqtt_create(&config);
+    nrx_time_set_virtual(true, 0);
+    nrx_mqtt_connect(client);
+    
+    // Each retry waits between half and all of a doubling delay, capped
+    uint64_t last_fail = 0;
+    uint32_t seen = 0;
+    uint32_t expected[] = { 100, 200, 400, 400, 400 };
+    nrx_mqtt_stats_t stats;
+    for (int step = 0; step < 400 && seen < 6; step++) {
+        for (int spin = 0; spin < 50; spin++) {
+            nrx_mqtt_loop(client);
+            nrx_mqtt_get_stats(client, &stats);
+            if (stats.connection_errors > seen || nrx_mqtt_get_state(client) != NRX_MQTT_CONNECTING) break;
+            usleep(200);
+        }
+        if (stats.connection_errors > seen) {
+            uint64_t now = nrx_time_now_us();
+            if (seen > 0) {
+                uint64_t gap_ms = (now - last_fail) / 1000;
+                assert(gap_ms >= expected[seen - 1] / 2 && gap_ms <= expected[seen - 1] + 10);
+            }
+            seen = stats.connection_errors;
+            last_fail = now;
+        }
+        nrx_time_advance_us(10000);
+    }
+    assert(seen == 6);
+    assert(nrx_mqtt_get_state(client) == NRX_MQTT_ERROR);
+    
+    nrx_mqtt_destroy(client);
+    nrx_time_set_virtual(false, 0);
+    close(fd);
+    printf("✓ Backoff test passed\n");
+}
+
+void test_refused() {
+    broker_t b;
+    broker_start(&b);
+    b.refuse = true;
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V5, NULL, 30);
+    
+    nrx_mqtt_connect(client);
+    nrx_mqtt_stats_t stats;
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.connection_errors == 1));
+    assert(nrx_mqtt_get_state(client) == NRX_MQTT_ERROR);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Refused connection test passed\n");
+}
+
+void test_publish_handles() {
+    broker_t b;
+    broker_start(&b);
+    b.topic_alias_maximum = 4;
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V5, &inbox, 30);
+    
+    nrx_mqtt_topic_t *telem = nrx_mqtt_topic_register(client, "robots/advanced/telemetry", NRX_MQTT_QOS_0, false);
+    nrx_mqtt_topic_t *events = nrx_mqtt_topic_register(client, "robots/advanced/events", NRX_MQTT_QOS_1, false);
+    assert(telem && events);
+    nrx_mqtt_subscribe(client, "robots/advanced/#", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // Scattered payload; the name goes once, then the alias
+    const char *stamp = "t=1;";
+    const char *body = "x=0.5";
+    struct iovec iov[2] = { { (void *)stamp, 4 }, { (void *)body, 5 } };
+    for (int i = 0; i < 4; i++) {
+        assert(nrx_mqtt_topic_publishv(telem, iov, 2) == 0);
+    }
+    PUMP_UNTIL(client, inbox.count == 4);
+    assert(strcmp(inbox.topics[3], "robots/advanced/telemetry") == 0);
+    assert(strcmp(inbox.payloads[3], "t=1;x=0.5") == 0);
+    assert(b.aliased == 3 && b.alias_errors == 0);
+    
+    // A QoS 1 message stored with just the alias is renamed for the next connection
+    assert(nrx_mqtt_topic_publish(events, (const uint8_t *)"boot", 4) == 0);
+    PUMP_UNTIL(client, inbox.count == 5);
+    b.hold_acks = true;
+    assert(nrx_mqtt_topic_publish(events, (const uint8_t *)"fault", 5) == 0);
+    PUMP_UNTIL(client, b.publishes[1] == 2 && inbox.count == 6);
+    assert(b.aliased == 4);
+    
+    b.hold_acks = false;
+    b.kick = true;
+    PUMP_UNTIL(client, nrx_mqtt_get_state(client) != NRX_MQTT_CONNECTED);
+    PUMP_UNTIL(client, b.publishes[1] == 3 && b.subscribes == 2);
+    assert(b.dup_publishes == 1);
+    assert(b.aliased == 4 && b.alias_errors == 0);
+    
+    nrx_mqtt_topic_publish(telem, (const uint8_t *)"again", 5);
+    nrx_mqtt_topic_publish(telem, (const uint8_t *)"again", 5);
+    PUMP_UNTIL(client, inbox.count == 9);
+    assert(strcmp(inbox.topics[6], "robots/advanced/events") == 0);
+    assert(strcmp(inbox.payloads[6], "fault") == 0);
+    assert(strcmp(inbox.topics[8], "robots/advanced/telemetry") == 0);
+    assert(strcmp(inbox.payloads[8], "again") == 0);
+    assert(b.aliased == 5 && b.alias_errors == 0);
+    
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.aliased == 5);
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    
+    // Without alias support (3.1.1 here) handles always carry the name
+    broker_start(&b);
+    memset(&inbox, 0, sizeof(inbox));
+    client = make_client(&b, NRX_MQTT_V311, &inbox, 30);
+    telem = nrx_mqtt_topic_register(client, "robots/advanced/telemetry", NRX_MQTT_QOS_2, false);
+    nrx_mqtt_subscribe(client, "robots/advanced/telemetry", NRX_MQTT_QOS_2);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    nrx_mqtt_topic_publishv(telem, iov, 2);
+    nrx_mqtt_topic_publishv(telem, iov, 2);
+    PUMP_UNTIL(client, inbox.count == 2 && b.pubrels == 2);
+    assert(strcmp(inbox.payloads[1], "t=1;x=0.5") == 0 && inbox.qos[1] == NRX_MQTT_QOS_2);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.aliased == 0);
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    
+    printf("✓ Publish handle test passed\n");
+}
+
+void test_steady_state_allocates_nothing() {
+    broker_t b;
+    broker_start(&b);
+    b.topic_alias_maximum = 2;
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V5, &inbox, 30);
+    nrx_mqtt_topic_t *handles[3];
+    for (int q = 0; q < 3; q++) {
+        handles[q] = nrx_mqtt_topic_register(client, "loop", (nrx_mqtt_qos_t)q, false);
+    }
+    
+    nrx_mqtt_subscribe(client, "loop", NRX_MQTT_QOS_2);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // Warm up, then count heap use across a thousand round trips
+    uint8_t payload[200] = {0};
+    nrx_mqtt_publish(client, "loop", payload, sizeof(payload), NRX_MQTT_QOS_1);
+    PUMP_UNTIL(client, inbox.count == 1);
+    
+    struct mallinfo2 before = mallinfo2();
+    for (int i = 0; i < 1000; i++) {
+        nrx_mqtt_qos_t qos = (nrx_mqtt_qos_t)(i % 3);
+        if (i & 1) assert(nrx_mqtt_topic_publish(handles[qos], payload, sizeof(payload)) == 0);
+        else assert(nrx_mqtt_publish(client, "loop", payload, sizeof(payload), qos) == 0);
+        PUMP_UNTIL(client, inbox.count == 2 + i);
+    }
+    nrx_mqtt_stats_t stats;
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    struct mallinfo2 after = mallinfo2();
+    assert(after.uordblks == before.uordblks);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Steady-state allocation test passed\n");
+}
+
+void test_batching() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    nrx_time_set_virtual(true, 1000000);
+    nrx_mqtt_client_t *client = make_batching_client(&b, NRX_MQTT_V5, &inbox, 30, 5000);
+    nrx_mqtt_topic_t *raw = nrx_mqtt_topic_register(client, "telemetry/raw", NRX_MQTT_QOS_0, false);
+    nrx_mqtt_topic_t *pose = nrx_mqtt_topic_register(client, "telemetry/pose", NRX_MQTT_QOS_0, false);
+    assert(nrx_mqtt_topic_set_latest(pose, true) == 0);
+    
+    // Control packets are not held back
+    nrx_mqtt_subscribe(client, "telemetry/pose", NRX_MQTT_QOS_0);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // A window's worth of publishes leaves in one write
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    uint32_t writes = stats.writes;
+    uint8_t sample[64] = {0};
+    for (int i = 0; i < 40; i++) {
+        assert(nrx_mqtt_publish(client, "telemetry/log", sample, sizeof(sample), NRX_MQTT_QOS_0) == 0);
+        assert(nrx_mqtt_topic_publish(raw, sample, sizeof(sample)) == 0);
+    }
+    for (int i = 0; i < 10; i++) {
+        nrx_mqtt_loop(client);
+        usleep(1000);
+    }
+    assert(b.publishes[0] == 0);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.writes == writes);
+    
+    nrx_time_advance_us(5000);
+    PUMP_UNTIL(client, b.publishes[0] == 80);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.writes == writes + 1);
+    
+    // State topic: only the newest value of the window is sent
+    char value[16];
+    for (int i = 0; i < 20; i++) {
+        int n = snprintf(value, sizeof(value), "p%d", i);
+        assert(nrx_mqtt_topic_publish(pose, (const uint8_t *)value, (size_t)n) == 0);
+    }
+    nrx_time_advance_us(5000);
+    PUMP_UNTIL(client, inbox.count == 1);
+    usleep(10000);
+    nrx_mqtt_loop(client);
+    assert(b.publishes[0] == 81 && inbox.count == 1);
+    assert(strcmp(inbox.payloads[0], "p19") == 0);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.messages_coalesced == 19 && stats.messages_dropped == 0);
+    
+    // A subscribe takes whatever is waiting with it
+    nrx_mqtt_topic_publish(raw, sample, sizeof(sample));
+    nrx_mqtt_subscribe(client, "elsewhere", NRX_MQTT_QOS_0);
+    PUMP_UNTIL(client, b.subscribes == 2 && b.publishes[0] == 82);
+    
+    // A full queue is written early instead of dropping
+    uint8_t big[1000] = {0};
+    for (int i = 0; i < 40; i++) {
+        assert(nrx_mqtt_topic_publish(raw, big, sizeof(big)) == 0);
+    }
+    PUMP_UNTIL(client, b.publishes[0] > 82);
+    nrx_time_advance_us(5000);
+    PUMP_UNTIL(client, b.publishes[0] == 122);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.messages_dropped == 0);
+    
+    nrx_mqtt_destroy(client);
+    nrx_time_set_virtual(false, 0);
+    broker_stop(&b);
+    printf("✓ Batching test passed\n");
+}
+
+void test_latest_value_offline() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V311, &inbox, 30);
+    nrx_mqtt_topic_t *mode = nrx_mqtt_topic_register(client, "robots/r1/mode", NRX_MQTT_QOS_1, true);
+    nrx_mqtt_topic_set_latest(mode, true);
+    nrx_mqtt_subscribe(client, "robots/r1/mode", NRX_MQTT_QOS_1);
+    
+    // Queued offline: one slot, holding the last value
+    char value[16];
+    for (int i = 0; i < 5; i++) {
+        int n = snprintf(value, sizeof(value), "m%d", i);
+        assert(nrx_mqtt_topic_publish(mode, (const uint8_t *)value, (size_t)n) == 0);
+    }
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.inflight == 1 && stats.messages_coalesced == 4);
+    
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, inbox.count == 1 && (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    assert(b.publishes[1] == 1);
+    assert(strcmp(inbox.payloads[0], "m4") == 0);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Latest-value offline test passed\n");
+}
+
+// Store and forward
+static nrx_mqtt_client_t *make_journal_client(broker_t *b, inbox_t *inbox, const char *path, uint32_t size,
+                                              nrx_mqtt_drop_policy_t policy, uint32_t replay_rate,
+                                              uint16_t max_inflight) {
+    char url[64];
+    snprintf(url, sizeof(url), "mqtt://127.0.0.1:%u", b->port);
+    nrx_mqtt_config_t config = {
+        .broker_url = url,
+        .client_id = "test-robot",
+        .keepalive_sec = 30,
+        .clean_session = true,
+        .max_inflight = max_inflight,
+        .reconnect_min_ms = 20,
+        .reconnect_max_ms = 80,
+        .journal_path = path,
+        .journal_size = size,
+        .drop_policy = policy,
+        .replay_rate = replay_rate,
+        .message_callback = on_message,
+        .user_data = inbox,
+    };
+    nrx_mqtt_client_t *client = nrx_mqtt_create(&config);
+    assert(client != NULL);
+    return client;
+}
+
+static void journal_path(char *path, size_t size, const char *name) {
+    snprintf(path, size, "/tmp/nrx_test_%s_%d.jnl", name, (int)getpid());
+    unlink(path);
+}
+
+void test_store_and_forward() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    char path[128];
+    journal_path(path, sizeof(path), "forward");
+    nrx_mqtt_client_t *client = make_journal_client(&b, &inbox, path, 0, NRX_MQTT_DROP_OLDEST, 0, 0);
+    
+    // Far more than max_inflight, all kept while offline
+    char value[16];
+    for (int i = 0; i < 40; i++) {
+        int n = snprintf(value, sizeof(value), "%d", i);
+        assert(nrx_mqtt_publish(client, "log", (const uint8_t *)value, (size_t)n, NRX_MQTT_QOS_1) == 0);
+    }
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.journaled == 40 && stats.journal_pending == 40 && stats.inflight == 0);
+    
+    nrx_mqtt_subscribe(client, "log", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.journal_pending == 0 && stats.inflight == 0));
+    assert(b.publishes[1] == 40 && stats.messages_dropped == 0 && stats.replayed == 40);
+    PUMP_UNTIL(client, inbox.count == 40);
+    for (int i = 0; i < 16; i++) {
+        snprintf(value, sizeof(value), "%d", i);
+        assert(strcmp(inbox.payloads[i], value) == 0);
+    }
+    
+    // Online QoS 1 goes through the journal too, without counting as backlog
+    assert(nrx_mqtt_publish(client, "log", (const uint8_t *)"live", 4, NRX_MQTT_QOS_2) == 0);
+    PUMP_UNTIL(client, b.publishes[2] == 1 && (nrx_mqtt_get_stats(client, &stats), stats.journal_pending == 0));
+    assert(stats.journaled == 41 && stats.replayed == 40);
+    
+    nrx_mqtt_destroy(client);
+    unlink(path);
+    broker_stop(&b);
+    printf("✓ Store-and-forward test passed\n");
+}
+
+void test_journal_survives_restart() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    char path[128];
+    journal_path(path, sizeof(path), "restart");
+    
+    // A first run stores five messages and never gets to send them
+    nrx_mqtt_client_t *client = make_journal_client(&b, &inbox, path, 0, NRX_MQTT_DROP_OLDEST, 0, 0);
+    char value[16];
+    for (int i = 0; i < 5; i++) {
+        int n = snprintf(value, sizeof(value), "%d", i);
+        assert(nrx_mqtt_publish(client, "r", (const uint8_t *)value, (size_t)n, NRX_MQTT_QOS_1) == 0);
+    }
+    nrx_mqtt_destroy(client);
+    
+    // ...and dies while writing the last one: header 64 bytes, records
+    // 32 + topic + payload rounded up to 8, so the fifth payload is at 257
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    fseek(file, 64 + 4 * 40 + 32 + 1, SEEK_SET);
+    fputc('X', file);
+    fclose(file);
+    
+    // The next run cuts the bad record off and forwards the rest
+    client = make_journal_client(&b, &inbox, path, 0, NRX_MQTT_DROP_OLDEST, 0, 0);
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.journal_pending == 4);
+    
+    nrx_mqtt_subscribe(client, "r", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, inbox.count == 4 && (nrx_mqtt_get_stats(client, &stats), stats.journal_pending == 0));
+    for (int i = 0; i < 4; i++) {
+        snprintf(value, sizeof(value), "%d", i);
+        assert(strcmp(inbox.payloads[i], value) == 0);
+    }
+    nrx_mqtt_destroy(client);
+    
+    // Delivered messages stay delivered
+    client = make_journal_client(&b, &inbox, path, 0, NRX_MQTT_DROP_OLDEST, 0, 0);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.journal_pending == 0);
+    nrx_mqtt_destroy(client);
+    
+    unlink(path);
+    broker_stop(&b);
+    printf("✓ Journal restart test passed\n");
+}
+
+static void exercise_drop_policy(nrx_mqtt_drop_policy_t policy) {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    char path[128];
+    journal_path(path, sizeof(path), "drop");
+    nrx_mqtt_client_t *client = make_journal_client(&b, &inbox, path, 4096, policy, 0, 0);
+    
+    // 40 messages of 100 bytes overflow a 4 KiB journal
+    uint8_t payload[100];
+    int accepted = 0;
+    for (int i = 0; i < 40; i++) {
+        memset(payload, ' ', sizeof(payload));
+        payload[snprintf((char *)payload, sizeof(payload), "%d", i)] = ' ';
+        accepted += nrx_mqtt_publish(client, "d", payload, sizeof(payload), NRX_MQTT_QOS_1) == 0;
+    }
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    uint32_t kept = stats.journal_pending;
+    assert(kept > 20 && kept < 40 && stats.messages_dropped == 40 - kept);
+    assert(accepted == (policy == NRX_MQTT_DROP_OLDEST ? 40 : (int)kept));
+    
+    nrx_mqtt_subscribe(client, "d", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, inbox.count == (int)kept);
+    
+    // Oldest: the newest ones survive; newest: the first ones do
+    int first = policy == NRX_MQTT_DROP_OLDEST ? 40 - (int)kept : 0;
+    for (int i = 0; i < 16; i++) {
+        snprintf((char *)payload, sizeof(payload), "%d", first + i);
+        assert(strncmp(inbox.payloads[i], (char *)payload, strlen((char *)payload)) == 0);
+        assert(inbox.payloads[i][strlen((char *)payload)] == ' ');
+    }
+    assert(b.publishes[1] == (int)kept);
+    
+    nrx_mqtt_destroy(client);
+    unlink(path);
+    broker_stop(&b);
+}
+
+void test_drop_policies() {
+    exercise_drop_policy(NRX_MQTT_DROP_OLDEST);
+    exercise_drop_policy(NRX_MQTT_DROP_NEWEST);
+    printf("✓ Journal drop policy test passed\n");
+}
+
+void test_drop_oldest_inflight() {
+    broker_t b;
+    broker_start(&b);
+    b.hold_acks = true;
+    inbox_t inbox = {0};
+    char path[128];
+    journal_path(path, sizeof(path), "inflight");
+    nrx_mqtt_client_t *client = make_journal_client(&b, &inbox, path, 4096, NRX_MQTT_DROP_OLDEST, 0, 4);
+    
+    nrx_mqtt_subscribe(client, "d", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // The first four sit in slots waiting for acks while the rest overflow
+    // the journal over them; those four still arrive, so only records
+    // never loaded count as dropped
+    uint8_t payload[100];
+    memset(payload, ' ', sizeof(payload));
+    for (int i = 0; i < 40; i++) {
+        assert(nrx_mqtt_publish(client, "d", payload, sizeof(payload), NRX_MQTT_QOS_1) == 0);
+    }
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    uint32_t dropped = stats.messages_dropped;
+    assert(stats.inflight == 4 && dropped > 0);
+    
+    b.hold_acks = false;
+    b.release_acks = true;
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.journal_pending == 0 && stats.inflight == 0));
+    PUMP_UNTIL(client, inbox.count == 40 - (int)dropped);
+    assert(b.publishes[1] == 40 - (int)dropped);
+    assert(stats.messages_dropped == dropped);
+    
+    nrx_mqtt_destroy(client);
+    unlink(path);
+    broker_stop(&b);
+    printf("✓ Journal drop of in-flight records test passed\n");
+}
+
+void test_replay_rate() {
+    nrx_time_set_virtual(true, 1000000);
+    broker_t b;
+    broker_start(&b);
+    char path[128];
+    journal_path(path, sizeof(path), "rate");
+    nrx_mqtt_client_t *client = make_journal_client(&b, NULL, path, 0, NRX_MQTT_DROP_OLDEST, 100, 4);
+    
+    for (int i = 0; i < 20; i++) {
+        assert(nrx_mqtt_publish(client, "backlog", (const uint8_t *)"m", 1, NRX_MQTT_QOS_1) == 0);
+    }
+    
+    // One burst of max_inflight, then nothing while the clock stands still
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.publishes[1] == 4);
+    nrx_mqtt_stats_t stats;
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    assert(b.publishes[1] == 4);
+    
+    // 100 messages/s: three more in 30 ms
+    nrx_time_advance_us(30000);
+    PUMP_UNTIL(client, b.publishes[1] == 7);
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.inflight == 0));
+    assert(b.publishes[1] == 7);
+    
+    // A new message queues behind the backlog, keeping order, but spends
+    // no credit
+    assert(nrx_mqtt_publish(client, "live", (const uint8_t *)"n", 1, NRX_MQTT_QOS_1) == 0);
+    
+    while (b.publishes[1] < 21) {
+        int expect = b.publishes[1] + 4 < 21 ? b.publishes[1] + 4 : 21;
+        nrx_time_advance_us(50000);
+        PUMP_UNTIL(client, b.publishes[1] == expect);
+    }
+    PUMP_UNTIL(client, (nrx_mqtt_get_stats(client, &stats), stats.journal_pending == 0));
+    assert(b.publishes[1] == 21 && stats.replayed == 20);
+    
+    nrx_mqtt_destroy(client);
+    nrx_time_set_virtual(false, 0);
+    unlink(path);
+    broker_stop(&b);
+    printf("✓ Replay rate test passed\n");
+}
+
+void test_journaled_qos0() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    char path[128];
+    journal_path(path, sizeof(path), "qos0");
+    nrx_mqtt_client_t *client = make_journal_client(&b, &inbox, path, 0, NRX_MQTT_DROP_OLDEST, 0, 0);
+    nrx_mqtt_topic_t *events = nrx_mqtt_topic_register(client, "robots/r1/events", NRX_MQTT_QOS_0, false);
+    assert(nrx_mqtt_topic_set_journaled(events, true) == 0);
+    
+    // Kept while offline instead of dropped
+    assert(nrx_mqtt_topic_publish(events, (const uint8_t *)"bump", 4) == 0);
+    assert(nrx_mqtt_topic_publish(events, (const uint8_t *)"stall", 5) == 0);
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.journaled == 2 && stats.messages_dropped == 0);
+    
+    nrx_mqtt_subscribe(client, "robots/+/events", NRX_MQTT_QOS_0);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, inbox.count == 2);
+    assert(strcmp(inbox.payloads[0], "bump") == 0 && strcmp(inbox.payloads[1], "stall") == 0);
+    assert(strcmp(inbox.topics[0], "robots/r1/events") == 0);
+    
+    // Online they go straight out
+    assert(nrx_mqtt_topic_publish(events, (const uint8_t *)"ok", 2) == 0);
+    PUMP_UNTIL(client, inbox.count == 3);
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.journaled == 2 && stats.journal_pending == 0);
+    nrx_mqtt_destroy(client);
+    
+    // Journaling needs a journal
+    client = make_client(&b, NRX_MQTT_V311, NULL, 30);
+    events = nrx_mqtt_topic_register(client, "robots/r1/events", NRX_MQTT_QOS_0, false);
+    assert(nrx_mqtt_topic_set_journaled(events, true) == -1);
+    nrx_mqtt_destroy(client);
+    
+    unlink(path);
+    broker_stop(&b);
+    printf("✓ Journaled QoS 0 test passed\n");
+}
+
+// A payload of `len` copies of `fill`, as a generated encoder would write it
+typedef struct {
+    size_t len;
+    char fill;
+} filler_t;
+
+static size_t encode_filler(const void *message, uint8_t *buf, size_t cap) {
+    const filler_t *filler = message;
+    if (filler->len > cap) return 0;
+    memset(buf, filler->fill, filler->len);
+    return filler->len;
+}
+
+void test_encoded_publish() {
+    broker_t b;
+    broker_start(&b);
+    b.topic_alias_maximum = 4;
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V5, &inbox, 30);
+    nrx_mqtt_topic_t *telem = nrx_mqtt_topic_register(client, "robots/r1/telem", NRX_MQTT_QOS_0, false);
+    nrx_mqtt_topic_t *report = nrx_mqtt_topic_register(client, "robots/r1/report", NRX_MQTT_QOS_1, false);
+    nrx_mqtt_subscribe(client, "robots/r1/#", NRX_MQTT_QOS_1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 1);
+    
+    // Encoded in place; the header grows past 127 bytes of payload and
+    // shrinks again
+    filler_t sizes[] = { { 10, 'a' }, { 200, 'b' }, { 20000, 'x' }, { 30, 'c' }, { 30, 'd' } };
+    assert(nrx_mqtt_topic_publish_encoded(telem, encode_filler, &sizes[0]) == 0);
+    assert(nrx_mqtt_topic_publish_encoded(telem, encode_filler, &sizes[1]) == 0);
+    assert(nrx_mqtt_topic_publish_encoded(telem, encode_filler, &sizes[2]) == -1);
+    assert(nrx_mqtt_topic_publish_encoded(telem, encode_filler, &sizes[3]) == 0);
+    assert(nrx_mqtt_topic_publish_encoded(report, encode_filler, &sizes[4]) == 0);
+    PUMP_UNTIL(client, inbox.count == 4);
+    
+    const char expect[] = { 'a', 'b', 'c', 'd' };
+    for (int i = 0; i < 4; i++) {
+        size_t len = strlen(inbox.payloads[i]);
+        assert(len == (expect[i] == 'b' ? 63 : expect[i] == 'a' ? 10 : 30));
+        for (size_t k = 0; k < len; k++) assert(inbox.payloads[i][k] == expect[i]);
+    }
+    assert(strcmp(inbox.topics[0], "robots/r1/telem") == 0 && strcmp(inbox.topics[3], "robots/r1/report") == 0);
+    assert(b.aliased >= 1 && b.alias_errors == 0);
+    
+    nrx_mqtt_stats_t stats;
+    nrx_mqtt_get_stats(client, &stats);
+    assert(stats.messages_dropped == 1);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Encoded publish test passed\n");
+}
+
+// Topic trie
+typedef struct {
+    int count;
+    const char *names[16];
+} hits_t;
+
+static void collect_hit(void *value, void *ctx) {
+    hits_t *hits = ctx;
+    hits->names[hits->count++] = value;
+}
+
+static bool hit(const hits_t *hits, const char *name) {
+    for (int i = 0; i < hits->count; i++) {
+        if (strcmp(hits->names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+static int match(nrx_topic_trie_t *trie, const char *topic, hits_t *hits) {
+    hits->count = 0;
+    return (int)nrx_topic_trie_match(trie, topic, strlen(topic), collect_hit, hits);
+}
+
+static void count_filter(const char *filter, void *value, void *ctx) {
+    assert(strcmp(filter, value) == 0);
+    (*(int *)ctx)++;
+}
+
+void test_topic_trie() {
+    assert(nrx_topic_filter_valid("a/+/c") && nrx_topic_filter_valid("#") && nrx_topic_filter_valid("a//b"));
+    assert(!nrx_topic_filter_valid("a/#/b") && !nrx_topic_filter_valid("a+") && !nrx_topic_filter_valid("#a"));
+    assert(!nrx_topic_filter_valid("") && !nrx_topic_filter_valid("a/b#"));
+    
+    // Each filter's value is its own text
+    static const char *filters[] = {
+        "a/b/c", "a/+/c", "a/#", "#", "+/+", "+", "$SYS/#", "a/b/c/#", "a//c", "a/+",
+    };
+    nrx_topic_trie_t *trie = nrx_topic_trie_create();
+    for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+        assert(nrx_topic_trie_insert(trie, filters[i], (void *)filters[i]) == 0);
+    }
+    assert(nrx_topic_trie_insert(trie, "a/#/b", "bad") == -1);
+    assert(nrx_topic_trie_count(trie) == 10);
+    
+    hits_t hits;
+    assert(match(trie, "a/b/c", &hits) == 5);
+    assert(hit(&hits, "a/b/c") && hit(&hits, "a/+/c") && hit(&hits, "a/#") && hit(&hits, "#") && hit(&hits, "a/b/c/#"));
+    assert(match(trie, "a", &hits) == 3);
+    assert(hit(&hits, "a/#") && hit(&hits, "#") && hit(&hits, "+"));
+    assert(match(trie, "a/x", &hits) == 4);
+    assert(hit(&hits, "a/+") && hit(&hits, "+/+"));
+    assert(match(trie, "a//c", &hits) == 4);
+    assert(hit(&hits, "a//c") && hit(&hits, "a/+/c"));
+    assert(match(trie, "a/", &hits) == 4);
+    assert(hit(&hits, "a/+"));
+    
+    // Wildcards never match a first level starting with $
+    assert(match(trie, "$SYS/uptime", &hits) == 1 && hit(&hits, "$SYS/#"));
+    
+    // Replace, remove, and the filters rebuilt from the trie
+    assert(nrx_topic_trie_insert(trie, "a/+", (void *)"a/+") == 0);
+    assert(nrx_topic_trie_count(trie) == 10);
+    assert(nrx_topic_trie_remove(trie, "a/b/c") == filters[0]);
+    assert(nrx_topic_trie_remove(trie, "a/b/c") == NULL);
+    assert(nrx_topic_trie_remove(trie, "#") == filters[3]);
+    assert(match(trie, "a/b/c", &hits) == 3);
+    assert(nrx_topic_trie_find(trie, "a/b/c/#") == filters[7]);
+    int listed = 0;
+    nrx_topic_trie_foreach(trie, count_filter, &listed);
+    assert(listed == 8);
+    
+    // Churn reuses pruned nodes; matching stays right throughout
+    static char names[64][32];
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 64; i++) {
+            snprintf(names[i], sizeof(names[i]), "fleet/r%d/%s", i, i % 2 ? "+" : "pose");
+            assert(nrx_topic_trie_insert(trie, names[i], names[i]) == 0);
+        }
+        assert(match(trie, "fleet/r7/pose", &hits) == 1 && hit(&hits, "fleet/r7/+"));
+        for (int i = 0; i < 64; i++) {
+            assert(nrx_topic_trie_remove(trie, names[i]) == names[i]);
+        }
+    }
+    assert(nrx_topic_trie_count(trie) == 8);
+    assert(match(trie, "fleet/r7/pose", &hits) == 0);
+    
+    nrx_topic_trie_destroy(trie);
+    printf("✓ Topic trie test passed\n");
+}
+
+typedef struct {
+    int pose, fleet, self_removing;
+    nrx_mqtt_client_t *client;
+} routes_t;
+
+static void on_pose(const nrx_mqtt_message_t *message, void *user_data) {
+    (void)message;
+    ((routes_t *)user_data)->pose++;
+}
+
+static void on_fleet(const nrx_mqtt_message_t *message, void *user_data) {
+    (void)message;
+    ((routes_t *)user_data)->fleet++;
+}
+
+static void on_once(const nrx_mqtt_message_t *message, void *user_data) {
+    (void)message;
+    routes_t *routes = user_data;
+    routes->self_removing++;
+    nrx_mqtt_unsubscribe(routes->client, "once/#");
+}
+
+void test_subscription_callbacks() {
+    broker_t b;
+    broker_start(&b);
+    inbox_t inbox = {0};
+    nrx_mqtt_client_t *client = make_client(&b, NRX_MQTT_V311, &inbox, 30);
+    routes_t routes = { .client = client };
+    
+    assert(nrx_mqtt_subscribe_cb(client, "robots/+/pose", NRX_MQTT_QOS_1, on_pose, &routes) == 0);
+    assert(nrx_mqtt_subscribe_cb(client, "robots/r1/#", NRX_MQTT_QOS_1, on_fleet, &routes) == 0);
+    assert(nrx_mqtt_subscribe_cb(client, "once/#", NRX_MQTT_QOS_0, on_once, &routes) == 0);
+    assert(nrx_mqtt_subscribe(client, "alerts", NRX_MQTT_QOS_0) == 0);
+    assert(nrx_mqtt_subscribe(client, "bad/#/filter", NRX_MQTT_QOS_0) == -1);
+    nrx_mqtt_connect(client);
+    PUMP_UNTIL(client, b.subscribes == 4);
+    
+    // One copy from the broker reaches every matching subscription
+    nrx_mqtt_publish(client, "robots/r1/pose", (const uint8_t *)"p", 1, NRX_MQTT_QOS_1);
+    nrx_mqtt_publish(client, "robots/r2/pose", (const uint8_t *)"p", 1, NRX_MQTT_QOS_1);
+    nrx_mqtt_publish(client, "alerts", (const uint8_t *)"a", 1, NRX_MQTT_QOS_0);
+    nrx_mqtt_publish(client, "once/now", (const uint8_t *)"o", 1, NRX_MQTT_QOS_0);
+    PUMP_UNTIL(client, routes.pose == 2 && routes.fleet == 1 && inbox.count == 1 && routes.self_removing == 1);
+    assert(strcmp(inbox.topics[0], "alerts") == 0);
+    
+    // The callback unsubscribed itself; resubscribing to a filter replaces it
+    nrx_mqtt_publish(client, "once/again", (const uint8_t *)"o", 1, NRX_MQTT_QOS_0);
+    assert(nrx_mqtt_subscribe_cb(client, "robots/+/pose", NRX_MQTT_QOS_1, on_fleet, &routes) == 0);
+    nrx_mqtt_publish(client, "robots/r3/pose", (const uint8_t *)"p", 1, NRX_MQTT_QOS_1);
+    PUMP_UNTIL(client, routes.fleet == 2);
+    assert(routes.pose == 2 && routes.self_removing == 1);
+    
+    nrx_mqtt_destroy(client);
+    broker_stop(&b);
+    printf("✓ Subscription callback test passed\n");
+}
+
+int main() {
+    printf("Running MQTT tests...\n\n");
+    
+    test_qos_flows();
+    test_qos2_delivered_once();
+    test_qos2_table_full();
+    test_keepalive();
+    test_reconnect_resends();
+    test_receive_maximum();
+    test_backoff();
+    test_refused();
+    test_publish_handles();
+    test_batching();
+    test_latest_value_offline();
+    test_store_and_forward();
+    test_journal_survives_restart();
+    test_drop_policies();
+    test_drop_oldest_inflight();
+    test_replay_rate();
+    test_journaled_qos0();
+    test_encoded_publish();
+    test_topic_trie();
+    test_subscription_callbacks();
+    test_steady_state_allocates_nothing();
+    
+    printf("\n✓ All MQTT tests passed!\n");
+    return 0;
+}
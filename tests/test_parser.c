@@ -83,12 +83,51 @@ void test_parse_schedule() {
     printf("✓ Schedule parse test passed\n");
 }
 
+void test_parse_message() {
+    const char *source = 
+        "robot TestBot {\n"
+        "  message Pose as cbor { x: f32, y: f32 }\n"
+        "  message Status {\n"
+        "    battery: f32\n"
+        "    docked: bool\n"
+        "  }\n"
+        "}";
+    
+    lexer_t lexer;
+    lexer_init(&lexer, source, "test");
+    
+    parser_t parser;
+    parser_init(&parser, &lexer);
+    
+    ast_robot_t *robot = parser_parse(&parser);
+    
+    assert(robot != NULL);
+    assert(robot->decl_count == 2);
+    assert(robot->declarations[0]->type == DECL_MESSAGE);
+    
+    ast_message_decl_t *pose = &robot->declarations[0]->as.message;
+    assert(strcmp(pose->name, "Pose") == 0);
+    assert(pose->format == MESSAGE_CBOR);
+    assert(pose->field_count == 2);
+    assert(strcmp(pose->fields[1]->name, "y") == 0);
+    assert(strcmp(pose->fields[1]->type->name, "f32") == 0);
+    
+    ast_message_decl_t *status = &robot->declarations[1]->as.message;
+    assert(status->format == MESSAGE_JSON);
+    assert(status->field_count == 2);
+    assert(strcmp(status->fields[1]->type->name, "bool") == 0);
+    
+    ast_robot_free(robot);
+    printf("✓ Message parse test passed\n");
+}
+
 int main() {
     printf("Running parser tests...\n");
     
     test_parse_minimal();
     test_parse_task();
     test_parse_schedule();
+    test_parse_message();
     
     printf("\n✓ All parser tests passed!\n");
     return 0;
@@ -0,0 +1,269 @@
+#include "../runtime/core/safety.h"
+#include "../runtime/hal/hal.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static int fault_count = 0;
+
+static void on_fault(nrx_fault_code_t fault) {
+    (void)fault;
+    fault_count++;
+}
+
+static void init_safety(void) {
+    nrx_safety_config_t config = {0};
+    config.enable_estop = true;
+    config.fault_handler = on_fault;
+    nrx_safety_init(&config);
+    fault_count = 0;
+}
+
+void test_check_limit() {
+    init_safety();
+    nrx_safety_set_limit(NRX_LIMIT_SPEED, -50.0f, 50.0f);
+    
+    assert(nrx_safety_check_limit(NRX_LIMIT_SPEED, 25.0f));
+    assert(nrx_safety_check_limit(NRX_LIMIT_POWER, 1000.0f));
+    assert(!nrx_safety_check_limit(NRX_LIMIT_SPEED, 75.0f));
+    assert(nrx_safety_get_fault() == NRX_FAULT_LIMIT_EXCEEDED);
+    
+    printf("✓ Limit check test passed\n");
+}
+
+void test_monitor_bounds() {
+    init_safety();
+    nrx_safety_set_limit(NRX_LIMIT_SPEED, -50.0f, 50.0f);
+    int left = nrx_safety_channel_add(NRX_LIMIT_SPEED);
+    int right = nrx_safety_channel_add(NRX_LIMIT_SPEED);
+    assert(left == 0 && right == 1);
+    
+    // Channels without a command never trip
+    assert(nrx_safety_monitor_run(1000) == 0);
+    
+    nrx_safety_command(left, 10.0f);
+    nrx_safety_command(right, 20.0f);
+    assert(nrx_safety_monitor_run(2000) == 0);
+    assert(nrx_safety_get_state() == NRX_SAFETY_NORMAL);
+    
+    nrx_safety_command(right, 60.0f);
+    assert(nrx_safety_monitor_run(3000) == (1u << right));
+    assert(nrx_safety_get_fault() == NRX_FAULT_LIMIT_EXCEEDED);
+    assert(fault_count == 1);
+    
+    // A sustained violation does not re-trip
+    assert(nrx_safety_monitor_run(4000) == (1u << right));
+    assert(fault_count == 1);
+    
+    nrx_safety_monitor_stats_t stats;
+    nrx_safety_monitor_get_stats(&stats);
+    assert(stats.passes == 4);
+    assert(stats.trips == 1);
+    assert(stats.last_trip_channel == right);
+    
+    printf("✓ Monitor bounds test passed\n");
+}
+
+void test_monitor_rate() {
+    init_safety();
+    nrx_safety_set_rate_limit(NRX_LIMIT_SPEED, 100.0f); // 100 units/s
+    int ch = nrx_safety_channel_add(NRX_LIMIT_SPEED);
+    
+    nrx_safety_command(ch, 0.0f);
+    assert(nrx_safety_monitor_run(0) == 0);
+    
+    // 0.05 per ms is within 100/s
+    nrx_safety_command(ch, 0.05f);
+    assert(nrx_safety_monitor_run(1000) == 0);
+    
+    // A second pass at the same timestamp has no interval to measure over
+    nrx_safety_command(ch, 0.06f);
+    assert(nrx_safety_monitor_run(1000) == 0);
+    
+    // Jump of 5 within 1 ms is 5000/s
+    nrx_safety_command(ch, 5.0f);
+    assert(nrx_safety_monitor_run(2000) == 1u);
+    assert(nrx_safety_get_state() == NRX_SAFETY_FAULT);
+    
+    printf("✓ Monitor rate test passed\n");
+}
+
+void test_estop_fanout() {
+    init_safety();
+    
+    nrx_motor_t left, right;
+    nrx_servo_t arm;
+    nrx_motor_init(&left, 10, 11, 12);
+    nrx_motor_init(&right, 20, 21, 22);
+    nrx_servo_init(&arm, 30);
+    assert(nrx_actuator_count() == 3);
+    
+    nrx_motor_set_power(&left, 60.0f);
+    nrx_motor_set_power(&right, -40.0f);
+    nrx_servo_set_angle(&arm, 45.0f);
+    assert(nrx_pwm_get_duty(20) > 0.0f);
+    
+    nrx_safety_estop();
+    assert(nrx_safety_is_estopped());
+    assert(nrx_pwm_get_duty(10) == 0.0f);
+    assert(nrx_pwm_get_duty(20) == 0.0f);
+    assert(nrx_pwm_get_duty(30) == 0.0f);
+    assert(nrx_gpio_read(21) == NRX_GPIO_LOW);
+    assert(nrx_gpio_read(22) == NRX_GPIO_LOW);
+    
+    nrx_estop_stats_t stats;
+    nrx_safety_estop_get_stats(&stats);
+    assert(stats.count == 1);
+    assert(stats.actuators_stopped == 3);
+    assert(stats.worst_latency_us >= stats.last_latency_us);
+    
+    // A limit fault must not clear a latched E-stop
+    nrx_safety_check_limit(NRX_LIMIT_SPEED, 0.0f);
+    nrx_safety_fault(NRX_FAULT_SENSOR);
+    assert(nrx_safety_get_state() == NRX_SAFETY_ESTOP);
+    
+    nrx_safety_estop_reset();
+    printf("✓ E-stop fan-out test passed\n");
+}
+
+void test_monitor_actuators() {
+    init_safety();
+    nrx_safety_set_limit(NRX_LIMIT_POWER, -80.0f, 80.0f);
+    nrx_safety_set_limit(NRX_LIMIT_ANGLE, 0.0f, 120.0f);
+    
+    // Motors and servos feed the monitor themselves
+    nrx_motor_t drive;
+    nrx_servo_t wrist;
+    nrx_motor_init(&drive, 40, 41, 42);
+    nrx_servo_init(&wrist, 43);
+    
+    uint64_t t0 = nrx_time_now_us();
+    assert(nrx_motor_set_power(&drive, 50.0f) == 0);
+    assert(nrx_servo_set_angle(&wrist, 100.0f) == 0);
+    assert(nrx_safety_monitor_run(t0) == 0);
+    
+    // An out-of-range command trips on the very next pass
+    assert(nrx_motor_set_power(&drive, -95.0f) == 0);
+    assert(nrx_safety_monitor_run(t0 + 10000) == 1u);
+    assert(nrx_safety_get_fault() == NRX_FAULT_LIMIT_EXCEEDED);
+    assert(fault_count == 1);
+    
+    // Staged commands are checked the same way
+    nrx_motor_stage_power(&drive, 20.0f);
+    nrx_servo_stage_angle(&wrist, 150.0f);
+    assert(nrx_safety_monitor_run(t0 + 20000) == 2u);
+    assert(fault_count == 2);
+    
+    printf("✓ Monitor actuator test passed\n");
+}
+
+static int watchdog_task_runs = 0;
+
+static void watchdog_task(void *context) {
+    (void)context;
+    if (++watchdog_task_runs >= 3) {
+        nrx_scheduler_stop();
+    }
+}
+
+void test_task_watchdog() {
+    init_safety();
+    
+    uint64_t t0 = nrx_time_now_us();
+    int fast = nrx_safety_watchdog_add("fast", 10);
+    int slow = nrx_safety_watchdog_add("slow", 50);
+    
+    assert(nrx_safety_watchdog_check(t0) == -1);
+    
+    // The fast channel stalls first and is named without scanning
+    assert(nrx_safety_watchdog_check(t0 + 20000) == fast);
+    assert(strcmp(nrx_safety_watchdog_stalled(), "fast") == 0);
+    
+    // A stalled channel reports once until it is fed again
+    assert(nrx_safety_watchdog_check(t0 + 20000) == -1);
+    assert(nrx_safety_watchdog_check(t0 + 60000 + 50000) == slow);
+    
+    nrx_safety_heartbeat(fast);
+    nrx_safety_heartbeat(slow);
+    assert(nrx_safety_watchdog_check(nrx_time_now_us()) == -1);
+    
+    // A channel fed after a stall is watched again
+    uint64_t t1 = nrx_time_now_us();
+    assert(nrx_safety_watchdog_check(t1 + 20000) == fast);
+    nrx_safety_heartbeat(fast);
+    assert(nrx_safety_watchdog_check(nrx_time_now_us() + 20000) == fast);
+    nrx_safety_heartbeat(fast);
+    nrx_safety_heartbeat(slow);
+    
+    // The scheduler feeds attached tasks after each run
+    nrx_scheduler_init(NULL);
+    nrx_task_t *task = nrx_task_create("worker", watchdog_task, NULL, NRX_PRIORITY_MEDIUM);
+    int channel = nrx_safety_watchdog_attach(task, 100);
+    assert(channel == task->watchdog_channel);
+    nrx_task_schedule_periodic(task, 500);
+    nrx_scheduler_start();
+    assert(watchdog_task_runs == 3);
+    
+    nrx_safety_update();
+    assert(nrx_safety_get_state() == NRX_SAFETY_NORMAL);
+    
+    printf("✓ Task watchdog test passed\n");
+}
+
+void test_long_watchdog_timeout() {
+    init_safety();
+    
+    // Two hours is past 32 bits of microseconds (about 71 minutes)
+    uint64_t t0 = nrx_time_now_us();
+    int hourly = nrx_safety_watchdog_add("hourly", 2 * 60 * 60 * 1000);
+    assert(nrx_safety_watchdog_check(t0 + 60ULL * 60 * 1000000) == -1);
+    assert(nrx_safety_watchdog_check(t0 + 2ULL * 60 * 60 * 1000000 + 1000000) == hourly);
+    
+    printf("✓ Long watchdog timeout test passed\n");
+}
+
+static int critical_runs = 0;
+
+static void critical_task(void *context) {
+    (void)context;
+    if (++critical_runs >= 3) {
+        nrx_scheduler_stop();
+    }
+}
+
+void test_critical_reschedule() {
+    nrx_scheduler_init(NULL);
+    nrx_task_t *task = nrx_task_create("monitor", critical_task, NULL, NRX_PRIORITY_LOW);
+    
+    // Rescheduling moves the task instead of linking it in again; a task
+    // linked twice would loop the scheduler forever, which the alarm catches
+    nrx_task_schedule_periodic(task, 1000);
+    nrx_task_schedule_critical(task, 1000);
+    nrx_task_schedule_critical(task, 2000);
+    assert(task->priority == NRX_PRIORITY_HIGH && task->next == NULL);
+    
+    alarm(5);
+    nrx_scheduler_start();
+    alarm(0);
+    assert(critical_runs == 3);
+    
+    nrx_task_delete(task);
+    printf("✓ Critical reschedule test passed\n");
+}
+
+int main() {
+    printf("Running safety tests...\n");
+    
+    test_check_limit();
+    test_monitor_bounds();
+    test_monitor_rate();
+    test_estop_fanout();
+    test_monitor_actuators();
+    test_task_watchdog();
+    test_long_watchdog_timeout();
+    test_critical_reschedule();
+    
+    printf("\n✓ All safety tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,181 @@
+#define _DEFAULT_SOURCE
+
+#include "../runtime/hal/sensor.h"
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Source that returns a scripted sequence, then counts up
+typedef struct {
+    const float *script;
+    size_t length;
+    size_t reads;
+} scripted_source_t;
+
+static float scripted_read(void *context) {
+    scripted_source_t *src = context;
+    size_t i = src->reads++;
+    return i < src->length ? src->script[i] : (float)i;
+}
+
+static nrx_sensor_channel_t *make_channel(nrx_sensor_t *sensor, scripted_source_t *src) {
+    nrx_sensor_init(sensor, src, scripted_read);
+    nrx_sensor_channel_t *channel = nrx_sensor_channel_create("test", sensor, 100);
+    assert(channel != NULL);
+    return channel;
+}
+
+void test_latest_and_history() {
+    scripted_source_t src = {0};
+    nrx_sensor_t sensor;
+    nrx_sensor_channel_t *channel = make_channel(&sensor, &src);
+    
+    nrx_sample_t sample;
+    assert(!nrx_sensor_latest(channel, &sample));
+    
+    for (int i = 0; i < 100; i++) {
+        nrx_sensor_channel_sample(channel);
+    }
+    
+    // Reading never touches the source
+    assert(nrx_sensor_latest(channel, &sample));
+    assert(sample.value == 99.0f);
+    assert(src.reads == 100);
+    
+    nrx_sample_t history[NRX_SENSOR_RING_SIZE];
+    size_t count = nrx_sensor_history(channel, history, NRX_SENSOR_RING_SIZE);
+    assert(count == NRX_SENSOR_RING_SIZE - 1);
+    for (size_t i = 0; i < count; i++) {
+        assert(history[i].value == 99.0f - (float)i);
+        if (i > 0) assert(history[i].timestamp_us <= history[i - 1].timestamp_us);
+    }
+    assert(nrx_sensor_sample_count(channel) == 100);
+    
+    nrx_sensor_channel_destroy(channel);
+    printf("✓ Latest/history test passed\n");
+}
+
+void test_filters_and_decimation() {
+    nrx_sensor_t sensor;
+    nrx_sample_t sample;
+    
+    // Median of 3 removes a single spike
+    const float spiky[] = {1, 1, 50, 1, 1};
+    scripted_source_t src = { spiky, 5, 0 };
+    nrx_sensor_channel_t *channel = make_channel(&sensor, &src);
+    assert(nrx_sensor_channel_add_filter(channel, NRX_FILTER_MEDIAN, 3) == 0);
+    for (int i = 0; i < 5; i++) {
+        nrx_sensor_channel_sample(channel);
+        assert(nrx_sensor_latest(channel, &sample));
+        assert(sample.value < 2.0f);
+    }
+    nrx_sensor_channel_destroy(channel);
+    
+    // Moving average of 4 over a ramp lags by 1.5 samples
+    src = (scripted_source_t){0};
+    channel = make_channel(&sensor, &src);
+    assert(nrx_sensor_channel_add_filter(channel, NRX_FILTER_MOVING_AVERAGE, 4) == 0);
+    for (int i = 0; i < 20; i++) {
+        nrx_sensor_channel_sample(channel);
+    }
+    assert(nrx_sensor_latest(channel, &sample));
+    assert(fabsf(sample.value - 17.5f) < 1e-4f);
+    nrx_sensor_channel_destroy(channel);
+    
+    // IIR step response, decimated by 4: every stage sees every raw sample
+    const float step[] = {0, 1, 1, 1, 1, 1, 1, 1};
+    src = (scripted_source_t){ step, 8, 0 };
+    channel = make_channel(&sensor, &src);
+    assert(nrx_sensor_channel_add_filter(channel, NRX_FILTER_IIR, 0.5f) == 0);
+    assert(nrx_sensor_channel_set_decimation(channel, 4) == 0);
+    for (int i = 0; i < 8; i++) {
+        nrx_sensor_channel_sample(channel);
+    }
+    assert(nrx_sensor_sample_count(channel) == 2);
+    assert(nrx_sensor_latest(channel, &sample));
+    assert(fabsf(sample.value - (1.0f - 1.0f / 128.0f)) < 1e-6f);
+    
+    // Bad parameters are rejected
+    assert(nrx_sensor_channel_add_filter(channel, NRX_FILTER_IIR, 0.0f) == -1);
+    assert(nrx_sensor_channel_add_filter(channel, NRX_FILTER_MEDIAN, NRX_SENSOR_WINDOW_MAX + 1) == -1);
+    nrx_sensor_channel_destroy(channel);
+    
+    printf("✓ Filter/decimation test passed\n");
+}
+
+void test_interpolation() {
+    scripted_source_t src = {0};
+    nrx_sensor_t sensor;
+    nrx_sensor_channel_t *channel = make_channel(&sensor, &src);
+    
+    for (int i = 0; i < 3; i++) {
+        nrx_sensor_channel_sample(channel);
+        usleep(2000);
+    }
+    
+    nrx_sample_t history[3];
+    assert(nrx_sensor_history(channel, history, 3) == 3);
+    
+    float value;
+    uint64_t mid = history[2].timestamp_us + (history[1].timestamp_us - history[2].timestamp_us) / 2;
+    assert(nrx_sensor_value_at(channel, mid, &value));
+    assert(fabsf(value - 0.5f) < 0.01f);
+    
+    assert(nrx_sensor_value_at(channel, history[0].timestamp_us + 1000000, &value));
+    assert(value == 2.0f);
+    assert(!nrx_sensor_value_at(channel, history[2].timestamp_us - 1, &value));
+    
+    nrx_sensor_channel_destroy(channel);
+    printf("✓ Interpolation test passed\n");
+}
+
+#define WRITER_SAMPLES 200000
+
+static void *writer(void *arg) {
+    nrx_sensor_channel_t *channel = arg;
+    for (int i = 0; i < WRITER_SAMPLES; i++) {
+        nrx_sensor_channel_sample(channel);
+    }
+    return NULL;
+}
+
+void test_concurrent_readers() {
+    scripted_source_t src = {0};
+    nrx_sensor_t sensor;
+    nrx_sensor_channel_t *channel = make_channel(&sensor, &src);
+    
+    pthread_t thread;
+    pthread_create(&thread, NULL, writer, channel);
+    
+    // Every snapshot is a consistent run of consecutive samples
+    nrx_sample_t history[NRX_SENSOR_RING_SIZE];
+    float last = -1.0f;
+    while (nrx_sensor_sample_count(channel) < WRITER_SAMPLES) {
+        size_t count = nrx_sensor_history(channel, history, NRX_SENSOR_RING_SIZE);
+        for (size_t i = 1; i < count; i++) {
+            assert(history[i].value == history[i - 1].value - 1.0f);
+        }
+        if (count > 0) {
+            assert(history[0].value >= last);
+            last = history[0].value;
+        }
+    }
+    
+    pthread_join(thread, NULL);
+    nrx_sensor_channel_destroy(channel);
+    printf("✓ Concurrent reader test passed\n");
+}
+
+int main() {
+    printf("Running sensor pipeline tests...\n");
+    
+    test_latest_and_history();
+    test_filters_and_decimation();
+    test_interpolation();
+    test_concurrent_readers();
+    
+    printf("\n✓ All sensor pipeline tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,304 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../runtime/hal/hal_sim.h"
+#include "../runtime/core/scheduler.h"
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PI 3.14159265f
+
+static nrx_motor_t left, right;
+
+static void setup(void) {
+    assert(nrx_sim_init(NULL) == 0);
+    nrx_motor_init(&left, 12, 5, 6);
+    nrx_motor_init(&right, 13, 19, 26);
+}
+
+static void drive(float left_power, float right_power) {
+    nrx_motor_set_power(&left, left_power);
+    nrx_motor_set_power(&right, right_power);
+}
+
+void test_virtual_time() {
+    setup();
+    
+    uint64_t start = nrx_time_now_us();
+    assert(start == 0);
+    nrx_delay_ms(250);
+    assert(nrx_time_now_us() == 250000);
+    nrx_sim_run(750000);
+    assert(nrx_time_now_us() == 1000000);
+    
+    nrx_sim_deinit();
+    assert(!nrx_time_is_virtual());
+    printf("✓ Virtual time test passed\n");
+}
+
+void test_straight_and_turn() {
+    setup();
+    
+    // Full power settles at 0.5 m/s well within a second
+    drive(100.0f, 100.0f);
+    nrx_sim_run(2000000);
+    float x, y, theta, v, omega;
+    nrx_sim_get_pose(&x, &y, &theta);
+    nrx_sim_get_velocity(&v, &omega);
+    assert(fabsf(v - 0.5f) < 1e-3f);
+    assert(fabsf(omega) < 1e-6f);
+    assert(fabsf(x - (1.0f - 0.5f * 0.05f)) < 0.01f);     // Lag costs one time constant
+    assert(fabsf(y) < 1e-6f && fabsf(theta) < 1e-6f);
+    
+    // Spin in place: omega = 2 * 0.25 / 0.15
+    nrx_sim_set_pose(0.0f, 0.0f, 0.0f);
+    drive(-50.0f, 50.0f);
+    nrx_sim_run(500000);
+    nrx_sim_get_velocity(&v, &omega);
+    assert(fabsf(v) < 1e-4f);
+    assert(fabsf(omega - 0.5f / 0.15f) < 0.01f);
+    
+    // Stopping decays the wheels
+    drive(0.0f, 0.0f);
+    nrx_sim_run(500000);
+    nrx_sim_get_velocity(&v, &omega);
+    assert(fabsf(v) < 1e-3f && fabsf(omega) < 1e-3f);
+    
+    nrx_sim_deinit();
+    printf("✓ Straight/turn test passed\n");
+}
+
+void test_collision() {
+    setup();
+    nrx_sim_add_wall(1.0f, -1.0f, 1.0f, 1.0f);
+    
+    drive(100.0f, 100.0f);
+    nrx_sim_run(5000000);
+    float x, y, theta;
+    nrx_sim_get_pose(&x, &y, &theta);
+    
+    // Held one radius short of the wall, one collision for one contact
+    assert(x < 0.9f && x > 0.88f);
+    assert(nrx_sim_collisions() == 1);
+    
+    // Backing off and driving in again is a second contact
+    drive(-100.0f, -100.0f);
+    nrx_sim_run(500000);
+    drive(100.0f, 100.0f);
+    nrx_sim_run(2000000);
+    assert(nrx_sim_collisions() == 2);
+    
+    nrx_sim_deinit();
+    printf("✓ Collision test passed\n");
+}
+
+void test_ultrasonic() {
+    setup();
+    nrx_sim_add_box(-2.0f, -2.0f, 2.0f, 2.0f);
+    nrx_sim_set_pose(0.5f, 0.0f, 0.0f);
+    
+    float direct = nrx_sim_ray_cast(0.5f, 0.0f, 0.0f, 10.0f);
+    assert(fabsf(direct - 1.5f) < 1e-5f);
+    
+    // Sensor on the robot's front edge sees 2.0 - 0.5 - 0.1
+    int front = nrx_sim_add_ultrasonic(0.0f, 4.0f, 0.0f, 3);
+    assert(front == 0);
+    assert(fabsf(nrx_sim_ultrasonic_read(front) - 1.4f) < 1e-4f);
+    
+    // Through the ADC: range / max range as 12-bit counts
+    uint16_t counts = nrx_adc_read(3);
+    assert(abs((int)counts - (int)(1.4f / 4.0f * 4095.0f + 0.5f)) <= 1);
+    assert(nrx_adc_read(4) == 0);
+    
+    // And through a sensor source
+    nrx_sensor_t sensor;
+    nrx_sim_ultrasonic_sensor(&sensor, front);
+    assert(fabsf(nrx_sensor_read(&sensor) - 1.4f) < 1e-4f);
+    
+    // Beyond range reads max range
+    int far = nrx_sim_add_ultrasonic(PI, 1.0f, 0.0f, NRX_SIM_NO_PIN);
+    assert(fabsf(nrx_sim_ultrasonic_read(far) - 1.0f) < 1e-6f);
+    
+    // Noise stays near the truth
+    int noisy = nrx_sim_add_ultrasonic(0.0f, 4.0f, 0.01f, NRX_SIM_NO_PIN);
+    float sum = 0.0f;
+    for (int i = 0; i < 1000; i++) sum += nrx_sim_ultrasonic_read(noisy);
+    assert(fabsf(sum / 1000.0f - 1.4f) < 0.005f);
+    
+    // Round obstacles
+    nrx_sim_clear_world();
+    nrx_sim_add_obstacle(2.0f, 0.0f, 0.25f);
+    assert(fabsf(nrx_sim_ray_cast(0.0f, 0.0f, 0.0f, 10.0f) - 1.75f) < 1e-5f);
+    assert(nrx_sim_ray_cast(0.0f, 0.0f, PI / 2.0f, 10.0f) == 10.0f);
+    
+    nrx_sim_deinit();
+    printf("✓ Ultrasonic test passed\n");
+}
+
+void test_lidar_frames() {
+    setup();
+    nrx_sim_add_box(-1.0f, -1.0f, 1.0f, 1.0f);
+    assert(nrx_sim_add_lidar(2, 360, 8.0f, 10.0f) == 0);
+    nrx_uart_t *uart = nrx_uart_init(2, 115200);
+    assert(uart != NULL);
+    
+    // Nothing until the first scan is due, then one frame per 100 ms
+    assert(nrx_uart_available(uart) == 0);
+    nrx_sim_run(300000);
+    assert(nrx_uart_available(uart) == 3 * (4 + 2 * 360));
+    
+    uint8_t frame[4 + 2 * 360];
+    assert(nrx_uart_read(uart, frame, sizeof(frame)) == (int)sizeof(frame));
+    assert(frame[0] == 0xA5 && frame[1] == 0x5A);
+    assert((frame[2] | frame[3] << 8) == 360);
+    
+    // Walls 1 m away along the axes, sqrt(2) in the corners
+    uint16_t ahead = (uint16_t)(frame[4] | frame[5] << 8);
+    uint16_t left_side = (uint16_t)(frame[4 + 2 * 90] | frame[5 + 2 * 90] << 8);
+    uint16_t corner = (uint16_t)(frame[4 + 2 * 45] | frame[5 + 2 * 45] << 8);
+    assert(ahead == 1000 && left_side == 1000);
+    assert(abs((int)corner - 1414) <= 1);
+    
+    float ranges[360];
+    assert(nrx_sim_lidar_scan(ranges, 360, 8.0f) == 360);
+    assert(fabsf(ranges[180] - 1.0f) < 1e-4f);
+    
+    nrx_uart_deinit(uart);
+    nrx_sim_deinit();
+    printf("✓ Lidar frame test passed\n");
+}
+
+// A wall follower run twice must land on exactly the same pose
+static void follow_wall(float *x, float *y, float *theta, uint32_t seed) {
+    nrx_sim_config_t config = {
+        .left_pwm = 12, .left_dir1 = 5, .left_dir2 = 6,
+        .right_pwm = 13, .right_dir1 = 19, .right_dir2 = 26,
+        .seed = seed,
+    };
+    assert(nrx_sim_init(&config) == 0);
+    nrx_motor_init(&left, 12, 5, 6);
+    nrx_motor_init(&right, 13, 19, 26);
+    nrx_sim_add_box(-2.0f, -2.0f, 2.0f, 2.0f);
+    nrx_sim_add_obstacle(0.8f, 0.6f, 0.2f);
+    int front = nrx_sim_add_ultrasonic(0.0f, 3.0f, 0.02f, NRX_SIM_NO_PIN);
+    
+    for (int i = 0; i < 2000; i++) {
+        float range = nrx_sim_ultrasonic_read(front);
+        if (range < 0.4f) drive(-40.0f, 40.0f);
+        else drive(60.0f, 55.0f);
+        nrx_delay_ms(10);
+    }
+    
+    nrx_sim_get_pose(x, y, theta);
+    nrx_sim_deinit();
+}
+
+void test_determinism() {
+    float x1, y1, t1, x2, y2, t2, x3, y3, t3;
+    follow_wall(&x1, &y1, &t1, 42);
+    follow_wall(&x2, &y2, &t2, 42);
+    follow_wall(&x3, &y3, &t3, 7);
+    
+    assert(x1 == x2 && y1 == y2 && t1 == t2);
+    assert(x1 != x3 || y1 != y3 || t1 != t3);       // Noise seed matters
+    printf("✓ Determinism test passed\n");
+}
+
+// A whole program under the scheduler, well beyond real time
+static uint32_t control_runs;
+
+static void control_task(void *context) {
+    (void)context;
+    control_runs++;
+    
+    float range = nrx_sim_ultrasonic_read(0);
+    if (range < 0.5f) drive(-50.0f, 50.0f);
+    else drive(70.0f, 70.0f);
+    
+    if (nrx_time_now_us() >= 600000000ULL) nrx_scheduler_stop();
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void test_scheduler_faster_than_real_time() {
+    setup();
+    nrx_sim_add_box(-3.0f, -3.0f, 3.0f, 3.0f);
+    nrx_sim_add_ultrasonic(0.0f, 3.0f, 0.0f, NRX_SIM_NO_PIN);
+    
+    nrx_scheduler_init(NULL);
+    nrx_task_t *task = nrx_task_create("control", control_task, NULL, NRX_PRIORITY_HIGH);
+    nrx_task_schedule_periodic(task, 50);
+    
+    control_runs = 0;
+    double start = wall_seconds();
+    nrx_scheduler_start();
+    double elapsed = wall_seconds() - start;
+    
+    // Ten simulated minutes at 50 Hz
+    assert(control_runs >= 29999 && control_runs <= 30001);
+    assert(nrx_sim_collisions() == 0);
+    double speedup = 600.0 / elapsed;
+    printf("  600 s simulated in %.3f s (%.0fx real time)\n", elapsed, speedup);
+    assert(speedup > 50.0);
+    
+    nrx_task_delete(task);
+    nrx_sim_deinit();
+    printf("✓ Scheduler speedup test passed\n");
+}
+
+static atomic_bool observer_running;
+
+static void *observer(void *arg) {
+    (void)arg;
+    float x, y, theta;
+    while (atomic_load(&observer_running)) nrx_sim_get_pose(&x, &y, &theta);
+    return NULL;
+}
+
+void test_estop_while_model_busy() {
+    setup();
+    drive(100.0f, 100.0f);
+    nrx_sim_run(1000000);
+    
+    // The E-stop lands while another thread keeps the model busy; its
+    // writes must neither wait for the model nor race with it
+    pthread_t thread;
+    atomic_store(&observer_running, true);
+    assert(pthread_create(&thread, NULL, observer, NULL) == 0);
+    assert(nrx_hal_estop_all() >= 2);
+    atomic_store(&observer_running, false);
+    pthread_join(thread, NULL);
+    
+    nrx_sim_run(500000);
+    float v, omega;
+    nrx_sim_get_velocity(&v, &omega);
+    assert(fabsf(v) < 1e-3f && fabsf(omega) < 1e-3f);
+    
+    nrx_hal_estop_release();
+    nrx_sim_deinit();
+    printf("✓ E-stop while busy test passed\n");
+}
+
+int main() {
+    printf("Running simulator tests...\n\n");
+    
+    test_virtual_time();
+    test_straight_and_turn();
+    test_collision();
+    test_ultrasonic();
+    test_lidar_frames();
+    test_determinism();
+    test_scheduler_faster_than_real_time();
+    test_estop_while_model_busy();
+    
+    printf("\n✓ All simulator tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,1027 @@
+#include "../runtime/swarm/swarm.h"
+#include "../runtime/swarm/spatial.h"
+#include "../runtime/swarm/pose_codec.h"
+#include "../runtime/swarm/assign.h"
+#include "../runtime/swarm/coverage.h"
+#include "../runtime/swarm/raft.h"
+#include "../runtime/swarm/sim_net.h"
+#include "../runtime/core/scheduler.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static nrx_swarm_t *make_swarm(uint32_t id, size_t max_robots) {
+    nrx_swarm_config_t config = {
+        .robot_id = id,
+        .swarm_name = "test",
+        .timeout_ms = 1000,
+        .max_robots = max_robots,
+        .cell_size = 2.0f,
+    };
+    return nrx_swarm_init(&config);
+}
+
+static float frand_unit(void) {
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static void put(nrx_swarm_t *swarm, uint32_t id, float x, float y) {
+    nrx_robot_pose_t pose = { .id = id, .x = x, .y = y };
+    assert(nrx_swarm_update_pose(swarm, &pose) == 0);
+}
+
+void test_robot_table() {
+    nrx_time_set_virtual(true, 1000000);
+    nrx_swarm_t *swarm = make_swarm(1, 64);
+    assert(swarm);
+    assert(nrx_swarm_get_robot_count(swarm) == 1);
+    assert(nrx_swarm_is_robot_alive(swarm, 1));
+    
+    // Adds and removes against a reference, so the id index is exercised
+    // through many backward shifts
+    bool present[200] = { false };
+    present[1] = true;
+    srand(7);
+    for (int round = 0; round < 2000; round++) {
+        uint32_t id = 2 + (uint32_t)(rand() % 198);
+        if (!present[id] && nrx_swarm_get_robot_count(swarm) < 64) {
+            put(swarm, id, (float)id, 0.0f);
+            present[id] = true;
+        } else if (present[id] && rand() % 2) {
+            // Go silent past the timeout while everyone else speaks up
+            nrx_time_advance_us(1001000);
+            for (uint32_t other = 2; other < 200; other++) {
+                if (present[other] && other != id) put(swarm, other, (float)other, 0.0f);
+            }
+            nrx_swarm_loop(swarm);
+            present[id] = false;
+        }
+        
+        size_t expected = 0;
+        for (uint32_t other = 1; other < 200; other++) {
+            nrx_robot_pose_t pose;
+            bool found = nrx_swarm_get_pose(swarm, other, &pose) == 0;
+            if (other == 1) continue;
+            assert(found == present[other]);
+            if (found) assert(pose.id == other && pose.x == (float)other);
+            expected += present[other];
+        }
+        assert(nrx_swarm_get_robot_count(swarm) == expected + 1);
+    }
+    
+    uint32_t ids[64];
+    int n = nrx_swarm_get_robots(swarm, ids, 64);
+    assert(n == (int)nrx_swarm_get_robot_count(swarm));
+    for (int i = 0; i < n; i++) assert(ids[i] == 1 || present[ids[i]]);
+    
+    // A full table refuses newcomers
+    nrx_swarm_t *small = make_swarm(1, 2);
+    put(small, 5, 0.0f, 0.0f);
+    nrx_robot_pose_t pose = { .id = 6 };
+    assert(nrx_swarm_update_pose(small, &pose) == -1);
+    
+    // Late poses do not overwrite newer ones
+    uint64_t now = nrx_time_now_us();
+    nrx_robot_pose_t newer = { .id = 5, .x = 5.0f, .timestamp_us = now + 2000 };
+    nrx_robot_pose_t older = { .id = 5, .x = 1.0f, .timestamp_us = now + 1000 };
+    nrx_swarm_update_pose(small, &newer);
+    nrx_swarm_update_pose(small, &older);
+    assert(nrx_swarm_get_pose(small, 5, &pose) == 0 && pose.x == 5.0f);
+    
+    // ...and do not keep a silent robot alive
+    nrx_time_advance_us(1500000);
+    nrx_swarm_update_pose(small, &older);
+    assert(!nrx_swarm_is_robot_alive(small, 5));
+    nrx_swarm_deinit(small);
+    
+    nrx_swarm_deinit(swarm);
+    nrx_time_set_virtual(false, 0);
+    printf("✓ Robot table test passed\n");
+}
+
+typedef struct {
+    uint32_t hits[4096];
+    size_t count;
+} hits_t;
+
+static void record(uint32_t item, float x, float y, float dist_sq, void *ctx) {
+    (void)x; (void)y; (void)dist_sq;
+    hits_t *h = ctx;
+    h->hits[h->count++] = item;
+}
+
+void test_spatial_grid() {
+    enum { N = 2000 };
+    static float xs[N], ys[N];
+    nrx_spatial_grid_t *grid = nrx_spatial_create(N, 3.0f);
+    assert(grid);
+    
+    srand(11);
+    for (int round = 0; round < 3; round++) {
+        // Scatter, then move everything a little or a lot
+        for (uint32_t i = 0; i < N; i++) {
+            if (round > 0 && i % 5 == 0) {
+                nrx_spatial_remove(grid, i);
+                continue;
+            }
+            float spread = round == 2 ? 0.5f : 200.0f;
+            xs[i] = (round == 2 ? xs[i] : -100.0f) + spread * (float)rand() / RAND_MAX;
+            ys[i] = (round == 2 ? ys[i] : -100.0f) + spread * (float)rand() / RAND_MAX;
+            nrx_spatial_update(grid, i, xs[i], ys[i]);
+        }
+        
+        static const float radii[] = { 0.0f, 1.0f, 4.5f, 20.0f, 1000.0f };
+        for (int q = 0; q < 100; q++) {
+            float qx = -120.0f + 240.0f * (float)rand() / RAND_MAX;
+            float qy = -120.0f + 240.0f * (float)rand() / RAND_MAX;
+            float r = radii[q % 5];
+            
+            static hits_t h;
+            h.count = 0;
+            nrx_spatial_query(grid, qx, qy, r, record, &h);
+            
+            bool seen[N] = { false };
+            for (size_t k = 0; k < h.count; k++) {
+                assert(!seen[h.hits[k]]);
+                seen[h.hits[k]] = true;
+            }
+            for (uint32_t i = 0; i < N; i++) {
+                float dx = xs[i] - qx, dy = ys[i] - qy;
+                bool inside = nrx_spatial_contains(grid, i) && dx * dx + dy * dy <= r * r;
+                assert(seen[i] == inside);
+            }
+        }
+    }
+    
+    nrx_spatial_destroy(grid);
+    printf("✓ Spatial grid test passed\n");
+}
+
+// Loopback network: every broadcast reaches every other swarm
+typedef struct {
+    nrx_swarm_t *members[4];
+    int count;
+    int delivered;
+} network_t;
+
+static int deliver(const nrx_swarm_message_t *msg, void *ctx) {
+    network_t *net = ctx;
+    for (int i = 0; i < net->count; i++) {
+        nrx_swarm_receive(net->members[i], msg);
+        net->delivered++;
+    }
+    return 0;
+}
+
+static int received_types[8];
+
+static void on_message(nrx_swarm_message_t *msg, void *user_data) {
+    (void)user_data;
+    received_types[msg->type]++;
+}
+
+void test_messaging() {
+    nrx_time_set_virtual(true, 5000000);
+    network_t net = { .count = 3 };
+    for (uint32_t i = 0; i < 3; i++) {
+        nrx_swarm_config_t config = {
+            .robot_id = 10 + i,
+            .heartbeat_interval_ms = 100,
+            .timeout_ms = 500,
+            .transport = deliver,
+            .transport_ctx = &net,
+        };
+        net.members[i] = nrx_swarm_init(&config);
+        assert(net.members[i]);
+    }
+    nrx_swarm_set_callback(net.members[1], on_message, NULL);
+    
+    // Own poses are broadcast and land in everyone's table
+    nrx_robot_pose_t pose = { .x = 3.0f, .y = -1.0f, .heading = 0.5f };
+    assert(nrx_swarm_update_pose(net.members[0], &pose) == 0);
+    nrx_robot_pose_t seen;
+    assert(nrx_swarm_get_pose(net.members[1], 10, &seen) == 0);
+    assert(seen.x == 3.0f && seen.y == -1.0f && seen.timestamp_us == 5000000);
+    assert(fabsf(seen.heading - 0.5f) < 1e-4f);
+    assert(nrx_swarm_get_pose(net.members[2], 10, &seen) == 0);
+    assert(received_types[NRX_MSG_POSE] == 1);
+    
+    // Direct messages reach only their target
+    uint8_t data[3] = { 1, 2, 3 };
+    assert(nrx_swarm_send(net.members[0], 12, NRX_MSG_DATA, data, sizeof(data)) == 0);
+    assert(received_types[NRX_MSG_DATA] == 0);
+    assert(nrx_swarm_send(net.members[0], 11, NRX_MSG_DATA, data, sizeof(data)) == 0);
+    assert(received_types[NRX_MSG_DATA] == 1);
+    
+    // Quiet robots send heartbeats; silent ones drop out
+    nrx_time_advance_us(150000);
+    nrx_swarm_loop(net.members[2]);
+    assert(received_types[NRX_MSG_HEARTBEAT] == 1);
+    assert(nrx_swarm_is_robot_alive(net.members[1], 12));
+    assert(nrx_swarm_get_robot_count(net.members[1]) == 3);
+    
+    nrx_time_advance_us(400000);
+    assert(!nrx_swarm_is_robot_alive(net.members[1], 10));
+    assert(nrx_swarm_is_robot_alive(net.members[1], 12));
+    nrx_swarm_loop(net.members[1]);
+    assert(nrx_swarm_get_robot_count(net.members[1]) == 2);
+    assert(nrx_swarm_get_pose(net.members[1], 10, &seen) == -1);
+    
+    nrx_swarm_stats_t stats;
+    nrx_swarm_get_stats(net.members[0], &stats);
+    assert(stats.messages_sent == 3 && stats.messages_received == 2);
+    
+    for (int i = 0; i < 3; i++) nrx_swarm_deinit(net.members[i]);
+    nrx_time_set_virtual(false, 0);
+    printf("✓ Messaging test passed\n");
+}
+
+void test_neighbors_and_flocking() {
+    nrx_time_set_virtual(true, 1000000);
+    nrx_swarm_t *swarm = make_swarm(1, 16);
+    float vx = 1.0f, vy = 0.0f;
+    nrx_flock_params_t flock = { 0.0f, 0.0f, 1.0f, 0.0f, 5.0f };
+    assert(nrx_swarm_flock_update(swarm, &flock, &vx, &vy) == -1);
+    
+    put(swarm, 1, 0.0f, 0.0f);
+    put(swarm, 2, 2.0f, 2.0f);
+    put(swarm, 3, 2.0f, -2.0f);
+    put(swarm, 4, 30.0f, 0.0f);
+    
+    nrx_robot_pose_t near[8];
+    assert(nrx_swarm_neighbors(swarm, 0.0f, 0.0f, 5.0f, near, 8) == 2);
+    assert(nrx_swarm_neighbors(swarm, 0.0f, 0.0f, 5.0f, near, 1) == 1);
+    assert(nrx_swarm_neighbors(swarm, 30.0f, 0.0f, 1.0f, near, 8) == 1 && near[0].id == 4);
+    
+    // Cohesion pulls toward the centroid of the neighbors, (2, 0)
+    assert(nrx_swarm_flock_update(swarm, &flock, &vx, &vy) == 2);
+    assert(fabsf(vx - 3.0f) < 1e-5f && fabsf(vy) < 1e-5f);
+    
+    nrx_swarm_stats_t stats;
+    nrx_swarm_get_stats(swarm, &stats);
+    assert(fabsf(stats.avg_distance_to_neighbors - sqrtf(8.0f)) < 1e-5f);
+    
+    // Separation pushes away; the speed limit holds
+    nrx_flock_params_t apart = { 1.0f, 0.0f, 0.0f, 0.5f, 5.0f };
+    vx = vy = 0.0f;
+    nrx_swarm_flock_update(swarm, &apart, &vx, &vy);
+    assert(vx < 0.0f && fabsf(vy) < 1e-5f);
+    assert(fabsf(sqrtf(vx * vx + vy * vy) - 0.5f) < 1e-5f);
+    
+    // Alignment follows the neighbors' velocity, estimated from their poses
+    nrx_time_advance_us(500000);
+    put(swarm, 2, 2.0f, 3.0f);
+    put(swarm, 3, 2.0f, -1.0f);
+    nrx_flock_params_t align = { 0.0f, 1.0f, 0.0f, 0.0f, 5.0f };
+    vx = vy = 0.0f;
+    nrx_swarm_flock_update(swarm, &align, &vx, &vy);
+    assert(fabsf(vx) < 1e-4f && fabsf(vy - 2.0f) < 1e-4f);
+    
+    nrx_swarm_deinit(swarm);
+    nrx_time_set_virtual(false, 0);
+    printf("✓ Neighbors and flocking test passed\n");
+}
+
+void test_collision_avoidance() {
+    nrx_swarm_t *swarm = make_swarm(1, 16);
+    put(swarm, 1, 0.0f, 0.0f);
+    put(swarm, 2, 1.0f, 0.0f);
+    
+    // Heading straight at a robot inside min_distance: the closing part goes
+    nrx_collision_params_t params = { 1.5f, 0.0f };
+    float vx = 1.0f, vy = 1.0f;
+    assert(nrx_swarm_avoid_collisions(swarm, &params, &vx, &vy) == 1);
+    assert(fabsf(vx) < 1e-6f && fabsf(vy - 1.0f) < 1e-6f);
+    
+    // Moving away is left alone
+    vx = -1.0f, vy = 0.0f;
+    assert(nrx_swarm_avoid_collisions(swarm, &params, &vx, &vy) == 0 && vx == -1.0f);
+    
+    // Between min_distance and twice that, only part of it
+    params.min_distance = 0.8f;
+    vx = 1.0f, vy = 0.0f;
+    assert(nrx_swarm_avoid_collisions(swarm, &params, &vx, &vy) == 1);
+    assert(fabsf(vx - 0.25f) < 1e-5f);
+    
+    // A cap on the reduction keeps some speed
+    params = (nrx_collision_params_t){ 1.5f, 0.5f };
+    vx = 1.0f, vy = 0.2f;
+    nrx_swarm_avoid_collisions(swarm, &params, &vx, &vy);
+    assert(fabsf(sqrtf(vx * vx + vy * vy) - 0.5f * sqrtf(1.04f)) < 1e-5f && vx == 0.0f);
+    
+    nrx_swarm_deinit(swarm);
+    printf("✓ Collision avoidance test passed\n");
+}
+
+static bool same_q(const nrx_pose_q_t *a, const nrx_pose_q_t *b) {
+    return a->x == b->x && a->y == b->y && a->z == b->z && a->heading == b->heading &&
+           a->vx == b->vx && a->vy == b->vy && a->timestamp_us == b->timestamp_us;
+}
+
+void test_pose_codec() {
+    nrx_pose_keyframe_t tx = { 0 }, rx = { 0 };
+    nrx_robot_pose_t pose = { .x = 12.345f, .y = -7.5f, .z = 0.25f, .heading = -3.0f,
+                              .timestamp_us = 123456789 };
+    nrx_pose_rate_t rate = { 1.2f, -0.4f, 0.3f };
+    nrx_pose_q_t q, out;
+    uint8_t buf[NRX_POSE_MAX_PAYLOAD];
+    
+    // Keyframe: every field back within half a step
+    nrx_pose_quantize(&pose, &rate, 10000, &q);
+    assert(q.x == 1235 && q.y == -750 && q.z == 25 && q.vx == 120 && q.vy == -40 && q.yaw_rate == 3129);
+    size_t len = nrx_pose_encode_keyframe(&tx, &q, 10000, buf);
+    assert(len > 0 && len < 28 && tx.valid && tx.seq == 0);
+    assert(nrx_pose_decode(&rx, buf, len, &out) == 0 && rx.valid && rx.resolution_um == 10000);
+    assert(same_q(&out, &q));
+    
+    nrx_robot_pose_t back;
+    nrx_pose_rate_t back_rate;
+    nrx_pose_dequantize(&out, rx.resolution_um, &back, &back_rate);
+    assert(fabsf(back.x - pose.x) <= 0.0051f && fabsf(back.heading - pose.heading) < 1e-4f);
+    assert(fabsf(back_rate.vx - 1.2f) < 1e-6f && fabsf(back_rate.yaw_rate - 0.3f) < 1e-4f);
+    assert(back.timestamp_us == pose.timestamp_us);
+    
+    // Deltas are small, and the heading wraps the short way round
+    pose.x += 0.5f;
+    pose.heading = 3.1f;
+    pose.timestamp_us += 20000;
+    nrx_pose_quantize(&pose, &rate, 10000, &q);
+    size_t delta = nrx_pose_encode_delta(&tx, &q, buf);
+    assert(delta > 0 && delta <= 13);
+    assert(nrx_pose_decode(&rx, buf, delta, &out) == 0 && same_q(&out, &q));
+    
+    // Deltas decode only against their own keyframe
+    uint8_t stale[NRX_POSE_MAX_PAYLOAD];
+    memcpy(stale, buf, delta);
+    len = nrx_pose_encode_keyframe(&tx, &q, 10000, buf);
+    assert(tx.seq == 1);
+    assert(nrx_pose_decode(&rx, stale, delta, &out) == 0);
+    nrx_pose_decode(&rx, buf, len, &out);
+    assert(nrx_pose_decode(&rx, stale, delta, &out) == -1);
+    nrx_pose_keyframe_t fresh = { 0 };
+    assert(nrx_pose_decode(&fresh, stale, delta, &out) == -1);
+    
+    // Truncated or padded payloads are refused
+    for (size_t n = 0; n < len; n++) assert(nrx_pose_decode(&fresh, buf, n, &out) == -1);
+    buf[len] = 0;
+    assert(nrx_pose_decode(&fresh, buf, len + 1, &out) == -1);
+    assert(!fresh.valid);
+    
+    // A hostile delta far outside int32 is refused, not added
+    static const uint8_t hostile[] = {
+        1, 1, 0,
+        0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01,   // dx = INT64_MAX
+        0, 0, 0, 0, 0, 0,
+    };
+    assert(rx.valid && rx.seq == 1);
+    assert(nrx_pose_decode(&rx, hostile, sizeof(hostile), &out) == -1);
+    
+    // Prediction stops at the horizon; the heading wraps
+    nrx_robot_pose_t p = { .x = 1.0f, .heading = 3.0f, .timestamp_us = 1000000 }, ahead;
+    nrx_pose_rate_t moving = { 2.0f, 0.0f, 1.0f };
+    nrx_pose_predict(&p, &moving, 1500000, 0, &ahead);
+    assert(fabsf(ahead.x - 2.0f) < 1e-6f && ahead.timestamp_us == 1500000);
+    assert(fabsf(ahead.heading - (3.5f - 6.2831853f)) < 1e-5f);
+    nrx_pose_predict(&p, &moving, 9000000, 1000000, &ahead);
+    assert(fabsf(ahead.x - 3.0f) < 1e-6f);
+    nrx_pose_predict(&p, &moving, 500000, 0, &ahead);
+    assert(ahead.x == 1.0f && ahead.heading == 3.0f);
+    
+    printf("✓ Pose codec test passed\n");
+}
+
+// One robot driving at 50 Hz, watched by another across a link that may
+// drop every few messages
+typedef struct {
+    nrx_swarm_t *to;
+    int drop_every;
+    int sent;
+} link_t;
+
+static int lossy(const nrx_swarm_message_t *msg, void *ctx) {
+    link_t *link = ctx;
+    link->sent++;
+    if (link->drop_every == 0 || link->sent % link->drop_every != 0) nrx_swarm_receive(link->to, msg);
+    return 0;
+}
+
+// Straight, then a turn, then straight again; the worst error seen
+static float drive(nrx_swarm_t *driver, nrx_swarm_t *watcher, float *x, float *y, int ticks) {
+    float heading = 0.0f, worst = 0.0f;
+    for (int tick = 0; tick < ticks; tick++) {
+        float turn_rate = tick >= ticks / 3 && tick < 2 * ticks / 3 ? 0.6f : 0.0f;
+        heading += turn_rate * 0.02f;
+        *x += cosf(heading) * 1.5f * 0.02f;
+        *y += sinf(heading) * 1.5f * 0.02f;
+        nrx_robot_pose_t pose = { .x = *x, .y = *y, .heading = heading };
+        assert(nrx_swarm_update_pose(driver, &pose) == 0);
+        
+        nrx_robot_pose_t seen;
+        assert(nrx_swarm_get_pose(watcher, 1, &seen) == 0);
+        float err = hypotf(seen.x - *x, seen.y - *y);
+        if (tick > 0 && err > worst) worst = err;
+        nrx_time_advance_us(20000);
+    }
+    return worst;
+}
+
+void test_dead_reckoning() {
+    nrx_time_set_virtual(true, 1000000);
+    link_t link = { 0 };
+    nrx_swarm_config_t config = { .robot_id = 1, .transport = lossy, .transport_ctx = &link };
+    nrx_swarm_t *driver = nrx_swarm_init(&config);
+    config.robot_id = 2;
+    nrx_swarm_t *watcher = nrx_swarm_init(&config);
+    link.to = watcher;
+    
+    // Over a clean link the estimate stays within the threshold plus one
+    // tick of travel, for under a tenth of the messages
+    float x = 0.0f, y = 0.0f;
+    float worst = drive(driver, watcher, &x, &y, 1500);
+    nrx_swarm_stats_t stats;
+    nrx_swarm_get_stats(driver, &stats);
+    assert(worst < 0.05f + 0.03f + 0.01f);
+    assert(stats.messages_sent * 10 < 1500);
+    assert(stats.poses_skipped + stats.messages_sent == 1500);
+    assert(stats.bytes_sent * 20 < 1500 * 28);      // Against a 28-byte pose per update
+    
+    // Losing a keyframe blinds the watcher until the next one, no longer
+    link.drop_every = 3;
+    worst = drive(driver, watcher, &x, &y, 1500);
+    assert(worst < 1.0f);
+    link.drop_every = 0;
+    
+    // A robot that keeps its course sends about one keyframe a second
+    nrx_swarm_get_stats(driver, &stats);
+    size_t before = stats.messages_sent;
+    for (int tick = 0; tick < 500; tick++) {
+        x += 1.5f * 0.02f;
+        nrx_robot_pose_t pose = { .x = x, .y = y };
+        nrx_swarm_update_pose(driver, &pose);
+        nrx_time_advance_us(20000);
+    }
+    nrx_swarm_get_stats(driver, &stats);
+    assert(stats.messages_sent - before <= 14);
+    
+    // The grid follows the estimate as the loop runs
+    nrx_time_advance_us(500000);
+    nrx_swarm_loop(watcher);
+    nrx_robot_pose_t near[2];
+    assert(nrx_swarm_neighbors(watcher, x + 0.75f, y, 0.3f, near, 2) == 1 && near[0].id == 1);
+    
+    nrx_swarm_deinit(driver);
+    nrx_swarm_deinit(watcher);
+    nrx_time_set_virtual(false, 0);
+    printf("✓ Dead reckoning test passed\n");
+}
+
+// Cheapest assignment by trying every one
+static float brute_force(const float *cost, size_t rows, size_t cols, size_t row, bool *taken) {
+    if (row == rows) return 0.0f;
+    size_t need = rows - row, left = 0;
+    for (size_t j = 0; j < cols; j++) left += !taken[j];
+    float best = INFINITY;
+    if (need > left) best = brute_force(cost, rows, cols, row + 1, taken);    // Row goes without
+    for (size_t j = 0; j < cols; j++) {
+        if (taken[j]) continue;
+        taken[j] = true;
+        float c = cost[row * cols + j] + brute_force(cost, rows, cols, row + 1, taken);
+        taken[j] = false;
+        if (c < best) best = c;
+    }
+    return best;
+}
+
+static float total(const float *cost, size_t rows, size_t cols, const int32_t *row_to_col, int pairs) {
+    bool taken[16] = { false };
+    float sum = 0.0f;
+    int matched = 0;
+    for (size_t r = 0; r < rows; r++) {
+        if (row_to_col[r] < 0) continue;
+        assert((size_t)row_to_col[r] < cols && !taken[row_to_col[r]]);
+        taken[row_to_col[r]] = true;
+        sum += cost[r * cols + (size_t)row_to_col[r]];
+        matched++;
+    }
+    assert(matched == pairs && (size_t)pairs == (rows < cols ? rows : cols));
+    return sum;
+}
+
+void test_assign_solvers() {
+    nrx_assign_t *solver = nrx_assign_create(16, 16);
+    float cost[64];
+    int32_t out[8];
+    srand(5);
+    for (int trial = 0; trial < 300; trial++) {
+        size_t rows = 1 + (size_t)(rand() % 7), cols = 1 + (size_t)(rand() % 7);
+        for (size_t k = 0; k < rows * cols; k++) cost[k] = (float)(rand() % 100) - 20.0f;
+        
+        bool taken[8] = { false };
+        float best = brute_force(cost, rows, cols, 0, taken);
+        int pairs = nrx_assign_optimal(solver, cost, rows, cols, out);
+        assert(fabsf(total(cost, rows, cols, out, pairs) - best) < 1e-3f);
+        pairs = nrx_assign_market(solver, cost, rows, cols, out);
+        assert(total(cost, rows, cols, out, pairs) >= best - 1e-3f);
+    }
+    
+    // Greedy takes the cheapest pair first and pays for it later
+    const float trap[] = {
+        1.0f, 2.0f,
+        2.0f, 100.0f,
+    };
+    assert(nrx_assign_optimal(solver, trap, 2, 2, out) == 2 && out[0] == 1 && out[1] == 0);
+    assert(nrx_assign_market(solver, trap, 2, 2, out) == 2 && out[0] == 0 && out[1] == 1);
+    
+    assert(nrx_assign_optimal(solver, cost, 17, 2, out) == -1);
+    assert(nrx_assign_market(solver, NULL, 3, 0, out) == 0 && out[0] == -1);
+    nrx_assign_destroy(solver);
+    printf("✓ Assignment solver test passed\n");
+}
+
+void test_task_allocation() {
+    nrx_time_set_virtual(true, 1000000);
+    network_t net = { .count = 2 };
+    for (uint32_t i = 0; i < 2; i++) {
+        nrx_swarm_config_t config = {
+            .robot_id = 1 + i,
+            .heartbeat_interval_ms = 500,
+            .timeout_ms = 1000,
+            .transport = deliver,
+            .transport_ctx = &net,
+        };
+        net.members[i] = nrx_swarm_init(&config);
+    }
+    nrx_swarm_t *lead = net.members[0], *worker = net.members[1];
+    
+    // The leader assigns; robots 3 and 4 are tracked without a link
+    nrx_robot_pose_t pose = { .x = 0.0f, .y = 0.0f };
+    nrx_swarm_update_pose(lead, &pose);
+    pose = (nrx_robot_pose_t){ .x = 10.0f, .y = 0.0f };
+    nrx_swarm_update_pose(worker, &pose);
+    put(lead, 3, 0.0f, 10.0f);
+    put(lead, 4, 10.0f, 10.0f);
+    
+    nrx_swarm_task_t task = { .task_id = 100, .x = 9.0f, .y = 1.0f };
+    assert(nrx_swarm_add_task(lead, &task) == 0);
+    task = (nrx_swarm_task_t){ .task_id = 101, .x = 1.0f, .y = 9.0f };
+    assert(nrx_swarm_add_task(lead, &task) == 0);
+    task = (nrx_swarm_task_t){ .task_id = 102, .x = 8.0f, .y = 0.0f, .priority = 1.0f };
+    assert(nrx_swarm_add_task(lead, &task) == 0);
+    task.status = 3;
+    assert(nrx_swarm_add_task(lead, &task) == -1);
+    
+    // 100 and 102 both sit by robot 2. The optimum gives it 100 and sends
+    // the leader 7 m to 102 rather than robot 4 over 9 m to either.
+    assert(nrx_swarm_assign_tasks(lead) == 3);
+    nrx_swarm_task_t mine[4];
+    assert(nrx_swarm_get_my_tasks(worker, mine, 4) == 1 && mine[0].task_id == 100 && mine[0].status == 1);
+    assert(nrx_swarm_get_my_tasks(lead, mine, 4) == 1 && mine[0].task_id == 102);
+    assert(nrx_swarm_assign_tasks(lead) == 0);
+    
+    // Completing frees the worker, and a task it adds nearby goes to it
+    assert(nrx_swarm_complete_task(worker, 100) == 0);
+    assert(nrx_swarm_complete_task(worker, 100) == -1);
+    assert(nrx_swarm_get_my_tasks(worker, mine, 4) == 0);
+    task = (nrx_swarm_task_t){ .task_id = 103, .x = 11.0f, .y = 0.0f };
+    assert(nrx_swarm_add_task(worker, &task) == 0);
+    assert(nrx_swarm_assign_tasks(lead) == 1);
+    assert(nrx_swarm_get_my_tasks(worker, mine, 4) == 1 && mine[0].task_id == 103);
+    
+    // The worker starts on it, so it stays there
+    task = mine[0];
+    task.status = 2;
+    assert(nrx_swarm_add_task(worker, &task) == 0);
+    task = (nrx_swarm_task_t){ .task_id = 104, .x = 10.0f, .y = 10.0f };
+    nrx_swarm_add_task(lead, &task);
+    assert(nrx_swarm_assign_tasks(lead) == 1);
+    
+    // Robot 4 goes quiet and its task is left open: robot 3 is better off
+    // with the one it has, and the worker is busy
+    nrx_time_advance_us(600000);
+    nrx_swarm_loop(worker);
+    put(lead, 3, 0.0f, 10.0f);
+    nrx_time_advance_us(600000);
+    nrx_swarm_loop(lead);
+    assert(!nrx_swarm_is_robot_alive(lead, 4));
+    assert(nrx_swarm_assign_tasks(lead) == 1);
+    assert(nrx_swarm_get_my_tasks(worker, mine, 4) == 1 && mine[0].task_id == 103 && mine[0].status == 2);
+    assert(nrx_swarm_get_my_tasks(lead, mine, 4) == 1 && mine[0].task_id == 102);
+    
+    // Robot 5 joins with work of its own but no pose yet: the leader is
+    // right beside that work, but cannot weigh robot 5 against it, so it
+    // stays where it is
+    nrx_swarm_config_t config = {
+        .robot_id = 5,
+        .heartbeat_interval_ms = 500,
+        .timeout_ms = 1000,
+        .transport = deliver,
+        .transport_ctx = &net,
+    };
+    nrx_swarm_t *late = nrx_swarm_init(&config);
+    net.members[net.count++] = late;
+    task = (nrx_swarm_task_t){ .task_id = 105, .assigned_robot_id = 5, .x = 0.5f, .y = 0.0f, .status = 1 };
+    assert(nrx_swarm_add_task(late, &task) == 0);
+    task = (nrx_swarm_task_t){ .task_id = 106, .x = 30.0f, .y = 30.0f };
+    assert(nrx_swarm_add_task(lead, &task) == 0);
+    nrx_swarm_assign_tasks(lead);
+    assert(nrx_swarm_get_my_tasks(late, mine, 4) == 1 && mine[0].task_id == 105);
+    assert(nrx_swarm_get_my_tasks(lead, mine, 4) == 1 && mine[0].task_id == 102);
+    
+    nrx_swarm_deinit(late);
+    nrx_swarm_deinit(lead);
+    nrx_swarm_deinit(worker);
+    nrx_time_set_virtual(false, 0);
+    printf("✓ Task allocation test passed\n");
+}
+
+// Past the exact limit the market places new work without moving the rest
+void test_task_market() {
+    nrx_swarm_config_t config = { .robot_id = 1, .max_robots = 300, .max_tasks = 300 };
+    nrx_swarm_t *swarm = nrx_swarm_init(&config);
+    srand(9);
+    put(swarm, 1, 0.0f, 0.0f);
+    for (uint32_t id = 2; id <= 200; id++) put(swarm, id, frand_unit() * 100.0f, frand_unit() * 100.0f);
+    for (uint32_t t = 0; t < 150; t++) {
+        nrx_swarm_task_t task = { .task_id = 1000 + t, .x = frand_unit() * 100.0f, .y = frand_unit() * 100.0f };
+        assert(nrx_swarm_add_task(swarm, &task) == 0);
+    }
+    assert(nrx_swarm_assign_tasks(swarm) == 150);
+    
+    nrx_swarm_task_t task = { .task_id = 2000, .x = 50.0f, .y = 50.0f };
+    nrx_swarm_add_task(swarm, &task);
+    assert(nrx_swarm_complete_task(swarm, 1000) == 0);
+    assert(nrx_swarm_assign_tasks(swarm) == 1);
+    nrx_swarm_deinit(swarm);
+    printf("✓ Task market test passed\n");
+}
+
+// Against a plain array: counts, frontier and nearest target after each mark
+#define COV_W 130
+#define COV_H 70
+
+static bool frontier_cell(bool seen[COV_H][COV_W], int r, int c) {
+    if (seen[r][c]) return false;
+    return (c > 0 && seen[r][c - 1]) || (c + 1 < COV_W && seen[r][c + 1]) ||
+           (r > 0 && seen[r - 1][c]) || (r + 1 < COV_H && seen[r + 1][c]);
+}
+
+void test_coverage_grid() {
+    static bool seen[COV_H][COV_W];
+    memset(seen, 0, sizeof(seen));
+    nrx_coverage_area_t area = { -10.0f, -10.0f + COV_W * 0.5f, 5.0f, 5.0f + COV_H * 0.5f, 0.5f };
+    nrx_coverage_grid_t *grid = nrx_coverage_create(&area);
+    assert(grid && nrx_coverage_cell_count(grid) == COV_W * COV_H);
+    
+    // Nothing visited: the target is the cell under the query point
+    float tx, ty;
+    assert(nrx_coverage_nearest(grid, -9.9f, 5.1f, &tx, &ty) && tx == -9.75f && ty == 5.25f);
+    assert(nrx_coverage_nearest(grid, -100.0f, 0.0f, &tx, &ty) && tx == -9.75f && ty == 5.25f);
+    
+    // A corner cell has two frontier neighbors, and marking it again adds nothing
+    assert(nrx_coverage_mark(grid, -9.9f, 5.1f, 0.0f) == 1);
+    seen[0][0] = true;
+    assert(nrx_coverage_frontier_count(grid) == 2);
+    assert(nrx_coverage_mark(grid, -9.9f, 5.1f, 0.0f) == 0);
+    assert(nrx_coverage_is_visited(grid, -9.6f, 5.4f) && !nrx_coverage_is_visited(grid, -9.4f, 5.4f));
+    assert(nrx_coverage_mark(grid, -11.0f, 0.0f, 0.0f) == -1);
+    assert(nrx_coverage_mark(grid, 200.0f, 1e30f, 0.0f) == -1);
+    
+    srand(21);
+    for (int step = 0; step < 400; step++) {
+        float x = area.min_x - 2.0f + frand_unit() * (COV_W * 0.5f + 4.0f);
+        float y = area.min_y - 2.0f + frand_unit() * (COV_H * 0.5f + 4.0f);
+        float radius = step % 3 == 0 ? 0.0f : frand_unit() * 3.0f;
+        int added = nrx_coverage_mark(grid, x, y, radius);
+        
+        // Cells whose centres are in the circle, and the one under the point
+        double gx = (x - area.min_x) / 0.5 - 0.5, gy = (y - area.min_y) / 0.5 - 0.5;
+        int expect = 0, hit = 0;
+        for (int r = 0; r < COV_H; r++) {
+            for (int c = 0; c < COV_W; c++) {
+                double dx = c - gx, dy = r - gy, rr = radius / 0.5;
+                bool home = c == (int)floor(gx + 0.5) && r == (int)floor(gy + 0.5);
+                if (home || dx * dx + dy * dy <= rr * rr) {
+                    hit++;
+                    if (!seen[r][c]) expect++;
+                    seen[r][c] = true;
+                }
+            }
+        }
+        assert(added == (hit ? expect : -1));
+        
+        size_t visited = 0, frontier = 0;
+        double best = INFINITY;
+        for (int r = 0; r < COV_H; r++) {
+            for (int c = 0; c < COV_W; c++) {
+                visited += seen[r][c];
+                if (!frontier_cell(seen, r, c)) continue;
+                frontier++;
+                double dx = c - gx, dy = r - gy;
+                if (dx * dx + dy * dy < best) best = dx * dx + dy * dy;
+            }
+        }
+        assert(nrx_coverage_visited_count(grid) == visited);
+        assert(nrx_coverage_frontier_count(grid) == frontier);
+        
+        // Query from the point just marked; ties may go either way, so
+        // compare distances
+        if (frontier == 0) continue;
+        assert(nrx_coverage_nearest(grid, x, y, &tx, &ty));
+        int c = (int)floorf((tx - area.min_x) / 0.5f), r = (int)floorf((ty - area.min_y) / 0.5f);
+        assert(frontier_cell(seen, r, c));
+        double dx = c - gx, dy = r - gy;
+        assert(fabs(dx * dx + dy * dy - best) < 1e-6);
+    }
+    
+    // Cover it all
+    assert(nrx_coverage_mark(grid, 0.0f, 0.0f, 100.0f) > 0);
+    assert(nrx_coverage_visited_count(grid) == COV_W * COV_H && nrx_coverage_frontier_count(grid) == 0);
+    assert(!nrx_coverage_nearest(grid, 0.0f, 0.0f, &tx, &ty));
+    nrx_coverage_destroy(grid);
+    
+    nrx_coverage_area_t empty = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+    nrx_coverage_area_t huge = { 0.0f, 1e9f, 0.0f, 1e9f, 1.0f };
+    assert(!nrx_coverage_create(&empty) && !nrx_coverage_create(&huge));
+    printf("✓ Coverage grid test passed\n");
+}
+
+// A robot that keeps going to its target covers the area
+void test_coverage_control() {
+    nrx_swarm_t *swarm = make_swarm(1, 4);
+    nrx_coverage_area_t area = { 0.0f, 10.0f, 0.0f, 8.0f, 1.0f };
+    float x, y;
+    assert(nrx_swarm_coverage_get_target(swarm, &x, &y) == -1);
+    assert(nrx_swarm_coverage_init(swarm, &area) == 0);
+    assert(nrx_swarm_coverage_get_target(swarm, &x, &y) == -1);
+    assert(nrx_swarm_coverage_get_progress(swarm) == 0.0f);
+    assert(nrx_swarm_coverage_mark_visited(swarm, 20.0f, 0.0f) == -1);
+    
+    put(swarm, 1, 3.2f, 4.7f);
+    int steps = 0;
+    while (nrx_swarm_coverage_get_target(swarm, &x, &y) == 0) {
+        assert(nrx_swarm_coverage_mark_visited(swarm, x, y) == 0);
+        put(swarm, 1, x, y);
+        steps++;
+    }
+    assert(steps == 80 && nrx_swarm_coverage_get_progress(swarm) == 1.0f);
+    
+    // Starting over forgets it
+    assert(nrx_swarm_coverage_init(swarm, &area) == 0);
+    assert(nrx_swarm_coverage_get_progress(swarm) == 0.0f);
+    nrx_swarm_deinit(swarm);
+    printf("✓ Coverage control test passed\n");
+}
+
+// Consensus: five robots on a simulated network
+#define CLUSTER 5
+
+static const uint32_t cluster_ids[CLUSTER] = { 1, 2, 3, 4, 5 };
+static nrx_swarm_t *cluster[CLUSTER];
+
+static nrx_sim_net_t *make_cluster(const nrx_sim_net_config_t *net_config) {
+    nrx_sim_net_t *net = nrx_sim_net_create(net_config);
+    assert(net);
+    for (int i = 0; i < CLUSTER; i++) {
+        nrx_swarm_config_t config = {
+            .robot_id = cluster_ids[i],
+            .transport = nrx_sim_net_transport,
+            .transport_ctx = net,
+            .consensus_members = cluster_ids,
+            .consensus_member_count = CLUSTER,
+            .election_timeout_ms = 100,
+        };
+        cluster[i] = nrx_swarm_init(&config);
+        assert(cluster[i] && nrx_sim_net_attach(net, cluster_ids[i], cluster[i]) == 0);
+    }
+    return net;
+}
+
+static void free_cluster(nrx_sim_net_t *net) {
+    for (int i = 0; i < CLUSTER; i++) nrx_swarm_deinit(cluster[i]);
+    nrx_sim_net_destroy(net);
+}
+
+// The one robot that believes it leads, among those listed; 0 if not one
+static uint32_t sole_leader(const int *robots, int n) {
+    uint32_t leader = 0;
+    for (int k = 0; k < n; k++) {
+        if (!nrx_swarm_is_leader(cluster[robots[k]])) continue;
+        if (leader) return 0;
+        leader = cluster_ids[robots[k]];
+    }
+    return leader;
+}
+
+static const int everyone[CLUSTER] = { 0, 1, 2, 3, 4 };
+
+void test_consensus() {
+    nrx_time_set_virtual(true, 1000000);
+    nrx_sim_net_config_t net_config = { .latency_us = 2000, .jitter_us = 1000, .seed = 5 };
+    nrx_sim_net_t *net = make_cluster(&net_config);
+    
+    float result;
+    assert(nrx_swarm_consensus_propose(cluster[0], 1.0f) == -1);
+    assert(nrx_swarm_consensus_get_result(cluster[0], &result) == -1);
+    
+    nrx_sim_net_run(net, 1000000, 1000);
+    uint32_t leader = sole_leader(everyone, CLUSTER);
+    assert(leader);
+    for (int i = 0; i < CLUSTER; i++) assert(nrx_swarm_elect_leader(cluster[i]) == leader);
+    nrx_swarm_stats_t stats;
+    nrx_swarm_get_stats(cluster[0], &stats);
+    assert(stats.leader_id == leader);
+    
+    // The leader's own value goes in first, the forwarded one after it
+    nrx_swarm_t *lead = cluster[leader - 1], *other = cluster[leader % CLUSTER];
+    assert(nrx_swarm_consensus_propose(lead, 7.25f) == 0);
+    assert(nrx_swarm_consensus_propose(other, 3.5f) == 0);
+    nrx_sim_net_run(net, 100000, 1000);
+    assert(nrx_swarm_consensus_get_result(lead, &result) == 0 && result == 3.5f);
+    for (int i = 0; i < CLUSTER; i++) {
+        if (cluster[i] == lead) continue;
+        assert(nrx_swarm_consensus_get_result(cluster[i], &result) == 1 && result == 3.5f);
+    }
+    
+    // Cut the leader and one other off: the three elect among themselves,
+    // and the old leader loses its lease, then steps down
+    int side = leader % CLUSTER;
+    nrx_sim_net_set_group(net, leader, 1);
+    nrx_sim_net_set_group(net, cluster_ids[side], 1);
+    int majority[3], m = 0;
+    for (int i = 0; i < CLUSTER; i++) {
+        if (cluster_ids[i] != leader && i != side) majority[m++] = i;
+    }
+    nrx_sim_net_run(net, 100000, 1000);
+    assert(nrx_swarm_is_leader(lead) && nrx_swarm_consensus_get_result(lead, &result) == 1);
+    nrx_sim_net_run(net, 900000, 1000);
+    assert(!nrx_swarm_is_leader(lead) && nrx_swarm_consensus_propose(lead, 9.0f) == -1);
+    uint32_t second = sole_leader(majority, 3);
+    assert(second && second != leader);
+    
+    assert(nrx_swarm_consensus_propose(cluster[second - 1], 42.0f) == 0);
+    nrx_sim_net_run(net, 100000, 1000);
+    assert(nrx_swarm_consensus_get_result(cluster[second - 1], &result) == 0 && result == 42.0f);
+    assert(nrx_swarm_consensus_get_result(lead, &result) == 1 && result == 3.5f);
+    
+    // Healed, the two catch up without unseating the leader, whose term
+    // they never got past
+    nrx_sim_net_heal(net);
+    nrx_sim_net_run(net, 1000000, 1000);
+    assert(sole_leader(everyone, CLUSTER) == second);
+    for (int i = 0; i < CLUSTER; i++) {
+        assert(nrx_swarm_elect_leader(cluster[i]) == second);
+        assert(nrx_swarm_consensus_get_result(cluster[i], &result) >= 0 && result == 42.0f);
+    }
+    free_cluster(net);
+    
+    // Losing a fifth of the messages and reordering the rest costs time,
+    // not entries
+    nrx_sim_net_config_t lossy_config = { .latency_us = 1000, .jitter_us = 5000, .loss = 0.2f, .seed = 8 };
+    net = make_cluster(&lossy_config);
+    nrx_sim_net_run(net, 2000000, 1000);
+    leader = sole_leader(everyone, CLUSTER);
+    assert(leader);
+    for (int v = 1; v <= 300; v++) {
+        assert(nrx_swarm_consensus_propose(cluster[leader - 1], (float)v) == 0);
+        nrx_sim_net_run(net, 1000, 1000);
+    }
+    nrx_sim_net_run(net, 2000000, 1000);
+    for (int i = 0; i < CLUSTER; i++) {
+        assert(nrx_swarm_consensus_get_result(cluster[i], &result) >= 0 && result == 300.0f);
+    }
+    nrx_sim_net_stats_t net_stats;
+    nrx_sim_net_get_stats(net, &net_stats);
+    assert(net_stats.dropped > net_stats.sent / 10);
+    free_cluster(net);
+    
+    // Without members, the lowest live id leads
+    nrx_swarm_t *plain = make_swarm(7, 8);
+    assert(nrx_swarm_elect_leader(plain) == 7 && nrx_swarm_is_leader(plain));
+    put(plain, 3, 0.0f, 0.0f);
+    assert(nrx_swarm_elect_leader(plain) == 3 && !nrx_swarm_is_leader(plain));
+    assert(nrx_swarm_consensus_propose(plain, 1.0f) == -1);
+    nrx_time_advance_us(2000000);
+    assert(nrx_swarm_elect_leader(plain) == 7);
+    nrx_swarm_deinit(plain);
+    nrx_time_set_virtual(false, 0);
+    printf("✓ Consensus test passed\n");
+}
+
+// The Raft core alone, on a network that delivers in order at once, with
+// a log small enough to wrap: a robot that was down catches up through a
+// snapshot
+#define RAFT_QUEUE 4096
+
+typedef struct {
+    uint32_t from, to;
+    size_t len;
+    uint8_t data[NRX_RAFT_MAX_PAYLOAD];
+} raft_msg_t;
+
+static raft_msg_t raft_queue[RAFT_QUEUE];
+static size_t raft_head, raft_tail;
+static bool raft_down[4];
+static uint32_t raft_ids[3] = { 1, 2, 3 };
+
+static void raft_send(uint32_t to, const uint8_t *payload, size_t len, void *ctx) {
+    assert(raft_tail - raft_head < RAFT_QUEUE);
+    raft_msg_t *m = &raft_queue[raft_tail++ % RAFT_QUEUE];
+    m->from = *(const uint32_t *)ctx;
+    m->to = to;
+    m->len = len;
+    memcpy(m->data, payload, len);
+}
+
+static void raft_step(nrx_raft_t **rafts, uint64_t now) {
+    for (int i = 0; i < 3; i++) {
+        if (!raft_down[i + 1]) nrx_raft_tick(rafts[i], now);
+    }
+    while (raft_head != raft_tail) {
+        raft_msg_t *m = &raft_queue[raft_head++ % RAFT_QUEUE];
+        if (!raft_down[m->from] && !raft_down[m->to]) nrx_raft_receive(rafts[m->to - 1], m->from, m->data, m->len, now);
+    }
+}
+
+void test_raft_log() {
+    nrx_raft_t *rafts[3];
+    for (int i = 0; i < 3; i++) {
+        nrx_raft_config_t config = {
+            .id = raft_ids[i],
+            .members = raft_ids,
+            .member_count = 3,
+            .election_timeout_ms = 50,
+            .log_capacity = 16,
+            .max_batch = 4,
+            .send = raft_send,
+            .send_ctx = &raft_ids[i],
+        };
+        rafts[i] = nrx_raft_create(&config, 0);
+        assert(rafts[i]);
+    }
+    nrx_raft_config_t outsider = { .id = 9, .members = raft_ids, .member_count = 3, .send = raft_send };
+    assert(!nrx_raft_create(&outsider, 0));
+    
+    uint64_t now = 0;
+    while (nrx_raft_leader(rafts[0]) == 0 || nrx_raft_leader(rafts[0]) != nrx_raft_leader(rafts[1])) {
+        raft_step(rafts, now += 1000);
+        assert(now < 2000000);
+    }
+    nrx_raft_t *lead = rafts[nrx_raft_leader(rafts[0]) - 1];
+    int down = nrx_raft_leader(rafts[0]) % 3 + 1;
+    raft_down[down] = true;
+    
+    // Half the log may wait on commits; past that, proposals are refused
+    int refused = 0;
+    for (int v = 1; v <= 100; v++) {
+        while (nrx_raft_propose(lead, (float)v, 1) != 0) {
+            refused++;
+            raft_step(rafts, now += 1000);
+        }
+    }
+    assert(refused > 0);
+    for (int k = 0; k < 10; k++) raft_step(rafts, now += 1000);
+    nrx_consensus_value_t value;
+    assert(nrx_raft_read(lead, now, &value) == 1 && value.value == 100.0f && value.round == nrx_raft_commit_index(lead));
+    assert(nrx_raft_read(rafts[down - 1], now, &value) == -1);
+    
+    // The entries it is missing have been dropped, so it gets a snapshot
+    raft_down[down] = false;
+    for (int k = 0; k < 100; k++) raft_step(rafts, now += 1000);
+    assert(nrx_raft_read(rafts[down - 1], now, &value) == 0 && value.value == 100.0f);
+    assert(nrx_raft_commit_index(rafts[down - 1]) == nrx_raft_commit_index(lead));
+    assert(nrx_raft_last_index(rafts[down - 1]) == nrx_raft_last_index(lead));
+    assert(nrx_raft_term(rafts[down - 1]) == nrx_raft_term(lead));
+    
+    // The new entry reaches everyone along the normal path again
+    assert(nrx_raft_propose(lead, 101.0f, 2) == 0);
+    for (int k = 0; k < 100; k++) raft_step(rafts, now += 1000);
+    for (int i = 0; i < 3; i++) {
+        assert(nrx_raft_read(rafts[i], now, &value) >= 0 && value.value == 101.0f && value.proposer_id == 2);
+    }
+    for (int i = 0; i < 3; i++) nrx_raft_destroy(rafts[i]);
+    printf("✓ Raft log test passed\n");
+}
+
+int main() {
+    printf("Running swarm tests...\n\n");
+    
+    test_robot_table();
+    test_spatial_grid();
+    test_messaging();
+    test_pose_codec();
+    test_dead_reckoning();
+    test_assign_solvers();
+    test_task_allocation();
+    test_task_market();
+    test_neighbors_and_flocking();
+    test_collision_avoidance();
+    test_coverage_grid();
+    test_coverage_control();
+    test_consensus();
+    test_raft_log();
+    
+    printf("\n✓ All swarm tests passed!\n");
+    return 0;
+}
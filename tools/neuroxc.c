@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include "common.h"
 #include "lexer.h"
 #include "parser.h"
@@ -12,6 +13,7 @@ static void print_usage(const char *prog_name) {
     printf("Usage: %s <command> [options] <input>\n\n", prog_name);
     printf("Commands:\n");
     printf("  emit-c <file>      Generate C code from .neuro file\n");
+    printf("  emit-h <file>      Generate a header with the file's message types\n");
     printf("  parse <file>       Parse and print AST (debug)\n");
     printf("  lex <file>         Tokenize and print tokens (debug)\n");
     printf("  check <file>       Type check only\n");
@@ -95,7 +97,302 @@ static int cmd_parse(const char *input_file) {
     }
 }
 
-static int cmd_emit_c(const char *input_file, const char *output_file) {
+// Sensor types backed by a runtime fusion filter
+static const struct {
+    const char *sensor_type;
+    const char *fusion_kind;
+} fused_sensor_types[] = {
+    { "IMU", "NRX_FUSION_MADGWICK" },
+    { "TiltIMU", "NRX_FUSION_COMPLEMENTARY" },
+    { "Odometry", "NRX_FUSION_EKF" },
+};
+
+static const char *fusion_kind_for(const ast_decl_t *decl) {
+    if (decl->type != DECL_SENSOR || !decl->as.sensor.sensor_type) return NULL;
+    for (size_t i = 0; i < sizeof(fused_sensor_types) / sizeof(fused_sensor_types[0]); i++) {
+        if (strcmp(decl->as.sensor.sensor_type, fused_sensor_types[i].sensor_type) == 0) {
+            return fused_sensor_types[i].fusion_kind;
+        }
+    }
+    return NULL;
+}
+
+// Message field types
+typedef enum {
+    FIELD_UINT,
+    FIELD_INT,
+    FIELD_F32,
+    FIELD_F64,
+    FIELD_BOOL,
+} field_kind_t;
+
+static const struct {
+    const char *name;
+    const char *c_type;
+    field_kind_t kind;
+    size_t size;                // Bytes in the fixed layout
+} message_field_types[] = {
+    { "u8", "uint8_t", FIELD_UINT, 1 },
+    { "u16", "uint16_t", FIELD_UINT, 2 },
+    { "u32", "uint32_t", FIELD_UINT, 4 },
+    { "u64", "uint64_t", FIELD_UINT, 8 },
+    { "i8", "int8_t", FIELD_INT, 1 },
+    { "i16", "int16_t", FIELD_INT, 2 },
+    { "i32", "int32_t", FIELD_INT, 4 },
+    { "i64", "int64_t", FIELD_INT, 8 },
+    { "f32", "float", FIELD_F32, 4 },
+    { "f64", "double", FIELD_F64, 8 },
+    { "bool", "bool", FIELD_BOOL, 1 },
+};
+
+static int field_type_index(const ast_param_t *field) {
+    for (size_t i = 0; i < sizeof(message_field_types) / sizeof(message_field_types[0]); i++) {
+        if (strcmp(field->type->name, message_field_types[i].name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// Bytes as a C string literal, the first `binary` of them as hex escapes;
+// a printable character that would extend a hex escape starts a new literal
+static void emit_bytes(FILE *out, const uint8_t *bytes, size_t len, size_t binary) {
+    bool after_hex = false;
+    fputc('"', out);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = bytes[i];
+        if (i >= binary && b >= 0x20 && b < 0x7F && b != '"' && b != '\\') {
+            if (after_hex && strchr("0123456789abcdefABCDEF", b)) fputs("\" \"", out);
+            fputc(b, out);
+            after_hex = false;
+        } else if (b == '"' || b == '\\') {
+            fprintf(out, "\\%c", b);
+            after_hex = false;
+        } else {
+            fprintf(out, "\\x%02x", b);
+            after_hex = true;
+        }
+    }
+    fputc('"', out);
+}
+
+static size_t cbor_head(uint8_t *p, uint8_t major, size_t value) {
+    if (value < 24) {
+        p[0] = (uint8_t)(major << 5 | value);
+        return 1;
+    }
+    p[0] = (uint8_t)(major << 5 | 24);
+    p[1] = (uint8_t)value;
+    return 2;
+}
+
+static void emit_raw(FILE *out, const uint8_t *bytes, size_t len, size_t binary) {
+    fprintf(out, "    nrx_codec_raw(&w, ");
+    emit_bytes(out, bytes, len, binary);
+    fprintf(out, ", %zu);\n", len);
+}
+
+// A struct and its encoders, one per wire format, unrolled over the fields.
+// Keys and map headers are constants; only the values are formatted at run
+// time. <Name>_publish uses the declared format.
+static bool emit_message(FILE *out, const ast_message_decl_t *msg) {
+    static const char *formats[] = { "json", "cbor", "binary" };
+    const char *name = msg->name;
+    size_t binary_size = 0;
+    
+    for (size_t i = 0; i < msg->field_count; i++) {
+        int type = field_type_index(msg->fields[i]);
+        if (type < 0) {
+            fprintf(stderr, "Error: message %s: field '%s' has unknown type '%s'\n",
+                    name, msg->fields[i]->name, msg->fields[i]->type->name);
+            return false;
+        }
+        if (strlen(msg->fields[i]->name) > 255) {
+            fprintf(stderr, "Error: message %s: field name '%s' too long\n", name, msg->fields[i]->name);
+            return false;
+        }
+        binary_size += message_field_types[type].size;
+    }
+    if (msg->field_count == 0 || msg->field_count > 255) {
+        fprintf(stderr, "Error: message %s: %s\n", name, msg->field_count ? "too many fields" : "no fields");
+        return false;
+    }
+    
+    fprintf(out, "// Message %s (%s)\n", name, formats[msg->format]);
+    fprintf(out, "typedef struct {\n");
+    for (size_t i = 0; i < msg->field_count; i++) {
+        fprintf(out, "    %s %s;\n", message_field_types[field_type_index(msg->fields[i])].c_type,
+                msg->fields[i]->name);
+    }
+    fprintf(out, "} %s;\n\n", name);
+    fprintf(out, "#define %s_BINARY_SIZE %zu\n\n", name, binary_size);
+    
+    // CBOR: a map of field name to value
+    uint8_t key[2 + 2 + 256];
+    fprintf(out, "static inline size_t %s_encode_cbor(const void *message, uint8_t *buf, size_t cap) {\n", name);
+    fprintf(out, "    const %s *m = message;\n", name);
+    fprintf(out, "    nrx_codec_writer_t w = nrx_codec_writer(buf, cap);\n");
+    for (size_t i = 0; i < msg->field_count; i++) {
+        const ast_param_t *field = msg->fields[i];
+        size_t field_len = strlen(field->name);
+        size_t n = i == 0 ? cbor_head(key, 5, msg->field_count) : 0;
+        n += cbor_head(key + n, 3, field_len);
+        memcpy(key + n, field->name, field_len);
+        emit_raw(out, key, n + field_len, n);
+        
+        static const char *cbor_calls[] = { "nrx_cbor_uint", "nrx_cbor_int", "nrx_cbor_f32", "nrx_cbor_f64", "nrx_cbor_bool" };
+        fprintf(out, "    %s(&w, m->%s);\n", cbor_calls[message_field_types[field_type_index(field)].kind], field->name);
+    }
+    fprintf(out, "    return nrx_codec_end(&w);\n");
+    fprintf(out, "}\n\n");
+    
+    // Fixed layout, and its decoder
+    fprintf(out, "static inline size_t %s_encode_binary(const void *message, uint8_t *buf, size_t cap) {\n", name);
+    fprintf(out, "    const %s *m = message;\n", name);
+    fprintf(out, "    nrx_codec_writer_t w = nrx_codec_writer(buf, cap);\n");
+    for (size_t i = 0; i < msg->field_count; i++) {
+        const ast_param_t *field = msg->fields[i];
+        int type = field_type_index(field);
+        switch (message_field_types[type].kind) {
+            case FIELD_F32:
+                fprintf(out, "    nrx_bin_f32(&w, m->%s);\n", field->name);
+                break;
+            case FIELD_F64:
+                fprintf(out, "    nrx_bin_f64(&w, m->%s);\n", field->name);
+                break;
+            default:
+                fprintf(out, "    nrx_bin_uint(&w, (uint64_t)m->%s, %zu);\n", field->name, message_field_types[type].size);
+                break;
+        }
+    }
+    fprintf(out, "    return nrx_codec_end(&w);\n");
+    fprintf(out, "}\n\n");
+    
+    fprintf(out, "static inline bool %s_decode_binary(%s *m, const uint8_t *buf, size_t len) {\n", name, name);
+    fprintf(out, "    if (len != %s_BINARY_SIZE) return false;\n", name);
+    size_t offset = 0;
+    for (size_t i = 0; i < msg->field_count; i++) {
+        const ast_param_t *field = msg->fields[i];
+        int type = field_type_index(field);
+        switch (message_field_types[type].kind) {
+            case FIELD_F32:
+                fprintf(out, "    m->%s = nrx_bin_read_f32(buf + %zu);\n", field->name, offset);
+                break;
+            case FIELD_F64:
+                fprintf(out, "    m->%s = nrx_bin_read_f64(buf + %zu);\n", field->name, offset);
+                break;
+            case FIELD_BOOL:
+                fprintf(out, "    m->%s = buf[%zu] != 0;\n", field->name, offset);
+                break;
+            default:
+                fprintf(out, "    m->%s = (%s)nrx_bin_read_uint(buf + %zu, %zu);\n", field->name,
+                        message_field_types[type].c_type, offset, message_field_types[type].size);
+                break;
+        }
+        offset += message_field_types[type].size;
+    }
+    fprintf(out, "    return true;\n");
+    fprintf(out, "}\n\n");
+    
+    // JSON: an object, streamed field by field
+    fprintf(out, "static inline size_t %s_encode_json(const void *message, uint8_t *buf, size_t cap) {\n", name);
+    fprintf(out, "    const %s *m = message;\n", name);
+    fprintf(out, "    nrx_codec_writer_t w = nrx_codec_writer(buf, cap);\n");
+    for (size_t i = 0; i < msg->field_count; i++) {
+        const ast_param_t *field = msg->fields[i];
+        size_t n = (size_t)snprintf((char *)key, sizeof(key), "%s\"%s\":", i == 0 ? "{" : ",", field->name);
+        emit_raw(out, key, n, 0);
+        
+        static const char *json_calls[] = { "nrx_json_uint", "nrx_json_int", "nrx_json_f32", "nrx_json_f64", "nrx_json_bool" };
+        fprintf(out, "    %s(&w, m->%s);\n", json_calls[message_field_types[field_type_index(field)].kind], field->name);
+    }
+    emit_raw(out, (const uint8_t *)"}", 1, 0);
+    fprintf(out, "    return nrx_codec_end(&w);\n");
+    fprintf(out, "}\n\n");
+    
+    // JSON decoding: every field must be present, unknown members are skipped
+    bool any_uint = false, any_int = false;
+    for (size_t i = 0; i < msg->field_count; i++) {
+        field_kind_t kind = message_field_types[field_type_index(msg->fields[i])].kind;
+        any_uint |= kind == FIELD_UINT;
+        any_int |= kind == FIELD_INT;
+    }
+    fprintf(out, "static inline bool %s_read_json(%s *m, const nrx_json_tape_t *t, uint32_t object) {\n", name, name);
+    fprintf(out, "    static const nrx_json_step_t keys[%zu] = {\n", msg->field_count);
+    for (size_t i = 0; i < msg->field_count; i++) {
+        fprintf(out, "        NRX_JSON_KEY(\"%s\"),\n", msg->fields[i]->name);
+    }
+    fprintf(out, "    };\n");
+    fprintf(out, "    uint32_t at[%zu];\n", msg->field_count);
+    if (any_uint) fprintf(out, "    uint64_t u;\n");
+    if (any_int) fprintf(out, "    int64_t i;\n");
+    fprintf(out, "    if (!nrx_json_lookup(t, object, keys, %zu, at)) return false;\n", msg->field_count);
+    for (size_t i = 0; i < msg->field_count; i++) {
+        const ast_param_t *field = msg->fields[i];
+        int type = field_type_index(field);
+        static const char *uint_max[] = { "", "UINT8_MAX", "UINT16_MAX", "", "UINT32_MAX" };
+        static const char *int_min[] = { "", "INT8_MIN", "INT16_MIN", "", "INT32_MIN" };
+        static const char *int_max[] = { "", "INT8_MAX", "INT16_MAX", "", "INT32_MAX" };
+        size_t size = message_field_types[type].size;
+        switch (message_field_types[type].kind) {
+            case FIELD_UINT:
+                if (size < 8) {
+                    fprintf(out, "    if (!nrx_json_get_u64(t, at[%zu], &u) || u > %s) return false;\n", i, uint_max[size]);
+                } else {
+                    fprintf(out, "    if (!nrx_json_get_u64(t, at[%zu], &u)) return false;\n", i);
+                }
+                fprintf(out, "    m->%s = (%s)u;\n", field->name, message_field_types[type].c_type);
+                break;
+            case FIELD_INT:
+                if (size < 8) {
+                    fprintf(out, "    if (!nrx_json_get_i64(t, at[%zu], &i) || i < %s || i > %s) return false;\n",
+                            i, int_min[size], int_max[size]);
+                } else {
+                    fprintf(out, "    if (!nrx_json_get_i64(t, at[%zu], &i)) return false;\n", i);
+                }
+                fprintf(out, "    m->%s = (%s)i;\n", field->name, message_field_types[type].c_type);
+                break;
+            case FIELD_F32:
+                fprintf(out, "    if (!nrx_json_get_f32(t, at[%zu], &m->%s)) return false;\n", i, field->name);
+                break;
+            case FIELD_F64:
+                fprintf(out, "    if (!nrx_json_get_f64(t, at[%zu], &m->%s)) return false;\n", i, field->name);
+                break;
+            case FIELD_BOOL:
+                fprintf(out, "    if (!nrx_json_get_bool(t, at[%zu], &m->%s)) return false;\n", i, field->name);
+                break;
+        }
+    }
+    fprintf(out, "    return true;\n");
+    fprintf(out, "}\n\n");
+    
+    fprintf(out, "static inline bool %s_decode_json(%s *m, const uint8_t *buf, size_t len) {\n", name, name);
+    fprintf(out, "    nrx_json_node_t nodes[NRX_JSON_MESSAGE_NODES(%zu)];\n", msg->field_count);
+    fprintf(out, "    nrx_json_tape_t t;\n");
+    fprintf(out, "    return nrx_json_parse(&t, nodes, NRX_JSON_MESSAGE_NODES(%zu), (const char *)buf, len) == 0 &&\n",
+            msg->field_count);
+    fprintf(out, "           %s_read_json(m, &t, 0);\n", name);
+    fprintf(out, "}\n\n");
+    
+    fprintf(out, "static inline int %s_publish(nrx_mqtt_topic_t *topic, const %s *m) {\n", name, name);
+    fprintf(out, "    return nrx_mqtt_topic_publish_encoded(topic, %s_encode_%s, m);\n", name, formats[msg->format]);
+    fprintf(out, "}\n\n");
+    return true;
+}
+
+// Message types and their codecs on their own, for C code that talks to a
+// robot without being generated from it
+static void emit_header(FILE *out, const char *input_file, const ast_robot_t *robot) {
+    fprintf(out, "// Generated from %s\n", input_file);
+    fprintf(out, "#ifndef NEUROX_GEN_");
+    for (const char *c = robot->name; *c; c++) fputc(toupper((unsigned char)*c), out);
+    fprintf(out, "_H\n#define NEUROX_GEN_");
+    for (const char *c = robot->name; *c; c++) fputc(toupper((unsigned char)*c), out);
+    fprintf(out, "_H\n\n");
+    fprintf(out, "#include \"runtime/net/mqtt.h\"\n");
+    fprintf(out, "#include \"runtime/net/codec.h\"\n");
+    fprintf(out, "#include \"runtime/net/json.h\"\n\n");
+}
+
+static int cmd_emit_c(const char *input_file, const char *output_file, bool header) {
     char *source = read_file(input_file);
     if (!source) return 1;
     
@@ -125,17 +422,58 @@ static int cmd_emit_c(const char *input_file, const char *output_file) {
         }
     }
     
+    if (header) {
+        emit_header(out, input_file, robot);
+        for (size_t i = 0; i < robot->decl_count; i++) {
+            if (robot->declarations[i]->type == DECL_MESSAGE && !emit_message(out, &robot->declarations[i]->as.message)) {
+                if (output_file) fclose(out);
+                ast_robot_free(robot);
+                free(source);
+                return 1;
+            }
+        }
+        fprintf(out, "#endif\n");
+        if (output_file) {
+            fclose(out);
+            printf("Generated header: %s\n", output_file);
+        }
+        ast_robot_free(robot);
+        free(source);
+        return 0;
+    }
+    
     // Generate C code (simplified codegen)
     fprintf(out, "// Generated from %s\n", input_file);
     fprintf(out, "#include \"runtime/core/scheduler.h\"\n");
     fprintf(out, "#include \"runtime/core/safety.h\"\n");
+    fprintf(out, "#include \"runtime/core/fusion.h\"\n");
     fprintf(out, "#include \"runtime/hal/hal.h\"\n");
     fprintf(out, "#include \"runtime/net/mqtt.h\"\n");
+    fprintf(out, "#include \"runtime/net/codec.h\"\n");
+    fprintf(out, "#include \"runtime/net/json.h\"\n");
     fprintf(out, "#include <stdio.h>\n\n");
     
     fprintf(out, "// Robot: %s\n", robot->name);
     fprintf(out, "// TODO: Full code generation\n\n");
     
+    bool has_fusion = false;
+    for (size_t i = 0; i < robot->decl_count; i++) {
+        if (fusion_kind_for(robot->declarations[i])) {
+            fprintf(out, "static nrx_fusion_t %s;\n", robot->declarations[i]->as.sensor.name);
+            has_fusion = true;
+        }
+    }
+    if (has_fusion) fprintf(out, "\n");
+    
+    for (size_t i = 0; i < robot->decl_count; i++) {
+        if (robot->declarations[i]->type == DECL_MESSAGE && !emit_message(out, &robot->declarations[i]->as.message)) {
+            if (output_file) fclose(out);
+            ast_robot_free(robot);
+            free(source);
+            return 1;
+        }
+    }
+    
     fprintf(out, "int main(void) {\n");
     fprintf(out, "    printf(\"NeuroX Robot: %s\\n\");\n", robot->name);
     fprintf(out, "    \n");
@@ -146,6 +484,14 @@ static int cmd_emit_c(const char *input_file, const char *output_file) {
     fprintf(out, "    nrx_safety_config_t safety_config = {0};\n");
     fprintf(out, "    nrx_safety_init(&safety_config);\n");
     fprintf(out, "    \n");
+    for (size_t i = 0; i < robot->decl_count; i++) {
+        const char *kind = fusion_kind_for(robot->declarations[i]);
+        if (kind) {
+            fprintf(out, "    nrx_fusion_init(&%s, %s);\n", robot->declarations[i]->as.sensor.name, kind);
+        }
+    }
+    if (has_fusion) fprintf(out, "    \n");
+    
     fprintf(out, "    // TODO: Initialize hardware, tasks, schedules\n");
     fprintf(out, "    \n");
     fprintf(out, "    printf(\"Starting scheduler...\\n\");\n");
@@ -199,7 +545,7 @@ int main(int argc, char **argv) {
         return cmd_parse(argv[2]);
     }
     
-    if (strcmp(command, "emit-c") == 0) {
+    if (strcmp(command, "emit-c") == 0 || strcmp(command, "emit-h") == 0) {
         if (argc < 3) {
             fprintf(stderr, "Error: Missing input file\n");
             return 1;
@@ -216,7 +562,7 @@ int main(int argc, char **argv) {
             }
         }
         
-        return cmd_emit_c(input_file, output_file);
+        return cmd_emit_c(input_file, output_file, strcmp(command, "emit-h") == 0);
     }
     
     fprintf(stderr, "Error: Unknown command '%s'\n", command);